@@ -0,0 +1,114 @@
+---@meta
+
+---@class drawlist
+---@field FILL_RECT integer тип команди для ``DrawList:add``: x, y, w, h, color
+---@field FILL_CIRCLE integer тип команди для ``DrawList:add``: x, y, r, color
+---@field IMAGE integer тип команди для ``DrawList:add``: image_id, x, y
+---@field RECT integer тип команди для ``DrawList:add``: x, y, w, h, color
+---@field CIRCLE integer тип команди для ``DrawList:add``: x, y, r, color
+---@field LINE integer тип команди для ``DrawList:add``: x0, y0, x1, y1, color
+---@field PIXEL integer тип команди для ``DrawList:add``: x, y, color
+drawlist = {}
+
+---Створити новий порожній список малювання.
+---
+---@return DrawList
+function drawlist.new() end
+
+---Список команд малювання, які виконуються одним викликом ``draw``.
+---
+---Команди малюються згруповано за типом: спершу зафарбовані прямокутники, потім зафарбовані кола, зображення, прямокутники, кола, лінії і, нарешті, пікселі. В межах одного типу порядок команд зберігається. Якщо потрібен інший порядок шарів - використовуйте кілька списків.
+---@class DrawList
+DrawList = {}
+
+---Додати піксель.
+---
+---@param x number координата X
+---@param y number координата Y
+---@param color integer колір
+function DrawList:pixel(x, y, color) end
+
+---Додати лінію.
+---
+---@param x0 number координата X початку
+---@param y0 number координата Y початку
+---@param x1 number координата X кінця
+---@param y1 number координата Y кінця
+---@param color integer колір
+function DrawList:line(x0, y0, x1, y1, color) end
+
+---Додати прямокутник.
+---
+---@param x number координата X
+---@param y number координата Y
+---@param w number ширина
+---@param h number висота
+---@param color integer колір
+function DrawList:rect(x, y, w, h, color) end
+
+---Додати зафарбований прямокутник.
+---
+---@param x number координата X
+---@param y number координата Y
+---@param w number ширина
+---@param h number висота
+---@param color integer колір
+function DrawList:fill_rect(x, y, w, h, color) end
+
+---Додати коло.
+---
+---@param x number координата X центру
+---@param y number координата Y центру
+---@param r number радіус
+---@param color integer колір
+function DrawList:circle(x, y, r, color) end
+
+---Додати зафарбоване коло.
+---
+---@param x number координата X центру
+---@param y number координата Y центру
+---@param r number радіус
+---@param color integer колір
+function DrawList:fill_circle(x, y, r, color) end
+
+---Додати зображення.
+---
+---@param image Image зображення
+---@param x number координата X
+---@param y number координата Y
+function DrawList:image(image, x, y) end
+
+---Зареєструвати зображення у списку та повернути його ідентифікатор для команд ``drawlist.IMAGE``. Один список може посилатися на 32 різні зображення.
+---
+---@param image Image зображення
+---@return integer
+function DrawList:add_image(image) end
+
+---Додати одразу багато команд з плаского масиву.
+---
+---Якщо ``type`` не вказано, кожен запис починається з типу команди: ``{drawlist.PIXEL, x, y, color, drawlist.LINE, x0, y0, x1, y1, color, ...}``. Якщо ``type`` вказано, масив містить лише значення команд цього типу: ``{x, y, color, x, y, color, ...}``.
+---
+---@param records table плаский масив записів
+---@param type? integer тип усіх команд у масиві
+---@usage
+--- local list = drawlist.new()
+--- local stars = {}
+--- for i = 1, 100 do
+---     stars[#stars + 1] = math.random(0, display.width - 1)
+---     stars[#stars + 1] = math.random(0, display.height - 1)
+---     stars[#stars + 1] = display.color565(255, 255, 255)
+--- end
+--- list:add(stars, drawlist.PIXEL)
+--- list:draw()
+function DrawList:add(records, type) end
+
+---Видалити всі команди зі списку. Зареєстровані зображення залишаються.
+function DrawList:clear() end
+
+---Повернути кількість команд у списку (те ж саме, що ``#list``).
+---
+---@return integer
+function DrawList:size() end
+
+---Намалювати всі команди списку на екрані.
+function DrawList:draw() end
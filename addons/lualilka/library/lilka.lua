@@ -1,7 +1,7 @@
 ---@meta
 
 ---@class lilka
----@field show_fps boolean Показувати частоту кадрів на екрані, якщо встановлено в ``true``. Наприклад: ``lilka.show_fps = true``
+---@field show_fps boolean Показувати частоту кадрів, час збирання сміття (GC) та розмір пам'яті Lua на екрані, якщо встановлено в ``true``. Наприклад: ``lilka.show_fps = true``
 ---@field fullscreen boolean Відображати додаток на весь екран (за замовчуванням ``true``). Якщо встановити ``false``, буде видно статусбар. Наприклад: ``lilka.fullscreen = false``
 lilka = {}
 
@@ -0,0 +1,122 @@
+---@meta
+
+---@class tilemap
+---@field EMPTY integer індекс порожньої клітинки (-1), у ній видно колір фону
+tilemap = {}
+
+---Створити нову карту тайлів. Усі клітинки спочатку порожні.
+---
+---Тайлсет - це зображення, на якому тайли однакового розміру розташовані зліва направо та згори донизу. Тайли нумеруються з нуля в тому ж порядку.
+---
+---@param tileset table зображення з тайлами
+---@param tile_width integer ширина тайлу
+---@param tile_height integer висота тайлу
+---@param cols integer ширина карти (в тайлах)
+---@param rows integer висота карти (в тайлах)
+---@return TileMap
+---@usage
+--- local tiles = resources.load_image("tiles.bmp", display.color565(255, 0, 255))
+--- local hero = resources.load_image("hero.bmp", display.color565(255, 0, 255), 8, 15)
+--- local map = tilemap.new(tiles, 16, 16, 64, 32)
+--- map:load(level) -- level - таблиця з 64 * 32 індексів тайлів
+--- local player = map:add_sprite(hero, 40, 40)
+---
+--- function lilka.update(delta)
+---     map:set_scroll(camera_x, camera_y)
+---     map:move_sprite(player, player_x, player_y)
+--- end
+---
+--- function lilka.draw()
+---     map:draw()
+--- end
+function tilemap.new(tileset, tile_width, tile_height, cols, rows) end
+
+---Карта тайлів зі спрайтами.
+---
+---Карта запам'ятовує вже намальовані тайли, тому під час прокрутки малюються лише нові рядки та стовпці, а після ``set`` - лише змінені тайли. Спрайти малюються поверх карти у порядку зростання координати Y, тому нижчі на екрані спрайти перекривають вищі.
+---@class TileMap
+TileMap = {}
+
+---Встановити тайл у клітинці.
+---
+---@param col integer стовпець (з нуля)
+---@param row integer рядок (з нуля)
+---@param tile integer індекс тайлу (з нуля) або ``tilemap.EMPTY``
+function TileMap:set(col, row, tile) end
+
+---Повернути індекс тайлу у клітинці, або ``tilemap.EMPTY``.
+---
+---@param col integer стовпець (з нуля)
+---@param row integer рядок (з нуля)
+---@return integer
+function TileMap:get(col, row) end
+
+---Заповнити всю карту з плаского масиву індексів тайлів, рядок за рядком. ``nil`` означає порожню клітинку.
+---
+---@param tiles table масив з ``cols * rows`` індексів
+function TileMap:load(tiles) end
+
+---Повернути розмір карти в тайлах.
+---
+---@return integer, integer
+function TileMap:size() end
+
+---Перемалювати тайл (або всю карту, якщо клітинку не вказано) під час наступного ``draw``. Потрібно лише якщо змінилися пікселі тайлсету.
+---
+---@param col? integer стовпець (з нуля)
+---@param row? integer рядок (з нуля)
+function TileMap:invalidate(col, row) end
+
+---Встановити колір фону, який видно в порожніх клітинках та прозорих пікселях тайлів.
+---
+---@param color integer колір
+function TileMap:set_background(color) end
+
+---Встановити область екрану, яку займає карта. За замовчуванням карта займає весь екран.
+---
+---@param x integer координата X
+---@param y integer координата Y
+---@param w integer ширина
+---@param h integer висота
+function TileMap:set_viewport(x, y, w, h) end
+
+---Встановити прокрутку: піксель карти, який буде у лівому верхньому куті області.
+---
+---@param x number координата X на карті
+---@param y number координата Y на карті
+function TileMap:set_scroll(x, y) end
+
+---Додати спрайт і повернути його ідентифікатор. Координати спрайта задаються в пікселях карти, з урахуванням півоту зображення.
+---
+---@param image table зображення
+---@param x number координата X на карті
+---@param y number координата Y на карті
+---@return integer
+function TileMap:add_sprite(image, x, y) end
+
+---Перемістити спрайт.
+---
+---@param id integer ідентифікатор спрайта
+---@param x number координата X на карті
+---@param y number координата Y на карті
+function TileMap:move_sprite(id, x, y) end
+
+---Змінити зображення спрайта, наприклад для анімації.
+---
+---@param id integer ідентифікатор спрайта
+---@param image table зображення
+function TileMap:set_sprite_image(id, image) end
+
+---Показати або сховати спрайт.
+---
+---@param id integer ідентифікатор спрайта
+---@param visible boolean чи показувати спрайт
+function TileMap:show_sprite(id, visible) end
+
+---Видалити спрайт. Його ідентифікатор може бути повторно використаний.
+---
+---@param id integer ідентифікатор спрайта
+function TileMap:remove_sprite(id) end
+
+---Намалювати карту та спрайти.
+function TileMap:draw() end
@@ -6948,6 +6948,29 @@ clean:
   return len;
 }
 
+void mjs_array_get_all(struct mjs *mjs, mjs_val_t arr, mjs_val_t *out,
+                       unsigned long len) {
+  struct mjs_property *p;
+  unsigned long i;
+
+  for (i = 0; i < len; i++) {
+    out[i] = MJS_UNDEFINED;
+  }
+  if (!mjs_is_object(arr)) {
+    return;
+  }
+
+  /* Single pass over properties, instead of a lookup per index */
+  for (p = get_object_struct(arr)->properties; p != NULL; p = p->next) {
+    int ok = 0;
+    unsigned long n = 0;
+    str_to_ulong(mjs, p->name, &ok, &n);
+    if (ok && n < len) {
+      out[n] = p->value;
+    }
+  }
+}
+
 mjs_err_t mjs_array_set(struct mjs *mjs, mjs_val_t arr, unsigned long index,
                         mjs_val_t v) {
   mjs_err_t ret = MJS_OK;
@@ -9072,6 +9095,68 @@ clean:
   return error;
 }
 
+mjs_err_t mjs_compile(struct mjs *mjs, const char *path, const char *src,
+                      size_t *off) {
+  size_t start = mjs->bcode_len;
+  mjs->error = mjs_parse(path, src, mjs);
+  if (mjs->error == MJS_OK && off != NULL) *off = start;
+  return mjs->error;
+}
+
+mjs_err_t mjs_get_bcode(struct mjs *mjs, size_t off, const char **bcode,
+                        size_t *len) {
+  struct mjs_bcode_part *bp = mjs_bcode_part_get_by_offset(mjs, off);
+  if (bp == NULL || bp->start_idx != off) {
+    return mjs_set_errorf(mjs, MJS_BAD_ARGS_ERROR, "no bcode at offset %d",
+                          (int) off);
+  }
+  *bcode = bp->data.p;
+  *len = bp->data.len;
+  return MJS_OK;
+}
+
+mjs_err_t mjs_load_bcode(struct mjs *mjs, char *bcode, size_t len,
+                         size_t *off) {
+  struct mjs_bcode_part bp;
+  mjs_header_item_t hdr[MJS_HDR_ITEMS_CNT];
+  const size_t hdr_len = 1 /* OP_BCODE_HEADER */ + sizeof(hdr);
+
+  if (len <= hdr_len || (uint8_t) bcode[0] != OP_BCODE_HEADER) {
+    return mjs_set_errorf(mjs, MJS_BAD_ARGS_ERROR, "invalid bcode");
+  }
+  memcpy(hdr, bcode + 1, sizeof(hdr));
+  if (hdr[MJS_HDR_ITEM_TOTAL_SIZE] + 1 != len ||
+      hdr[MJS_HDR_ITEM_BCODE_OFFSET] <= sizeof(hdr) ||
+      hdr[MJS_HDR_ITEM_BCODE_OFFSET] >= hdr[MJS_HDR_ITEM_MAP_OFFSET] ||
+      hdr[MJS_HDR_ITEM_MAP_OFFSET] >= hdr[MJS_HDR_ITEM_TOTAL_SIZE] ||
+      bcode[hdr[MJS_HDR_ITEM_BCODE_OFFSET]] != '\0') {
+    return mjs_set_errorf(mjs, MJS_BAD_ARGS_ERROR, "invalid bcode");
+  }
+
+  memset(&bp, 0, sizeof(bp));
+  bp.data.p = bcode;
+  bp.data.len = len;
+  bp.start_idx = mjs->bcode_len;
+  bp.exec_res = MJS_ERRS_CNT;
+  mjs_bcode_part_add(mjs, &bp);
+  mjs->bcode_len += len;
+
+  if (off != NULL) *off = bp.start_idx;
+  return MJS_OK;
+}
+
+mjs_err_t mjs_exec_bcode(struct mjs *mjs, size_t off, mjs_val_t *res) {
+  mjs_val_t r = MJS_UNDEFINED;
+  struct mjs_bcode_part *bp = mjs_bcode_part_get_by_offset(mjs, off);
+  if (bp == NULL || bp->start_idx != off) {
+    return mjs_set_errorf(mjs, MJS_BAD_ARGS_ERROR, "no bcode at offset %d",
+                          (int) off);
+  }
+  mjs_execute(mjs, off, &r);
+  if (res != NULL) *res = r;
+  return mjs->error;
+}
+
 mjs_err_t mjs_call(struct mjs *mjs, mjs_val_t *res, mjs_val_t func,
                    mjs_val_t this_val, int nargs, ...) {
   va_list ap;
@@ -341,6 +341,14 @@ mjs_val_t mjs_mk_array(struct mjs *mjs);
 /* Returns length on an array. If `arr` is not an array, 0 is returned. */
 unsigned long mjs_array_length(struct mjs *mjs, mjs_val_t arr);
 
+/*
+ * Fill `out` with the first `len` members of array `arr`, missing members
+ * are set to undefined. Unlike calling `mjs_array_get()` for each index, the
+ * array is walked only once.
+ */
+void mjs_array_get_all(struct mjs *mjs, mjs_val_t arr, mjs_val_t *out,
+                       unsigned long len);
+
 /* Insert value `v` in array `arr` at the end of the array. */
 mjs_err_t mjs_array_push(struct mjs *mjs, mjs_val_t arr, mjs_val_t v);
 
@@ -616,6 +624,37 @@ mjs_err_t mjs_exec(struct mjs *, const char *src, mjs_val_t *res);
 mjs_err_t mjs_exec_buf(struct mjs *, const char *src, size_t, mjs_val_t *res);
 
 mjs_err_t mjs_exec_file(struct mjs *mjs, const char *path, mjs_val_t *res);
+
+/*
+ * Compiles `src` into a new bcode part without executing it. On success,
+ * offset of the part is stored in `off`; it can be passed to
+ * `mjs_get_bcode()` and `mjs_exec_bcode()`.
+ */
+mjs_err_t mjs_compile(struct mjs *mjs, const char *path, const char *src,
+                      size_t *off);
+
+/*
+ * Returns data of the bcode part at offset `off`, as produced by
+ * `mjs_compile()`. The data is owned by mJS and stays valid until
+ * `mjs_destroy()`.
+ */
+mjs_err_t mjs_get_bcode(struct mjs *mjs, size_t off, const char **bcode,
+                        size_t *len);
+
+/*
+ * Adds previously compiled bcode (see `mjs_get_bcode()`) as a new bcode part.
+ * `bcode` must be allocated with `malloc()`; on success mJS takes ownership
+ * of it. Bcode is expected to come from the same mJS build, only its header
+ * is validated.
+ */
+mjs_err_t mjs_load_bcode(struct mjs *mjs, char *bcode, size_t len,
+                         size_t *off);
+
+/*
+ * Executes bcode part at offset `off`.
+ */
+mjs_err_t mjs_exec_bcode(struct mjs *mjs, size_t off, mjs_val_t *res);
+
 mjs_err_t mjs_apply(struct mjs *mjs, mjs_val_t *res, mjs_val_t func,
                     mjs_val_t this_val, int nargs, mjs_val_t *args);
 mjs_err_t mjs_call(struct mjs *mjs, mjs_val_t *res, mjs_val_t func,
@@ -9,6 +9,8 @@ FileManagerApp::FileManagerApp(const String& path) :
     dirLoadProgress(K_S_FMANAGER_LOADING, "") {
     // MISC APP OPTIONS:
     setktStackSize(8192);
+    // Menus mostly move cursor around
+    setFlags(AppFlags::APP_FLAG_DEFAULT | AppFlags::APP_FLAG_DAMAGE_DIFF);
     // FILE OPTIONS MENU SETUP:
     fileOptionsMenu.setTitle(K_S_FMANAGER_OPTIONS);
     fileOptionsMenu.addItem(
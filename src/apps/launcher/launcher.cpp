@@ -1,7 +1,6 @@
 #include <ff.h>
 #include <FS.h>
 #include <qrcode.h>
-#include "keira/utils/mem.h"
 #include "keira/keira.h"
 #include "launcher.h"
 #include "keira/appmanager.h"
@@ -27,6 +26,8 @@
 #include "apps/tests/scan_i2c/scan_i2c.h"
 #include "apps/tests/callbacktest/callbacktest.h"
 #include "apps/tests/combo/combo.h"
+#include "apps/tests/vfsbench/vfsbench.h"
+#include "apps/tests/drawbench/drawbench.h"
 // Apps
 #include "apps/statusbar/statusbar.h"
 #include "apps/wificonfig/wificonfig.h"
@@ -39,6 +40,7 @@
 #include "apps/weather/weather.h"
 #include "apps/madplayer/madplayer.h"
 #include "apps/lilcatalog/lilcatalog.h"
+#include "apps/lilcatalog/installed_index.h"
 #include "apps/liltracker/liltracker.h"
 #include "apps/fmanager/fmanager.h"
 #include "apps/pastebin/pastebinApp.h"
@@ -65,6 +67,8 @@
 
 LauncherApp::LauncherApp() : App("Launcher") {
     setktStackSize(8192); // Yeah, this one is heavy as fuck
+    // Menus mostly move cursor around
+    setFlags(AppFlags::APP_FLAG_DEFAULT | AppFlags::APP_FLAG_DAMAGE_DIFF);
 }
 
 void LauncherApp::run() {
@@ -102,6 +106,8 @@ void LauncherApp::run() {
                 ITEM::APP(K_S_LAUNCHER_I2C_SCANNER, [this]() { this->runApp<ScanI2CApp>(); }),
                 ITEM::APP(K_S_LAUNCHER_COMBO, [this]() { this->runApp<ComboApp>(); }),
                 ITEM::APP(K_S_LAUNCHER_CALLBACK_TEST, [this]() { this->runApp<CallBackTestApp>(); }),
+                ITEM::APP(K_S_LAUNCHER_VFS_BENCH, [this]() { this->runApp<VFSBenchApp>(); }),
+                ITEM::APP(K_S_LAUNCHER_DRAW_BENCH, [this]() { this->runApp<DrawBenchApp>(); }),
             },
             &app_group_img,
             lilka::colors::White
@@ -359,6 +365,30 @@ void LauncherApp::run() {
                                     }
                                 }
                             ),
+                            ITEM::MENU(
+                                K_S_LAUNCHER_CPU,
+                                [this]() {
+                                    auto statusBar = static_cast<StatusBarApp*>(ksystem.apps.getpanel());
+                                    statusBar->setCpuMode((statusBar->getCpuMode() + 1));
+                                },
+                                nullptr,
+                                lilka::colors::White,
+                                [this](void* item) {
+                                    lilka::MenuItem* menuItem = static_cast<lilka::MenuItem*>(item);
+                                    auto statusBar = static_cast<StatusBarApp*>(ksystem.apps.getpanel());
+                                    switch (statusBar->getCpuMode()) {
+                                        case 0:
+                                            menuItem->postfix = K_S_LAUNCHER_CPU_0;
+                                            break;
+                                        case 1:
+                                            menuItem->postfix = K_S_LAUNCHER_CPU_1;
+                                            break;
+                                        default:
+                                            menuItem->postfix = K_S_LAUNCHER_CPU_2;
+                                            break;
+                                    }
+                                }
+                            ),
                             ITEM::MENU(
                                 K_S_LAUNCHER_NETWORK,
                                 [this]() {
@@ -473,108 +503,19 @@ void LauncherApp::runApp(Args&&... args) {
 }
 
 ITEM_LIST LauncherApp::loadCatalogItems() {
-    struct ScanEntry {
-        String name;
-        String execPath;
-        ExecutionType type;
-    };
-    std::vector<ScanEntry> scanned;
-
-    DIR* dir = opendir("/sd/lilcatalog/manifests");
-    if (!dir) {
+    // Index is rebuilt from manifests only when they've changed since it was saved
+    InstalledIndex index;
+    if (!index.load()) {
         return {};
     }
 
-    const struct dirent* de;
-    while ((de = readdir(dir)) != nullptr) {
-        String filename = de->d_name;
-        if (!filename.endsWith(".json")) {
-            continue;
-        }
-
-        String entryId = filename.substring(0, filename.length() - 5);
-        String manifestPath = "/sd/lilcatalog/manifests/" + filename;
-
-        FILE* f = fopen(manifestPath.c_str(), "r");
-        if (!f) {
-            continue;
-        }
-
-        fseek(f, 0, SEEK_END);
-        long fileSize = ftell(f);
-        fseek(f, 0, SEEK_SET);
-
-        if (fileSize <= 0 || fileSize > 8192) {
-            fclose(f);
-            continue;
-        }
-
-        String json;
-        char buf[256];
-        size_t n;
-        while ((n = fread(buf, 1, sizeof(buf) - 1, f)) > 0) {
-            buf[n] = '\0';
-            json += buf;
-        }
-        fclose(f);
-
-        JsonDocument doc(&spiRamAllocator);
-        if (deserializeJson(doc, json)) {
-            continue;
-        }
-
-        String name = doc["name"].as<String>();
-        if (name.isEmpty()) {
-            continue;
-        }
-
-        String execTypeStr;
-        String execLocation;
-        if (doc.containsKey("entryfile")) {
-            execTypeStr = doc["entryfile"]["type"].as<String>();
-            execLocation = doc["entryfile"]["location"].as<String>();
-        }
-        if (execLocation.isEmpty()) {
-            continue;
-        }
-
-        String execPath = "/sd/lilcatalog/" + entryId + "/" + execLocation;
-        FILE* execCheck = fopen(execPath.c_str(), "r");
-        if (!execCheck) {
-            continue;
-        }
-        fclose(execCheck);
-
-        ExecutionType execType = EXEC_TYPE_UNKNOWN;
-        if (execTypeStr == "lua") {
-            execType = EXEC_TYPE_LUA;
-        } else if (execTypeStr == "binary") {
-            execType = EXEC_TYPE_BINARY;
-        } else if (execTypeStr == "dynapp" || execTypeStr == "so") {
-            execType = EXEC_TYPE_DYNAPP;
-        } else {
-            String loc = execLocation;
-            loc.toLowerCase();
-            if (loc.endsWith(".lua")) execType = EXEC_TYPE_LUA;
-            else if (loc.endsWith(".bin")) execType = EXEC_TYPE_BINARY;
-            else if (loc.endsWith(".so")) execType = EXEC_TYPE_DYNAPP;
-        }
-
-        if (execType == EXEC_TYPE_UNKNOWN) {
-            continue;
-        }
-
-        scanned.push_back({name, execPath, execType});
-    }
-    closedir(dir);
-
     ITEM_LIST items;
-    catalogItemNames_.reserve(scanned.size());
-    for (auto& e : scanned) {
-        catalogItemNames_.push_back(e.name);
+    catalogItemNames_.reserve(index.size());
+    for (uint16_t i = 0; i < index.size(); i++) {
+        catalogItemNames_.push_back(index.getName(i));
         const char* nameCStr = catalogItemNames_.back().c_str();
-        String execPath = e.execPath;
-        ExecutionType execType = e.type;
+        String execPath = index.getExecutablePath(i);
+        ExecutionType execType = index.getType(i);
         items.push_back(
             ITEM::APP(
                 nameCStr,
@@ -234,6 +234,7 @@ void LetrisApp::run() {
             }
         }
         queueDraw();
+        waitNextFrame();
     }
 
     // Очищаємо екран
@@ -309,6 +310,8 @@ void LetrisApp::run() {
                 queueDraw();
                 // Відображаємо зміни на екрані
                 // lilka::display.drawCanvas(canvas);
+                // Чекаємо наступного кадру, щоб не навантажувати процесор
+                waitNextFrame();
             }
 
             // Перевіряємо, чи може фігура рухатися вниз
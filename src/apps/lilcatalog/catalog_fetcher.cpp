@@ -0,0 +1,345 @@
+#include "catalog_fetcher.h"
+#include <WiFi.h>
+
+static const char* catalog_fetcher_headers[] = {"ETag", "Last-Modified"};
+
+CatalogFetcher::CatalogFetcher() :
+    poolMutex(xSemaphoreCreateMutex()),
+    poolFree(xSemaphoreCreateCounting(CATALOG_CONNECTION_COUNT, CATALOG_CONNECTION_COUNT)),
+    cacheMutex(xSemaphoreCreateMutex()),
+    jobMutex(xSemaphoreCreateMutex()),
+    jobGeneration(0),
+    runningGeneration(0),
+    runningTask(NULL),
+    jobCount(0) {
+    for (int i = 0; i < CATALOG_CONNECTION_COUNT; i++) {
+        connections[i] = {NULL, NULL, "", false, false};
+    }
+}
+
+CatalogFetcher::~CatalogFetcher() {
+    cancel();
+    // Jobs use this fetcher until their task ends, and a request in flight can't be interrupted
+    while (jobCount > 0) {
+        vTaskDelay(pdMS_TO_TICKS(CATALOG_IN_FLIGHT_POLL_MS));
+    }
+    for (int i = 0; i < CATALOG_CONNECTION_COUNT; i++) {
+        if (connections[i].http) {
+            connections[i].http->end();
+            delete connections[i].http;
+        }
+        if (connections[i].client) {
+            connections[i].client->stop();
+            delete connections[i].client;
+        }
+    }
+    vSemaphoreDelete(poolMutex);
+    vSemaphoreDelete(poolFree);
+    vSemaphoreDelete(cacheMutex);
+    vSemaphoreDelete(jobMutex);
+}
+
+String CatalogFetcher::getHost(const String& url) {
+    int start = url.indexOf("://");
+    start = start < 0 ? 0 : start + 3;
+    int end = url.indexOf('/', start);
+    return end < 0 ? url.substring(start) : url.substring(start, end);
+}
+
+CatalogFetcher::connection_t* CatalogFetcher::acquire(const String& url) {
+    String host = getHost(url);
+    bool secure = url.startsWith("https://");
+
+    xSemaphoreTake(poolFree, portMAX_DELAY);
+    xSemaphoreTake(poolMutex, portMAX_DELAY);
+    // Prefer connection that is already open to this host
+    connection_t* connection = NULL;
+    for (int i = 0; i < CATALOG_CONNECTION_COUNT; i++) {
+        connection_t* candidate = &connections[i];
+        if (!candidate->busy && (!connection || (candidate->host == host && candidate->secure == secure))) {
+            connection = candidate;
+        }
+    }
+    connection->busy = true;
+    xSemaphoreGive(poolMutex);
+
+    if (connection->client && (connection->host != host || connection->secure != secure)) {
+        connection->http->end();
+        connection->client->stop();
+        delete connection->http;
+        delete connection->client;
+        connection->client = NULL;
+        connection->http = NULL;
+    }
+    if (!connection->client) {
+        if (secure) {
+            WiFiClientSecure* client = new WiFiClientSecure();
+            client->setInsecure();
+            connection->client = client;
+        } else {
+            // Plain HTTP is only used with a local catalog server during development
+            connection->client = new WiFiClient();
+        }
+        connection->http = new HTTPClient();
+        connection->http->setReuse(true);
+        connection->host = host;
+        connection->secure = secure;
+    }
+    return connection;
+}
+
+void CatalogFetcher::release(connection_t* connection, bool keepAlive) {
+    connection->http->end();
+    if (!keepAlive) {
+        // Response wasn't read to the end, connection can't be reused
+        connection->client->stop();
+    }
+    xSemaphoreTake(poolMutex, portMAX_DELAY);
+    connection->busy = false;
+    xSemaphoreGive(poolMutex);
+    xSemaphoreGive(poolFree);
+}
+
+bool CatalogFetcher::isValidated(const String& cachePath) {
+    xSemaphoreTake(cacheMutex, portMAX_DELAY);
+    bool result = validated.count(cachePath) > 0;
+    xSemaphoreGive(cacheMutex);
+    return result;
+}
+
+void CatalogFetcher::setValidated(const String& cachePath) {
+    xSemaphoreTake(cacheMutex, portMAX_DELAY);
+    validated.insert(cachePath);
+    xSemaphoreGive(cacheMutex);
+}
+
+catalog_cache_meta CatalogFetcher::readMeta(const String& cachePath) {
+    catalog_cache_meta meta;
+    fs::File file = SD.open(cachePath + CATALOG_CACHE_META_EXTENSION, FILE_READ);
+    if (file) {
+        meta.etag = file.readStringUntil('\n');
+        meta.lastModified = file.readStringUntil('\n');
+        file.close();
+    }
+    return meta;
+}
+
+void CatalogFetcher::writeMeta(const String& cachePath, const catalog_cache_meta& meta) {
+    String metaPath = cachePath + CATALOG_CACHE_META_EXTENSION;
+    if (meta.etag.isEmpty() && meta.lastModified.isEmpty()) {
+        SD.remove(metaPath);
+        return;
+    }
+    fs::File file = SD.open(metaPath, FILE_WRITE);
+    if (file) {
+        file.print(meta.etag + "\n" + meta.lastModified + "\n");
+        file.close();
+    }
+}
+
+void CatalogFetcher::lockPath(const String& cachePath) {
+    while (true) {
+        xSemaphoreTake(cacheMutex, portMAX_DELAY);
+        bool locked = inFlight.insert(cachePath).second;
+        xSemaphoreGive(cacheMutex);
+        if (locked) {
+            return;
+        }
+        vTaskDelay(pdMS_TO_TICKS(CATALOG_IN_FLIGHT_POLL_MS));
+    }
+}
+
+void CatalogFetcher::unlockPath(const String& cachePath) {
+    xSemaphoreTake(cacheMutex, portMAX_DELAY);
+    inFlight.erase(cachePath);
+    xSemaphoreGive(cacheMutex);
+}
+
+catalog_fetch_result_t CatalogFetcher::fetch(const String& url, const String& cachePath, int timeout) {
+    // Held for the whole request: temp file, cached file and its meta belong to one fetch at a time.
+    // Whoever waited usually finds the file already validated and doesn't ask server again
+    lockPath(cachePath);
+    catalog_fetch_result_t result = fetchLocked(url, cachePath, timeout);
+    unlockPath(cachePath);
+    return result;
+}
+
+catalog_fetch_result_t CatalogFetcher::fetchLocked(const String& url, const String& cachePath, int timeout) {
+    bool cached = SD.exists(cachePath);
+    if (cached && isValidated(cachePath)) {
+        return CATALOG_FETCH_CACHED;
+    }
+    if (WiFi.status() != WL_CONNECTED) {
+        return cached ? CATALOG_FETCH_CACHED : CATALOG_FETCH_FAILED;
+    }
+
+    connection_t* connection = acquire(url);
+    HTTPClient* http = connection->http;
+    http->begin(*connection->client, url);
+    http->setTimeout(timeout);
+    http->collectHeaders(catalog_fetcher_headers, 2);
+    if (cached) {
+        catalog_cache_meta meta = readMeta(cachePath);
+        if (meta.etag.length()) {
+            http->addHeader("If-None-Match", meta.etag);
+        }
+        if (meta.lastModified.length()) {
+            http->addHeader("If-Modified-Since", meta.lastModified);
+        }
+    }
+
+    int httpCode = http->GET();
+    if (httpCode == HTTP_CODE_NOT_MODIFIED && cached) {
+        release(connection, true);
+        setValidated(cachePath);
+        return CATALOG_FETCH_NOT_MODIFIED;
+    }
+    if (httpCode != HTTP_CODE_OK) {
+        lilka::serial.err("HTTP GET failed: %s, code: %d", url.c_str(), httpCode);
+        // Error body is not read, so connection is not reused
+        release(connection, false);
+        return cached ? CATALOG_FETCH_CACHED : CATALOG_FETCH_FAILED;
+    }
+
+    // New copy replaces cached one only when it's complete
+    String tempPath = cachePath + CATALOG_CACHE_TEMP_EXTENSION;
+    lilka::fileutils.makePath(&SD, lilka::fileutils.getParentDirectory(cachePath));
+    fs::File file = SD.open(tempPath, FILE_WRITE);
+    int written = file ? http->writeToStream(&file) : -1;
+    bool complete = written >= 0 && (http->getSize() < 0 || written == http->getSize());
+    if (file) {
+        file.close();
+    }
+    catalog_cache_meta meta = {http->header("ETag"), http->header("Last-Modified")};
+    release(connection, complete);
+
+    // Cache may have been cleared after job was cancelled, so its download doesn't go in
+    if (!complete || isCancelled()) {
+        SD.remove(tempPath);
+        return cached ? CATALOG_FETCH_CACHED : CATALOG_FETCH_FAILED;
+    }
+    SD.remove(cachePath);
+    bool renamed = SD.rename(tempPath, cachePath);
+    if (renamed) {
+        writeMeta(cachePath, meta);
+        setValidated(cachePath);
+    }
+    return renamed ? CATALOG_FETCH_UPDATED : CATALOG_FETCH_FAILED;
+}
+
+String CatalogFetcher::get(const String& url, int timeout) {
+    if (WiFi.status() != WL_CONNECTED) {
+        return "";
+    }
+    connection_t* connection = acquire(url);
+    HTTPClient* http = connection->http;
+    http->begin(*connection->client, url);
+    http->setTimeout(timeout);
+
+    int httpCode = http->GET();
+    String result = "";
+    if (httpCode == HTTP_CODE_OK) {
+        result = http->getString();
+    } else {
+        lilka::serial.err("HTTP GET failed: %s, code: %d", url.c_str(), httpCode);
+    }
+    release(connection, httpCode == HTTP_CODE_OK);
+    return result;
+}
+
+int CatalogFetcher::download(
+    const String& url, const String& path, int timeout, std::function<void(size_t, size_t)> progress
+) {
+    if (WiFi.status() != WL_CONNECTED) {
+        return HTTPC_ERROR_NOT_CONNECTED;
+    }
+    connection_t* connection = acquire(url);
+    HTTPClient* http = connection->http;
+    http->begin(*connection->client, url);
+    http->setTimeout(timeout);
+
+    int httpCode = http->GET();
+    if (httpCode != HTTP_CODE_OK) {
+        release(connection, false);
+        return httpCode;
+    }
+
+    fs::File file = SD.open(path, FILE_WRITE);
+    if (!file) {
+        release(connection, false);
+        return HTTPC_ERROR_STREAM_WRITE;
+    }
+
+    int size = http->getSize();
+    bool complete;
+    if (size < 0) {
+        // Chunked response, HTTPClient decodes it but can't report progress
+        complete = http->writeToStream(&file) >= 0;
+    } else {
+        uint8_t buffer[CATALOG_DOWNLOAD_BUFFER_SIZE];
+        WiFiClient* stream = http->getStreamPtr();
+        int written = 0;
+        uint32_t lastData = millis();
+        while (written < size && http->connected() && millis() - lastData < static_cast<uint32_t>(timeout)) {
+            size_t available = stream->available();
+            if (!available) {
+                vTaskDelay(1);
+                continue;
+            }
+            size_t toRead = available < sizeof(buffer) ? available : sizeof(buffer);
+            size_t actualRead = stream->readBytes(buffer, toRead);
+            if (file.write(buffer, actualRead) != actualRead) {
+                break;
+            }
+            written += actualRead;
+            lastData = millis();
+            if (progress) {
+                progress(written, size);
+            }
+        }
+        complete = written == size;
+    }
+    file.close();
+    release(connection, complete);
+    if (!complete) {
+        SD.remove(path);
+        return HTTPC_ERROR_READ_TIMEOUT;
+    }
+    return httpCode;
+}
+
+void CatalogFetcher::jobTask(void* arg) {
+    job_t* job = static_cast<job_t*>(arg);
+    CatalogFetcher* fetcher = job->fetcher;
+    xSemaphoreTake(fetcher->jobMutex, portMAX_DELAY);
+    fetcher->runningGeneration = job->generation;
+    fetcher->runningTask = xTaskGetCurrentTaskHandle();
+    // Job cancelled while waiting for the previous one doesn't run at all
+    if (!fetcher->isCancelled()) {
+        job->job();
+    }
+    fetcher->runningTask = NULL;
+    xSemaphoreGive(fetcher->jobMutex);
+    delete job;
+    // Fetcher may be gone after this
+    fetcher->jobCount--;
+    vTaskDelete(NULL);
+}
+
+void CatalogFetcher::runInBackground(std::function<void()> job) {
+    cancel();
+    job_t* context = new job_t{this, job, jobGeneration};
+    jobCount++;
+    if (xTaskCreate(jobTask, "catalogFetch", CATALOG_PREFETCH_STACK_SIZE, context, 1, NULL) != pdPASS) {
+        jobCount--;
+        delete context;
+    }
+}
+
+void CatalogFetcher::cancel() {
+    jobGeneration++;
+}
+
+bool CatalogFetcher::isCancelled() {
+    return runningTask == xTaskGetCurrentTaskHandle() && runningGeneration != jobGeneration;
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <set>
+#include <lilka.h>
+#include <HTTPClient.h>
+#include <WiFiClientSecure.h>
+
+// Connections kept open between requests. One is normally used by UI and one by prefetch job
+#define CATALOG_CONNECTION_COUNT     2
+#define CATALOG_PREFETCH_STACK_SIZE  12288
+#define CATALOG_CACHE_META_EXTENSION ".meta"
+#define CATALOG_CACHE_TEMP_EXTENSION ".tmp"
+// Download buffer size, it's on the stack of the calling task
+#define CATALOG_DOWNLOAD_BUFFER_SIZE 2048
+// How often fetch checks whether another task is done with the same cached file
+#define CATALOG_IN_FLIGHT_POLL_MS 10
+
+typedef enum {
+    CATALOG_FETCH_FAILED,
+    // Cached copy is returned without asking server: already revalidated in this session, or offline
+    CATALOG_FETCH_CACHED,
+    CATALOG_FETCH_NOT_MODIFIED,
+    CATALOG_FETCH_UPDATED,
+} catalog_fetch_result_t;
+
+// Validators of cached file, stored next to it in "<file>.meta": ETag on first line, Last-Modified on second
+typedef struct {
+    String etag;
+    String lastModified;
+} catalog_cache_meta;
+
+// HTTP access for catalog. Connections are kept alive and reused for the same host, so a page of
+// entries costs one TLS handshake instead of one per request. Cached files are revalidated with
+// If-None-Match/If-Modified-Since once per session. Background job (e.g. prefetch of the next page)
+// runs in its own task on a separate connection.
+class CatalogFetcher {
+public:
+    CatalogFetcher();
+    ~CatalogFetcher();
+
+    // Makes sure cachePath holds up-to-date copy of url. Falls back to cached copy if server can't be reached
+    catalog_fetch_result_t fetch(const String& url, const String& cachePath, int timeout);
+    // GET without caching. Returns empty string on failure
+    String get(const String& url, int timeout);
+    // Downloads url into path. Returns HTTP status code, or negative HTTPClient error
+    int download(
+        const String& url, const String& path, int timeout, std::function<void(size_t, size_t)> progress = nullptr
+    );
+
+    // Runs job in background task, cancelling the previous one. Job should check isCancelled() between requests.
+    // New job starts once the previous one has finished its current request
+    void runInBackground(std::function<void()> job);
+    // Cancels background job without waiting for it, request it's in is finished by its own task
+    void cancel();
+    // True inside a job that was cancelled or replaced by a newer one
+    bool isCancelled();
+
+    static catalog_cache_meta readMeta(const String& cachePath);
+    static void writeMeta(const String& cachePath, const catalog_cache_meta& meta);
+
+private:
+    typedef struct {
+        CatalogFetcher* fetcher;
+        std::function<void()> job;
+        uint32_t generation;
+    } job_t;
+
+    typedef struct {
+        WiFiClient* client;
+        HTTPClient* http;
+        String host;
+        bool secure;
+        bool busy;
+    } connection_t;
+
+    static String getHost(const String& url);
+    connection_t* acquire(const String& url);
+    void release(connection_t* connection, bool keepAlive);
+    bool isValidated(const String& cachePath);
+    void setValidated(const String& cachePath);
+    void lockPath(const String& cachePath);
+    void unlockPath(const String& cachePath);
+    catalog_fetch_result_t fetchLocked(const String& url, const String& cachePath, int timeout);
+    static void jobTask(void* arg);
+
+    connection_t connections[CATALOG_CONNECTION_COUNT];
+    SemaphoreHandle_t poolMutex;
+    SemaphoreHandle_t poolFree;
+    // Guards validated and inFlight sets
+    SemaphoreHandle_t cacheMutex;
+    std::set<String> validated;
+    // Cached files being fetched. UI and job may fetch the same file, the second one waits for the first
+    std::set<String> inFlight;
+
+    // Held by the running job, so jobs never run side by side
+    SemaphoreHandle_t jobMutex;
+    // Bumped by cancel(), jobs started before that are cancelled
+    std::atomic<uint32_t> jobGeneration;
+    uint32_t runningGeneration;
+    std::atomic<TaskHandle_t> runningTask;
+    // Job tasks not finished yet, including ones waiting for jobMutex
+    std::atomic<int> jobCount;
+};
@@ -0,0 +1,19 @@
+#pragma once
+
+// Definitions shared by catalog app and installed apps index, which is also used by launcher
+
+// Cache paths
+#define CATALOG_ICON_CACHE_FOLDER           "/lilcatalog/icons"
+#define CATALOG_MANIFEST_CACHE_FOLDER       "/lilcatalog/manifests"
+#define CATALOG_SHORT_MANIFEST_CACHE_FOLDER "/lilcatalog/short_manifests"
+#define CATALOG_PAGE_CACHE_FOLDER           "/lilcatalog/pages"
+
+// Execution file types
+typedef enum {
+    EXEC_TYPE_UNKNOWN,
+    EXEC_TYPE_LUA,
+    EXEC_TYPE_BINARY,
+    EXEC_TYPE_ARCHIVE,
+    EXEC_TYPE_IMAGE,
+    EXEC_TYPE_DYNAPP
+} ExecutionType;
@@ -0,0 +1,381 @@
+#include "installed_index.h"
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include "keira/utils/mem.h"
+
+InstalledIndex::InstalledIndex() : data(NULL), header(NULL), records(NULL), strings(NULL) {
+}
+
+InstalledIndex::~InstalledIndex() {
+    release();
+}
+
+void InstalledIndex::release() {
+    spiRamAllocator.deallocate(data);
+    data = NULL;
+    header = NULL;
+    records = NULL;
+    strings = NULL;
+}
+
+String InstalledIndex::getPath() {
+    return lilka::fileutils.getSDRoot() + CATALOG_INSTALLED_INDEX_FILE;
+}
+
+String InstalledIndex::getBackupPath() {
+    return getPath() + ".bak";
+}
+
+uint32_t InstalledIndex::hashName(const char* name) {
+    uint32_t hash = 2166136261u;
+    while (*name) {
+        hash = (hash ^ static_cast<uint8_t>(*name++)) * 16777619u;
+    }
+    return hash;
+}
+
+uint32_t InstalledIndex::checksum(const uint8_t* data, size_t size) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ data[i]) * 16777619u;
+    }
+    return hash;
+}
+
+InstalledIndex::signature_t InstalledIndex::getSignature() {
+    // Sum of name hashes doesn't depend on directory order, and a single file can be added or
+    // subtracted from it, which is what update() relies on
+    signature_t signature = {0, 0};
+    String folder = lilka::fileutils.getSDRoot() + CATALOG_MANIFEST_CACHE_FOLDER;
+    DIR* dir = opendir(folder.c_str());
+    if (!dir) {
+        return signature;
+    }
+    const struct dirent* de;
+    while ((de = readdir(dir)) != NULL) {
+        size_t length = strlen(de->d_name);
+        if (length > 5 && strcmp(de->d_name + length - 5, ".json") == 0) {
+            signature.count++;
+            signature.hash += hashName(de->d_name);
+        }
+    }
+    closedir(dir);
+    return signature;
+}
+
+ExecutionType InstalledIndex::resolveType(ExecutionType type, const String& location) {
+    if (type == EXEC_TYPE_LUA || type == EXEC_TYPE_BINARY || type == EXEC_TYPE_DYNAPP) {
+        return type;
+    }
+    String loc = location;
+    loc.toLowerCase();
+    if (loc.endsWith(".lua")) return EXEC_TYPE_LUA;
+    if (loc.endsWith(".bin")) return EXEC_TYPE_BINARY;
+    if (loc.endsWith(".so")) return EXEC_TYPE_DYNAPP;
+    return EXEC_TYPE_UNKNOWN;
+}
+
+uint8_t* InstalledIndex::build(const std::vector<catalog_installed_app>& apps, signature_t signature, size_t* size) {
+    uint32_t stringsSize = 0;
+    for (const auto& app : apps) {
+        stringsSize += app.id.length() + app.name.length() + app.location.length() + 3;
+    }
+    *size = sizeof(catalog_index_header_t) + apps.size() * sizeof(catalog_index_record_t) + stringsSize;
+    uint8_t* buffer = static_cast<uint8_t*>(spiRamAllocator.allocate(*size));
+    if (!buffer) {
+        return NULL;
+    }
+    memset(buffer, 0, *size);
+
+    catalog_index_header_t* header = reinterpret_cast<catalog_index_header_t*>(buffer);
+    catalog_index_record_t* records = reinterpret_cast<catalog_index_record_t*>(header + 1);
+    char* strings = reinterpret_cast<char*>(records + apps.size());
+    uint32_t offset = 0;
+    auto addString = [strings, &offset](const String& str) {
+        uint32_t start = offset;
+        memcpy(strings + offset, str.c_str(), str.length() + 1);
+        offset += str.length() + 1;
+        return start;
+    };
+    for (size_t i = 0; i < apps.size(); i++) {
+        records[i].id = addString(apps[i].id);
+        records[i].name = addString(apps[i].name);
+        records[i].location = addString(apps[i].location);
+        records[i].type = apps[i].type;
+    }
+
+    memcpy(header->magic, CATALOG_INSTALLED_INDEX_MAGIC, 4);
+    header->version = CATALOG_INSTALLED_INDEX_VERSION;
+    header->count = apps.size();
+    header->manifestCount = signature.count;
+    header->manifestHash = signature.hash;
+    header->stringsSize = stringsSize;
+    header->checksum = checksum(buffer + sizeof(catalog_index_header_t), *size - sizeof(catalog_index_header_t));
+    return buffer;
+}
+
+bool InstalledIndex::save(const uint8_t* buffer, size_t size) {
+    // Written next to the old index, so a failed write leaves the old one intact. FAT can't rename
+    // over an existing file, so the old index is moved aside and removed only after the new one is
+    // in place. If power is lost in between, read() picks up the old one
+    String path = getPath();
+    String tempPath = path + ".tmp";
+    String backupPath = getBackupPath();
+    FILE* file = fopen(tempPath.c_str(), "wb");
+    if (!file) {
+        return false;
+    }
+    bool ok = fwrite(buffer, 1, size, file) == size;
+    ok = fclose(file) == 0 && ok;
+    if (ok) {
+        // Without current index, backup left by interrupted save is the latest one, and is kept
+        struct stat st;
+        bool backedUp = false;
+        if (stat(path.c_str(), &st) == 0) {
+            ::remove(backupPath.c_str());
+            backedUp = rename(path.c_str(), backupPath.c_str()) == 0;
+        }
+        ok = rename(tempPath.c_str(), path.c_str()) == 0;
+        if (ok) {
+            ::remove(backupPath.c_str());
+        } else if (backedUp) {
+            rename(backupPath.c_str(), path.c_str());
+        }
+    }
+    if (!ok) {
+        lilka::serial.err("LilCatalog: failed to save installed apps index");
+        ::remove(tempPath.c_str());
+    }
+    return ok;
+}
+
+bool InstalledIndex::adopt(uint8_t* buffer, size_t size) {
+    release();
+    const catalog_index_header_t* h = reinterpret_cast<const catalog_index_header_t*>(buffer);
+    bool valid = size >= sizeof(catalog_index_header_t) &&
+                 memcmp(h->magic, CATALOG_INSTALLED_INDEX_MAGIC, 4) == 0 &&
+                 h->version == CATALOG_INSTALLED_INDEX_VERSION &&
+                 size == sizeof(catalog_index_header_t) + h->count * sizeof(catalog_index_record_t) + h->stringsSize &&
+                 (!h->stringsSize || buffer[size - 1] == 0) &&
+                 h->checksum ==
+                     checksum(buffer + sizeof(catalog_index_header_t), size - sizeof(catalog_index_header_t));
+    const catalog_index_record_t* r = reinterpret_cast<const catalog_index_record_t*>(h + 1);
+    for (uint16_t i = 0; valid && i < h->count; i++) {
+        valid = r[i].id < h->stringsSize && r[i].name < h->stringsSize && r[i].location < h->stringsSize;
+    }
+    if (!valid) {
+        spiRamAllocator.deallocate(buffer);
+        return false;
+    }
+    data = buffer;
+    header = h;
+    records = r;
+    strings = reinterpret_cast<const char*>(r + h->count);
+    return true;
+}
+
+bool InstalledIndex::read() {
+    FILE* file = fopen(getPath().c_str(), "rb");
+    if (!file) {
+        // Interrupted save() leaves only the previous index, signature check tells if it's still valid
+        file = fopen(getBackupPath().c_str(), "rb");
+    }
+    if (!file) {
+        return false;
+    }
+    struct stat st;
+    uint8_t* buffer = NULL;
+    bool ok = fstat(fileno(file), &st) == 0 && st.st_size > 0;
+    if (ok) {
+        buffer = static_cast<uint8_t*>(spiRamAllocator.allocate(st.st_size));
+        ok = buffer && fread(buffer, 1, st.st_size, file) == static_cast<size_t>(st.st_size);
+    }
+    fclose(file);
+    if (!ok) {
+        spiRamAllocator.deallocate(buffer);
+        return false;
+    }
+    return adopt(buffer, st.st_size);
+}
+
+bool InstalledIndex::matches(signature_t signature) const {
+    return header && header->manifestCount == signature.count && header->manifestHash == signature.hash;
+}
+
+bool InstalledIndex::rebuild(signature_t signature) {
+    lilka::serial.log("LilCatalog: rebuilding installed apps index");
+    release();
+
+    std::vector<catalog_installed_app> apps;
+    String root = lilka::fileutils.getSDRoot();
+    String folder = root + CATALOG_MANIFEST_CACHE_FOLDER;
+    DIR* dir = opendir(folder.c_str());
+    char* json = static_cast<char*>(malloc(CATALOG_INSTALLED_MANIFEST_MAX_SIZE));
+    if (dir && json) {
+        // Only these fields are kept, the rest of manifest is skipped while parsing
+        JsonDocument filter;
+        filter["name"] = true;
+        filter["entryfile"]["type"] = true;
+        filter["entryfile"]["location"] = true;
+
+        const struct dirent* de;
+        while ((de = readdir(dir)) != NULL) {
+            String filename = de->d_name;
+            if (!filename.endsWith(".json")) {
+                continue;
+            }
+            FILE* file = fopen((folder + "/" + filename).c_str(), "r");
+            if (!file) {
+                continue;
+            }
+            size_t length = fread(json, 1, CATALOG_INSTALLED_MANIFEST_MAX_SIZE, file);
+            bool tooLarge = fgetc(file) != EOF;
+            fclose(file);
+            if (!length || tooLarge) {
+                continue;
+            }
+
+            JsonDocument doc(&spiRamAllocator);
+            if (deserializeJson(doc, json, length, DeserializationOption::Filter(filter))) {
+                continue;
+            }
+            catalog_installed_app app;
+            app.id = filename.substring(0, filename.length() - 5);
+            app.name = doc["name"].as<String>();
+            app.location = doc["entryfile"]["location"].as<String>();
+            if (app.name.isEmpty() || app.location.isEmpty()) {
+                continue;
+            }
+
+            String typeStr = doc["entryfile"]["type"].as<String>();
+            ExecutionType type = EXEC_TYPE_UNKNOWN;
+            if (typeStr == "lua") type = EXEC_TYPE_LUA;
+            else if (typeStr == "binary") type = EXEC_TYPE_BINARY;
+            else if (typeStr == "dynapp" || typeStr == "so") type = EXEC_TYPE_DYNAPP;
+            app.type = resolveType(type, app.location);
+            if (app.type == EXEC_TYPE_UNKNOWN) {
+                continue;
+            }
+
+            struct stat st;
+            String execPath = root + "/lilcatalog/" + app.id + "/" + app.location;
+            if (stat(execPath.c_str(), &st) != 0) {
+                continue;
+            }
+            apps.push_back(app);
+        }
+    }
+    if (dir) {
+        closedir(dir);
+    }
+    free(json);
+
+    size_t bufferSize;
+    uint8_t* buffer = build(apps, signature, &bufferSize);
+    if (!buffer) {
+        return false;
+    }
+    save(buffer, bufferSize);
+    return adopt(buffer, bufferSize) && size();
+}
+
+bool InstalledIndex::load() {
+    if (lilka::fileutils.getSDRoot().length() == 0) {
+        return false;
+    }
+    signature_t signature = getSignature();
+    if (read() && matches(signature)) {
+        return size();
+    }
+    return rebuild(signature);
+}
+
+uint16_t InstalledIndex::size() const {
+    return header ? header->count : 0;
+}
+
+const char* InstalledIndex::getId(uint16_t index) const {
+    return strings + records[index].id;
+}
+
+const char* InstalledIndex::getName(uint16_t index) const {
+    return strings + records[index].name;
+}
+
+const char* InstalledIndex::getLocation(uint16_t index) const {
+    return strings + records[index].location;
+}
+
+ExecutionType InstalledIndex::getType(uint16_t index) const {
+    return static_cast<ExecutionType>(records[index].type);
+}
+
+String InstalledIndex::getExecutablePath(uint16_t index) const {
+    return lilka::fileutils.getSDRoot() + "/lilcatalog/" + getId(index) + "/" + getLocation(index);
+}
+
+void InstalledIndex::toVector(std::vector<catalog_installed_app>* apps) const {
+    for (uint16_t i = 0; i < size(); i++) {
+        apps->push_back({getId(i), getName(i), getLocation(i), getType(i)});
+    }
+}
+
+bool InstalledIndex::update(const String& id, const catalog_installed_app* app) {
+    if (lilka::fileutils.getSDRoot().length() == 0) {
+        return false;
+    }
+    // Manifest of this app has just been saved or removed. Index is still up to date for the rest
+    // if it was built either with or without that manifest
+    signature_t signature = getSignature();
+    uint32_t hash = hashName((id + ".json").c_str());
+    signature_t previous = signature;
+    if (app) {
+        previous.count--;
+        previous.hash -= hash;
+    } else {
+        previous.count++;
+        previous.hash += hash;
+    }
+
+    InstalledIndex index;
+    if (!index.read() || !(index.matches(signature) || index.matches(previous))) {
+        // Full rescan already reflects the change
+        return index.rebuild(signature) || !app;
+    }
+
+    std::vector<catalog_installed_app> apps;
+    index.toVector(&apps);
+    index.release();
+    for (auto it = apps.begin(); it != apps.end(); it++) {
+        if (it->id == id) {
+            apps.erase(it);
+            break;
+        }
+    }
+    if (app) {
+        apps.push_back(*app);
+    }
+
+    size_t bufferSize;
+    uint8_t* buffer = build(apps, signature, &bufferSize);
+    if (!buffer) {
+        return false;
+    }
+    bool ok = save(buffer, bufferSize);
+    spiRamAllocator.deallocate(buffer);
+    return ok;
+}
+
+bool InstalledIndex::put(const catalog_installed_app& app) {
+    return update(app.id, &app);
+}
+
+bool InstalledIndex::remove(const String& id) {
+    return update(id, NULL);
+}
+
+void InstalledIndex::clear() {
+    ::remove(getPath().c_str());
+    ::remove(getBackupPath().c_str());
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <vector>
+#include <lilka.h>
+
+#include "catalog_types.h"
+
+// Binary index of installed apps, so launcher doesn't have to parse every manifest on start
+#define CATALOG_INSTALLED_INDEX_FILE    "/lilcatalog/installed.idx"
+#define CATALOG_INSTALLED_INDEX_MAGIC   "LCIX"
+#define CATALOG_INSTALLED_INDEX_VERSION 1
+// Manifests larger than this are skipped when index is rebuilt
+#define CATALOG_INSTALLED_MANIFEST_MAX_SIZE 8192
+
+// File layout: header, count records, then string table with NUL-terminated strings
+typedef struct {
+    char magic[4];
+    uint16_t version;
+    uint16_t count;
+    // Manifests folder state the index was built for, see getSignature()
+    uint32_t manifestCount;
+    uint32_t manifestHash;
+    uint32_t stringsSize;
+    // FNV-1a of records and strings, torn writes are rejected by it
+    uint32_t checksum;
+} catalog_index_header_t;
+
+typedef struct {
+    // Offsets into string table
+    uint32_t id;
+    uint32_t name;
+    uint32_t location;
+    uint8_t type;
+    uint8_t reserved[3];
+} catalog_index_record_t;
+
+typedef struct {
+    String id;
+    String name;
+    String location; // Entry file, relative to app folder
+    ExecutionType type; // Resolved type, always LUA, BINARY or DYNAPP
+} catalog_installed_app;
+
+// Index is loaded with a single read and used in place. It's checked against the manifests folder
+// contents (names, not mtime: FAT doesn't update folder mtime when files inside change), and rebuilt
+// from manifests when it's missing, damaged or stale.
+class InstalledIndex {
+public:
+    InstalledIndex();
+    ~InstalledIndex();
+
+    // Returns false if there are no installed apps
+    bool load();
+    uint16_t size() const;
+    const char* getId(uint16_t index) const;
+    const char* getName(uint16_t index) const;
+    const char* getLocation(uint16_t index) const;
+    ExecutionType getType(uint16_t index) const;
+    String getExecutablePath(uint16_t index) const;
+
+    // Updates index after manifest of the app was saved or removed. New index replaces the old one
+    // only when it's fully written
+    static bool put(const catalog_installed_app& app);
+    static bool remove(const String& id);
+    static void clear();
+
+    // Returns LUA, BINARY or DYNAPP, using file extension if manifest type is not runnable
+    static ExecutionType resolveType(ExecutionType type, const String& location);
+
+private:
+    typedef struct {
+        uint32_t count;
+        uint32_t hash;
+    } signature_t;
+
+    static String getPath();
+    // Previous index, kept while the new one is renamed into place
+    static String getBackupPath();
+    static signature_t getSignature();
+    static uint32_t hashName(const char* name);
+    static uint32_t checksum(const uint8_t* data, size_t size);
+    // Serializes apps into a buffer allocated in PSRAM
+    static uint8_t* build(const std::vector<catalog_installed_app>& apps, signature_t signature, size_t* size);
+    static bool save(const uint8_t* buffer, size_t size);
+    static bool update(const String& id, const catalog_installed_app* app);
+
+    // Reads index file with a single read, checking its integrity but not signature
+    bool read();
+    // Takes ownership of buffer if it's a valid index
+    bool adopt(uint8_t* buffer, size_t size);
+    bool matches(signature_t signature) const;
+    bool rebuild(signature_t signature);
+    void toVector(std::vector<catalog_installed_app>* apps) const;
+    void release();
+
+    uint8_t* data;
+    const catalog_index_header_t* header;
+    const catalog_index_record_t* records;
+    const char* strings;
+};
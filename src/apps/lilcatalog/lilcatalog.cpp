@@ -1,11 +1,12 @@
 #include "lilcatalog.h"
+#include "installed_index.h"
 #include <HTTPClient.h>
 #include <WiFi.h>
 #include <lilka/config.h>
 
 #include "keira/utils/mem.h"
 
-LilCatalogApp::LilCatalogApp() : App(K_S_LILCATALOG_APP), currentEntry{}, iconBuffer{}, downloadBuffer{} {
+LilCatalogApp::LilCatalogApp() : App(K_S_LILCATALOG_APP), currentEntry{}, iconBuffer{} {
     setktStackSize(16384);
     path_catalog_folder = "/lilcatalog";
 }
@@ -30,6 +31,7 @@ void LilCatalogApp::run() {
                 mainMenu.update();
                 mainMenu.draw(canvas);
                 if (lilka::controller.peekState().b.justPressed) {
+                    fetcher.cancel();
                     exit();
                     return;
                 }
@@ -69,172 +71,47 @@ void LilCatalogApp::run() {
 // ================================
 
 String LilCatalogApp::httpGet(const String& url, int timeout) {
-    // No network - return empty
-    if (WiFi.status() != WL_CONNECTED) {
-        return "";
-    }
-
-    WiFiClientSecure client;
-    HTTPClient http;
-
-    client.setInsecure();
-    http.begin(client, url);
-    http.setTimeout(timeout);
-
-    int httpCode = http.GET();
-    String result = "";
-
-    if (httpCode == HTTP_CODE_OK) {
-        result = http.getString();
-    } else {
-        lilka::serial.err("HTTP GET failed: %s, code: %d", url.c_str(), httpCode);
-    }
-
-    http.end();
-    return result;
-}
-
-bool LilCatalogApp::httpGetBinary(const String& url, uint8_t* buffer, size_t bufferSize, size_t* bytesRead) {
-    *bytesRead = 0;
-
-    // No network - return false
-    if (WiFi.status() != WL_CONNECTED) {
-        return false;
-    }
-
-    WiFiClientSecure client;
-    HTTPClient http;
-
-    client.setInsecure();
-    http.begin(client, url);
-    http.setTimeout(CATALOG_HTTP_TIMEOUT);
-
-    int httpCode = http.GET();
-
-    if (httpCode == HTTP_CODE_OK) {
-        WiFiClient* stream = http.getStreamPtr();
-        size_t remaining = bufferSize;
-
-        while (http.connected() && remaining > 0) {
-            size_t available = stream->available();
-            if (available) {
-                size_t toRead = min(available, remaining);
-                size_t actualRead = stream->readBytes(buffer + *bytesRead, toRead);
-                *bytesRead += actualRead;
-                remaining -= actualRead;
-            }
-        }
-
-        http.end();
-        return true;
-    }
-
-    http.end();
-    return false;
+    return fetcher.get(url, timeout);
 }
 
 bool LilCatalogApp::downloadFile(const String& url, const String& targetPath) {
-    WiFiClientSecure client;
-    HTTPClient http;
-
-    client.setInsecure();
-    http.begin(client, url);
-    http.setTimeout(CATALOG_HTTP_TIMEOUT);
-
-    int httpCode = http.GET();
-
-    if (httpCode == HTTP_CODE_OK) {
-        String parentDir = lilka::fileutils.getParentDirectory(targetPath);
-        if (!lilka::fileutils.makePath(&SD, parentDir)) {
-            http.end();
-            return false;
-        }
-
-        fs::File file = SD.open(targetPath.c_str(), FILE_WRITE);
-        if (!file) {
-            http.end();
-            return false;
-        }
-
-        WiFiClient* stream = http.getStreamPtr();
-        size_t size = http.getSize();
-        size_t written = 0;
-
-        while (http.connected() && (written < size || size == (size_t)-1)) {
-            size_t available = stream->available();
-            if (available) {
-                size_t toRead = min(available, (size_t)CATALOG_DOWNLOAD_BUFFER_SIZE);
-                size_t actualRead = stream->readBytes(downloadBuffer, toRead);
-                file.write(downloadBuffer, actualRead);
-                written += actualRead;
-            }
-        }
-
-        file.close();
-        http.end();
-        return true;
+    String parentDir = lilka::fileutils.getParentDirectory(targetPath);
+    if (!lilka::fileutils.makePath(&SD, parentDir)) {
+        return false;
     }
-
-    http.end();
-    return false;
+    return fetcher.download(url, targetPath, CATALOG_HTTP_TIMEOUT) == HTTP_CODE_OK;
 }
 
 bool LilCatalogApp::downloadFileWithProgress(const String& url, const String& targetPath, const String& displayName) {
-    WiFiClientSecure client;
-    HTTPClient http;
-
-    client.setInsecure();
-    http.begin(client, url);
-    http.setTimeout(CATALOG_HTTP_TIMEOUT);
-
-    int httpCode = http.GET();
-
-    if (httpCode == HTTP_CODE_OK) {
-        String parentDir = lilka::fileutils.getParentDirectory(targetPath);
-        if (!lilka::fileutils.makePath(&SD, parentDir)) {
-            showAlert(K_S_LILCATALOG_ERROR_DIRETORY_CREATE);
-            http.end();
-            return false;
-        }
-
-        fs::File file = SD.open(targetPath.c_str(), FILE_WRITE);
-        if (!file) {
-            showAlert(K_S_LILCATALOG_ERROR_FILE_OPEN);
-            http.end();
-            return false;
-        }
-
-        WiFiClient* stream = http.getStreamPtr();
-        size_t size = http.getSize();
-        size_t written = 0;
-
-        lilka::ProgressDialog dialog(K_S_LILCATALOG_APP, displayName);
-
-        while (http.connected() && (written < size || size == (size_t)-1)) {
-            size_t available = stream->available();
-            if (available) {
-                size_t toRead = min(available, (size_t)CATALOG_DOWNLOAD_BUFFER_SIZE);
-                size_t actualRead = stream->readBytes(downloadBuffer, toRead);
-                file.write(downloadBuffer, actualRead);
-                written += actualRead;
+    String parentDir = lilka::fileutils.getParentDirectory(targetPath);
+    if (!lilka::fileutils.makePath(&SD, parentDir)) {
+        showAlert(K_S_LILCATALOG_ERROR_DIRETORY_CREATE);
+        return false;
+    }
 
-                if (size > 0) {
-                    int progress = written * 100 / size;
-                    dialog.setProgress(progress);
-                }
-                dialog.draw(canvas);
-                queueDraw();
-            }
+    lilka::ProgressDialog dialog(K_S_LILCATALOG_APP, displayName);
+    int lastProgress = -1;
+    auto onProgress = [this, &dialog, &lastProgress](size_t written, size_t size) {
+        // Redraw only when percentage changes, drawing is slower than reading a chunk
+        int progress = written * 100 / size;
+        if (progress != lastProgress) {
+            lastProgress = progress;
+            dialog.setProgress(progress);
+            dialog.draw(canvas);
+            queueDraw();
         }
+    };
+    int httpCode = fetcher.download(url, targetPath, CATALOG_HTTP_TIMEOUT, onProgress);
 
-        file.close();
-        http.end();
-        return true;
+    if (httpCode == HTTPC_ERROR_STREAM_WRITE) {
+        showAlert(K_S_LILCATALOG_ERROR_FILE_OPEN);
+        return false;
     }
-
-    showAlert(K_S_LILCATALOG_ERROR_CONNECTION + String(httpCode));
-    http.end();
-    return false;
+    if (httpCode != HTTP_CODE_OK) {
+        showAlert(K_S_LILCATALOG_ERROR_CONNECTION + String(httpCode));
+        return false;
+    }
+    return true;
 }
 
 // ================================
@@ -247,14 +124,25 @@ bool LilCatalogApp::fetchIndex(int page) {
     queueDraw();
 
     String url = String(CATALOG_BASE_URL) + "/apps/index_" + String(page) + ".json";
+    String cachePath = getPageCachePath(page);
 
-    String json = httpGet(url);
+    // Page may already be there from prefetch
+    if (fetcher.fetch(url, cachePath, CATALOG_HTTP_TIMEOUT) == CATALOG_FETCH_FAILED) {
+        return false;
+    }
 
-    if (json.length() == 0) {
+    fs::File file = SD.open(cachePath, FILE_READ);
+    if (!file) {
         return false;
     }
+    String json = file.readString();
+    file.close();
 
-    return parseIndex(json);
+    if (!parseIndex(json)) {
+        return false;
+    }
+    startPrefetch();
+    return true;
 }
 
 bool LilCatalogApp::parseIndex(const String& json) {
@@ -299,20 +187,13 @@ bool LilCatalogApp::parseIndex(const String& json) {
 }
 
 bool LilCatalogApp::fetchEntryShortManifest(const String& entryId, catalog_entry& entry) {
-    // Try cache first
-    String json = loadShortManifestFromCache(entryId);
-
-    // If not cached, fetch from network with shorter timeout
-    if (json.length() == 0) {
-        String url = String(CATALOG_BASE_URL) + "/apps/" + entryId + "/index_short.json";
-        json = httpGet(url, CATALOG_HTTP_TIMEOUT_SHORT);
-
-        // Cache for next time
-        if (json.length() > 0) {
-            saveShortManifestToCache(entryId, json);
-        }
+    // Cached copy is revalidated once per session, usually by prefetch of this page
+    String url = String(CATALOG_BASE_URL) + "/apps/" + entryId + "/index_short.json";
+    if (fetcher.fetch(url, getShortManifestCachePath(entryId), CATALOG_HTTP_TIMEOUT_SHORT) == CATALOG_FETCH_FAILED) {
+        return false;
     }
 
+    String json = loadShortManifestFromCache(entryId);
     if (json.length() == 0) {
         return false;
     }
@@ -345,17 +226,29 @@ bool LilCatalogApp::parseShortManifest(const String& json, catalog_entry& entry)
 }
 
 bool LilCatalogApp::fetchEntryManifest(const String& entryId) {
-    // Try cache first (for offline support)
-    String json = loadManifestFromCache(entryId);
-
-    // If not in cache, try network
-    if (json.length() == 0) {
+    String url = String(CATALOG_BASE_URL) + "/apps/" + entryId + "/index.json";
+    String cachePath = getManifestCachePath(entryId);
+    String json;
+
+    if (SD.exists(cachePath)) {
+        // Manifest of installed app: revalidate it, cached copy is used when offline
+        catalog_fetch_result_t result = fetcher.fetch(url, cachePath, CATALOG_HTTP_TIMEOUT_SHORT);
+        json = loadManifestFromCache(entryId);
+        if (result == CATALOG_FETCH_UPDATED && parseManifest(json, currentEntry)) {
+            catalog_installed_app app;
+            app.id = entryId;
+            app.name = currentEntry.name;
+            app.location = currentEntry.entryfile.location;
+            app.type = InstalledIndex::resolveType(currentEntry.entryfile.type, app.location);
+            if (app.type != EXEC_TYPE_UNKNOWN) {
+                InstalledIndex::put(app);
+            }
+        }
+    } else {
         lilka::Alert alert(K_S_LILCATALOG_APP, K_S_LILCATALOG_FILE_LOADING);
         alert.draw(canvas);
         queueDraw();
 
-        String url = String(CATALOG_BASE_URL) + "/apps/" + entryId + "/index.json";
-
         json = httpGet(url);
     }
 
@@ -414,12 +307,65 @@ bool LilCatalogApp::parseManifest(const String& json, catalog_entry& entry) {
 
 bool LilCatalogApp::fetchIcon(const String& entryId, const String& iconMinName) {
     String url = String(CATALOG_BASE_URL) + "/apps/" + entryId + "/static/" + iconMinName;
+    if (fetcher.fetch(url, getIconCachePath(entryId), CATALOG_HTTP_TIMEOUT) == CATALOG_FETCH_FAILED) {
+        return false;
+    }
+    return loadIconFromCache(entryId);
+}
 
-    size_t bytesRead = 0;
-    if (httpGetBinary(url, reinterpret_cast<uint8_t*>(iconBuffer), CATALOG_ICON_SIZE, &bytesRead)) {
-        return bytesRead == CATALOG_ICON_SIZE;
+void LilCatalogApp::startPrefetch() {
+    // Job works on its own copies, entries may change while it runs
+    std::vector<std::pair<String, String>> icons;
+    for (const auto& entry : entries) {
+        if (!entry.icon_min.isEmpty()) {
+            icons.push_back({entry.id, entry.icon_min});
+        }
     }
-    return false;
+    int nextPage = currentPage + 1 < totalPages ? currentPage + 1 : -1;
+
+    fetcher.runInBackground([this, icons, nextPage]() {
+        for (const auto& icon : icons) {
+            if (fetcher.isCancelled()) return;
+            String url = String(CATALOG_BASE_URL) + "/apps/" + icon.first + "/static/" + icon.second;
+            fetcher.fetch(url, getIconCachePath(icon.first), CATALOG_HTTP_TIMEOUT);
+        }
+        if (nextPage < 0 || fetcher.isCancelled()) {
+            return;
+        }
+
+        String url = String(CATALOG_BASE_URL) + "/apps/index_" + String(nextPage) + ".json";
+        String pagePath = getPageCachePath(nextPage);
+        if (fetcher.fetch(url, pagePath, CATALOG_HTTP_TIMEOUT) == CATALOG_FETCH_FAILED) {
+            return;
+        }
+        fs::File file = SD.open(pagePath, FILE_READ);
+        if (!file) {
+            return;
+        }
+        JsonDocument doc(&spiRamAllocator);
+        DeserializationError error = deserializeJson(doc, file);
+        file.close();
+        if (error) {
+            return;
+        }
+
+        for (JsonVariant v : doc["manifests"].as<JsonArray>()) {
+            if (fetcher.isCancelled()) return;
+            String entryId = v.as<String>();
+            url = String(CATALOG_BASE_URL) + "/apps/" + entryId + "/index_short.json";
+            if (fetcher.fetch(url, getShortManifestCachePath(entryId), CATALOG_HTTP_TIMEOUT_SHORT) ==
+                CATALOG_FETCH_FAILED) {
+                continue;
+            }
+            catalog_entry entry;
+            if (parseShortManifest(loadShortManifestFromCache(entryId), entry) && !entry.icon_min.isEmpty() &&
+                !fetcher.isCancelled()) {
+                url = String(CATALOG_BASE_URL) + "/apps/" + entryId + "/static/" + entry.icon_min;
+                fetcher.fetch(url, getIconCachePath(entryId), CATALOG_HTTP_TIMEOUT);
+            }
+        }
+        lilka::serial.log("Prefetched catalog page %d", nextPage + 1);
+    });
 }
 
 ExecutionType LilCatalogApp::parseExecutionType(const String& typeStr) {
@@ -468,27 +414,6 @@ bool LilCatalogApp::loadIconFromCache(const String& entryId) {
     return bytesRead == CATALOG_ICON_SIZE;
 }
 
-bool LilCatalogApp::saveIconToCache(const String& entryId) {
-    if (!iconLoaded) {
-        return false;
-    }
-
-    if (!SD.exists(CATALOG_ICON_CACHE_FOLDER)) {
-        lilka::fileutils.makePath(&SD, CATALOG_ICON_CACHE_FOLDER);
-    }
-
-    String cachePath = getIconCachePath(entryId);
-    fs::File file = SD.open(cachePath.c_str(), FILE_WRITE);
-    if (!file) {
-        return false;
-    }
-
-    size_t written = file.write(reinterpret_cast<uint8_t*>(iconBuffer), CATALOG_ICON_SIZE);
-    file.close();
-
-    return written == CATALOG_ICON_SIZE;
-}
-
 void LilCatalogApp::drawLoadingAnimation() {
     // Draw current app view with loading animation in icon area
     canvas->fillScreen(lilka::colors::Black);
@@ -582,7 +507,6 @@ void LilCatalogApp::loadCurrentIcon() {
     // Fetch from network
     if (fetchIcon(entry.id, iconMinName)) {
         iconLoaded = true;
-        saveIconToCache(entry.id);
     }
 }
 
@@ -614,22 +538,6 @@ String LilCatalogApp::getShortManifestCachePath(const String& entryId) {
     return String(CATALOG_SHORT_MANIFEST_CACHE_FOLDER) + "/" + entryId + ".json";
 }
 
-bool LilCatalogApp::saveShortManifestToCache(const String& entryId, const String& json) {
-    if (!lilka::fileutils.makePath(&SD, CATALOG_SHORT_MANIFEST_CACHE_FOLDER)) {
-        return false;
-    }
-
-    String cachePath = getShortManifestCachePath(entryId);
-    fs::File file = SD.open(cachePath.c_str(), FILE_WRITE);
-    if (!file) {
-        return false;
-    }
-
-    file.print(json);
-    file.close();
-    return true;
-}
-
 String LilCatalogApp::loadShortManifestFromCache(const String& entryId) {
     String cachePath = getShortManifestCachePath(entryId);
 
@@ -664,6 +572,31 @@ void LilCatalogApp::clearShortManifestCache() {
     }
 }
 
+// ================================
+// Index Page Cache Methods
+// ================================
+
+String LilCatalogApp::getPageCachePath(int page) {
+    return String(CATALOG_PAGE_CACHE_FOLDER) + "/index_" + String(page) + ".json";
+}
+
+void LilCatalogApp::clearPageCache() {
+    if (SD.exists(CATALOG_PAGE_CACHE_FOLDER)) {
+        fs::File dir = SD.open(CATALOG_PAGE_CACHE_FOLDER);
+        if (dir && dir.isDirectory()) {
+            fs::File entry = dir.openNextFile();
+            while (entry) {
+                String path = String(CATALOG_PAGE_CACHE_FOLDER) + "/" + entry.name();
+                entry.close();
+                SD.remove(path.c_str());
+                entry = dir.openNextFile();
+            }
+            dir.close();
+        }
+        SD.rmdir(CATALOG_PAGE_CACHE_FOLDER);
+    }
+}
+
 // ================================
 // Manifest Cache Methods
 // ================================
@@ -774,6 +707,7 @@ void LilCatalogApp::clearManifestCache() {
         }
         SD.rmdir(CATALOG_MANIFEST_CACHE_FOLDER);
     }
+    InstalledIndex::clear();
 }
 
 // ================================
@@ -831,8 +765,15 @@ void LilCatalogApp::fetchEntry() {
     // Save manifest to cache for offline use
     String manifestUrl = String(CATALOG_BASE_URL) + "/apps/" + currentEntry.id + "/index.json";
     String manifestJson = httpGet(manifestUrl);
-    if (manifestJson.length() > 0) {
-        saveManifestToCache(currentEntry.id, manifestJson);
+    if (manifestJson.length() > 0 && saveManifestToCache(currentEntry.id, manifestJson)) {
+        catalog_installed_app app;
+        app.id = currentEntry.id;
+        app.name = currentEntry.name;
+        app.location = currentEntry.entryfile.location;
+        app.type = InstalledIndex::resolveType(currentEntry.entryfile.type, app.location);
+        if (app.type != EXEC_TYPE_UNKNOWN) {
+            InstalledIndex::put(app);
+        }
     }
 
     showAlert(K_S_LILCATALOG_FILE_LOADING_COMPLETE);
@@ -863,6 +804,8 @@ void LilCatalogApp::removeEntry() {
     if (SD.exists(manifestPath.c_str())) {
         SD.remove(manifestPath.c_str());
     }
+    SD.remove(manifestPath + CATALOG_CACHE_META_EXTENSION);
+    InstalledIndex::remove(currentEntry.id);
 
     showEntry();
 }
@@ -1022,8 +965,11 @@ void LilCatalogApp::showMainMenu() {
         K_S_LILCATALOG_EMPTY,
         [](void* ctx) {
             LilCatalogApp* app = static_cast<LilCatalogApp*>(ctx);
+            // Cancelled prefetch job drops what it downloads instead of putting it into cleared folders
+            app->fetcher.cancel();
             app->clearIconCache();
             app->clearShortManifestCache();
+            app->clearPageCache();
             app->clearManifestCache();
             app->showAlert(K_S_LILCATALOG_CACHE_CLEARED);
         },
@@ -1037,6 +983,7 @@ void LilCatalogApp::showMainMenu() {
         K_S_LILCATALOG_EMPTY,
         [](void* ctx) {
             LilCatalogApp* app = static_cast<LilCatalogApp*>(ctx);
+            app->fetcher.cancel();
             app->exit();
         },
         this
@@ -13,36 +13,23 @@
 #include "../fmanager/fmanager.h"
 #include "../dynapp/dynapp.h"
 
-// Base URL for catalog API (apps only)
-#define CATALOG_BASE_URL "https://catalog.lilka.dev"
+#include "catalog_fetcher.h"
+#include "catalog_types.h"
+
+// Base URL for catalog API (apps only). Can be overridden to test with local server (tools/catalog_server.py)
+#ifndef CATALOG_BASE_URL
+#    define CATALOG_BASE_URL "https://catalog.lilka.dev"
+#endif
 
 // Icon size for mini icons (icon_min.bin is RGB565 raw format, 64x64 px)
 #define CATALOG_ICON_WIDTH  64
 #define CATALOG_ICON_HEIGHT 64
 #define CATALOG_ICON_SIZE   (CATALOG_ICON_WIDTH * CATALOG_ICON_HEIGHT * 2) // 8192 bytes
 
-// Cache paths
-#define CATALOG_ICON_CACHE_FOLDER           "/lilcatalog/icons"
-#define CATALOG_MANIFEST_CACHE_FOLDER       "/lilcatalog/manifests"
-#define CATALOG_SHORT_MANIFEST_CACHE_FOLDER "/lilcatalog/short_manifests"
-
 // HTTP timeout in milliseconds
 #define CATALOG_HTTP_TIMEOUT       10000
 #define CATALOG_HTTP_TIMEOUT_SHORT 5000 // For small files like short manifests
 
-// Download buffer size
-#define CATALOG_DOWNLOAD_BUFFER_SIZE 2048
-
-// Execution file types
-typedef enum {
-    EXEC_TYPE_UNKNOWN,
-    EXEC_TYPE_LUA,
-    EXEC_TYPE_BINARY,
-    EXEC_TYPE_ARCHIVE,
-    EXEC_TYPE_IMAGE,
-    EXEC_TYPE_DYNAPP
-} ExecutionType;
-
 // Source info
 typedef struct {
     String type; // "git"
@@ -108,8 +95,8 @@ private:
     // Loading animation state
     uint8_t loadingFrame = 0;
 
-    // Download buffer (reused across all download operations)
-    uint8_t downloadBuffer[CATALOG_DOWNLOAD_BUFFER_SIZE];
+    // Keeps connections open between requests and prefetches the next page
+    CatalogFetcher fetcher;
 
     // Menus
     lilka::Menu mainMenu;
@@ -118,7 +105,6 @@ private:
 
     // Network methods
     String httpGet(const String& url, int timeout = CATALOG_HTTP_TIMEOUT);
-    bool httpGetBinary(const String& url, uint8_t* buffer, size_t bufferSize, size_t* bytesRead);
     bool downloadFile(const String& url, const String& targetPath);
     bool downloadFileWithProgress(const String& url, const String& targetPath, const String& displayName);
 
@@ -127,20 +113,24 @@ private:
     bool fetchEntryManifest(const String& entryId);
     bool fetchEntryShortManifest(const String& entryId, catalog_entry& entry);
     bool fetchIcon(const String& entryId, const String& iconMinName);
+    // Revalidates icons of the current page and fetches the next page into cache in background
+    void startPrefetch();
 
     // Short manifest cache methods
     String getShortManifestCachePath(const String& entryId);
-    bool saveShortManifestToCache(const String& entryId, const String& json);
     String loadShortManifestFromCache(const String& entryId);
     void clearShortManifestCache();
 
     // Icon cache methods
     String getIconCachePath(const String& entryId);
     bool loadIconFromCache(const String& entryId);
-    bool saveIconToCache(const String& entryId);
     void loadCurrentIcon();
     void clearIconCache();
 
+    // Index page cache methods
+    String getPageCachePath(int page);
+    void clearPageCache();
+
     // Manifest cache methods
     String getManifestCachePath(const String& entryId);
     bool saveManifestToCache(const String& entryId, const String& json);
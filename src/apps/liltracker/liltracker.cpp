@@ -3,7 +3,7 @@
 #include "liltracker.h"
 #include "note.h"
 #include "i2s_sink.h"
-#include "wav_sink.h"
+#include "offline_render.h"
 #include "keira/utils/defer.h"
 #include "keira/utils/string.h"
 #include "icons/liltracker_icons.h"
@@ -93,8 +93,6 @@ void LilTrackerApp::run() {
     I2SSink i2sSink;
     sequencer.setSink(&i2sSink);
 
-    WAVSink* wavSink = NULL;
-
     if (initialPath.length()) {
         loadTrack(&track, initialPath);
     }
@@ -128,12 +126,6 @@ void LilTrackerApp::run() {
             pageIndex = seqState.pageIndex;
         }
 
-        if (!seqState.playing && wavSink) {
-            delete wavSink;
-            wavSink = NULL;
-            sequencer.setSink(&i2sSink);
-        }
-
         int currentChannel = scoreCursorX / SEGMENT_COUNT;
         int currentSegment = scoreCursorX % SEGMENT_COUNT;
 
@@ -284,7 +276,7 @@ void LilTrackerApp::run() {
             bool isWAVRenderFocused =
                 activeBlock == BLOCK_CONTROLS && controlCursorX == 1 && controlCursorY == CONTROL_ROW_2_SETTINGS;
             drawElement(
-                "Запис WAV",
+                K_S_LILTRACKER_RENDER_WAV,
                 CONTROL_PADDING_LEFT + CONTROL_WIDTH,
                 CONTROL_TOP + ITEM_HEIGHT * 5 / 2,
                 lilka::ALIGN_START,
@@ -556,9 +548,7 @@ void LilTrackerApp::run() {
                             // Save WAV
                             String filename = filePicker(".wav", true);
                             if (filename.length()) {
-                                wavSink = new WAVSink(filename);
-                                sequencer.setSink(wavSink);
-                                sequencer.play(&track, pageIndex, false);
+                                renderWAV(&track, pageIndex, filename);
                             }
                         } else {
                             isEditing = true;
@@ -827,6 +817,32 @@ int LilTrackerApp::drawElement(
 //     }
 // }
 
+void LilTrackerApp::renderWAV(Track* track, uint16_t pageIndex, String filename) {
+    sequencer.stop();
+    bool stems = confirm(K_S_LILTRACKER_RENDER_WAV, K_S_LILTRACKER_EXPORT_STEMS);
+
+    OfflineRenderer renderer(track, sequencer.getMasterVolume());
+    lilka::ProgressDialog dialog(K_S_LILTRACKER_RENDER_WAV, filename);
+    int lastPercent = -1;
+    uint32_t startTime = millis();
+    bool ok = renderer.render(filename, pageIndex, stems, [&](float progress) {
+        // Redraw only when percentage changes, so screen doesn't slow rendering down
+        int percent = progress * 100;
+        if (percent != lastPercent) {
+            lastPercent = percent;
+            dialog.setProgress(percent);
+            dialog.draw(canvas);
+            queueDraw();
+        }
+    });
+
+    if (ok) {
+        alert(K_S_LILTRACKER_RENDER_WAV, StringFormat(K_S_LILTRACKER_RENDER_DONE_FMT, (millis() - startTime) / 1000.0f));
+    } else {
+        alert(K_S_ERROR, K_S_LILTRACKER_RENDER_FAILED);
+    }
+}
+
 String LilTrackerApp::filePicker(String ext, bool isSave) {
     // isSave determines whether we are writing to file or opening an existing one
 
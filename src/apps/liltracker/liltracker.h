@@ -17,6 +17,7 @@ private:
     );
     // void startPreview(Track* track, page_t* page, int8_t requestedChannelIndex, uint16_t requestedEventIndex);
     String filePicker(String ext, bool isSave);
+    void renderWAV(Track* track, uint16_t pageIndex, String filename);
     void loadTrack(Track* track, String path);
     void saveTrack(Track* track, String path);
 
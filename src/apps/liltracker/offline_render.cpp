@@ -0,0 +1,298 @@
+#include "offline_render.h"
+#include "sequencer.h"
+#include "keira/utils/mem.h"
+
+OfflineRenderer::OfflineRenderer(Track* track, float masterVolume) :
+    track(track),
+    masterVolume(masterVolume),
+    roundBlock(NULL),
+    roundSamples(0),
+    stopping(false),
+    outputCount(0),
+    writeFailed(false),
+    blocks(),
+    freeBlocks(xQueueCreate(2, sizeof(render_block_t*))),
+    filledBlocks(xQueueCreate(2, sizeof(render_block_t*))),
+    workerStart(xSemaphoreCreateBinary()),
+    workerDone(xSemaphoreCreateBinary()),
+    writerDone(xSemaphoreCreateBinary()) {
+    synths[0] = new Synth();
+    synths[1] = new Synth();
+}
+
+OfflineRenderer::~OfflineRenderer() {
+    delete synths[0];
+    delete synths[1];
+    vQueueDelete(freeBlocks);
+    vQueueDelete(filledBlocks);
+    vSemaphoreDelete(workerStart);
+    vSemaphoreDelete(workerDone);
+    vSemaphoreDelete(writerDone);
+}
+
+String OfflineRenderer::stemFilename(String filename, uint8_t channelIndex) {
+    String suffix = "_ch" + String(channelIndex + 1);
+    int extIndex = filename.lastIndexOf('.');
+    if (extIndex <= filename.lastIndexOf('/')) {
+        return filename + suffix;
+    }
+    return filename.substring(0, extIndex) + suffix + filename.substring(extIndex);
+}
+
+// Header takes whole OFFLINE_RENDER_DATA_OFFSET bytes: RIFF, fmt, JUNK padding and data chunk header
+static bool offline_render_write_header(File& file, uint32_t sampleCount) {
+    uint8_t header[OFFLINE_RENDER_DATA_OFFSET] = {};
+    uint32_t dataSize = sampleCount * 1 * 16 / 8;
+
+    riff_header_t* riffHeader = reinterpret_cast<riff_header_t*>(header);
+    memcpy(riffHeader->chunkID, "RIFF", 4);
+    riffHeader->chunkSize = OFFLINE_RENDER_DATA_OFFSET - 8 + dataSize;
+    memcpy(riffHeader->format, "WAVE", 4);
+
+    fmt_subchunk_t* fmtSubchunk = reinterpret_cast<fmt_subchunk_t*>(header + sizeof(riff_header_t));
+    memcpy(fmtSubchunk->subchunk1ID, "fmt ", 4);
+    fmtSubchunk->subchunk1Size = 16;
+    fmtSubchunk->audioFormat = 1;
+    fmtSubchunk->numChannels = 1;
+    fmtSubchunk->sampleRate = SYNTH_SAMPLE_RATE;
+    fmtSubchunk->byteRate = SYNTH_SAMPLE_RATE * 1 * 16 / 8;
+    fmtSubchunk->blockAlign = 1 * 16 / 8;
+    fmtSubchunk->bitsPerSample = 16;
+
+    // JUNK chunk is skipped by readers, it only moves samples to a sector boundary
+    data_subchunk_t* junkSubchunk =
+        reinterpret_cast<data_subchunk_t*>(header + sizeof(riff_header_t) + sizeof(fmt_subchunk_t));
+    memcpy(junkSubchunk->subchunk2ID, "JUNK", 4);
+    junkSubchunk->subchunk2Size = OFFLINE_RENDER_DATA_OFFSET - sizeof(riff_header_t) - sizeof(fmt_subchunk_t) -
+                                  2 * sizeof(data_subchunk_t);
+
+    data_subchunk_t* dataSubchunk =
+        reinterpret_cast<data_subchunk_t*>(header + OFFLINE_RENDER_DATA_OFFSET - sizeof(data_subchunk_t));
+    memcpy(dataSubchunk->subchunk2ID, "data", 4);
+    dataSubchunk->subchunk2Size = dataSize;
+
+    return file.write(header, sizeof(header)) == sizeof(header);
+}
+
+bool OfflineRenderer::openOutput(output_t* output, String filename) {
+    output->filename = filename;
+    output->sampleCount = 0;
+    output->file = SD.open(filename, FILE_WRITE);
+    if (!output->file) {
+        lilka::serial.log("LilTracker: failed to open %s for writing", filename.c_str());
+        return false;
+    }
+    // Sizes are not known yet, header is written again when file is closed
+    return offline_render_write_header(output->file, 0);
+}
+
+void OfflineRenderer::closeOutput(output_t* output) {
+    if (!output->file) {
+        return;
+    }
+    output->file.seek(0);
+    offline_render_write_header(output->file, output->sampleCount);
+    output->file.close();
+}
+
+void OfflineRenderer::writeBlock(const render_block_t* block) {
+    size_t size = block->sampleCount * sizeof(int16_t);
+    for (uint8_t i = 0; i < outputCount; i++) {
+        const int16_t* data = i == 0 ? block->mix : block->channels[i - 1];
+        if (outputs[i].file.write(reinterpret_cast<const uint8_t*>(data), size) != size) {
+            writeFailed = true;
+            return;
+        }
+        outputs[i].sampleCount += block->sampleCount;
+    }
+}
+
+void OfflineRenderer::renderRound(Synth* synth, uint8_t firstChannel, uint8_t lastChannel) {
+    int16_t combinedBuffer[SYNTH_BUFFER_SIZE];
+    int16_t channelBuffers[CHANNEL_COUNT][SYNTH_BUFFER_SIZE];
+    for (uint32_t offset = 0; offset < roundSamples; offset += SYNTH_BUFFER_SIZE) {
+        uint32_t sampleCount = roundSamples - offset;
+        if (sampleCount > SYNTH_BUFFER_SIZE) {
+            sampleCount = SYNTH_BUFFER_SIZE;
+        }
+        // Synth also renders silence for channels it doesn't own, which is just a memset
+        synth->render(combinedBuffer, channelBuffers, sampleCount, masterVolume);
+        for (uint8_t channelIndex = firstChannel; channelIndex < lastChannel; channelIndex++) {
+            memcpy(
+                roundBlock->channels[channelIndex] + offset, channelBuffers[channelIndex], sampleCount * sizeof(int16_t)
+            );
+        }
+    }
+}
+
+void OfflineRenderer::workerTask(void* arg) {
+    OfflineRenderer* renderer = static_cast<OfflineRenderer*>(arg);
+    while (1) {
+        xSemaphoreTake(renderer->workerStart, portMAX_DELAY);
+        if (renderer->stopping) {
+            break;
+        }
+        renderer->renderRound(renderer->synths[1], 0, OFFLINE_RENDER_WORKER_CHANNELS);
+        xSemaphoreGive(renderer->workerDone);
+    }
+    xSemaphoreGive(renderer->workerDone);
+    vTaskDelete(NULL);
+}
+
+void OfflineRenderer::writerTask(void* arg) {
+    OfflineRenderer* renderer = static_cast<OfflineRenderer*>(arg);
+    render_block_t* block;
+    while (xQueueReceive(renderer->filledBlocks, &block, portMAX_DELAY) == pdTRUE && block) {
+        if (!renderer->writeFailed) {
+            renderer->writeBlock(block);
+        }
+        xQueueSend(renderer->freeBlocks, &block, portMAX_DELAY);
+    }
+    xSemaphoreGive(renderer->writerDone);
+    vTaskDelete(NULL);
+}
+
+bool OfflineRenderer::render(String filename, uint16_t startPage, bool stems, std::function<void(float)> progress) {
+    uint16_t pageCount = track->getPageCount();
+    if (startPage >= pageCount) {
+        return false;
+    }
+    const uint32_t rowLength = SYNTH_SAMPLE_RATE * 60 / track->getBPM();
+    const uint32_t rowCount = (pageCount - startPage) * CHANNEL_SIZE;
+    const int64_t totalSamples = static_cast<int64_t>(rowLength) * rowCount;
+
+    // Blocks are in PSRAM, they're only touched by memcpy and SD writes
+    bool ok = true;
+    for (int i = 0; i < 2; i++) {
+        blocks[i].mix = static_cast<int16_t*>(spiRamAllocator.allocate(OFFLINE_RENDER_BLOCK_SIZE * sizeof(int16_t)));
+        ok = ok && blocks[i].mix;
+        for (uint8_t channelIndex = 0; channelIndex < CHANNEL_COUNT; channelIndex++) {
+            blocks[i].channels[channelIndex] =
+                static_cast<int16_t*>(spiRamAllocator.allocate(OFFLINE_RENDER_BLOCK_SIZE * sizeof(int16_t)));
+            ok = ok && blocks[i].channels[channelIndex];
+        }
+    }
+
+    outputCount = 0;
+    for (uint8_t i = 0; i < (stems ? CHANNEL_COUNT + 1 : 1) && ok; i++) {
+        ok = openOutput(&outputs[i], i == 0 ? filename : stemFilename(filename, i - 1));
+        if (outputs[i].file) {
+            outputCount++;
+        }
+    }
+
+    TaskHandle_t workerHandle = NULL;
+    TaskHandle_t writerHandle = NULL;
+    if (ok) {
+        // Writer mostly waits for SPI, so it shares core 0 with the worker at higher priority
+        ok = xTaskCreatePinnedToCore(workerTask, "renderWorker", 8192, this, 1, &workerHandle, 0) == pdPASS;
+        if (ok && xTaskCreatePinnedToCore(writerTask, "renderWriter", 4096, this, 2, &writerHandle, 0) != pdPASS) {
+            ok = false;
+        }
+    }
+
+    if (ok) {
+        synths[0]->reset();
+        synths[1]->reset();
+        writeFailed = false;
+        stopping = false;
+        for (int i = 0; i < 2; i++) {
+            render_block_t* block = &blocks[i];
+            xQueueSend(freeBlocks, &block, portMAX_DELAY);
+        }
+
+        Synth* channelSynths[CHANNEL_COUNT];
+        for (uint8_t channelIndex = 0; channelIndex < CHANNEL_COUNT; channelIndex++) {
+            channelSynths[channelIndex] = channelIndex < OFFLINE_RENDER_WORKER_CHANNELS ? synths[1] : synths[0];
+        }
+
+        uint32_t row = 0;
+        int64_t rowSample = 0;
+        int64_t renderedSamples = 0;
+        while (renderedSamples < totalSamples && !writeFailed) {
+            roundSamples = OFFLINE_RENDER_BLOCK_SIZE;
+            if (totalSamples - renderedSamples < roundSamples) {
+                roundSamples = totalSamples - renderedSamples;
+            }
+
+            // Rows starting in this round, synths apply them at their exact sample
+            while (row < rowCount && rowSample < renderedSamples + roundSamples) {
+                if (!Sequencer::queueRow(
+                        channelSynths, track, startPage + row / CHANNEL_SIZE, row % CHANNEL_SIZE, rowSample
+                    )) {
+                    // Round is cut short before this row to drain synth event queue, and the row is queued again
+                    // in the next one. Effects are evaluated in blocks counted from buffer start, so the cut stays
+                    // on a buffer boundary when possible, to sound the same as real-time playback
+                    if (rowSample == renderedSamples) {
+                        lilka::serial.log("LilTracker: synth event queue is full at row %d", row);
+                        ok = false;
+                    }
+                    roundSamples = rowSample - renderedSamples;
+                    if (roundSamples > SYNTH_BUFFER_SIZE) {
+                        roundSamples -= roundSamples % SYNTH_BUFFER_SIZE;
+                    }
+                    break;
+                }
+                row++;
+                rowSample += rowLength;
+            }
+            if (!ok) {
+                break;
+            }
+
+            render_block_t* block;
+            xQueueReceive(freeBlocks, &block, portMAX_DELAY);
+            roundBlock = block;
+
+            xSemaphoreGive(workerStart);
+            renderRound(synths[0], OFFLINE_RENDER_WORKER_CHANNELS, CHANNEL_COUNT);
+            xSemaphoreTake(workerDone, portMAX_DELAY);
+
+            for (uint32_t i = 0; i < roundSamples; i++) {
+                int32_t sum = 0;
+                for (uint8_t channelIndex = 0; channelIndex < CHANNEL_COUNT; channelIndex++) {
+                    sum += block->channels[channelIndex][i];
+                }
+                block->mix[i] = sum / CHANNEL_COUNT;
+            }
+            block->sampleCount = roundSamples;
+            xQueueSend(filledBlocks, &block, portMAX_DELAY);
+
+            renderedSamples += roundSamples;
+            if (progress) {
+                progress(static_cast<float>(renderedSamples) / totalSamples);
+            }
+        }
+    }
+
+    // Stop tasks, writer finishes queued blocks first
+    if (workerHandle) {
+        stopping = true;
+        xSemaphoreGive(workerStart);
+        xSemaphoreTake(workerDone, portMAX_DELAY);
+    }
+    if (writerHandle) {
+        render_block_t* end = NULL;
+        xQueueSend(filledBlocks, &end, portMAX_DELAY);
+        xSemaphoreTake(writerDone, portMAX_DELAY);
+    }
+    xQueueReset(freeBlocks);
+    xQueueReset(filledBlocks);
+
+    ok = ok && !writeFailed;
+    for (uint8_t i = 0; i < outputCount; i++) {
+        closeOutput(&outputs[i]);
+        // Partial file would pass for a finished render
+        if (!ok) {
+            SD.remove(outputs[i].filename);
+        }
+    }
+    for (int i = 0; i < 2; i++) {
+        spiRamAllocator.deallocate(blocks[i].mix);
+        for (uint8_t channelIndex = 0; channelIndex < CHANNEL_COUNT; channelIndex++) {
+            spiRamAllocator.deallocate(blocks[i].channels[channelIndex]);
+        }
+        blocks[i] = {};
+    }
+    return ok;
+}
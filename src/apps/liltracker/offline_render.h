@@ -0,0 +1,77 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <lilka.h>
+
+#include "track.h"
+#include "synth.h"
+#include "wav_sink.h"
+
+// Samples rendered per round, each output file gets one write of this many samples per round.
+// Multiple of SYNTH_BUFFER_SIZE, and of SD sector size in bytes
+#define OFFLINE_RENDER_BLOCK_SIZE 8192
+// Channels rendered by the worker on the other core, the rest are rendered by the calling task
+#define OFFLINE_RENDER_WORKER_CHANNELS ((CHANNEL_COUNT + 1) / 2)
+// WAV data starts at this offset (header is padded with a JUNK chunk), so block writes stay sector-aligned
+#define OFFLINE_RENDER_DATA_OFFSET 512
+
+typedef struct {
+    // Samples of the mix and of each channel (stems), OFFLINE_RENDER_BLOCK_SIZE each
+    int16_t* mix;
+    int16_t* channels[CHANNEL_COUNT];
+    uint32_t sampleCount;
+} render_block_t;
+
+// Renders track to WAV as fast as possible, without going through Sequencer and a real-time sink.
+// Channels are split between two synths running on both cores, and SD writes are done by a separate
+// task from double-buffered blocks, so rendering doesn't wait for the card.
+class OfflineRenderer {
+public:
+    OfflineRenderer(Track* track, float masterVolume);
+    ~OfflineRenderer();
+
+    // Renders track from startPage to the end into filename. With stems, every channel is also saved
+    // into its own file, named like "<name>_ch1.wav". Progress (0..1) is reported after every block.
+    // Returns false if files can't be written or there's not enough memory, partial files are removed then
+    bool render(String filename, uint16_t startPage, bool stems, std::function<void(float)> progress);
+
+    static String stemFilename(String filename, uint8_t channelIndex);
+
+private:
+    typedef struct {
+        String filename;
+        File file;
+        uint32_t sampleCount;
+    } output_t;
+
+    static void workerTask(void* arg);
+    static void writerTask(void* arg);
+    // Renders given channels of the current round with the synth that owns them
+    void renderRound(Synth* synth, uint8_t firstChannel, uint8_t lastChannel);
+    bool openOutput(output_t* output, String filename);
+    void closeOutput(output_t* output);
+    void writeBlock(const render_block_t* block);
+
+    Track* track;
+    float masterVolume;
+    Synth* synths[2];
+
+    // Round that is currently rendered
+    render_block_t* roundBlock;
+    uint32_t roundSamples;
+    bool stopping;
+
+    output_t outputs[CHANNEL_COUNT + 1];
+    // Outputs that were created on SD
+    uint8_t outputCount;
+    // Set by writer task
+    std::atomic<bool> writeFailed;
+
+    render_block_t blocks[2];
+    QueueHandle_t freeBlocks;
+    QueueHandle_t filledBlocks;
+    SemaphoreHandle_t workerStart;
+    SemaphoreHandle_t workerDone;
+    SemaphoreHandle_t writerDone;
+};
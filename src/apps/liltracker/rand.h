@@ -1,26 +1,19 @@
+#pragma once
+
 #include <stdint.h>
 
-// So why do we need this?
-// - rand_r(seed) does not produce satisfactory results
-// - std::mt19937 is too slow
-// - std::minstd_rand0 does not seem random at all
-// - LFSR depends on state and it's hard to make it idempotent
-// So behold - Xoroshiro128+!
-// https://en.wikipedia.org/wiki/Xoroshiro128%2B
-// /AD
+// Noise used to be generated from scratch for every sample with Xoroshiro128+ seeded by time,
+// since stateful generators couldn't be used with time-based waveforms.
+// Now that every channel keeps its own phase, a plain 32-bit Galois LFSR is enough:
+// it's stepped once per waveform period, like NES noise channel does.
+// https://en.wikipedia.org/wiki/Linear-feedback_shift_register#Galois_LFSRs
+
+#define LFSR_SEED 0xACE1u
 
-class Xoroshiro128Plus {
-public:
-    explicit Xoroshiro128Plus(uint64_t seed);
-    uint64_t operator()();
-    inline uint64_t max() const {
-        return UINT64_MAX;
-    }
+// Maximal length taps for 32 bits: 32, 22, 2, 1
+#define LFSR_TAPS 0x80200003u
 
-private:
-    static uint64_t rotl(const uint64_t x, int k);
-    static uint64_t splitmix64(uint64_t x);
-    // We don't really need the state at all, since we always generate one number at a time for any given seed.
-    // Keeping it here in case we need to generate multiple numbers in the future.
-    uint64_t state[2];
-};
+inline uint32_t lfsr_next(uint32_t state) {
+    // Branchless: XOR taps in if lowest bit was set
+    return (state >> 1) ^ (-(state & 1u) & LFSR_TAPS);
+}
@@ -192,9 +192,8 @@ void Sequencer::singleEventTask() {
 
     while (1) {
         synth.render(audioBuffer, channelAudioBuffers, SYNTH_BUFFER_SIZE, masterVolume);
-        size_t sampWritten = sink->write(audioBuffer, SYNTH_BUFFER_SIZE);
+        writeBuffer(audioBuffer, SYNTH_BUFFER_SIZE);
         copyBuffers(audioBuffer, channelAudioBuffers);
-        synth.advanceTime(sampWritten);
         {
             Acquire acquire(xMutex);
             if (!playstate.playing) {
@@ -214,6 +213,18 @@ void Sequencer::multiEventTask() {
     sink->start();
     synth.reset();
 
+    // Synth applies events at their exact sample, so rows are queued ahead, right before the buffer
+    // they start in is rendered, and every buffer is rendered at full size
+    int64_t rowSample = 0;
+    // Row at current event index is yet to be queued
+    bool rowPending = true;
+    // Sample at which the last row of the track ends, -1 until it's queued
+    int64_t endSample = -1;
+    Synth* synths[CHANNEL_COUNT];
+    for (uint8_t channelIndex = 0; channelIndex < CHANNEL_COUNT; channelIndex++) {
+        synths[channelIndex] = &synth;
+    }
+
     while (1) {
         // Play the page.
         // If we reach the end of the page:
@@ -224,87 +235,111 @@ void Sequencer::multiEventTask() {
         // - Else, stop playing
         // If we stop playing, yield the task
 
+        float _masterVolume;
         {
             Acquire acquire(xMutex);
-            const page_t* page = playstate.track->getPage(playstate.pageIndex);
-            for (uint8_t channelIndex = 0; channelIndex < CHANNEL_COUNT; channelIndex++) {
-                Pattern* pattern = playstate.track->getPattern(page->patternIndices[channelIndex]);
-                event_t event = pattern->getChannelEvent(channelIndex, playstate.eventIndex);
-                if (event.type == EVENT_TYPE_OFF) {
-                    synth.setOff(channelIndex);
-                } else if (event.type == EVENT_TYPE_NORMAL) {
-                    synth.setFrequency(channelIndex, event.note.toFrequency());
-                }
-                if (event.waveform != WAVEFORM_CONT) {
-                    synth.setWaveform(channelIndex, event.waveform);
-                }
-                if (event.effect.type != EFFECT_TYPE_NONE) {
-                    synth.setEffect(channelIndex, event.effect);
+            if (!playstate.playing) {
+                break;
+            }
+            _masterVolume = masterVolume;
+
+            while (endSample < 0 && rowSample < synth.getCurrentSample() + SYNTH_BUFFER_SIZE) {
+                // Increment the event index, unless previous row didn't fit into synth event queue
+                if (!rowPending && ++playstate.eventIndex >= CHANNEL_SIZE) {
+                    // End of the page
+                    playstate.eventIndex = 0;
+                    int16_t nextPageIndex = playstate.pageIndex + 1;
+
+                    if (playstate.loopPage) {
+                        // Loop the page
+                    } else if (nextPageIndex < playstate.track->getPageCount()) {
+                        // Play the next page
+                        playstate.pageIndex = nextPageIndex;
+                    } else {
+                        // End of the track
+                        playstate.pageIndex = 0;
+                        if (playstate.loopTrack) {
+                            // Loop the track
+                        } else {
+                            // Stop playing once the last row is rendered
+                            endSample = rowSample;
+                            break;
+                        }
+                    }
                 }
-                if (event.volume) {
-                    synth.setVolume(channelIndex, ((float)event.volume) / MAX_VOLUME);
+                rowPending = true;
+
+                if (!queueRow(synths, playstate.track, playstate.pageIndex, playstate.eventIndex, rowSample)) {
+                    // Rendering drains the queue, row is queued again afterwards. Changes that did fit are
+                    // queued twice, which is harmless, since they set the same values at the same sample
+                    lilka::serial.log("Sequencer: synth event queue is full, row %d is delayed", playstate.eventIndex);
+                    break;
                 }
+                rowPending = false;
+                rowSample += SYNTH_SAMPLE_RATE * 60 / playstate.track->getBPM();
             }
         }
+
         // Render samples
-        size_t sampTotal = SYNTH_SAMPLE_RATE * 60 / playstate.track->getBPM();
-        size_t sampWritten = 0;
-        while (sampWritten < sampTotal) {
-            float _masterVolume;
-            {
-                Acquire acquire(xMutex);
-                if (!playstate.playing) {
-                    break;
-                }
-                _masterVolume = masterVolume;
-            }
-            size_t sampToWrite = sampTotal - sampWritten;
-            if (sampToWrite > SYNTH_BUFFER_SIZE) {
-                sampToWrite = SYNTH_BUFFER_SIZE;
-            }
+        size_t sampToWrite = SYNTH_BUFFER_SIZE;
+        if (endSample >= 0 && endSample - synth.getCurrentSample() < SYNTH_BUFFER_SIZE) {
+            sampToWrite = endSample - synth.getCurrentSample();
+        }
+        if (sampToWrite) {
             synth.render(audioBuffer, channelAudioBuffers, sampToWrite, _masterVolume);
-            size_t sampWrittenNow = sink->write(audioBuffer, sampToWrite);
-            synth.advanceTime(sampWrittenNow);
-            sampWritten += sampWrittenNow;
+            writeBuffer(audioBuffer, sampToWrite);
             copyBuffers(audioBuffer, channelAudioBuffers);
-            taskYIELD();
         }
-        // Increment the event index
-        {
+        if (endSample >= 0 && synth.getCurrentSample() >= endSample) {
             Acquire acquire(xMutex);
-            if (!playstate.playing) {
-                // Playback stopped while we were waiting
-                break;
-            }
-            playstate.eventIndex++;
-            if (playstate.eventIndex >= CHANNEL_SIZE) {
-                // End of the page
-                playstate.eventIndex = 0;
-                int16_t nextPageIndex = playstate.pageIndex + 1;
-
-                if (playstate.loopPage) {
-                    // Loop the page
-                } else if (nextPageIndex < playstate.track->getPageCount()) {
-                    // Play the next page
-                    playstate.pageIndex = nextPageIndex;
-                } else {
-                    // End of the track
-                    playstate.pageIndex = 0;
-                    if (playstate.loopTrack) {
-                        // Loop the track
-                    } else {
-                        // Stop playing
-                        playstate.playing = false;
-                        break;
-                    }
-                }
-            }
+            playstate.playing = false;
+            break;
         }
+        taskYIELD();
     }
 
     sink->stop();
 }
 
+bool Sequencer::queueRow(
+    Synth* const synths[CHANNEL_COUNT], Track* track, uint16_t pageIndex, uint16_t eventIndex, int64_t sample
+) {
+    const page_t* page = track->getPage(pageIndex);
+    bool queued = true;
+    for (uint8_t channelIndex = 0; channelIndex < CHANNEL_COUNT; channelIndex++) {
+        Synth* synth = synths[channelIndex];
+        Pattern* pattern = track->getPattern(page->patternIndices[channelIndex]);
+        event_t event = pattern->getChannelEvent(channelIndex, eventIndex);
+        if (event.type == EVENT_TYPE_OFF) {
+            queued &= synth->setOff(channelIndex, sample);
+        } else if (event.type == EVENT_TYPE_NORMAL) {
+            queued &= synth->setFrequency(channelIndex, event.note.toFrequency(), sample);
+        }
+        if (event.waveform != WAVEFORM_CONT) {
+            queued &= synth->setWaveform(channelIndex, event.waveform, sample);
+        }
+        if (event.effect.type != EFFECT_TYPE_NONE) {
+            queued &= synth->setEffect(channelIndex, event.effect, sample);
+        }
+        if (event.volume) {
+            queued &= synth->setVolume(channelIndex, ((float)event.volume) / MAX_VOLUME, sample);
+        }
+    }
+    return queued;
+}
+
+void Sequencer::writeBuffer(const int16_t* audioBuffer, size_t size) {
+    // Rendered samples can't be rendered again, so sinks that accept less than requested get the rest later
+    size_t written = 0;
+    while (written < size) {
+        size_t writtenNow = sink->write(audioBuffer + written, size - written);
+        if (!writtenNow) {
+            break;
+        }
+        written += writtenNow;
+    }
+}
+
 void Sequencer::copyBuffers(
     const int16_t* audioBuffer, const int16_t channelAudioBuffers[CHANNEL_COUNT][SYNTH_BUFFER_SIZE]
 ) {
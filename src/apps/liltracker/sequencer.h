@@ -28,10 +28,16 @@ public:
     void setMasterVolume(float volume);
     int16_t readBuffer(int16_t* targetBuffer);
     int16_t readBuffer(int16_t* targetBuffer, uint8_t channelIndex);
+    // Queues channel changes of a row, starting at given sample. Each channel goes to its own synth.
+    // Returns false if some of the changes didn't fit into synth event queue
+    static bool queueRow(
+        Synth* const synths[CHANNEL_COUNT], Track* track, uint16_t pageIndex, uint16_t eventIndex, int64_t sample
+    );
 
 private:
     void singleEventTask();
     void multiEventTask();
+    void writeBuffer(const int16_t* audioBuffer, size_t size);
     void copyBuffers(const int16_t* audioBuffer, const int16_t channelAudioBuffers[CHANNEL_COUNT][SYNTH_BUFFER_SIZE]);
     Synth synth;
     Sink* sink;
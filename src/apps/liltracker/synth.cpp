@@ -1,22 +1,15 @@
+#include <string.h>
 #include "synth.h"
-#include "keira/utils/acquire.h"
-#include "keira/mutex.h"
+#include "rand.h"
 
-Synth::Synth() : xMutex(xSemaphoreCreateMutex()), currentSample(0) {
-    for (int i = 0; i < CHANNEL_COUNT; i++) {
-        channelStates[i] = {
-            .waveform = WAVEFORM_SQUARE,
-            .frequency = 0.0f,
-            .volume = 1.0f,
-            .effect = {EFFECT_TYPE_NONE, 0},
-            .effectStartTime = 0.0f,
-        };
-    }
-    KMTX_UNLOCK(xMutex);
+Synth::Synth() : currentSample(0) {
+    waveforms_init();
+    reset();
 }
 
 void Synth::reset() {
-    Acquire lock(xMutex);
+    // Consumer may drop events on its own, producer only looks at eventsRead to check for free space
+    eventsRead = eventsWritten.load(std::memory_order_acquire);
     currentSample = 0;
     for (int i = 0; i < CHANNEL_COUNT; i++) {
         channelStates[i] = {
@@ -24,77 +17,228 @@ void Synth::reset() {
             .frequency = 0.0f,
             .volume = 1.0f,
             .effect = {EFFECT_TYPE_NONE, 0},
-            .effectStartTime = 0.0f,
+            .effectStartSample = 0,
+            .phase = 0,
+            .noiseState = LFSR_SEED,
+            .noiseValue = 0,
         };
     }
 }
 
-void Synth::setWaveform(uint8_t channelIndex, waveform_t waveform) {
-    Acquire lock(xMutex);
-    channelStates[channelIndex].waveform = waveform;
+bool Synth::pushEvent(const synth_event_t& event) {
+    uint32_t written = eventsWritten.load(std::memory_order_relaxed);
+    if (written - eventsRead.load(std::memory_order_acquire) >= SYNTH_EVENT_QUEUE_SIZE) {
+        return false;
+    }
+    events[written & (SYNTH_EVENT_QUEUE_SIZE - 1)] = event;
+    // Publish event only after it's fully written
+    eventsWritten.store(written + 1, std::memory_order_release);
+    return true;
+}
+
+bool Synth::setWaveform(uint8_t channelIndex, waveform_t waveform, int64_t sample) {
+    synth_event_t event = {.sample = sample, .type = SYNTH_EVENT_WAVEFORM, .channelIndex = channelIndex};
+    event.waveform = waveform;
+    return pushEvent(event);
 }
 
-void Synth::setFrequency(uint8_t channelIndex, float frequency) {
-    Acquire lock(xMutex);
-    channelStates[channelIndex].frequency = frequency;
+bool Synth::setFrequency(uint8_t channelIndex, float frequency, int64_t sample) {
+    synth_event_t event = {.sample = sample, .type = SYNTH_EVENT_FREQUENCY, .channelIndex = channelIndex};
+    event.value = frequency;
+    return pushEvent(event);
 }
 
-void Synth::setVolume(uint8_t channelIndex, float volume) {
-    Acquire lock(xMutex);
-    channelStates[channelIndex].volume = volume;
+bool Synth::setVolume(uint8_t channelIndex, float volume, int64_t sample) {
+    synth_event_t event = {.sample = sample, .type = SYNTH_EVENT_VOLUME, .channelIndex = channelIndex};
+    event.value = volume;
+    return pushEvent(event);
 }
 
-void Synth::setEffect(uint8_t channelIndex, effect_t effect) {
-    Acquire lock(xMutex);
-    channelStates[channelIndex].effect = effect;
-    channelStates[channelIndex].effectStartTime = currentSample * SYNTH_SECONDS_PER_SAMPLE;
+bool Synth::setEffect(uint8_t channelIndex, effect_t effect, int64_t sample) {
+    synth_event_t event = {.sample = sample, .type = SYNTH_EVENT_EFFECT, .channelIndex = channelIndex};
+    event.effect = effect;
+    return pushEvent(event);
 }
 
-void Synth::advanceTime(uint64_t sampleCount) {
-    Acquire lock(xMutex);
-    currentSample += sampleCount;
+bool Synth::setOff(uint8_t channelIndex, int64_t sample) {
+    synth_event_t event = {.sample = sample, .type = SYNTH_EVENT_OFF, .channelIndex = channelIndex};
+    return pushEvent(event);
+}
+
+int64_t Synth::getCurrentSample() {
+    return currentSample;
+}
+
+void Synth::applyEvent(const synth_event_t& event, int64_t sample) {
+    channel_state_t* channelState = &channelStates[event.channelIndex];
+    switch (event.type) {
+        case SYNTH_EVENT_WAVEFORM:
+            channelState->waveform = event.waveform;
+            break;
+        case SYNTH_EVENT_FREQUENCY:
+            channelState->frequency = event.value;
+            break;
+        case SYNTH_EVENT_VOLUME:
+            channelState->volume = event.value;
+            break;
+        case SYNTH_EVENT_EFFECT:
+            channelState->effect = event.effect;
+            // Late events still start the effect at the sample they were meant for
+            channelState->effectStartSample = event.sample == SYNTH_NOW ? sample : event.sample;
+            break;
+        case SYNTH_EVENT_OFF:
+            channelState->frequency = 0.0f;
+            break;
+    }
+}
+
+// Oscillator loop for one waveform. Gain is in Q15 with 8 extra bits of precision, for smooth ramps
+template <int32_t (*wave)(uint32_t)>
+static inline void synth_oscillate(
+    int16_t* buffer, uint32_t sampleCount, uint32_t* phase, uint32_t increment, int32_t gain, int32_t gainStep
+) {
+    uint32_t p = *phase;
+    for (uint32_t i = 0; i < sampleCount; i++) {
+        buffer[i] = (wave(p) * (gain >> 8)) >> 15;
+        p += increment;
+        gain += gainStep;
+    }
+    *phase = p;
+}
+
+// Noise holds a random value for a whole period, and takes a new one when phase wraps around
+static inline void synth_noise(
+    int16_t* buffer, uint32_t sampleCount, channel_state_t* channelState, uint32_t increment, int32_t gain,
+    int32_t gainStep
+) {
+    uint32_t p = channelState->phase;
+    for (uint32_t i = 0; i < sampleCount; i++) {
+        uint32_t next = p + increment;
+        if (next < p) {
+            channelState->noiseState = lfsr_next(channelState->noiseState);
+            channelState->noiseValue = static_cast<int32_t>(channelState->noiseState & 0xFFFF) - 32768;
+        }
+        p = next;
+        buffer[i] = (channelState->noiseValue * (gain >> 8)) >> 15;
+        gain += gainStep;
+    }
+    channelState->phase = p;
+}
+
+static inline int32_t synth_gain(float amplitude, float masterVolume) {
+    float gain = amplitude * masterVolume;
+    gain = gain < 0.0f ? 0.0f : (gain > 1.0f ? 1.0f : gain);
+    return gain * (32768 << 8);
+}
+
+void Synth::renderChannel(
+    channel_state_t* channelState, int16_t* buffer, int64_t startSample, uint32_t sampleCount, float masterVolume
+) {
+    if (channelState->frequency == 0.0f) {
+        memset(buffer, 0, sizeof(int16_t) * sampleCount);
+        return;
+    }
+    effect_t effect = channelState->effect;
+    effect_fn_t effect_fn = effect_functions[effect.type];
+
+    for (uint32_t blockStart = 0; blockStart < sampleCount; blockStart += SYNTH_CONTROL_BLOCK_SIZE) {
+        uint32_t blockSize = sampleCount - blockStart;
+        if (blockSize > SYNTH_CONTROL_BLOCK_SIZE) {
+            blockSize = SYNTH_CONTROL_BLOCK_SIZE;
+        }
+
+        // Effects are evaluated at both ends of the block. Frequency is taken from the start,
+        // while phase offset (vibrato) and amplitude (tremolo, volume slide) are interpolated.
+        // Relative time is taken from integer sample offset since effect start, so it stays exact
+        // no matter how long the song plays. Absolute time is only used for periodic modulation.
+        int64_t blockStartSample = startSample + blockStart;
+        int64_t blockEndSample = blockStartSample + blockSize;
+        float startTime = blockStartSample / static_cast<double>(SYNTH_SAMPLE_RATE);
+        float endTime = blockEndSample / static_cast<double>(SYNTH_SAMPLE_RATE);
+        int64_t effectOffset = blockStartSample - channelState->effectStartSample;
+        float startRelTime = effectOffset / static_cast<float>(SYNTH_SAMPLE_RATE);
+        float endRelTime = (effectOffset + blockSize) / static_cast<float>(SYNTH_SAMPLE_RATE);
+        float startFrequency = channelState->frequency, endFrequency = channelState->frequency;
+        float startVolume = channelState->volume, endVolume = channelState->volume;
+        float startPhase = 0.0f, endPhase = 0.0f;
+        effect_fn(startTime, startRelTime, &startFrequency, &startVolume, &startPhase, effect.param);
+        effect_fn(endTime, endRelTime, &endFrequency, &endVolume, &endPhase, effect.param);
+
+        // Frequencies above Nyquist would alias anyway
+        if (startFrequency > SYNTH_SAMPLE_RATE / 2) {
+            startFrequency = SYNTH_SAMPLE_RATE / 2;
+        }
+        uint32_t increment = startFrequency * (4294967296.0f / SYNTH_SAMPLE_RATE);
+        increment += static_cast<int32_t>((endPhase - startPhase) * 4294967296.0f / blockSize);
+        int32_t gain = synth_gain(startVolume, masterVolume);
+        int32_t gainStep = (synth_gain(endVolume, masterVolume) - gain) / static_cast<int32_t>(blockSize);
+
+        int16_t* block = buffer + blockStart;
+        uint32_t* phase = &channelState->phase;
+        switch (channelState->waveform) {
+            case WAVEFORM_SAWTOOTH:
+                synth_oscillate<wave_sawtooth>(block, blockSize, phase, increment, gain, gainStep);
+                break;
+            case WAVEFORM_TRIANGLE:
+                synth_oscillate<wave_triangle>(block, blockSize, phase, increment, gain, gainStep);
+                break;
+            case WAVEFORM_SINE:
+                synth_oscillate<wave_sine>(block, blockSize, phase, increment, gain, gainStep);
+                break;
+            case WAVEFORM_NOISE:
+                synth_noise(block, blockSize, channelState, increment, gain, gainStep);
+                break;
+            default:
+                synth_oscillate<wave_square>(block, blockSize, phase, increment, gain, gainStep);
+                break;
+        }
+    }
 }
 
 void Synth::render(
     int16_t combinedBuffer[SYNTH_BUFFER_SIZE], int16_t channelBuffers[CHANNEL_COUNT][SYNTH_BUFFER_SIZE],
     uint32_t sampleCount, float masterVolume
 ) {
-    Acquire lock(xMutex);
-    for (int16_t i = 0; i < sampleCount; i++) {
-        float timeSec = ((float)currentSample + i) * SYNTH_SECONDS_PER_SAMPLE;
-        for (uint8_t channelIndex = 0; channelIndex < CHANNEL_COUNT; channelIndex++) {
-            // event_t event = events[channelIndex];
-            const channel_state_t* channelState = &channelStates[channelIndex];
-            waveform_fn_t waveform_fn = waveform_functions[channelState->waveform];
-            float relTime = timeSec - channelState->effectStartTime;
-            float modFrequency = channelState->frequency;
-            if (modFrequency == 0.0f) {
-                channelBuffers[channelIndex][i] = 0;
-            } else {
-                float modVolume = channelState->volume;
-                float modPhase = 0.0;
-                effect_t effect = channelState->effect;
-                effect_fn_t effect_fn = effect_functions[effect.type];
-                effect_fn(timeSec, relTime, &modFrequency, &modVolume, &modPhase, effect.param);
-                channelBuffers[channelIndex][i] =
-                    waveform_fn(timeSec, modFrequency, modVolume, modPhase) * masterVolume * 32767;
+    // Buffer is rendered in segments split at event times
+    uint32_t offset = 0;
+    while (offset < sampleCount) {
+        int64_t segmentStart = currentSample + offset;
+        uint32_t segmentEnd = sampleCount;
+        uint32_t read = eventsRead.load(std::memory_order_relaxed);
+        uint32_t written = eventsWritten.load(std::memory_order_acquire);
+        for (; read != written; read++) {
+            const synth_event_t& event = events[read & (SYNTH_EVENT_QUEUE_SIZE - 1)];
+            if (event.sample > segmentStart) {
+                if (event.sample - currentSample < segmentEnd) {
+                    segmentEnd = event.sample - currentSample;
+                }
+                break;
             }
+            applyEvent(event, segmentStart);
         }
-    }
-    for (int16_t i = 0; i < sampleCount; i++) {
-        combinedBuffer[i] = 0;
+        eventsRead.store(read, std::memory_order_release);
+
         for (uint8_t channelIndex = 0; channelIndex < CHANNEL_COUNT; channelIndex++) {
-            combinedBuffer[i] += channelBuffers[channelIndex][i];
+            renderChannel(
+                &channelStates[channelIndex],
+                channelBuffers[channelIndex] + offset,
+                segmentStart,
+                segmentEnd - offset,
+                masterVolume
+            );
         }
-        combinedBuffer[i] /= CHANNEL_COUNT;
+        offset = segmentEnd;
     }
-}
+    currentSample += sampleCount;
 
-void Synth::setOff(uint8_t channelIndex) {
-    Acquire lock(xMutex);
-    channelStates[channelIndex].frequency = 0.0f;
+    for (uint32_t i = 0; i < sampleCount; i++) {
+        int32_t sum = 0;
+        for (uint8_t channelIndex = 0; channelIndex < CHANNEL_COUNT; channelIndex++) {
+            sum += channelBuffers[channelIndex][i];
+        }
+        combinedBuffer[i] = sum / CHANNEL_COUNT;
+    }
 }
 
 Synth::~Synth() {
-    vSemaphoreDelete(xMutex);
 }
@@ -1,7 +1,6 @@
 #pragma once
 
-#include <FreeRTOS.h>
-#include <semphr.h>
+#include <atomic>
 
 #include "config.h"
 #include "waveforms.h"
@@ -11,6 +10,12 @@
 #define SYNTH_SAMPLE_RATE 44100
 // #define SYNTH_BUFFER_DURATION_MS (SYNTH_BUFFER_SIZE * 1000 / SYNTH_SAMPLE_RATE)
 #define SYNTH_SECONDS_PER_SAMPLE (1.0f / SYNTH_SAMPLE_RATE)
+// Effects are evaluated once per this many samples, and interpolated in between
+#define SYNTH_CONTROL_BLOCK_SIZE 32
+// Max amount of events waiting to be applied, must be a power of two
+#define SYNTH_EVENT_QUEUE_SIZE 256
+// Event time for changes that should be applied at the start of the next rendered buffer
+#define SYNTH_NOW -1
 
 typedef struct {
     waveform_t waveform;
@@ -19,27 +24,69 @@ typedef struct {
     // TODO: Research how effects should generally be handled in NES & 6581, since things seem weird:
     // some effects are cancelled by others, some are reset by OFF, etc... /AD
     effect_t effect;
-    float effectStartTime;
+    // Sample at which current effect started
+    int64_t effectStartSample;
+    // Oscillator: full turn of phase is 2^32
+    uint32_t phase;
+    uint32_t noiseState;
+    int32_t noiseValue;
 } channel_state_t;
 
+typedef enum {
+    SYNTH_EVENT_WAVEFORM,
+    SYNTH_EVENT_FREQUENCY,
+    SYNTH_EVENT_VOLUME,
+    SYNTH_EVENT_EFFECT,
+    SYNTH_EVENT_OFF,
+} synth_event_type_t;
+
+typedef struct {
+    // Sample at which event is applied, or SYNTH_NOW
+    int64_t sample;
+    synth_event_type_t type;
+    uint8_t channelIndex;
+    union {
+        waveform_t waveform;
+        float value;
+        effect_t effect;
+    };
+} synth_event_t;
+
+// Channel changes are queued as timestamped events and applied by render() exactly at their sample,
+// so notes don't snap to buffer boundaries. Queue has a single producer (the thread calling setters)
+// and a single consumer (the thread calling reset() and render()), and takes no locks.
+// Events must be queued in order of their time. Events that are already late are applied immediately.
 class Synth {
 public:
     Synth();
     ~Synth();
+    // Drops queued events and resets time and channels. Called from rendering thread
     void reset();
-    void setWaveform(uint8_t channelIndex, waveform_t waveform);
-    void setFrequency(uint8_t channelIndex, float frequency);
-    void setVolume(uint8_t channelIndex, float volume);
-    void setEffect(uint8_t channelIndex, effect_t effect);
-    void setOff(uint8_t channelIndex);
-    void advanceTime(uint64_t sampleCount);
+    // Setters return false if event queue is full
+    bool setWaveform(uint8_t channelIndex, waveform_t waveform, int64_t sample = SYNTH_NOW);
+    bool setFrequency(uint8_t channelIndex, float frequency, int64_t sample = SYNTH_NOW);
+    bool setVolume(uint8_t channelIndex, float volume, int64_t sample = SYNTH_NOW);
+    bool setEffect(uint8_t channelIndex, effect_t effect, int64_t sample = SYNTH_NOW);
+    bool setOff(uint8_t channelIndex, int64_t sample = SYNTH_NOW);
+    // Sample at which next render() starts. Only valid in rendering thread
+    int64_t getCurrentSample();
+    // Renders next sampleCount samples, applying events that fall within them, and advances time
     void render(
         int16_t combinedBuffer[SYNTH_BUFFER_SIZE], int16_t channelBuffers[CHANNEL_COUNT][SYNTH_BUFFER_SIZE],
         uint32_t sampleCount, float masterVolume
     );
 
 private:
-    SemaphoreHandle_t xMutex;
+    bool pushEvent(const synth_event_t& event);
+    void applyEvent(const synth_event_t& event, int64_t sample);
+    void renderChannel(
+        channel_state_t* channelState, int16_t* buffer, int64_t startSample, uint32_t sampleCount, float masterVolume
+    );
     int64_t currentSample;
     channel_state_t channelStates[CHANNEL_COUNT];
+
+    synth_event_t events[SYNTH_EVENT_QUEUE_SIZE];
+    // Free-running counters, queued events are [eventsRead, eventsWritten)
+    std::atomic<uint32_t> eventsRead{0};
+    std::atomic<uint32_t> eventsWritten{0};
 };
@@ -21,22 +21,34 @@ const waveform_t waveforms[WAVEFORM_COUNT] = {
     WAVEFORM_NOISE,
 };
 
-typedef float (*waveform_fn_t)(float time, float frequency, float amplitude, float phase);
-
-// float silence(float time, float frequency, float amplitude, float phase);
-float triangle(float time, float frequency, float amplitude, float phase);
-// float sine(float time, float frequency, float amplitude, float phase);
-float fast_sine(float time, float frequency, float amplitude, float phase);
-float square(float time, float frequency, float amplitude, float phase);
-float sawtooth(float time, float frequency, float amplitude, float phase);
-float noise(float time, float frequency, float amplitude, float phase);
-
-const waveform_fn_t waveform_functions[WAVEFORM_COUNT] = {
-    0,
-    // silence,
-    square,
-    sawtooth,
-    triangle,
-    fast_sine,
-    noise,
-};
+// Waveforms are functions of 32-bit phase (full turn is 2^32) returning samples in range [-32767; 32767]
+
+#define WAVEFORM_SINE_TABLE_BITS 10
+#define WAVEFORM_SINE_TABLE_SIZE (1 << WAVEFORM_SINE_TABLE_BITS)
+
+extern int16_t sine_table[WAVEFORM_SINE_TABLE_SIZE];
+
+// Fills sine table, safe to call more than once
+void waveforms_init();
+
+inline int32_t wave_square(uint32_t phase) {
+    // High during first half of period
+    return 32767 - static_cast<int32_t>(phase >> 31) * 65534;
+}
+
+inline int32_t wave_sawtooth(uint32_t phase) {
+    // Rises from -1 to 1 over period
+    return static_cast<int32_t>(phase >> 16) - 32768;
+}
+
+inline int32_t wave_triangle(uint32_t phase) {
+    // Starts at 1, falls to -1 at half of period and rises back
+    int32_t x = static_cast<int32_t>(phase >> 15) - 65536;
+    int32_t sign = x >> 31;
+    int32_t value = ((x ^ sign) - sign) - 32768;
+    return value > 32767 ? 32767 : value;
+}
+
+inline int32_t wave_sine(uint32_t phase) {
+    return sine_table[phase >> (32 - WAVEFORM_SINE_TABLE_BITS)];
+}
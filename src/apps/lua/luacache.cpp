@@ -0,0 +1,292 @@
+#include "luacache.h"
+#include <sys/stat.h>
+#include <algorithm>
+#include "keira/mutex.h"
+#include "keira/utils/mem.h"
+#include "keira/crypto/fnv-1a-32.h"
+
+#define LUA_CACHE_MAGIC 0x4843554C // "LUCH"
+
+// Cache file layout: header, source path (without terminating zero), dumped chunk
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t pathLength;
+    uint32_t sourceSize;
+    int64_t sourceMtime;
+    uint32_t chunkSize;
+    uint32_t chunkHash;
+} LuaCacheHeader;
+
+typedef struct {
+    char* path;
+    uint32_t sourceSize;
+    int64_t sourceMtime;
+    char* chunk;
+    size_t chunkSize;
+    uint32_t lastUse;
+    // Loads reading chunk without cacheMutex held. Pinned entry is only marked stale on eviction,
+    // last load to finish frees it
+    uint16_t pins;
+    bool stale;
+} LuaCacheEntry;
+
+typedef struct {
+    char* data;
+    size_t size;
+    size_t capacity;
+    bool failed;
+} LuaDumpBuffer;
+
+static SemaphoreHandle_t cacheMutex = xSemaphoreCreateMutex();
+static LuaCacheEntry cacheEntries[LUA_MODULE_CACHE_ENTRIES];
+static size_t cacheUsed = 0;
+static uint32_t cacheClock = 0;
+
+static void lua_cache_mem_evict(LuaCacheEntry* entry) {
+    if (entry->pins) {
+        entry->stale = true;
+        return;
+    }
+    cacheUsed -= entry->chunkSize;
+    spiRamAllocator.deallocate(entry->path);
+    spiRamAllocator.deallocate(entry->chunk);
+    *entry = {};
+}
+
+// Must be called with cacheMutex held. Stale entry for the same path is evicted
+static LuaCacheEntry* lua_cache_mem_find(const char* path, const struct stat* st) {
+    for (int i = 0; i < LUA_MODULE_CACHE_ENTRIES; i++) {
+        LuaCacheEntry* entry = &cacheEntries[i];
+        if (entry->path && !entry->stale && strcmp(entry->path, path) == 0) {
+            if (entry->sourceSize == static_cast<uint32_t>(st->st_size) && entry->sourceMtime == st->st_mtime) {
+                entry->lastUse = ++cacheClock;
+                return entry;
+            }
+            lua_cache_mem_evict(entry);
+            return NULL;
+        }
+    }
+    return NULL;
+}
+
+// Takes ownership of chunk
+static void lua_cache_mem_put(const char* path, const struct stat* st, char* chunk, size_t chunkSize) {
+    if (chunkSize > LUA_MODULE_CACHE_SIZE) {
+        spiRamAllocator.deallocate(chunk);
+        return;
+    }
+    size_t pathLength = strlen(path);
+    char* pathCopy = static_cast<char*>(spiRamAllocator.allocate(pathLength + 1));
+    if (!pathCopy) {
+        spiRamAllocator.deallocate(chunk);
+        return;
+    }
+    memcpy(pathCopy, path, pathLength + 1);
+
+    KMTX_LOCK(cacheMutex);
+    // Previous version of the same file
+    for (int i = 0; i < LUA_MODULE_CACHE_ENTRIES; i++) {
+        if (cacheEntries[i].path && strcmp(cacheEntries[i].path, path) == 0) {
+            lua_cache_mem_evict(&cacheEntries[i]);
+        }
+    }
+    // Evict least recently used entries until chunk fits and there's a free slot
+    while (true) {
+        LuaCacheEntry* slot = NULL;
+        LuaCacheEntry* oldest = NULL;
+        for (int i = 0; i < LUA_MODULE_CACHE_ENTRIES; i++) {
+            LuaCacheEntry* entry = &cacheEntries[i];
+            if (!entry->path) {
+                slot = entry;
+            } else if (!entry->pins && (!oldest || entry->lastUse < oldest->lastUse)) {
+                oldest = entry;
+            }
+        }
+        if (slot && cacheUsed + chunkSize <= LUA_MODULE_CACHE_SIZE) {
+            *slot = {pathCopy, static_cast<uint32_t>(st->st_size), st->st_mtime, chunk, chunkSize, ++cacheClock};
+            cacheUsed += chunkSize;
+            KMTX_UNLOCK(cacheMutex);
+            return;
+        }
+        if (!oldest) break;
+        lua_cache_mem_evict(oldest);
+    }
+    KMTX_UNLOCK(cacheMutex);
+
+    // Everything left is being loaded right now, don't cache this one
+    spiRamAllocator.deallocate(pathCopy);
+    spiRamAllocator.deallocate(chunk);
+}
+
+static String lua_cache_file_path(const char* path) {
+    char name[16];
+    snprintf(name, sizeof(name), "%08lx.luac", static_cast<unsigned long>(fnv_32a_cstr(path, FNV_1A_INITIAL_HVAL)));
+    return String(LUA_CACHE_DIR "/") + name;
+}
+
+// Returns chunk from cache file allocated in PSRAM, or NULL if it's missing or outdated
+static char* lua_cache_file_load(const char* path, const struct stat* st, size_t* chunkSize) {
+    String cachePath = lua_cache_file_path(path);
+    FILE* fp = fopen(cachePath.c_str(), "rb");
+    if (!fp) {
+        return NULL;
+    }
+
+    LuaCacheHeader header;
+    size_t pathLength = strlen(path);
+    bool ok = fread(&header, sizeof(header), 1, fp) == 1 && header.magic == LUA_CACHE_MAGIC &&
+              header.version == LUA_CACHE_VERSION && header.pathLength == pathLength &&
+              header.sourceSize == static_cast<uint32_t>(st->st_size) && header.sourceMtime == st->st_mtime;
+
+    // Different paths can have the same hash, so path is stored in file too
+    char* chunk = NULL;
+    if (ok) {
+        chunk = static_cast<char*>(spiRamAllocator.allocate(std::max(pathLength, static_cast<size_t>(header.chunkSize))));
+        ok = chunk && fread(chunk, 1, pathLength, fp) == pathLength && memcmp(chunk, path, pathLength) == 0;
+    }
+    if (ok) {
+        ok = fread(chunk, 1, header.chunkSize, fp) == header.chunkSize &&
+             fnv_32a_buf(chunk, header.chunkSize, FNV_1A_INITIAL_HVAL) == header.chunkHash;
+    }
+    fclose(fp);
+
+    if (!ok) {
+        spiRamAllocator.deallocate(chunk);
+        return NULL;
+    }
+    *chunkSize = header.chunkSize;
+    return chunk;
+}
+
+static void lua_cache_file_save(const char* path, const struct stat* st, const char* chunk, size_t chunkSize) {
+    LuaCacheHeader header = {};
+    header.magic = LUA_CACHE_MAGIC;
+    header.version = LUA_CACHE_VERSION;
+    header.pathLength = strlen(path);
+    header.sourceSize = st->st_size;
+    header.sourceMtime = st->st_mtime;
+    header.chunkSize = chunkSize;
+    header.chunkHash = fnv_32a_buf(chunk, chunkSize, FNV_1A_INITIAL_HVAL);
+
+    String cachePath = lua_cache_file_path(path);
+    FILE* fp = fopen(cachePath.c_str(), "wb");
+    if (!fp) {
+        // Cache dir is created on first use
+        mkdir(LUA_CACHE_DIR, 0755);
+        fp = fopen(cachePath.c_str(), "wb");
+    }
+    if (!fp) {
+        lilka::serial.log("lua: cannot write bytecode cache %s", cachePath.c_str());
+        return;
+    }
+    bool ok = fwrite(&header, sizeof(header), 1, fp) == 1 &&
+              fwrite(path, 1, header.pathLength, fp) == header.pathLength &&
+              fwrite(chunk, 1, chunkSize, fp) == chunkSize;
+    if (fclose(fp) != 0 || !ok) {
+        lilka::serial.log("lua: failed to write bytecode cache %s", cachePath.c_str());
+        remove(cachePath.c_str());
+    }
+}
+
+static int lua_cache_writer(lua_State* L, const void* p, size_t size, void* ud) {
+    LuaDumpBuffer* buffer = static_cast<LuaDumpBuffer*>(ud);
+    if (buffer->size + size > buffer->capacity) {
+        size_t capacity = std::max(buffer->capacity * 2, buffer->size + size);
+        char* data = static_cast<char*>(spiRamAllocator.reallocate(buffer->data, capacity));
+        if (!data) {
+            buffer->failed = true;
+            return 1;
+        }
+        buffer->data = data;
+        buffer->capacity = capacity;
+    }
+    memcpy(buffer->data + buffer->size, p, size);
+    buffer->size += size;
+    return 0;
+}
+
+int lua_cache_loadfile(lua_State* L, const char* path) {
+    struct stat st;
+    if (stat(path, &st) != 0) {
+        // Let Lua report missing file as usual
+        return luaL_loadfile(L, path);
+    }
+    String chunkname = String("@") + path;
+
+    // Fast path: chunk is already in PSRAM. Entry is pinned rather than kept locked while Lua parses it,
+    // so other Lua apps aren't held up, and loads nested in the same task don't deadlock
+    KMTX_LOCK(cacheMutex);
+    LuaCacheEntry* entry = lua_cache_mem_find(path, &st);
+    if (entry) entry->pins++;
+    KMTX_UNLOCK(cacheMutex);
+    if (entry) {
+        int status = luaL_loadbufferx(L, entry->chunk, entry->chunkSize, chunkname.c_str(), "b");
+        KMTX_LOCK(cacheMutex);
+        entry->pins--;
+        // Chunk that doesn't load is of no use, and stale one was waiting for us to finish
+        if (status != LUA_OK || entry->stale) lua_cache_mem_evict(entry);
+        KMTX_UNLOCK(cacheMutex);
+        if (status == LUA_OK) return LUA_OK;
+        lua_pop(L, 1);
+    }
+
+    size_t chunkSize;
+    char* chunk = lua_cache_file_load(path, &st, &chunkSize);
+    if (chunk) {
+        if (luaL_loadbufferx(L, chunk, chunkSize, chunkname.c_str(), "b") == LUA_OK) {
+            lua_cache_mem_put(path, &st, chunk, chunkSize);
+            return LUA_OK;
+        }
+        // Chunk from incompatible Lua build, compile again
+        lua_pop(L, 1);
+        spiRamAllocator.deallocate(chunk);
+    }
+
+    lilka::serial.log("lua: compiling %s", path);
+    int status = luaL_loadfile(L, path);
+    if (status != LUA_OK) {
+        return status;
+    }
+    LuaDumpBuffer buffer = {};
+    lua_dump(L, lua_cache_writer, &buffer, 0);
+    if (buffer.failed) {
+        spiRamAllocator.deallocate(buffer.data);
+        return LUA_OK;
+    }
+    lua_cache_file_save(path, &st, buffer.data, buffer.size);
+    lua_cache_mem_put(path, &st, buffer.data, buffer.size);
+    return LUA_OK;
+}
+
+// Same as standard Lua file searcher, except file is loaded with lua_cache_loadfile()
+static int lua_cache_searcher(lua_State* L) {
+    const char* name = luaL_checkstring(L, 1);
+    lua_getfield(L, lua_upvalueindex(1), "searchpath");
+    lua_pushstring(L, name);
+    lua_getfield(L, lua_upvalueindex(1), "path");
+    lua_call(L, 2, 2);
+    if (lua_isnil(L, -2)) {
+        // Error message listing tried files
+        return 1;
+    }
+    const char* filename = lua_tostring(L, -2);
+    if (lua_cache_loadfile(L, filename) != LUA_OK) {
+        return luaL_error(
+            L, "error loading module '%s' from file '%s':\n\t%s", name, filename, lua_tostring(L, -1)
+        );
+    }
+    lua_pushstring(L, filename);
+    return 2;
+}
+
+void lua_cache_register_searcher(lua_State* L) {
+    // package.searchers[2] is the Lua file searcher, [1] is preload
+    lua_getglobal(L, "package");
+    lua_getfield(L, -1, "searchers");
+    // Keep package table as upvalue, like standard searchers do
+    lua_pushvalue(L, -2);
+    lua_pushcclosure(L, lua_cache_searcher, 1);
+    lua_rawseti(L, -2, 2);
+    lua_pop(L, 2);
+}
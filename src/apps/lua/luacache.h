@@ -0,0 +1,26 @@
+#pragma once
+
+#include <lua.hpp>
+#include <lilka.h>
+
+// Compiled chunks are stored in this directory, one file per source path.
+// Bump version when file layout changes, so that old files are ignored.
+#ifndef LUA_CACHE_DIR
+#    define LUA_CACHE_DIR LILKA_SD_ROOT "/.luacache"
+#endif
+#define LUA_CACHE_VERSION 1
+
+// In-memory (PSRAM) cache of compiled chunks, shared by all Lua apps during session
+#ifndef LUA_MODULE_CACHE_SIZE
+#    define LUA_MODULE_CACHE_SIZE (512 * 1024)
+#endif
+#ifndef LUA_MODULE_CACHE_ENTRIES
+#    define LUA_MODULE_CACHE_ENTRIES 32
+#endif
+
+/// Load Lua file as a chunk, same as luaL_loadfile(), but reuse compiled bytecode if source is unchanged.
+/// Chunks are looked up in PSRAM cache first, then in LUA_CACHE_DIR. If both miss, source is compiled and cached.
+int lua_cache_loadfile(lua_State* L, const char* path);
+
+/// Replace Lua file searcher in package.searchers, so require() goes through lua_cache_loadfile().
+void lua_cache_register_searcher(lua_State* L);
@@ -0,0 +1,206 @@
+#include "lualilka_drawlist.h"
+#include "keira/keira.h"
+#include "lualilka_display.h"
+#include "keira/utils/drawlist.h"
+
+#define DRAWLIST_PTR(x) static_cast<DrawList**>(x)
+
+static DrawList* lualilka_drawlist_check(lua_State* L) {
+    DrawList** userdata = DRAWLIST_PTR(luaL_checkudata(L, 1, DRAW_LIST));
+    return *userdata;
+}
+
+static lilka::Image* lualilka_drawlist_check_image(lua_State* L, int index) {
+    luaL_checktype(L, index, LUA_TTABLE);
+    lua_getfield(L, index, "pointer");
+    if (!lua_islightuserdata(L, -1)) {
+        luaL_error(L, K_S_LUA_DISPLAY_INVALID_IMAGE);
+    }
+    lilka::Image* image = static_cast<lilka::Image*>(lua_touserdata(L, -1));
+    lua_pop(L, 1);
+    return image;
+}
+
+static int lualilka_create_object_drawlist(lua_State* L) {
+    DrawList** userdata = DRAWLIST_PTR(lua_newuserdata(L, sizeof(DrawList*)));
+    *userdata = new DrawList();
+    luaL_setmetatable(L, DRAW_LIST);
+    return 1;
+}
+
+static int lualilka_delete_object_drawlist(lua_State* L) {
+    DrawList** userdata = DRAWLIST_PTR(luaL_checkudata(L, 1, DRAW_LIST));
+    if (*userdata) {
+        delete *userdata;
+        *userdata = nullptr;
+    }
+    return 0;
+}
+
+// Appends command of given type, record values are taken from arguments starting at 2
+static int lualilka_drawlist_push_args(lua_State* L, DrawCommandType type) {
+    DrawList* list = lualilka_drawlist_check(L);
+    int32_t values[DRAW_LIST_MAX_RECORD_SIZE];
+    for (int i = 0; i < DrawList::recordSize[type]; i++) {
+        values[i] = luaL_checknumber(L, i + 2);
+    }
+    if (!list->push(type, values)) {
+        return luaL_error(L, "draw list: out of memory");
+    }
+    return 0;
+}
+
+static int lualilka_drawlist_pixel(lua_State* L) {
+    return lualilka_drawlist_push_args(L, DRAW_CMD_PIXEL);
+}
+
+static int lualilka_drawlist_line(lua_State* L) {
+    return lualilka_drawlist_push_args(L, DRAW_CMD_LINE);
+}
+
+static int lualilka_drawlist_rect(lua_State* L) {
+    return lualilka_drawlist_push_args(L, DRAW_CMD_RECT);
+}
+
+static int lualilka_drawlist_fillRect(lua_State* L) {
+    return lualilka_drawlist_push_args(L, DRAW_CMD_FILL_RECT);
+}
+
+static int lualilka_drawlist_circle(lua_State* L) {
+    return lualilka_drawlist_push_args(L, DRAW_CMD_CIRCLE);
+}
+
+static int lualilka_drawlist_fillCircle(lua_State* L) {
+    return lualilka_drawlist_push_args(L, DRAW_CMD_FILL_CIRCLE);
+}
+
+static int lualilka_drawlist_addImage(lua_State* L) {
+    DrawList* list = lualilka_drawlist_check(L);
+    int id = list->addImage(lualilka_drawlist_check_image(L, 2));
+    if (id < 0) {
+        return luaL_error(L, "draw list: too many images");
+    }
+    lua_pushinteger(L, id);
+    return 1;
+}
+
+static int lualilka_drawlist_image(lua_State* L) {
+    DrawList* list = lualilka_drawlist_check(L);
+    int id = list->addImage(lualilka_drawlist_check_image(L, 2));
+    if (id < 0) {
+        return luaL_error(L, "draw list: too many images");
+    }
+    int32_t values[] = {id, static_cast<int32_t>(luaL_checknumber(L, 3)), static_cast<int32_t>(luaL_checknumber(L, 4))};
+    if (!list->push(DRAW_CMD_IMAGE, values)) {
+        return luaL_error(L, "draw list: out of memory");
+    }
+    return 0;
+}
+
+// list:add(records) - records is a flat array of {type, values..., type, values...}
+// list:add(records, type) - records is a flat array of values for commands of the same type
+static int lualilka_drawlist_add(lua_State* L) {
+    DrawList* list = lualilka_drawlist_check(L);
+    luaL_checktype(L, 2, LUA_TTABLE);
+    bool sameType = !lua_isnoneornil(L, 3);
+    lua_Integer type = sameType ? luaL_checkinteger(L, 3) : 0;
+    if (type < 0 || type >= DRAW_CMD_COUNT) {
+        return luaL_error(L, "draw list: unknown command type %d", static_cast<int>(type));
+    }
+    lua_Integer len = lua_rawlen(L, 2);
+    if (sameType) {
+        list->reserve(len / DrawList::recordSize[type]);
+    }
+
+    int32_t values[DRAW_LIST_MAX_RECORD_SIZE];
+    lua_Integer i = 1;
+    while (i <= len) {
+        if (!sameType) {
+            lua_rawgeti(L, 2, i++);
+            type = lua_tointeger(L, -1);
+            lua_pop(L, 1);
+            if (type < 0 || type >= DRAW_CMD_COUNT) {
+                return luaL_error(L, "draw list: unknown command type at %d", static_cast<int>(i - 1));
+            }
+        }
+        uint8_t size = DrawList::recordSize[type];
+        if (i + size - 1 > len) {
+            return luaL_error(L, "draw list: incomplete record at %d", static_cast<int>(i));
+        }
+        for (uint8_t j = 0; j < size; j++) {
+            lua_rawgeti(L, 2, i++);
+            values[j] = lua_tonumber(L, -1);
+            lua_pop(L, 1);
+        }
+        if (!list->push(static_cast<DrawCommandType>(type), values)) {
+            return luaL_error(L, "draw list: invalid record at %d", static_cast<int>(i - size));
+        }
+    }
+    return 0;
+}
+
+static int lualilka_drawlist_clear(lua_State* L) {
+    lualilka_drawlist_check(L)->clear();
+    return 0;
+}
+
+static int lualilka_drawlist_size(lua_State* L) {
+    lua_pushinteger(L, lualilka_drawlist_check(L)->size());
+    return 1;
+}
+
+static int lualilka_drawlist_draw(lua_State* L) {
+    lualilka_drawlist_check(L)->draw(getDrawable(L));
+    return 0;
+}
+
+static const luaL_Reg lualilka_drawlist[] = {
+    {"new", lualilka_create_object_drawlist},
+    {nullptr, nullptr},
+};
+
+static const luaL_Reg lualilka_drawlist_methods[] = {
+    {"pixel", lualilka_drawlist_pixel},
+    {"line", lualilka_drawlist_line},
+    {"rect", lualilka_drawlist_rect},
+    {"fill_rect", lualilka_drawlist_fillRect},
+    {"circle", lualilka_drawlist_circle},
+    {"fill_circle", lualilka_drawlist_fillCircle},
+    {"image", lualilka_drawlist_image},
+    {"add_image", lualilka_drawlist_addImage},
+    {"add", lualilka_drawlist_add},
+    {"clear", lualilka_drawlist_clear},
+    {"size", lualilka_drawlist_size},
+    {"draw", lualilka_drawlist_draw},
+    {nullptr, nullptr},
+};
+
+int lualilka_drawlist_register(lua_State* L) {
+    luaL_newlib(L, lualilka_drawlist);
+    // Command types for list:add()
+    const char* typeNames[DRAW_CMD_COUNT] = {};
+    typeNames[DRAW_CMD_FILL_RECT] = "FILL_RECT";
+    typeNames[DRAW_CMD_FILL_CIRCLE] = "FILL_CIRCLE";
+    typeNames[DRAW_CMD_IMAGE] = "IMAGE";
+    typeNames[DRAW_CMD_RECT] = "RECT";
+    typeNames[DRAW_CMD_CIRCLE] = "CIRCLE";
+    typeNames[DRAW_CMD_LINE] = "LINE";
+    typeNames[DRAW_CMD_PIXEL] = "PIXEL";
+    for (int i = 0; i < DRAW_CMD_COUNT; i++) {
+        lua_pushinteger(L, i);
+        lua_setfield(L, -2, typeNames[i]);
+    }
+    lua_setglobal(L, "drawlist");
+
+    luaL_newmetatable(L, DRAW_LIST);
+    lua_pushcfunction(L, lualilka_delete_object_drawlist);
+    lua_setfield(L, -2, "__gc");
+    lua_pushcfunction(L, lualilka_drawlist_size);
+    lua_setfield(L, -2, "__len");
+    lua_pushvalue(L, -1);
+    lua_setfield(L, -2, "__index");
+    luaL_setfuncs(L, lualilka_drawlist_methods, 0);
+    lua_pop(L, 1);
+
+    return 0;
+}
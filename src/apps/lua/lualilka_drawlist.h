@@ -0,0 +1,8 @@
+#pragma once
+
+#include <lilka.h>
+#include <lua.hpp>
+
+#define DRAW_LIST "DrawList"
+
+int lualilka_drawlist_register(lua_State* L);
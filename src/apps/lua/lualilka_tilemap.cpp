@@ -0,0 +1,215 @@
+#include "lualilka_tilemap.h"
+#include "keira/keira.h"
+#include "lualilka_display.h"
+#include "keira/utils/tilemap.h"
+
+#define TILEMAP_PTR(x) static_cast<TileMap**>(x)
+
+static TileMap* lualilka_tilemap_check(lua_State* L) {
+    TileMap** userdata = TILEMAP_PTR(luaL_checkudata(L, 1, TILE_MAP));
+    return *userdata;
+}
+
+static lilka::Image* lualilka_tilemap_check_image(lua_State* L, int index) {
+    luaL_checktype(L, index, LUA_TTABLE);
+    lua_getfield(L, index, "pointer");
+    if (!lua_islightuserdata(L, -1)) {
+        luaL_error(L, K_S_LUA_DISPLAY_INVALID_IMAGE);
+    }
+    lilka::Image* image = static_cast<lilka::Image*>(lua_touserdata(L, -1));
+    lua_pop(L, 1);
+    return image;
+}
+
+// tilemap.new(tileset, tile_width, tile_height, cols, rows)
+static int lualilka_create_object_tilemap(lua_State* L) {
+    lilka::Image* tileset = lualilka_tilemap_check_image(L, 1);
+    lua_Integer tileWidth = luaL_checkinteger(L, 2);
+    lua_Integer tileHeight = luaL_checkinteger(L, 3);
+    lua_Integer cols = luaL_checkinteger(L, 4);
+    lua_Integer rows = luaL_checkinteger(L, 5);
+    luaL_argcheck(L, tileWidth > 0 && tileWidth <= static_cast<lua_Integer>(tileset->width), 2, "invalid tile width");
+    luaL_argcheck(
+        L, tileHeight > 0 && tileHeight <= static_cast<lua_Integer>(tileset->height), 3, "invalid tile height"
+    );
+    luaL_argcheck(L, cols > 0 && cols <= UINT16_MAX, 4, "invalid map width");
+    luaL_argcheck(L, rows > 0 && rows <= UINT16_MAX, 5, "invalid map height");
+
+    TileMap** userdata = TILEMAP_PTR(lua_newuserdata(L, sizeof(TileMap*)));
+    *userdata = new TileMap(tileset, tileWidth, tileHeight, cols, rows);
+    luaL_setmetatable(L, TILE_MAP);
+    if (!(*userdata)->isValid()) {
+        return luaL_error(L, "tile map: out of memory");
+    }
+    return 1;
+}
+
+static int lualilka_delete_object_tilemap(lua_State* L) {
+    TileMap** userdata = TILEMAP_PTR(luaL_checkudata(L, 1, TILE_MAP));
+    if (*userdata) {
+        delete *userdata;
+        *userdata = nullptr;
+    }
+    return 0;
+}
+
+// map:set(col, row, tile) - tile is index in tileset starting from 0, or -1 for empty cell
+static int lualilka_tilemap_set(lua_State* L) {
+    TileMap* map = lualilka_tilemap_check(L);
+    lua_Integer col = luaL_checkinteger(L, 2);
+    lua_Integer row = luaL_checkinteger(L, 3);
+    lua_Integer tile = luaL_checkinteger(L, 4);
+    if (col < 0 || col >= map->getCols() || row < 0 || row >= map->getRows() || !map->setTile(col, row, tile)) {
+        return luaL_error(L, "tile map: invalid cell or tile");
+    }
+    return 0;
+}
+
+// map:get(col, row) -> tile
+static int lualilka_tilemap_get(lua_State* L) {
+    TileMap* map = lualilka_tilemap_check(L);
+    lua_Integer col = luaL_checkinteger(L, 2);
+    lua_Integer row = luaL_checkinteger(L, 3);
+    bool inside = col >= 0 && col < map->getCols() && row >= 0 && row < map->getRows();
+    lua_pushinteger(L, inside ? map->getTile(col, row) : TILE_MAP_EMPTY);
+    return 1;
+}
+
+// map:load(tiles) - tiles is a flat array of cols * rows tiles, row by row
+static int lualilka_tilemap_load(lua_State* L) {
+    TileMap* map = lualilka_tilemap_check(L);
+    luaL_checktype(L, 2, LUA_TTABLE);
+    uint16_t cols = map->getCols();
+    uint32_t count = cols * map->getRows();
+    for (uint32_t i = 0; i < count; i++) {
+        lua_rawgeti(L, 2, i + 1);
+        int32_t tile = lua_isnil(L, -1) ? TILE_MAP_EMPTY : lua_tointeger(L, -1);
+        lua_pop(L, 1);
+        if (!map->setTile(i % cols, i / cols, tile)) {
+            return luaL_error(L, "tile map: invalid tile at %d", static_cast<int>(i + 1));
+        }
+    }
+    return 0;
+}
+
+// map:size() -> cols, rows
+static int lualilka_tilemap_size(lua_State* L) {
+    TileMap* map = lualilka_tilemap_check(L);
+    lua_pushinteger(L, map->getCols());
+    lua_pushinteger(L, map->getRows());
+    return 2;
+}
+
+// map:invalidate([col, row]) - redraw one tile or whole map on next draw
+static int lualilka_tilemap_invalidate(lua_State* L) {
+    TileMap* map = lualilka_tilemap_check(L);
+    if (lua_isnoneornil(L, 2)) {
+        map->invalidate();
+    } else {
+        map->invalidateTile(luaL_checkinteger(L, 2), luaL_checkinteger(L, 3));
+    }
+    return 0;
+}
+
+static int lualilka_tilemap_setBackground(lua_State* L) {
+    lualilka_tilemap_check(L)->setBackground(luaL_checkinteger(L, 2));
+    return 0;
+}
+
+static int lualilka_tilemap_setViewport(lua_State* L) {
+    TileMap* map = lualilka_tilemap_check(L);
+    map->setViewport(luaL_checkinteger(L, 2), luaL_checkinteger(L, 3), luaL_checkinteger(L, 4), luaL_checkinteger(L, 5));
+    return 0;
+}
+
+static int lualilka_tilemap_setScroll(lua_State* L) {
+    lualilka_tilemap_check(L)->setScroll(luaL_checknumber(L, 2), luaL_checknumber(L, 3));
+    return 0;
+}
+
+// map:add_sprite(image, x, y) -> sprite id
+static int lualilka_tilemap_addSprite(lua_State* L) {
+    TileMap* map = lualilka_tilemap_check(L);
+    lilka::Image* image = lualilka_tilemap_check_image(L, 2);
+    lua_pushinteger(L, map->addSprite(image, luaL_checknumber(L, 3), luaL_checknumber(L, 4)));
+    return 1;
+}
+
+static int lualilka_tilemap_moveSprite(lua_State* L) {
+    TileMap* map = lualilka_tilemap_check(L);
+    if (!map->moveSprite(luaL_checkinteger(L, 2), luaL_checknumber(L, 3), luaL_checknumber(L, 4))) {
+        return luaL_error(L, "tile map: invalid sprite");
+    }
+    return 0;
+}
+
+static int lualilka_tilemap_setSpriteImage(lua_State* L) {
+    TileMap* map = lualilka_tilemap_check(L);
+    if (!map->setSpriteImage(luaL_checkinteger(L, 2), lualilka_tilemap_check_image(L, 3))) {
+        return luaL_error(L, "tile map: invalid sprite");
+    }
+    return 0;
+}
+
+static int lualilka_tilemap_showSprite(lua_State* L) {
+    TileMap* map = lualilka_tilemap_check(L);
+    if (!map->setSpriteVisible(luaL_checkinteger(L, 2), lua_toboolean(L, 3))) {
+        return luaL_error(L, "tile map: invalid sprite");
+    }
+    return 0;
+}
+
+static int lualilka_tilemap_removeSprite(lua_State* L) {
+    TileMap* map = lualilka_tilemap_check(L);
+    if (!map->removeSprite(luaL_checkinteger(L, 2))) {
+        return luaL_error(L, "tile map: invalid sprite");
+    }
+    return 0;
+}
+
+static int lualilka_tilemap_draw(lua_State* L) {
+    if (!lualilka_tilemap_check(L)->draw(getDrawable(L))) {
+        return luaL_error(L, "tile map: out of memory");
+    }
+    return 0;
+}
+
+static const luaL_Reg lualilka_tilemap[] = {
+    {"new", lualilka_create_object_tilemap},
+    {nullptr, nullptr},
+};
+
+static const luaL_Reg lualilka_tilemap_methods[] = {
+    {"set", lualilka_tilemap_set},
+    {"get", lualilka_tilemap_get},
+    {"load", lualilka_tilemap_load},
+    {"size", lualilka_tilemap_size},
+    {"invalidate", lualilka_tilemap_invalidate},
+    {"set_background", lualilka_tilemap_setBackground},
+    {"set_viewport", lualilka_tilemap_setViewport},
+    {"set_scroll", lualilka_tilemap_setScroll},
+    {"add_sprite", lualilka_tilemap_addSprite},
+    {"move_sprite", lualilka_tilemap_moveSprite},
+    {"set_sprite_image", lualilka_tilemap_setSpriteImage},
+    {"show_sprite", lualilka_tilemap_showSprite},
+    {"remove_sprite", lualilka_tilemap_removeSprite},
+    {"draw", lualilka_tilemap_draw},
+    {nullptr, nullptr},
+};
+
+int lualilka_tilemap_register(lua_State* L) {
+    luaL_newlib(L, lualilka_tilemap);
+    lua_pushinteger(L, TILE_MAP_EMPTY);
+    lua_setfield(L, -2, "EMPTY");
+    lua_setglobal(L, "tilemap");
+
+    luaL_newmetatable(L, TILE_MAP);
+    lua_pushcfunction(L, lualilka_delete_object_tilemap);
+    lua_setfield(L, -2, "__gc");
+    lua_pushvalue(L, -1);
+    lua_setfield(L, -2, "__index");
+    luaL_setfuncs(L, lualilka_tilemap_methods, 0);
+    lua_pop(L, 1);
+
+    return 0;
+}
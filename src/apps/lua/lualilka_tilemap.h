@@ -0,0 +1,8 @@
+#pragma once
+
+#include <lilka.h>
+#include <lua.hpp>
+
+#define TILE_MAP "TileMap"
+
+int lualilka_tilemap_register(lua_State* L);
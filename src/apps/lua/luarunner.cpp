@@ -5,6 +5,7 @@
 #include <lilka.h>
 #include "keira/keira.h"
 #include "luarunner.h"
+#include "luacache.h"
 #include "lualilka_display.h"
 #include "lualilka_console.h"
 #include "lualilka_controller.h"
@@ -22,6 +23,8 @@
 #include "lualilka_sdcard.h"
 #include "lualilka_wifi.h"
 #include "lualilka_imageTransform.h"
+#include "lualilka_drawlist.h"
+#include "lualilka_tilemap.h"
 #include "lualilka_serial.h"
 #include "lualilka_http.h"
 #include "lualilka_ui.h"
@@ -108,14 +111,15 @@ bool callDraw(lua_State* L) {
     return true;
 }
 
-AbstractLuaRunnerApp::AbstractLuaRunnerApp(const char* appName) : App(appName), L(NULL) {
-    setFlags(AppFlags::APP_FLAG_FULLSCREEN);
+AbstractLuaRunnerApp::AbstractLuaRunnerApp(const char* appName) : App(appName), L(NULL), heap() {
+    setFlags(AppFlags::APP_FLAG_FULLSCREEN | AppFlags::APP_FLAG_TRIPLE_BUFFER);
 }
 
 void* lua_smart_alloc(void* ud, void* ptr, size_t osize, size_t nsize) {
     // If there will be less than 32 KB of free RAM after reallocating, use PSRAM allocator.
-    (void)ud;
-    (void)osize;
+    LuaHeapState* heap = static_cast<LuaHeapState*>(ud);
+    // For new blocks Lua passes object type in osize instead of size
+    size_t oldSize = ptr ? osize : 0;
     int32_t free_mem = heap_caps_get_free_size(MALLOC_CAP_8BIT);
     if (nsize) {
         uint32_t caps = MALLOC_CAP_8BIT;
@@ -125,9 +129,18 @@ void* lua_smart_alloc(void* ud, void* ptr, size_t osize, size_t nsize) {
         } else {
             // More than 32 KB of free RAM after reallocating. Use regular allocator.
         }
-        return heap_caps_realloc(ptr, nsize, caps);
+        void* newPtr = heap_caps_realloc(ptr, nsize, caps);
+        if (newPtr) {
+            heap->used += nsize - oldSize;
+            if (free_mem - static_cast<int32_t>(nsize) < LUA_GC_PRESSURE_FREE_MEM) {
+                // Incremental steps can't keep up, ask for full collection at the end of frame
+                heap->pressure = true;
+            }
+        }
+        return newPtr;
     } else {
         free(ptr);
+        heap->used -= oldSize;
         return NULL;
     }
 }
@@ -135,7 +148,9 @@ void* lua_smart_alloc(void* ud, void* ptr, size_t osize, size_t nsize) {
 void AbstractLuaRunnerApp::luaSetup(const char* dir) {
     lilka::serial.log("lua: script dir: %s", dir);
 
-    L = lua_newstate(lua_smart_alloc, NULL);
+    heap.used = 0;
+    heap.pressure = false;
+    L = lua_newstate(lua_smart_alloc, &heap);
 
     lilka::serial.log("lua: init libs");
     luaL_openlibs(L);
@@ -157,6 +172,9 @@ void AbstractLuaRunnerApp::luaSetup(const char* dir) {
     lua_setfield(L, -2, "cpath");
     lua_pop(L, 1);
 
+    // Load required modules through bytecode cache
+    lua_cache_register_searcher(L);
+
     // Store app in registry with "app" key
     lua_pushlightuserdata(L, this);
     lua_setfield(L, LUA_REGISTRYINDEX, "app");
@@ -178,6 +196,8 @@ void AbstractLuaRunnerApp::luaSetup(const char* dir) {
     lualilka_sdcard_register(L);
     lualilka_wifi_register(L);
     lualilka_imageTransform_register(L);
+    lualilka_drawlist_register(L);
+    lualilka_tilemap_register(L);
     lualilka_serial_register(L);
     lualilka_http_register(L);
     lualilka_UI_register_keyboard(L);
@@ -277,11 +297,14 @@ int AbstractLuaRunnerApp::execute() {
         }
 
         // Check if lilka.update function exists and call it
-        const uint32_t perfectDelta = 1000 / 30;
+        const uint8_t targetFps = 30;
+        const uint32_t perfectDelta = 1000 / targetFps;
+        setTargetFps(targetFps);
         bool prevFullscreen = true;
         uint32_t delta = perfectDelta; // Delta for first frame is always 1/30
+        uint32_t gcTime = 0; // GC time of previous frame, in microseconds
         while (true) {
-            uint32_t now = millis();
+            uint32_t now = micros();
 
             if (!callUpdate(L, delta) || !callDraw(L)) {
                 // No update or draw function - we're done
@@ -294,7 +317,10 @@ int AbstractLuaRunnerApp::execute() {
             if (lua_toboolean(L, -1)) {
                 canvas->setCursor(24, 24);
                 canvas->setTextColor(0xFFFF, 0);
-                canvas->print(String("FPS: ") + (1000 / (delta > 0 ? delta : 1)) + "  ");
+                canvas->print(
+                    String("FPS: ") + (1000 / (delta > 0 ? delta : 1)) + " GC: " + String(gcTime / 1000.0f, 1) +
+                    "ms " + (heap.used / 1024) + "K  "
+                );
             }
             lua_pop(L, 1);
 
@@ -314,22 +340,17 @@ int AbstractLuaRunnerApp::execute() {
             lua_pop(L, 1);
             queueDraw();
 
-            lua_gc(L, LUA_GCCOLLECT, 0); // TODO: Use LUA_GCSTEP?
+            // Spend the rest of frame budget on garbage collection
+            gcTime = collectGarbage(now + perfectDelta * 1000 - LUA_GC_FRAME_MARGIN_US);
 
             // display.drawCanvas(canvas);
 
             // Calculate time spent in update & gargage collection
-            // TODO: Split time spent in update, time spent in draw, time spent in GC?
-            uint32_t elapsed = millis() - now;
-            // If we're too fast, delay to keep 30 FPS
-            if (elapsed < perfectDelta) {
-                vTaskDelay((perfectDelta - elapsed) / portTICK_PERIOD_MS);
-                // delay(perfectDelta - elapsed);
-                delta = perfectDelta;
-            } else {
-                // If we're too slow, don't delay and set delta to elapsed time
-                delta = elapsed;
-            }
+            uint32_t elapsed = (micros() - now) / 1000;
+            // If we're too slow, set delta to elapsed time
+            delta = elapsed < perfectDelta ? perfectDelta : elapsed;
+            // If we're too fast, sleep to keep 30 FPS
+            waitNextFrame();
         }
     }
 
@@ -341,6 +362,24 @@ int AbstractLuaRunnerApp::execute() {
     return retCode;
 }
 
+uint32_t AbstractLuaRunnerApp::collectGarbage(uint32_t frameEnd) {
+    uint32_t start = micros();
+    if (heap.pressure) {
+        // Running low on memory - do full collection even if it doesn't fit into frame
+        heap.pressure = false;
+        lua_gc(L, LUA_GCCOLLECT, 0);
+    } else {
+        // At least one step is done even if frame is over budget, so GC keeps up with allocations.
+        // Stop when cycle is finished: there's no point starting a new one right away.
+        do {
+            if (lua_gc(L, LUA_GCSTEP, LUA_GC_STEP_SIZE_KB)) {
+                break;
+            }
+        } while (static_cast<int32_t>(frameEnd - micros()) > 0);
+    }
+    return micros() - start;
+}
+
 LuaFileRunnerApp::LuaFileRunnerApp(String path) : AbstractLuaRunnerApp("Lua file run"), path(path) {
     setktStackSize(8192);
 }
@@ -366,7 +405,7 @@ void LuaFileRunnerApp::run() {
 
     lilka::serial.log("lua: run file");
 
-    int retCode = luaL_loadfile(L, path.c_str()) || execute();
+    int retCode = lua_cache_loadfile(L, path.c_str()) || execute();
 
     if (retCode) {
         const char* err = lua_tostring(L, -1);
@@ -9,12 +9,36 @@
 #    define LUA_SERIAL_TEMPORARY_BUFFER_RX_SIZE 32768
 #endif
 
+// Time kept in reserve when GC steps are run at the end of frame, in microseconds
+#ifndef LUA_GC_FRAME_MARGIN_US
+#    define LUA_GC_FRAME_MARGIN_US 2000
+#endif
+
+// Amount of work for a single GC step, in KB (see LUA_GCSTEP)
+#ifndef LUA_GC_STEP_SIZE_KB
+#    define LUA_GC_STEP_SIZE_KB 4
+#endif
+
+// If less than this amount of free memory is left after an allocation,
+// a full collection is done at the end of frame instead of incremental steps
+#ifndef LUA_GC_PRESSURE_FREE_MEM
+#    define LUA_GC_PRESSURE_FREE_MEM (64 * 1024)
+#endif
+
 #ifdef LUA_LIVE_DEBUG
 #    define LUA_DBG if (1)
 #else
 #    define LUA_DBG if (0)
 #endif
 
+// Lua heap accounting, updated by allocator
+typedef struct {
+    // Bytes currently allocated by Lua
+    size_t used;
+    // Set by allocator when free memory drops below LUA_GC_PRESSURE_FREE_MEM
+    bool pressure;
+} LuaHeapState;
+
 // Abstract Lua runner app. Sets up Lua VM and provides a method to run Lua code.
 // Does not implement the run method.
 class AbstractLuaRunnerApp : public App {
@@ -25,7 +49,11 @@ protected:
     void luaSetup(const char* dir);
     void luaTeardown();
     int execute();
+    // Runs GC steps until frameEnd (micros()) is reached, or does a full collect under memory pressure.
+    // Returns time spent in GC, in microseconds
+    uint32_t collectGarbage(uint32_t frameEnd);
     lua_State* L;
+    LuaHeapState heap;
 };
 
 // Lua runner app that runs a file.
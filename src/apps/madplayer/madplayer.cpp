@@ -49,19 +49,12 @@ int MadPlayerApp::drawWidget(lilka::Canvas* canvas) {
     return 24;
 }
 
-void MadPlayerApp::run() {
-    // Detect audio type by extension
-    const char* audioType = detectAudioType(fileName);
-    if (!audioType) {
-        alert("Помилка", "Непідтримуваний формат аудіо");
-        return;
-    }
-
+lilka::Sound* MadPlayerApp::loadSound(const char* audioType) {
     // Read file into memory
     FILE* file = fopen(fileName.c_str(), "rb");
     if (!file) {
         alert("Помилка", "Не вдалося відкрити файл");
-        return;
+        return nullptr;
     }
     fseek(file, 0, SEEK_END);
     size_t fileSize = ftell(file);
@@ -70,25 +63,43 @@ void MadPlayerApp::run() {
     if (fileSize == 0) {
         fclose(file);
         alert("Помилка", "Аудіо-файл порожній");
-        return;
+        return nullptr;
     }
 
     uint8_t* fileData = new (std::nothrow) uint8_t[fileSize];
     if (!fileData) {
         fclose(file);
         alert("Помилка", "Недостатньо пам'яті");
-        return;
+        return nullptr;
     }
     size_t bytesRead = fread(fileData, 1, fileSize, file);
     fclose(file);
     if (bytesRead != fileSize) {
         delete[] fileData;
         alert("Помилка", "Не вдалося прочитати файл");
-        return;
+        return nullptr;
     }
 
     // Create Sound (takes ownership of fileData)
-    sound = new lilka::Sound(fileData, fileSize, audioType);
+    return new lilka::Sound(fileData, fileSize, audioType);
+}
+
+void MadPlayerApp::run() {
+    // Detect audio type by extension
+    const char* audioType = detectAudioType(fileName);
+    if (!audioType) {
+        alert("Помилка", "Непідтримуваний формат аудіо");
+        return;
+    }
+
+    // MOD generator seeks all over the file, so keep it in memory. Other formats are read
+    // sequentially and streamed from file, which allows tracks of any size
+    if (strcmp(audioType, "mod") == 0) {
+        sound = loadSound(audioType);
+        if (!sound) return;
+    } else {
+        sound = new lilka::Sound(fileName.c_str(), audioType);
+    }
 
     // Create I2S output and analyzer (owned by this app)
     i2sOutput = new AudioOutputI2S();
@@ -97,7 +108,16 @@ void MadPlayerApp::run() {
 
     // Start playback via AudioPlayer
     lilka::AudioPlayer* player = &lilka::audioPlayer;
-    player->play(sound, analyzer);
+    if (!player->play(sound, analyzer)) {
+        delete analyzer;
+        analyzer = nullptr;
+        delete i2sOutput;
+        i2sOutput = nullptr;
+        delete sound;
+        sound = nullptr;
+        alert("Помилка", "Не вдалося відкрити файл");
+        return;
+    }
 
     while (1) {
         mainWindow();
@@ -190,6 +210,14 @@ void MadPlayerApp::mainWindow() {
     canvas->println("Гучність: " + String(currentGain));
     if (currentFinished) canvas->println("Трек закінчився");
 
+    const lilka::AudioFileSourceStream* stream = player->getStream();
+    if (stream) {
+        canvas->println(
+            "Буфер: " + String(stream->getBufferLevel() * 100 / stream->getBufferSize()) +
+            "%, недобір: " + String(stream->getUnderruns())
+        );
+    }
+
     lilka::Canvas titleCanvas(canvas->width(), 20);
     titleCanvas.fillScreen(lilka::colors::Black);
     titleCanvas.setFont(FONT_9x15);
@@ -15,6 +15,8 @@ public:
 
 private:
     void mainWindow();
+    // Reads whole file into memory
+    lilka::Sound* loadSound(const char* audioType);
     int drawWidget(lilka::Canvas* canvas);
 
     String fileName;
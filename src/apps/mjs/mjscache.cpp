@@ -0,0 +1,167 @@
+#include "mjscache.h"
+#include <lilka.h>
+#include <sys/stat.h>
+#include "keira/crypto/fnv-1a-32.h"
+
+#define MJS_CACHE_MAGIC 0x43534A4D // "MJSC"
+
+// Sidecar file layout: header followed by bcode part as produced by mjs_compile()
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t headerSize;
+    uint32_t sourceSize;
+    uint32_t sourceHash;
+    int64_t sourceMtime;
+    uint32_t bcodeSize;
+    uint32_t bcodeHash;
+} MJSCacheHeader;
+
+static String mjs_cache_path(const char* path) {
+    String cachePath(path);
+    int dot = cachePath.lastIndexOf('.');
+    if (dot > cachePath.lastIndexOf('/')) {
+        cachePath = cachePath.substring(0, dot);
+    }
+    return cachePath + ".jsc";
+}
+
+// Hash file in small chunks, so source doesn't need to be loaded into memory
+static bool mjs_cache_hash_file(const char* path, uint32_t* hash) {
+    FILE* fp = fopen(path, "rb");
+    if (!fp) {
+        return false;
+    }
+    char buf[256];
+    uint32_t hval = FNV_1A_INITIAL_HVAL;
+    size_t len;
+    while ((len = fread(buf, 1, sizeof(buf), fp)) > 0) {
+        hval = fnv_32a_buf(buf, len, hval);
+    }
+    bool ok = !ferror(fp);
+    fclose(fp);
+    *hash = hval;
+    return ok;
+}
+
+// Load bcode from sidecar if it matches the source. On success bcode is owned by mJS
+static bool mjs_cache_load(struct mjs* mjs, const char* path, const struct stat* st, const char* cachePath, size_t* off) {
+    FILE* fp = fopen(cachePath, "rb");
+    if (!fp) {
+        return false;
+    }
+
+    MJSCacheHeader header;
+    bool ok = fread(&header, sizeof(header), 1, fp) == 1 && header.magic == MJS_CACHE_MAGIC &&
+              header.version == MJS_CACHE_VERSION && header.headerSize == sizeof(header) &&
+              header.sourceSize == st->st_size;
+
+    bool refresh = false;
+    if (ok && (header.sourceMtime != st->st_mtime || st->st_mtime < MJS_CACHE_MIN_MTIME)) {
+        // Source was touched, or its mtime can't be trusted - compare contents
+        uint32_t hash;
+        ok = mjs_cache_hash_file(path, &hash) && hash == header.sourceHash;
+        refresh = ok && header.sourceMtime != st->st_mtime;
+    }
+
+    char* bcode = NULL;
+    if (ok) {
+        bcode = static_cast<char*>(malloc(header.bcodeSize));
+        ok = bcode && fread(bcode, 1, header.bcodeSize, fp) == header.bcodeSize &&
+             fnv_32a_buf(bcode, header.bcodeSize, FNV_1A_INITIAL_HVAL) == header.bcodeHash;
+    }
+    fclose(fp);
+
+    if (!ok || mjs_load_bcode(mjs, bcode, header.bcodeSize, off) != MJS_OK) {
+        free(bcode);
+        // Discard error set by mjs_load_bcode(), script will be compiled from source
+        mjs_set_errorf(mjs, MJS_OK, NULL);
+        return false;
+    }
+
+    if (refresh) {
+        // Same contents with new mtime: update header so next time hashing is skipped
+        header.sourceMtime = st->st_mtime;
+        fp = fopen(cachePath, "r+b");
+        if (fp) {
+            fwrite(&header, sizeof(header), 1, fp);
+            fclose(fp);
+        }
+    }
+    return true;
+}
+
+static void mjs_cache_save(struct mjs* mjs, size_t off, const char* cachePath, const MJSCacheHeader* source) {
+    const char* bcode;
+    size_t bcodeSize;
+    if (mjs_get_bcode(mjs, off, &bcode, &bcodeSize) != MJS_OK) {
+        mjs_set_errorf(mjs, MJS_OK, NULL);
+        return;
+    }
+
+    MJSCacheHeader header = *source;
+    header.bcodeSize = bcodeSize;
+    header.bcodeHash = fnv_32a_buf(bcode, bcodeSize, FNV_1A_INITIAL_HVAL);
+
+    FILE* fp = fopen(cachePath, "wb");
+    if (!fp) {
+        lilka::serial.log("mjs: cannot write bytecode cache %s", cachePath);
+        return;
+    }
+    bool ok = fwrite(&header, sizeof(header), 1, fp) == 1 && fwrite(bcode, 1, bcodeSize, fp) == bcodeSize;
+    if (fclose(fp) != 0 || !ok) {
+        lilka::serial.log("mjs: failed to write bytecode cache %s", cachePath);
+        remove(cachePath);
+    }
+}
+
+static mjs_err_t mjs_cache_compile(
+    struct mjs* mjs, const char* path, const struct stat* st, const char* cachePath, size_t* off
+) {
+    FILE* fp = fopen(path, "rb");
+    if (!fp) {
+        return mjs_set_errorf(mjs, MJS_FILE_READ_ERROR, "failed to read file \"%s\"", path);
+    }
+    char* source = static_cast<char*>(malloc(st->st_size + 1));
+    if (!source) {
+        fclose(fp);
+        return mjs_set_errorf(mjs, MJS_FILE_READ_ERROR, "out of memory loading \"%s\"", path);
+    }
+    size_t sourceSize = fread(source, 1, st->st_size, fp);
+    fclose(fp);
+    source[sourceSize] = '\0';
+
+    MJSCacheHeader header = {};
+    header.magic = MJS_CACHE_MAGIC;
+    header.version = MJS_CACHE_VERSION;
+    header.headerSize = sizeof(header);
+    header.sourceSize = sourceSize;
+    header.sourceHash = fnv_32a_buf(source, sourceSize, FNV_1A_INITIAL_HVAL);
+    header.sourceMtime = st->st_mtime;
+
+    mjs_err_t err = mjs_compile(mjs, path, source, off);
+    free(source);
+    if (err == MJS_OK) {
+        mjs_cache_save(mjs, *off, cachePath, &header);
+    }
+    return err;
+}
+
+mjs_err_t mjs_exec_cached(struct mjs* mjs, const char* path, mjs_val_t* res) {
+    struct stat st;
+    if (stat(path, &st) != 0) {
+        return mjs_set_errorf(mjs, MJS_FILE_READ_ERROR, "failed to read file \"%s\"", path);
+    }
+
+    String cachePath = mjs_cache_path(path);
+    size_t off;
+    if (mjs_cache_load(mjs, path, &st, cachePath.c_str(), &off)) {
+        lilka::serial.log("mjs: using bytecode cache %s", cachePath.c_str());
+    } else {
+        mjs_err_t err = mjs_cache_compile(mjs, path, &st, cachePath.c_str(), &off);
+        if (err != MJS_OK) {
+            return err;
+        }
+    }
+    return mjs_exec_bcode(mjs, off, res);
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include "mjs.h"
+
+// Sidecar files are created next to scripts: "game.js" -> "game.jsc".
+// Bump version when mJS bcode format changes, so that old sidecars are recompiled.
+#define MJS_CACHE_VERSION 1
+
+// Sidecars are trusted without hashing the source if size and mtime match and
+// mtime is newer than this (clock was set when the file was written, 2020-01-01)
+#ifndef MJS_CACHE_MIN_MTIME
+#    define MJS_CACHE_MIN_MTIME 1577836800
+#endif
+
+/// Execute script file, using precompiled bytecode from its sidecar file if it's up to date.
+/// Otherwise the script is compiled and the sidecar is (re)written.
+mjs_err_t mjs_exec_cached(struct mjs* mjs, const char* path, mjs_val_t* res);
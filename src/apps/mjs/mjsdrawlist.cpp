@@ -0,0 +1,230 @@
+#include "mjsdrawlist.h"
+#include <lilka.h>
+#include "mjs.h"
+#include "keira/app.h"
+#include "keira/utils/drawlist.h"
+
+// Methods are called as list.method(...), list object is taken from `this`
+static DrawList* mjs_drawlist_get(struct mjs* mjs) {
+    mjs_val_t ptr_val = mjs_get(mjs, mjs_get_this(mjs), "pointer", ~0);
+    if (!mjs_is_foreign(ptr_val)) {
+        mjs_set_errorf(mjs, MJS_TYPE_ERROR, "draw list was freed");
+        return NULL;
+    }
+    return static_cast<DrawList*>(mjs_get_ptr(mjs, ptr_val));
+}
+
+static lilka::Image* mjs_drawlist_get_image(struct mjs* mjs, mjs_val_t img) {
+    mjs_val_t ptr_val = mjs_get(mjs, img, "pointer", ~0);
+    if (!mjs_is_foreign(ptr_val)) {
+        mjs_set_errorf(mjs, MJS_TYPE_ERROR, "invalid image");
+        return NULL;
+    }
+    return static_cast<lilka::Image*>(mjs_get_ptr(mjs, ptr_val));
+}
+
+// Appends command of given type, record values are taken from arguments
+static void mjs_drawlist_push_args(struct mjs* mjs, DrawCommandType type) {
+    DrawList* list = mjs_drawlist_get(mjs);
+    if (list) {
+        int32_t values[DRAW_LIST_MAX_RECORD_SIZE];
+        for (int i = 0; i < DrawList::recordSize[type]; i++) {
+            values[i] = mjs_get_double(mjs, mjs_arg(mjs, i));
+        }
+        if (!list->push(type, values)) {
+            mjs_set_errorf(mjs, MJS_INTERNAL_ERROR, "draw list: out of memory");
+        }
+    }
+    mjs_return(mjs, mjs_mk_undefined());
+}
+
+// list.pixel(x, y, color)
+static void mjs_drawlist_pixel(struct mjs* mjs) {
+    mjs_drawlist_push_args(mjs, DRAW_CMD_PIXEL);
+}
+
+// list.line(x0, y0, x1, y1, color)
+static void mjs_drawlist_line(struct mjs* mjs) {
+    mjs_drawlist_push_args(mjs, DRAW_CMD_LINE);
+}
+
+// list.rect(x, y, w, h, color)
+static void mjs_drawlist_rect(struct mjs* mjs) {
+    mjs_drawlist_push_args(mjs, DRAW_CMD_RECT);
+}
+
+// list.fill_rect(x, y, w, h, color)
+static void mjs_drawlist_fill_rect(struct mjs* mjs) {
+    mjs_drawlist_push_args(mjs, DRAW_CMD_FILL_RECT);
+}
+
+// list.circle(x, y, r, color)
+static void mjs_drawlist_circle(struct mjs* mjs) {
+    mjs_drawlist_push_args(mjs, DRAW_CMD_CIRCLE);
+}
+
+// list.fill_circle(x, y, r, color)
+static void mjs_drawlist_fill_circle(struct mjs* mjs) {
+    mjs_drawlist_push_args(mjs, DRAW_CMD_FILL_CIRCLE);
+}
+
+// list.add_image(image) -> image id for IMAGE records
+static void mjs_drawlist_add_image(struct mjs* mjs) {
+    DrawList* list = mjs_drawlist_get(mjs);
+    lilka::Image* image = list ? mjs_drawlist_get_image(mjs, mjs_arg(mjs, 0)) : NULL;
+    if (!image) {
+        mjs_return(mjs, mjs_mk_undefined());
+        return;
+    }
+    int id = list->addImage(image);
+    if (id < 0) {
+        mjs_set_errorf(mjs, MJS_INTERNAL_ERROR, "draw list: too many images");
+        mjs_return(mjs, mjs_mk_undefined());
+        return;
+    }
+    mjs_return(mjs, mjs_mk_number(mjs, id));
+}
+
+// list.image(image, x, y)
+static void mjs_drawlist_image(struct mjs* mjs) {
+    DrawList* list = mjs_drawlist_get(mjs);
+    lilka::Image* image = list ? mjs_drawlist_get_image(mjs, mjs_arg(mjs, 0)) : NULL;
+    if (image) {
+        int id = list->addImage(image);
+        int32_t values[] = {id, mjs_get_int(mjs, mjs_arg(mjs, 1)), mjs_get_int(mjs, mjs_arg(mjs, 2))};
+        if (id < 0) {
+            mjs_set_errorf(mjs, MJS_INTERNAL_ERROR, "draw list: too many images");
+        } else if (!list->push(DRAW_CMD_IMAGE, values)) {
+            mjs_set_errorf(mjs, MJS_INTERNAL_ERROR, "draw list: out of memory");
+        }
+    }
+    mjs_return(mjs, mjs_mk_undefined());
+}
+
+// list.add(records) - records is a flat array of [type, values..., type, values...]
+// list.add(records, type) - records is a flat array of values for commands of the same type
+static void mjs_drawlist_add(struct mjs* mjs) {
+    DrawList* list = mjs_drawlist_get(mjs);
+    mjs_val_t records = mjs_arg(mjs, 0);
+    if (!list || !mjs_is_array(records)) {
+        if (list) mjs_set_errorf(mjs, MJS_BAD_ARGS_ERROR, "draw list: records must be an array");
+        mjs_return(mjs, mjs_mk_undefined());
+        return;
+    }
+    bool sameType = mjs_is_number(mjs_arg(mjs, 1));
+    int type = sameType ? mjs_get_int(mjs, mjs_arg(mjs, 1)) : 0;
+    if (type < 0 || type >= DRAW_CMD_COUNT) {
+        mjs_set_errorf(mjs, MJS_BAD_ARGS_ERROR, "draw list: unknown command type %d", type);
+        mjs_return(mjs, mjs_mk_undefined());
+        return;
+    }
+    unsigned long len = mjs_array_length(mjs, records);
+    if (sameType) {
+        list->reserve(len / DrawList::recordSize[type]);
+    }
+    // mjs_array_get() looks up index among all properties, so array is read in one pass instead
+    mjs_val_t* items = static_cast<mjs_val_t*>(malloc(len * sizeof(mjs_val_t)));
+    if (len && !items) {
+        mjs_set_errorf(mjs, MJS_INTERNAL_ERROR, "draw list: out of memory");
+        mjs_return(mjs, mjs_mk_undefined());
+        return;
+    }
+    mjs_array_get_all(mjs, records, items, len);
+
+    int32_t values[DRAW_LIST_MAX_RECORD_SIZE];
+    unsigned long i = 0;
+    while (i < len) {
+        if (!sameType) {
+            type = mjs_get_int(mjs, items[i++]);
+            if (type < 0 || type >= DRAW_CMD_COUNT) {
+                mjs_set_errorf(mjs, MJS_BAD_ARGS_ERROR, "draw list: unknown command type at %lu", i - 1);
+                break;
+            }
+        }
+        uint8_t size = DrawList::recordSize[type];
+        if (i + size > len) {
+            mjs_set_errorf(mjs, MJS_BAD_ARGS_ERROR, "draw list: incomplete record at %lu", i);
+            break;
+        }
+        for (uint8_t j = 0; j < size; j++) {
+            values[j] = mjs_get_double(mjs, items[i++]);
+        }
+        if (!list->push(static_cast<DrawCommandType>(type), values)) {
+            mjs_set_errorf(mjs, MJS_BAD_ARGS_ERROR, "draw list: invalid record at %lu", i - size);
+            break;
+        }
+    }
+    free(items);
+    mjs_return(mjs, mjs_mk_undefined());
+}
+
+// list.clear()
+static void mjs_drawlist_clear(struct mjs* mjs) {
+    DrawList* list = mjs_drawlist_get(mjs);
+    if (list) list->clear();
+    mjs_return(mjs, mjs_mk_undefined());
+}
+
+// list.size() -> number of commands
+static void mjs_drawlist_size(struct mjs* mjs) {
+    DrawList* list = mjs_drawlist_get(mjs);
+    mjs_return(mjs, list ? mjs_mk_number(mjs, list->size()) : mjs_mk_undefined());
+}
+
+// list.draw()
+static void mjs_drawlist_draw(struct mjs* mjs) {
+    DrawList* list = mjs_drawlist_get(mjs);
+    if (list) {
+        mjs_val_t app_val = mjs_get(mjs, mjs_get_global(mjs), "__app__", ~0);
+        list->draw(static_cast<App*>(mjs_get_ptr(mjs, app_val))->canvas);
+    }
+    mjs_return(mjs, mjs_mk_undefined());
+}
+
+// list.free() - free the list
+static void mjs_drawlist_free(struct mjs* mjs) {
+    mjs_val_t obj = mjs_get_this(mjs);
+    mjs_val_t ptr_val = mjs_get(mjs, obj, "pointer", ~0);
+    if (mjs_is_foreign(ptr_val)) {
+        delete static_cast<DrawList*>(mjs_get_ptr(mjs, ptr_val));
+        mjs_set(mjs, obj, "pointer", ~0, mjs_mk_null());
+    }
+    mjs_return(mjs, mjs_mk_undefined());
+}
+
+// drawlist.create() -> draw list object {pointer, methods...}
+static void mjs_drawlist_create(struct mjs* mjs) {
+    mjs_val_t obj = mjs_mk_object(mjs);
+    mjs_set(mjs, obj, "pointer", ~0, mjs_mk_foreign(mjs, new DrawList()));
+    mjs_set(mjs, obj, "pixel", ~0, mjs_mk_foreign_func(mjs, (mjs_func_ptr_t)mjs_drawlist_pixel));
+    mjs_set(mjs, obj, "line", ~0, mjs_mk_foreign_func(mjs, (mjs_func_ptr_t)mjs_drawlist_line));
+    mjs_set(mjs, obj, "rect", ~0, mjs_mk_foreign_func(mjs, (mjs_func_ptr_t)mjs_drawlist_rect));
+    mjs_set(mjs, obj, "fill_rect", ~0, mjs_mk_foreign_func(mjs, (mjs_func_ptr_t)mjs_drawlist_fill_rect));
+    mjs_set(mjs, obj, "circle", ~0, mjs_mk_foreign_func(mjs, (mjs_func_ptr_t)mjs_drawlist_circle));
+    mjs_set(mjs, obj, "fill_circle", ~0, mjs_mk_foreign_func(mjs, (mjs_func_ptr_t)mjs_drawlist_fill_circle));
+    mjs_set(mjs, obj, "image", ~0, mjs_mk_foreign_func(mjs, (mjs_func_ptr_t)mjs_drawlist_image));
+    mjs_set(mjs, obj, "add_image", ~0, mjs_mk_foreign_func(mjs, (mjs_func_ptr_t)mjs_drawlist_add_image));
+    mjs_set(mjs, obj, "add", ~0, mjs_mk_foreign_func(mjs, (mjs_func_ptr_t)mjs_drawlist_add));
+    mjs_set(mjs, obj, "clear", ~0, mjs_mk_foreign_func(mjs, (mjs_func_ptr_t)mjs_drawlist_clear));
+    mjs_set(mjs, obj, "size", ~0, mjs_mk_foreign_func(mjs, (mjs_func_ptr_t)mjs_drawlist_size));
+    mjs_set(mjs, obj, "draw", ~0, mjs_mk_foreign_func(mjs, (mjs_func_ptr_t)mjs_drawlist_draw));
+    mjs_set(mjs, obj, "free", ~0, mjs_mk_foreign_func(mjs, (mjs_func_ptr_t)mjs_drawlist_free));
+    mjs_return(mjs, obj);
+}
+
+void mjs_drawlist_register(struct mjs* mjs) {
+    mjs_val_t drawlist = mjs_mk_object(mjs);
+    mjs_set(mjs, drawlist, "create", ~0, mjs_mk_foreign_func(mjs, (mjs_func_ptr_t)mjs_drawlist_create));
+
+    // Command types for list.add()
+    mjs_set(mjs, drawlist, "FILL_RECT", ~0, mjs_mk_number(mjs, DRAW_CMD_FILL_RECT));
+    mjs_set(mjs, drawlist, "FILL_CIRCLE", ~0, mjs_mk_number(mjs, DRAW_CMD_FILL_CIRCLE));
+    mjs_set(mjs, drawlist, "IMAGE", ~0, mjs_mk_number(mjs, DRAW_CMD_IMAGE));
+    mjs_set(mjs, drawlist, "RECT", ~0, mjs_mk_number(mjs, DRAW_CMD_RECT));
+    mjs_set(mjs, drawlist, "CIRCLE", ~0, mjs_mk_number(mjs, DRAW_CMD_CIRCLE));
+    mjs_set(mjs, drawlist, "LINE", ~0, mjs_mk_number(mjs, DRAW_CMD_LINE));
+    mjs_set(mjs, drawlist, "PIXEL", ~0, mjs_mk_number(mjs, DRAW_CMD_PIXEL));
+
+    mjs_val_t global = mjs_get_global(mjs);
+    mjs_set(mjs, global, "drawlist", ~0, drawlist);
+}
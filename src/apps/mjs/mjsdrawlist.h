@@ -0,0 +1,7 @@
+#pragma once
+
+#include "mjs.h"
+
+/// Register the `drawlist` object in the mJS global scope.
+/// Must be registered after display, as it draws on __app__ canvas.
+void mjs_drawlist_register(struct mjs* mjs);
@@ -0,0 +1,259 @@
+#include "mjstilemap.h"
+#include <lilka.h>
+#include "mjs.h"
+#include "keira/app.h"
+#include "keira/utils/tilemap.h"
+
+// Methods are called as map.method(...), map object is taken from `this`
+static TileMap* mjs_tilemap_get(struct mjs* mjs) {
+    mjs_val_t ptr_val = mjs_get(mjs, mjs_get_this(mjs), "pointer", ~0);
+    if (!mjs_is_foreign(ptr_val)) {
+        mjs_set_errorf(mjs, MJS_TYPE_ERROR, "tile map was freed");
+        return NULL;
+    }
+    return static_cast<TileMap*>(mjs_get_ptr(mjs, ptr_val));
+}
+
+static lilka::Image* mjs_tilemap_get_image(struct mjs* mjs, mjs_val_t img) {
+    mjs_val_t ptr_val = mjs_get(mjs, img, "pointer", ~0);
+    if (!mjs_is_foreign(ptr_val)) {
+        mjs_set_errorf(mjs, MJS_TYPE_ERROR, "invalid image");
+        return NULL;
+    }
+    return static_cast<lilka::Image*>(mjs_get_ptr(mjs, ptr_val));
+}
+
+static bool mjs_tilemap_inside(TileMap* map, int col, int row) {
+    return col >= 0 && col < map->getCols() && row >= 0 && row < map->getRows();
+}
+
+// map.set(col, row, tile) - tile is index in tileset starting from 0, or -1 for empty cell
+static void mjs_tilemap_set(struct mjs* mjs) {
+    TileMap* map = mjs_tilemap_get(mjs);
+    if (map) {
+        int col = mjs_get_int(mjs, mjs_arg(mjs, 0));
+        int row = mjs_get_int(mjs, mjs_arg(mjs, 1));
+        if (!mjs_tilemap_inside(map, col, row) || !map->setTile(col, row, mjs_get_int(mjs, mjs_arg(mjs, 2)))) {
+            mjs_set_errorf(mjs, MJS_BAD_ARGS_ERROR, "tile map: invalid cell or tile");
+        }
+    }
+    mjs_return(mjs, mjs_mk_undefined());
+}
+
+// map.get(col, row) -> tile
+static void mjs_tilemap_get_tile(struct mjs* mjs) {
+    TileMap* map = mjs_tilemap_get(mjs);
+    if (!map) {
+        mjs_return(mjs, mjs_mk_undefined());
+        return;
+    }
+    int col = mjs_get_int(mjs, mjs_arg(mjs, 0));
+    int row = mjs_get_int(mjs, mjs_arg(mjs, 1));
+    mjs_return(mjs, mjs_mk_number(mjs, mjs_tilemap_inside(map, col, row) ? map->getTile(col, row) : TILE_MAP_EMPTY));
+}
+
+// map.load(tiles) - tiles is a flat array of cols * rows tiles, row by row
+static void mjs_tilemap_load(struct mjs* mjs) {
+    TileMap* map = mjs_tilemap_get(mjs);
+    mjs_val_t tiles = mjs_arg(mjs, 0);
+    if (!map || !mjs_is_array(tiles)) {
+        if (map) mjs_set_errorf(mjs, MJS_BAD_ARGS_ERROR, "tile map: tiles must be an array");
+        mjs_return(mjs, mjs_mk_undefined());
+        return;
+    }
+    uint16_t cols = map->getCols();
+    uint32_t count = cols * map->getRows();
+    mjs_val_t* items = static_cast<mjs_val_t*>(malloc(count * sizeof(mjs_val_t)));
+    if (!items) {
+        mjs_set_errorf(mjs, MJS_INTERNAL_ERROR, "tile map: out of memory");
+        mjs_return(mjs, mjs_mk_undefined());
+        return;
+    }
+    mjs_array_get_all(mjs, tiles, items, count);
+    for (uint32_t i = 0; i < count; i++) {
+        int32_t tile = mjs_is_number(items[i]) ? mjs_get_int(mjs, items[i]) : TILE_MAP_EMPTY;
+        if (!map->setTile(i % cols, i / cols, tile)) {
+            mjs_set_errorf(mjs, MJS_BAD_ARGS_ERROR, "tile map: invalid tile at %lu", static_cast<unsigned long>(i));
+            break;
+        }
+    }
+    free(items);
+    mjs_return(mjs, mjs_mk_undefined());
+}
+
+// map.invalidate([col, row]) - redraw one tile or whole map on next draw
+static void mjs_tilemap_invalidate(struct mjs* mjs) {
+    TileMap* map = mjs_tilemap_get(mjs);
+    if (map) {
+        if (mjs_is_number(mjs_arg(mjs, 0))) {
+            int col = mjs_get_int(mjs, mjs_arg(mjs, 0));
+            int row = mjs_get_int(mjs, mjs_arg(mjs, 1));
+            if (mjs_tilemap_inside(map, col, row)) map->invalidateTile(col, row);
+        } else {
+            map->invalidate();
+        }
+    }
+    mjs_return(mjs, mjs_mk_undefined());
+}
+
+// map.set_background(color)
+static void mjs_tilemap_set_background(struct mjs* mjs) {
+    TileMap* map = mjs_tilemap_get(mjs);
+    if (map) map->setBackground(mjs_get_int(mjs, mjs_arg(mjs, 0)));
+    mjs_return(mjs, mjs_mk_undefined());
+}
+
+// map.set_viewport(x, y, w, h)
+static void mjs_tilemap_set_viewport(struct mjs* mjs) {
+    TileMap* map = mjs_tilemap_get(mjs);
+    if (map) {
+        map->setViewport(
+            mjs_get_int(mjs, mjs_arg(mjs, 0)),
+            mjs_get_int(mjs, mjs_arg(mjs, 1)),
+            mjs_get_int(mjs, mjs_arg(mjs, 2)),
+            mjs_get_int(mjs, mjs_arg(mjs, 3))
+        );
+    }
+    mjs_return(mjs, mjs_mk_undefined());
+}
+
+// map.set_scroll(x, y)
+static void mjs_tilemap_set_scroll(struct mjs* mjs) {
+    TileMap* map = mjs_tilemap_get(mjs);
+    if (map) map->setScroll(mjs_get_double(mjs, mjs_arg(mjs, 0)), mjs_get_double(mjs, mjs_arg(mjs, 1)));
+    mjs_return(mjs, mjs_mk_undefined());
+}
+
+// map.add_sprite(image, x, y) -> sprite id
+static void mjs_tilemap_add_sprite(struct mjs* mjs) {
+    TileMap* map = mjs_tilemap_get(mjs);
+    lilka::Image* image = map ? mjs_tilemap_get_image(mjs, mjs_arg(mjs, 0)) : NULL;
+    if (!image) {
+        mjs_return(mjs, mjs_mk_undefined());
+        return;
+    }
+    int id = map->addSprite(image, mjs_get_double(mjs, mjs_arg(mjs, 1)), mjs_get_double(mjs, mjs_arg(mjs, 2)));
+    mjs_return(mjs, mjs_mk_number(mjs, id));
+}
+
+// map.move_sprite(id, x, y)
+static void mjs_tilemap_move_sprite(struct mjs* mjs) {
+    TileMap* map = mjs_tilemap_get(mjs);
+    if (map && !map->moveSprite(
+                   mjs_get_int(mjs, mjs_arg(mjs, 0)),
+                   mjs_get_double(mjs, mjs_arg(mjs, 1)),
+                   mjs_get_double(mjs, mjs_arg(mjs, 2))
+               )) {
+        mjs_set_errorf(mjs, MJS_BAD_ARGS_ERROR, "tile map: invalid sprite");
+    }
+    mjs_return(mjs, mjs_mk_undefined());
+}
+
+// map.set_sprite_image(id, image)
+static void mjs_tilemap_set_sprite_image(struct mjs* mjs) {
+    TileMap* map = mjs_tilemap_get(mjs);
+    lilka::Image* image = map ? mjs_tilemap_get_image(mjs, mjs_arg(mjs, 1)) : NULL;
+    if (image && !map->setSpriteImage(mjs_get_int(mjs, mjs_arg(mjs, 0)), image)) {
+        mjs_set_errorf(mjs, MJS_BAD_ARGS_ERROR, "tile map: invalid sprite");
+    }
+    mjs_return(mjs, mjs_mk_undefined());
+}
+
+// map.show_sprite(id, visible)
+static void mjs_tilemap_show_sprite(struct mjs* mjs) {
+    TileMap* map = mjs_tilemap_get(mjs);
+    if (map && !map->setSpriteVisible(mjs_get_int(mjs, mjs_arg(mjs, 0)), mjs_get_bool(mjs, mjs_arg(mjs, 1)))) {
+        mjs_set_errorf(mjs, MJS_BAD_ARGS_ERROR, "tile map: invalid sprite");
+    }
+    mjs_return(mjs, mjs_mk_undefined());
+}
+
+// map.remove_sprite(id)
+static void mjs_tilemap_remove_sprite(struct mjs* mjs) {
+    TileMap* map = mjs_tilemap_get(mjs);
+    if (map && !map->removeSprite(mjs_get_int(mjs, mjs_arg(mjs, 0)))) {
+        mjs_set_errorf(mjs, MJS_BAD_ARGS_ERROR, "tile map: invalid sprite");
+    }
+    mjs_return(mjs, mjs_mk_undefined());
+}
+
+// map.draw()
+static void mjs_tilemap_draw(struct mjs* mjs) {
+    TileMap* map = mjs_tilemap_get(mjs);
+    if (map) {
+        mjs_val_t app_val = mjs_get(mjs, mjs_get_global(mjs), "__app__", ~0);
+        if (!map->draw(static_cast<App*>(mjs_get_ptr(mjs, app_val))->canvas)) {
+            mjs_set_errorf(mjs, MJS_INTERNAL_ERROR, "tile map: out of memory");
+        }
+    }
+    mjs_return(mjs, mjs_mk_undefined());
+}
+
+// map.free() - free the map. Tileset and sprite images are not freed
+static void mjs_tilemap_free(struct mjs* mjs) {
+    mjs_val_t obj = mjs_get_this(mjs);
+    mjs_val_t ptr_val = mjs_get(mjs, obj, "pointer", ~0);
+    if (mjs_is_foreign(ptr_val)) {
+        delete static_cast<TileMap*>(mjs_get_ptr(mjs, ptr_val));
+        mjs_set(mjs, obj, "pointer", ~0, mjs_mk_null());
+    }
+    mjs_return(mjs, mjs_mk_undefined());
+}
+
+// tilemap.create(tileset, tileWidth, tileHeight, cols, rows) -> tile map object {cols, rows, pointer, methods...}
+static void mjs_tilemap_create(struct mjs* mjs) {
+    lilka::Image* tileset = mjs_tilemap_get_image(mjs, mjs_arg(mjs, 0));
+    int tileWidth = mjs_get_int(mjs, mjs_arg(mjs, 1));
+    int tileHeight = mjs_get_int(mjs, mjs_arg(mjs, 2));
+    int cols = mjs_get_int(mjs, mjs_arg(mjs, 3));
+    int rows = mjs_get_int(mjs, mjs_arg(mjs, 4));
+    if (!tileset) {
+        mjs_return(mjs, mjs_mk_undefined());
+        return;
+    }
+    if (tileWidth <= 0 || tileWidth > static_cast<int>(tileset->width) || tileHeight <= 0 ||
+        tileHeight > static_cast<int>(tileset->height) || cols <= 0 || cols > UINT16_MAX || rows <= 0 ||
+        rows > UINT16_MAX) {
+        mjs_set_errorf(mjs, MJS_BAD_ARGS_ERROR, "tile map: invalid size");
+        mjs_return(mjs, mjs_mk_undefined());
+        return;
+    }
+    TileMap* map = new TileMap(tileset, tileWidth, tileHeight, cols, rows);
+    if (!map->isValid()) {
+        delete map;
+        mjs_set_errorf(mjs, MJS_INTERNAL_ERROR, "tile map: out of memory");
+        mjs_return(mjs, mjs_mk_undefined());
+        return;
+    }
+
+    mjs_val_t obj = mjs_mk_object(mjs);
+    mjs_set(mjs, obj, "cols", ~0, mjs_mk_number(mjs, cols));
+    mjs_set(mjs, obj, "rows", ~0, mjs_mk_number(mjs, rows));
+    mjs_set(mjs, obj, "pointer", ~0, mjs_mk_foreign(mjs, map));
+    mjs_set(mjs, obj, "set", ~0, mjs_mk_foreign_func(mjs, (mjs_func_ptr_t)mjs_tilemap_set));
+    mjs_set(mjs, obj, "get", ~0, mjs_mk_foreign_func(mjs, (mjs_func_ptr_t)mjs_tilemap_get_tile));
+    mjs_set(mjs, obj, "load", ~0, mjs_mk_foreign_func(mjs, (mjs_func_ptr_t)mjs_tilemap_load));
+    mjs_set(mjs, obj, "invalidate", ~0, mjs_mk_foreign_func(mjs, (mjs_func_ptr_t)mjs_tilemap_invalidate));
+    mjs_set(mjs, obj, "set_background", ~0, mjs_mk_foreign_func(mjs, (mjs_func_ptr_t)mjs_tilemap_set_background));
+    mjs_set(mjs, obj, "set_viewport", ~0, mjs_mk_foreign_func(mjs, (mjs_func_ptr_t)mjs_tilemap_set_viewport));
+    mjs_set(mjs, obj, "set_scroll", ~0, mjs_mk_foreign_func(mjs, (mjs_func_ptr_t)mjs_tilemap_set_scroll));
+    mjs_set(mjs, obj, "add_sprite", ~0, mjs_mk_foreign_func(mjs, (mjs_func_ptr_t)mjs_tilemap_add_sprite));
+    mjs_set(mjs, obj, "move_sprite", ~0, mjs_mk_foreign_func(mjs, (mjs_func_ptr_t)mjs_tilemap_move_sprite));
+    mjs_set(
+        mjs, obj, "set_sprite_image", ~0, mjs_mk_foreign_func(mjs, (mjs_func_ptr_t)mjs_tilemap_set_sprite_image)
+    );
+    mjs_set(mjs, obj, "show_sprite", ~0, mjs_mk_foreign_func(mjs, (mjs_func_ptr_t)mjs_tilemap_show_sprite));
+    mjs_set(mjs, obj, "remove_sprite", ~0, mjs_mk_foreign_func(mjs, (mjs_func_ptr_t)mjs_tilemap_remove_sprite));
+    mjs_set(mjs, obj, "draw", ~0, mjs_mk_foreign_func(mjs, (mjs_func_ptr_t)mjs_tilemap_draw));
+    mjs_set(mjs, obj, "free", ~0, mjs_mk_foreign_func(mjs, (mjs_func_ptr_t)mjs_tilemap_free));
+    mjs_return(mjs, obj);
+}
+
+void mjs_tilemap_register(struct mjs* mjs) {
+    mjs_val_t tilemap = mjs_mk_object(mjs);
+    mjs_set(mjs, tilemap, "create", ~0, mjs_mk_foreign_func(mjs, (mjs_func_ptr_t)mjs_tilemap_create));
+    mjs_set(mjs, tilemap, "EMPTY", ~0, mjs_mk_number(mjs, TILE_MAP_EMPTY));
+
+    mjs_val_t global = mjs_get_global(mjs);
+    mjs_set(mjs, global, "tilemap", ~0, tilemap);
+}
@@ -0,0 +1,7 @@
+#pragma once
+
+#include "mjs.h"
+
+/// Register the `tilemap` object in the mJS global scope.
+/// Must be registered after display, as it draws on __app__ canvas.
+void mjs_tilemap_register(struct mjs* mjs);
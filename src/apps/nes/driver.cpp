@@ -1,14 +1,56 @@
 #include "driver.h"
+#include "keira/crypto/fnv-1a-32.h"
 
 NesApp* Driver::app;
-int16_t Driver::w, Driver::h, Driver::frame_x, Driver::frame_y, Driver::frame_x_offset, Driver::frame_width,
-    Driver::frame_height, Driver::frame_line_pixels;
+int16_t Driver::w, Driver::h;
 int64_t Driver::last_render = 0;
 int64_t Driver::last_frame_duration = 0;
 uint8_t Driver::rotation = LILKA_DISPLAY_ROTATION; // not actually same value
 
+NesScaleMode Driver::scaleMode = NESAPP_SCALE_MODE;
+int16_t Driver::dst_x, Driver::dst_y, Driver::dst_width, Driver::dst_height;
+uint8_t Driver::xMap[NES_BLIT_MAX_WIDTH];
+uint8_t Driver::yMap[NES_BLIT_MAX_HEIGHT];
+bool Driver::xIdentity = true;
+Driver::BlitTarget Driver::targets[APP_BUFFERS_MAX];
+uint8_t Driver::nextTarget = 0;
+
+void (*Driver::tickCallback)(void) = NULL;
+std::atomic<uint32_t> Driver::pendingTicks{0};
+uint32_t Driver::skippedFrames = 0;
+std::atomic<uint32_t> Driver::droppedTicks{0};
+std::atomic<uint32_t> Driver::audioUnderruns{0};
+int Driver::audioRemainder = 0;
+
 void Driver::setNesApp(NesApp* app) {
     Driver::app = app;
+    pendingTicks = 0;
+    skippedFrames = 0;
+    droppedTicks = 0;
+    audioUnderruns = 0;
+    audioRemainder = 0;
+}
+
+void Driver::setTickCallback(void (*callback)(void)) {
+    tickCallback = callback;
+}
+
+void Driver::tick() {
+    if (!tickCallback) return;
+    // nofrendo skips rendering of all frames it is behind on. Hold ticks
+    // back instead once NESAPP_MAX_FRAMESKIP frames went undrawn, so the
+    // screen is still updated at least every NESAPP_MAX_FRAMESKIP + 1 ticks
+    if (pendingTicks.load() > NESAPP_MAX_FRAMESKIP) {
+        droppedTicks++;
+        return;
+    }
+    pendingTicks++;
+    tickCallback();
+}
+
+void Driver::setScaleMode(NesScaleMode mode) {
+    // Applied on next init()
+    scaleMode = mode;
 }
 
 int Driver::init(int width, int height) {
@@ -16,35 +58,53 @@ int Driver::init(int width, int height) {
     h = app->canvas->height();
     rotation = app->canvas->getRotation();
     nofrendo_log_printf("display w: %d, h: %d\n", w, h);
-    if (w < 480) // assume only 240x240 or 320x240
-    {
-        if (w > NES_SCREEN_WIDTH) {
-            frame_x = (w - NES_SCREEN_WIDTH) / 2;
-            frame_x_offset = 0;
-            frame_width = NES_SCREEN_WIDTH;
-            frame_height = NES_SCREEN_HEIGHT;
-            frame_line_pixels = frame_width;
-        } else {
-            frame_x = 0;
-            frame_x_offset = (NES_SCREEN_WIDTH - w) / 2;
-            frame_width = w;
-            frame_height = NES_SCREEN_HEIGHT;
-            frame_line_pixels = frame_width;
-        }
-        frame_y = (app->canvas->height() - NES_SCREEN_HEIGHT) / 2;
-    } else // assume 480x320
-    {
-        frame_x = 0;
-        frame_y = 0;
-        frame_x_offset = 8;
-        frame_width = w;
-        frame_height = h;
-        frame_line_pixels = frame_width / 2;
-    }
+
+    updateLayout();
 
     return 0;
 }
 
+void Driver::updateLayout() {
+    int16_t maxWidth = w < NES_BLIT_MAX_WIDTH ? w : NES_BLIT_MAX_WIDTH;
+    int16_t maxHeight = h < NES_BLIT_MAX_HEIGHT ? h : NES_BLIT_MAX_HEIGHT;
+
+    int scale = 1;
+    if (scaleMode == NES_SCALE_INTEGER) {
+        int scaleX = maxWidth / NES_SCREEN_WIDTH;
+        int scaleY = maxHeight / NES_SCREEN_HEIGHT;
+        scale = scaleX < scaleY ? scaleX : scaleY;
+        if (scale < 1) scale = 1;
+    }
+
+    if (scaleMode == NES_SCALE_FIT) {
+        dst_width = maxWidth;
+        dst_height = maxHeight;
+        for (int x = 0; x < dst_width; x++)
+            xMap[x] = x * NES_SCREEN_WIDTH / dst_width;
+        for (int y = 0; y < dst_height; y++)
+            yMap[y] = y * NES_SCREEN_HEIGHT / dst_height;
+    } else {
+        // Centered frame, cropped if it doesn't fit
+        dst_width = NES_SCREEN_WIDTH * scale < maxWidth ? NES_SCREEN_WIDTH * scale : maxWidth;
+        dst_height = NES_SCREEN_HEIGHT * scale < maxHeight ? NES_SCREEN_HEIGHT * scale : maxHeight;
+        int src_x = (NES_SCREEN_WIDTH - dst_width / scale) / 2;
+        int src_y = (NES_SCREEN_HEIGHT - dst_height / scale) / 2;
+        for (int x = 0; x < dst_width; x++)
+            xMap[x] = src_x + x / scale;
+        for (int y = 0; y < dst_height; y++)
+            yMap[y] = src_y + y / scale;
+    }
+
+    dst_x = (w - dst_width) / 2;
+    dst_y = (h - dst_height) / 2;
+
+    xIdentity = true;
+    for (int x = 1; x < dst_width; x++)
+        xIdentity = xIdentity && xMap[x] == xMap[x - 1] + 1;
+
+    invalidateTargets();
+}
+
 void Driver::shutdown() {
 }
 
@@ -62,15 +122,102 @@ void Driver::setPalette(rgb_t* pal) {
         //myPalette[i]=(c>>8)|((c&0xff)<<8);
         nesPalette[i] = c;
     }
+    // Same source lines give different colors now
+    invalidateTargets();
 }
 
 void Driver::clear(uint8 color) {
     app->canvas->fillScreen(0);
+    invalidateTargets();
+}
+
+void Driver::invalidateTargets() {
+    for (uint8_t i = 0; i < APP_BUFFERS_MAX; i++) {
+        targets[i].valid = false;
+    }
 }
 
+Driver::BlitTarget* Driver::getTarget(lilka::Canvas* canvas) {
+    // Canvas pointer could be reused after canvases recreation, and system
+    // may paint over canvas. Epoch tells us it's not the same canvas anymore
+    uint32_t epoch = app->getCanvasEpoch();
+    for (uint8_t i = 0; i < APP_BUFFERS_MAX; i++) {
+        if (targets[i].canvas == canvas && targets[i].epoch == epoch) return &targets[i];
+    }
+
+    BlitTarget* target = &targets[nextTarget];
+    nextTarget = (nextTarget + 1) % APP_BUFFERS_MAX;
+    target->canvas = canvas;
+    target->epoch = epoch;
+    target->valid = false;
+    return target;
+}
+
+// Returns framebuffer position of logical (x, y) canvas pixel and distance
+// to the next pixel in a row, taking canvas rotation into account
+uint16_t* Driver::lineStart(uint16_t* fb, int16_t x, int16_t y, int* step) {
+    switch (rotation) {
+        case 1: // 90° clockwise
+            *step = w;
+            return fb + (h - 1 - y) + x * w;
+        case 2: // 180°
+            *step = -1;
+            return fb + (h - 1 - y) * w + (w - 1 - x);
+        case 3: // 270° clockwise
+            *step = -w;
+            return fb + y + (w - 1 - x) * w;
+        default: // no rotation
+            *step = 1;
+            return fb + y * w + x;
+    }
+}
+
+// Palette lookup for contiguous destination row. Two pixels are combined
+// into a single 32-bit store
+static inline void blitPairs(uint16_t* dst, const uint8_t* src, int n, const uint16* palette) {
+    // Align destination to 32 bits
+    if (n && (reinterpret_cast<uintptr_t>(dst) & 2)) {
+        *dst++ = palette[*src++];
+        n--;
+    }
+
+    uint32_t* dst32 = reinterpret_cast<uint32_t*>(dst);
+    for (; n >= 8; n -= 8, src += 8) {
+        dst32[0] = palette[src[0]] | ((uint32_t)palette[src[1]] << 16);
+        dst32[1] = palette[src[2]] | ((uint32_t)palette[src[3]] << 16);
+        dst32[2] = palette[src[4]] | ((uint32_t)palette[src[5]] << 16);
+        dst32[3] = palette[src[6]] | ((uint32_t)palette[src[7]] << 16);
+        dst32 += 4;
+    }
+    for (; n >= 2; n -= 2, src += 2) {
+        *dst32++ = palette[src[0]] | ((uint32_t)palette[src[1]] << 16);
+    }
+
+    if (n) *reinterpret_cast<uint16_t*>(dst32) = palette[*src];
+}
+
+// FNV-1a over 32-bit words, 4 times less multiplies than over bytes. Each
+// step is reversible, so a single changed word always changes the hash
+static inline uint32_t hashLine(const uint8_t* line) {
+    if (reinterpret_cast<uintptr_t>(line) & 3) return fnv_32a_buf(line, NES_SCREEN_WIDTH, FNV_1A_INITIAL_HVAL);
+
+    const uint32_t* words = reinterpret_cast<const uint32_t*>(line);
+    uint32_t hash = FNV_1A_INITIAL_HVAL;
+    for (int i = 0; i < NES_SCREEN_WIDTH / 4; i++) {
+        hash = (hash ^ words[i]) * 0x01000193;
+    }
+    return hash;
+}
+
+#ifdef INTERLACED
 bool odd = true;
+#endif
 
 void Driver::customBlit(bitmap_t* bmp, int numDirties, rect_t* dirtyRects) {
+    // Every tick which didn't end up here was emulated without rendering
+    uint32_t ticks = pendingTicks.exchange(0);
+    if (ticks > 1) skippedFrames += ticks - 1;
+
 #ifdef NES_FPS_COUNTER
     last_frame_duration = micros() - last_render;
     last_render = micros();
@@ -79,87 +226,66 @@ void Driver::customBlit(bitmap_t* bmp, int numDirties, rect_t* dirtyRects) {
     lilka::Canvas* canvas = app->canvas;
 
 #ifdef INTERLACED
-    for (int y = odd ? 1 : 0; y < frame_height; y += 2) {
-        const uint8_t* line = bmp->line[y];
-        int dst_y = y + frame_y;
-        int dst_x = frame_x;
-        for (int x = 0; x < frame_width; x++) {
-            canvas->writePixelPreclipped(dst_x + x, dst_y, nesPalette[line[x]]);
-            // app->canvas->drawPixel(dst_x + x, dst_y, nesPalette[line[x]]);
+    for (int y = odd ? 1 : 0; y < dst_height; y += 2) {
+        const uint8_t* line = bmp->line[yMap[y]];
+        for (int x = 0; x < dst_width; x++) {
+            canvas->writePixelPreclipped(dst_x + x, dst_y + y, nesPalette[line[xMap[x]]]);
+            // app->canvas->drawPixel(dst_x + x, dst_y + y, nesPalette[line[xMap[x]]]);
         }
     }
     odd = !odd;
 #else
-    // can't move framebuffer ptr outside, cause we dealing with different canvas
-    // unfortunatelly we can't reuse dirtyRects due to doublebuffering
-    // maybe it doesn't worth it
+    // nofrendo dirtyRects describe changes against previous frame, but we
+    // draw to two or three canvases in turn. Instead each canvas remembers
+    // hashes of lines it holds and only changed lines are redrawn
+    BlitTarget* target = getTarget(canvas);
 
-    auto fb = canvas->getFramebuffer();
+    // Nothing on unknown canvas can be trusted, area around frame included
+    if (!target->valid && (dst_width < w || dst_height < h)) canvas->fillScreen(0);
 
-    switch (rotation) {
-        case 0: // no rotation
-            for (int y = 0; y < frame_height; y++) {
-                const uint8_t* src = bmp->line[y];
-                uint16_t* dst = fb + (frame_y + y) * w + frame_x;
-                for (int x = 0; x < frame_width; x++) {
-                    dst[x] = nesPalette[src[x]];
-                }
-            }
-            break;
+    bool lineChanged[NES_SCREEN_HEIGHT];
+    for (int y = 0; y < NES_SCREEN_HEIGHT; y++) {
+        uint32_t hash = hashLine(bmp->line[y]);
+        lineChanged[y] = !target->valid || target->lineHash[y] != hash;
+        target->lineHash[y] = hash;
+    }
+    target->valid = true;
 
-        case 1: // 90° clockwise
-            for (int y = 0; y < frame_height; y++) {
-                const uint8_t* src = bmp->line[y];
-                uint16_t* dst = fb + (h - 1 - (frame_y + y));
-                for (int x = 0; x < frame_width; x++) {
-                    *dst = nesPalette[src[x]];
-                    dst += w;
-                }
-            }
-            break;
+    // can't move framebuffer ptr outside, cause we dealing with different canvas
+    uint16_t* fb = canvas->getFramebuffer();
 
-        case 2: // 180°
-            for (int y = 0; y < frame_height; y++) {
-                const uint8_t* src = bmp->line[y];
-                uint16_t* dst = fb + (h - 1 - (frame_y + y)) * w + (w - frame_width - frame_x);
-                for (int x = 0; x < frame_width; x++) {
-                    dst[x] = nesPalette[src[frame_width - 1 - x]];
-                }
-            }
-            break;
+    for (int y = 0; y < dst_height; y++) {
+        if (!lineChanged[yMap[y]]) continue;
 
-        case 3: // 270° clockwise
-            for (int y = 0; y < frame_height; y++) {
-                const uint8_t* src = bmp->line[y];
-                uint16_t* dst = fb + (frame_x + y);
-                for (int x = 0; x < frame_width; x++) {
-                    *dst = nesPalette[src[frame_width - 1 - x]];
-                    dst += w;
-                }
-            }
-            break;
-    }
+        const uint8_t* src = bmp->line[yMap[y]];
+        int step;
+        uint16_t* dst = lineStart(fb, dst_x, dst_y + y, &step);
 
-        // for (int y = 0; y < frame_height; y++) {
-        //     const uint8_t* line = bmp->line[y];
-        //     int dst_y = y + frame_y;
-        //     int dst_x = frame_x;
-        //     for (int x = 0; x < frame_width; x++) {
-        //         canvas->writePixelPreclipped(dst_x + x, dst_y, nesPalette[line[x]]);
-        //         // app->canvas->drawPixel(dst_x + x, dst_y, nesPalette[line[x]]);
-        //     }
-        // }
+        if (step == 1 && xIdentity) {
+            blitPairs(dst, src + xMap[0], dst_width, nesPalette);
+            continue;
+        }
+
+        for (int x = 0; x < dst_width; x++) {
+            *dst = nesPalette[src[xMap[x]]];
+            dst += step;
+        }
+    }
 #endif
 
     // Serial.println("Draw 1 took " + String(micros() - last_render) + "us");
 #ifdef NES_FPS_COUNTER
     if (last_frame_duration > 0) {
-        canvas->fillRect(80, canvas->height() - 20, 80, 20, lilka::colors::Black);
+        canvas->fillRect(80, canvas->height() - 20, 160, 20, lilka::colors::Black);
         canvas->setCursor(80, canvas->height() - 4);
         canvas->setTextSize(1);
         canvas->setTextColor(lilka::colors::Graygrey);
-        canvas->print("FPS: ");
-        canvas->print(1000000 / last_frame_duration);
+        canvas->printf(
+            "FPS: %d S: %u U: %u",
+            static_cast<int>(1000000 / last_frame_duration),
+            static_cast<unsigned>(skippedFrames),
+            static_cast<unsigned>(audioUnderruns.load())
+        );
     }
 #endif
 
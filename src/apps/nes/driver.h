@@ -1,4 +1,5 @@
 #include "nesapp.h"
+#include <atomic>
 
 extern "C" {
 #include <event.h>
@@ -14,9 +15,38 @@ extern "C" {
 // Історично, більшість старих телевізорів використовували інтерлейс, тому цей ефект зробить гру більш автентичною.
 // #define NESAPP_INTERLACED
 
+typedef enum {
+    // 1:1 по центру екрану, обрізаючи краї, якщо кадр не влазить
+    NES_SCALE_CENTER,
+    // Найбільший цілий масштаб, який влазить в екран
+    NES_SCALE_INTEGER,
+    // Розтягнути кадр на весь екран (nearest neighbour)
+    NES_SCALE_FIT,
+} NesScaleMode;
+
+// Режим масштабування за замовчуванням
+#ifndef NESAPP_SCALE_MODE
+#    define NESAPP_SCALE_MODE NES_SCALE_CENTER
+#endif
+
+// Розкоментуйте, щоб бачити FPS, кількість пропущених кадрів (S) та
+// кількість недозаповнень аудіобуфера (U) під час гри
+// #define NES_FPS_COUNTER
+
+// Скільки кадрів поспіль можна емулювати без відмальовки, якщо емуляція
+// відстає від звуку. Якщо відставання більше - гра сповільнюється
+#ifndef NESAPP_MAX_FRAMESKIP
+#    define NESAPP_MAX_FRAMESKIP 3
+#endif
+
+// Max canvas dimensions supported by blitter
+#define NES_BLIT_MAX_WIDTH  480
+#define NES_BLIT_MAX_HEIGHT 320
+
 class Driver {
 public:
     static void setNesApp(NesApp* app);
+    static void setScaleMode(NesScaleMode mode);
 
     static int init(int width, int height);
     static void shutdown();
@@ -29,9 +59,56 @@ public:
     static viddriver_t driver;
 
     static uint8_t rotation;
-    static int16_t w, h, frame_x, frame_y, frame_x_offset, frame_width, frame_height, frame_line_pixels;
+    static int16_t w, h;
     static int64_t last_render;
     static int64_t last_frame_duration;
 
     static NesApp* app;
+
+    // Pacing: emulation advances one frame per tick. Ticks are issued by
+    // audio task after each written audio frame, so I2S is the master clock
+    static void setTickCallback(void (*callback)(void));
+    static void tick();
+    // Frames emulated but not drawn, to catch up with audio
+    static uint32_t skippedFrames;
+    // Ticks dropped because emulation was too far behind
+    static std::atomic<uint32_t> droppedTicks;
+    // Times I2S DMA ran out of samples
+    static std::atomic<uint32_t> audioUnderruns;
+    // Sample rate isn't divisible by refresh rate, fractional samples per
+    // frame are accumulated here (in 1/NES_REFRESH_RATE units)
+    static int audioRemainder;
+
+private:
+    // Lines drawn on a single canvas. Each canvas remembers hashes of source
+    // lines it holds, so unchanged lines are skipped per canvas
+    typedef struct {
+        lilka::Canvas* canvas;
+        uint32_t epoch;
+        bool valid;
+        uint32_t lineHash[NES_SCREEN_HEIGHT];
+    } BlitTarget;
+
+    static void updateLayout();
+    static BlitTarget* getTarget(lilka::Canvas* canvas);
+    static void invalidateTargets();
+    static uint16_t* lineStart(uint16_t* fb, int16_t x, int16_t y, int* step);
+
+    static NesScaleMode scaleMode;
+    // Destination rect on canvas
+    static int16_t dst_x, dst_y, dst_width, dst_height;
+    // Source pixel/line for each destination column/row
+    static uint8_t xMap[NES_BLIT_MAX_WIDTH];
+    static uint8_t yMap[NES_BLIT_MAX_HEIGHT];
+    // Source columns are contiguous (1:1 horizontally), pair blit could be used
+    static bool xIdentity;
+
+    // Canvas contents are lost when canvases are recreated or painted over
+    // by system (e.g. toast). App's canvas epoch tells when that happens
+    static BlitTarget targets[APP_BUFFERS_MAX];
+    static uint8_t nextTarget;
+
+    static void (*tickCallback)(void);
+    // Ticks issued since last blit
+    static std::atomic<uint32_t> pendingTicks;
 };
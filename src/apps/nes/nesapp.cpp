@@ -6,9 +6,9 @@ NesApp::NesApp(String path) : App("NES") {
     argv[0] = new char[path.length() + 1];
     strcpy(argv[0], path.c_str());
 #ifdef NESAPP_INTERLACED
-    setFlags(AppFlags::APP_FLAG_FULLSCREEN | AppFlags::APP_FLAG_INTERLACED);
+    setFlags(AppFlags::APP_FLAG_FULLSCREEN | AppFlags::APP_FLAG_INTERLACED | AppFlags::APP_FLAG_TRIPLE_BUFFER);
 #else
-    setFlags(AppFlags::APP_FLAG_FULLSCREEN);
+    setFlags(AppFlags::APP_FLAG_FULLSCREEN | AppFlags::APP_FLAG_TRIPLE_BUFFER);
 #endif
 }
 
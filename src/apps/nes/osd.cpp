@@ -27,6 +27,8 @@ extern "C" {
 
 static SemaphoreHandle_t xSoundMutex = NULL;
 static TaskHandle_t audioTaskHandle = NULL;
+static SemaphoreHandle_t xAudioTaskDone = NULL;
+static volatile bool audioStopRequested = false;
 
 int osd_init_sound();
 
@@ -92,6 +94,8 @@ int logprint(const char* string) {
 int osd_init() {
     xSoundMutex = xSemaphoreCreateMutex();
     KMTX_UNLOCK(xSoundMutex);
+    xAudioTaskDone = xSemaphoreCreateBinary();
+    audioStopRequested = false;
     nofrendo_log_chain_logfunc(logprint);
     osd_init_sound();
     return 0;
@@ -104,10 +108,16 @@ int osd_main(int argc, char* argv[]) {
 }
 
 TimerHandle_t timer;
+// Set once audio task runs. From then on it ticks emulation instead of timer
+static volatile bool audioClock = false;
 
 int osd_installtimer(int frequency, void* func, int funcsize, void* counter, int countersize) {
     nofrendo_log_printf("Timer install, configTICK_RATE_HZ=%d, freq=%d\n", configTICK_RATE_HZ, frequency);
-    timer = xTimerCreate("nes", configTICK_RATE_HZ / frequency, pdTRUE, NULL, (TimerCallbackFunction_t)func);
+    Driver::setTickCallback(reinterpret_cast<void (*)(void)>(func));
+    // Timer is a fallback clock for when there's no sound
+    timer = xTimerCreate("nes", configTICK_RATE_HZ / frequency, pdTRUE, NULL, [](TimerHandle_t) {
+        if (!audioClock) Driver::tick();
+    });
     xTimerStart(timer, 0);
     return 0;
 }
@@ -140,6 +150,14 @@ void osd_getmouse(int* x, int* y, int* button) {
 #define DEFAULT_FRAGSIZE    64
 #define HW_AUDIO_SAMPLERATE 22050
 #define HW_AUDIO_BPS        16
+#define AUDIO_DMA_BUF_COUNT 7
+#define AUDIO_DMA_BUF_LEN   256
+// 16 bit stereo
+#define AUDIO_DMA_BUF_BYTES   (AUDIO_DMA_BUF_LEN * 4)
+#define AUDIO_DMA_BYTES       (AUDIO_DMA_BUF_COUNT * AUDIO_DMA_BUF_BYTES)
+#define AUDIO_FRAME_MAX_BYTES ((HW_AUDIO_SAMPLERATE / NES_REFRESH_RATE + 1) * 4)
+// Should fit all TX_DONE events which may arrive between two audio frames
+#define AUDIO_EVENT_QUEUE_LEN 16
 static void (*audio_callback)(void* buffer, int length) = NULL;
 int16_t* audio_frame = NULL;
 QueueHandle_t queue;
@@ -165,11 +183,11 @@ int osd_init_sound() {
         .communication_format =
             (esp_i2s::i2s_comm_format_t)(esp_i2s::I2S_COMM_FORMAT_I2S | esp_i2s::I2S_COMM_FORMAT_I2S_MSB),
         .intr_alloc_flags = ESP_INTR_FLAG_LEVEL1,
-        .dma_buf_count = 7,
-        .dma_buf_len = 256,
+        .dma_buf_count = AUDIO_DMA_BUF_COUNT,
+        .dma_buf_len = AUDIO_DMA_BUF_LEN,
         .use_apll = false,
     };
-    i2s_driver_install(esp_i2s::I2S_NUM_0, &cfg, 2, &queue);
+    i2s_driver_install(esp_i2s::I2S_NUM_0, &cfg, AUDIO_EVENT_QUEUE_LEN, &queue);
     // esp_i2s::i2s_pin_config_t pins = {
     //     .bck_io_num = LILKA_I2S_BCLK,
     //     .ws_io_num = LILKA_I2S_LRCK,
@@ -186,6 +204,12 @@ int osd_init_sound() {
 }
 
 void osd_stopsound() {
+    if (audioTaskHandle) {
+        // Audio task waits on I2S event queue outside of lock, let it exit
+        // before driver (and queue) is gone
+        audioStopRequested = true;
+        xSemaphoreTake(xAudioTaskDone, portMAX_DELAY);
+    }
     Acquire lock(xSoundMutex);
     if (i2s_driver_uninstall(esp_i2s::I2S_NUM_0) != ESP_OK) {
         lilka::serial.err("Failed to uninstall I2S driver\n");
@@ -195,9 +219,18 @@ void osd_stopsound() {
     audio_callback = 0;
 }
 
-void do_audio_frame() {
+// Returns amount of bytes written to I2S
+int do_audio_frame() {
     // Reference: https://github.com/moononournation/arduino-nofrendo/blob/c5ba6d39c1fff0ceed314b76f6da5145d0d99bcc/examples/esp32-nofrendo/sound.c#L72
+    // Sample rate isn't divisible by refresh rate, carry the remainder over
+    // so audio (and emulation clocked by it) doesn't drift
     int left = HW_AUDIO_SAMPLERATE / NES_REFRESH_RATE;
+    Driver::audioRemainder += HW_AUDIO_SAMPLERATE % NES_REFRESH_RATE;
+    if (Driver::audioRemainder >= NES_REFRESH_RATE) {
+        Driver::audioRemainder -= NES_REFRESH_RATE;
+        left++;
+    }
+    int written = 0;
     auto volume = lilka::audio.getVolume();
     while (left) {
         int n = DEFAULT_FRAGSIZE;
@@ -221,7 +254,9 @@ void do_audio_frame() {
         lilka::audio.adjustVolume(audio_frame, 4 * n, 16, volume);
         i2s_write(esp_i2s::I2S_NUM_0, static_cast<int16_t*>(audio_frame), 4 * n, &i2s_bytes_write, portMAX_DELAY);
         left -= i2s_bytes_write / 4;
+        written += i2s_bytes_write;
     }
+    return written;
 }
 
 void osd_setsound(void (*playfunc)(void* buffer, int length)) {
@@ -230,25 +265,52 @@ void osd_setsound(void (*playfunc)(void* buffer, int length)) {
     audio_callback = playfunc;
     xTaskCreatePinnedToCore(
         [](void* arg) {
-            const TickType_t xFrequency = pdMS_TO_TICKS(1000 / NES_REFRESH_RATE);
-            TickType_t xLastWakeTime = xTaskGetTickCount();
-            while (true) {
-                // Call do_audio_frame 60 times per second.
+            // Bytes queued to I2S DMA and not played yet. Each TX_DONE event
+            // means one DMA buffer was played
+            int level = 0;
+            bool primed = false;
+            audioClock = true;
+            while (!audioStopRequested) {
+                // Wait until there's room for the next audio frame. Waiting
+                // happens outside of lock, so osd_stopsound() isn't starved
+                while (!audioStopRequested && level + AUDIO_FRAME_MAX_BYTES > AUDIO_DMA_BYTES) {
+                    esp_i2s::i2s_event_t event;
+                    if (xQueueReceive(queue, &event, pdMS_TO_TICKS(100)) != pdTRUE) {
+                        // DMA stopped sending events, don't trust level anymore
+                        level = 0;
+                        break;
+                    }
+                    if (event.type != esp_i2s::I2S_EVENT_TX_DONE) continue;
+                    if (level < AUDIO_DMA_BUF_BYTES) {
+                        // Buffer played before it was filled completely
+                        if (primed) Driver::audioUnderruns++;
+                        level = 0;
+                    } else {
+                        level -= AUDIO_DMA_BUF_BYTES;
+                    }
+                }
                 {
                     Acquire lock(xSoundMutex);
-                    if (!audio_frame) {
+                    if (!audio_frame || audioStopRequested) {
                         break;
                     }
-                    do_audio_frame();
+                    level += do_audio_frame();
                 }
-                vTaskDelayUntil(&xLastWakeTime, xFrequency);
+                // DMA filled up once, from now on running dry is an underrun
+                if (level + AUDIO_FRAME_MAX_BYTES > AUDIO_DMA_BYTES) primed = true;
+                // One audio frame written - one frame emulated
+                Driver::tick();
             }
+            audioClock = false;
+            audioTaskHandle = NULL;
+            xSemaphoreGive(xAudioTaskDone);
             vTaskDelete(NULL);
         },
         "nes_audio",
         8192,
         NULL,
-        1,
+        // Emulation shouldn't starve audio, it's our clock
+        KT_PRIO_MAX,
         &audioTaskHandle,
         1
     );
@@ -269,8 +331,9 @@ void osd_getvideoinfo(vidinfo_t* info) {
 void osd_shutdown() {
     osd_stopsound();
 
-    vTaskDelete(audioTaskHandle);
+    if (audioTaskHandle) vTaskDelete(audioTaskHandle);
     xTimerDelete(timer, 0);
 
+    vSemaphoreDelete(xAudioTaskDone);
     vSemaphoreDelete(xSoundMutex);
 }
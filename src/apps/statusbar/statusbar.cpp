@@ -20,9 +20,13 @@
 #include <Preferences.h>
 
 StatusBarApp::StatusBarApp() : App("StatusBar") {
-    setFlags(AppFlags::APP_FLAG_STATUSBAR);
+    // Mostly clock and icons changing now and then
+    setFlags(AppFlags::APP_FLAG_STATUSBAR | AppFlags::APP_FLAG_DAMAGE_DIFF);
     loadSettings();
     initSystemWidgets();
+    events = ksystem.events.subscribe(
+        KEVENT_MASK(KEVENT_NETWORK_STATE) | KEVENT_MASK(KEVENT_CLOCK_TICK) | KEVENT_MASK(KEVENT_APP_SWITCH)
+    );
 }
 
 void StatusBarApp::initSystemWidgets() {
@@ -34,6 +38,9 @@ void StatusBarApp::initSystemWidgets() {
         uint8_t memAlign = memMode == 1 ? lilka::ALIGN_END : lilka::ALIGN_START;
         systemWidgets.push_back({[this](lilka::Canvas* canvas) { return drawMem(canvas); }, memAlign, 150});
     }
+    if (cpuMode > 0) {
+        systemWidgets.push_back({[this](lilka::Canvas* canvas) { return drawCpu(canvas); }, lilka::ALIGN_START, 150});
+    }
     if (networkMode > 0) {
         systemWidgets.push_back({[this](lilka::Canvas* canvas) { return drawNetwork(canvas); }, lilka::ALIGN_END, 24});
     }
@@ -62,7 +69,19 @@ const uint16_t leftMargin = 24;
 const uint16_t rightMargin = 24;
 const uint16_t* wifiIcons[] = {wifi_0_img, wifi_1_img, wifi_2_img, wifi_3_img};
 
+// Widgets changing on their own (seconds, memory, CPU, app widgets) need
+// periodic redraw. Otherwise only battery does, network and clock changes wake
+// us up
+uint32_t StatusBarApp::getRefreshInterval() {
+    bool showsSeconds = clockMode == 1 || clockMode == 3;
+    if (showsSeconds || memMode > 0 || cpuMode > 0 || !appWidgets.empty()) {
+        return STATUSBAR_REFRESH_INTERVAL;
+    }
+    return STATUSBAR_IDLE_REFRESH_INTERVAL;
+}
+
 void StatusBarApp::run() {
+    KeiraEvent event;
     while (1) {
         canvas->fillScreen(lilka::colors::Black);
         int availableWidth = canvas->width() - leftMargin - rightMargin;
@@ -76,7 +95,9 @@ void StatusBarApp::run() {
 
         // Draw everything
         queueDraw();
-        vTaskDelay(1000 / portTICK_PERIOD_MS);
+        uint32_t waitStart = micros();
+        ksystem.events.wait(events, &event, pdMS_TO_TICKS(getRefreshInterval()));
+        addIdleTime(micros() - waitStart);
     }
 }
 
@@ -195,6 +216,34 @@ int StatusBarApp::drawMem(lilka::Canvas* canvas) {
     }
 }
 
+// Shows app burning CPU the most, status bar itself excluded
+int StatusBarApp::drawCpu(lilka::Canvas* canvas) {
+    char busiestName[KT_NAME_MAX] = "";
+    int16_t busiestPercent = -1;
+    for (auto& report : ksystem.apps.getPerfReports()) {
+        if (strcmp(report.name, getName()) == 0) continue;
+        if (report.busyPercent > busiestPercent) {
+            strlcpy(busiestName, report.name, sizeof(busiestName));
+            busiestPercent = report.busyPercent;
+        }
+    }
+    if (busiestPercent < 0) return 0;
+
+    // clang-format off
+    auto color = busiestPercent < 50
+        ? lilka::colors::Green
+        : busiestPercent < 80
+            ? lilka::colors::Yellow
+            : lilka::colors::Red;
+    // clang-format on
+
+    canvas->setCursor(0, 17);
+    if (cpuMode == 2) canvas->printf("%s ", busiestName);
+    canvas->setTextColor(color, lilka::colors::Black);
+    canvas->printf("%u%%", busiestPercent);
+    return canvas->getCursorX();
+}
+
 int StatusBarApp::drawNetwork(lilka::Canvas* canvas) {
     NetworkService* networkService = static_cast<NetworkService*>(ksystem.services["network"]);
 
@@ -280,6 +329,7 @@ void StatusBarApp::loadSettings() {
     prefs.begin(STATUSBAR_KEIRA_NAMESPACE, true);
     clockMode = prefs.getInt("clock", 1);
     memMode = prefs.getInt("mem", 1);
+    cpuMode = prefs.getInt("cpu", 0);
     networkMode = prefs.getInt("network", 1);
     batteryMode = prefs.getInt("battery", 1);
     prefs.end();
@@ -296,6 +346,10 @@ void StatusBarApp::setMode(const char* key, uint8_t& mode, uint8_t newMode, uint
     NVS_UNLOCK;
 
     initSystemWidgets();
+
+    // Show new mode right away. Event of no type only wakes status bar up
+    KeiraEvent event = {KEVENT_COUNT, 0};
+    xQueueSend(events, &event, 0);
 }
 
 uint8_t StatusBarApp::getClockMode() {
@@ -304,6 +358,9 @@ uint8_t StatusBarApp::getClockMode() {
 uint8_t StatusBarApp::getMemMode() {
     return memMode;
 }
+uint8_t StatusBarApp::getCpuMode() {
+    return cpuMode;
+}
 uint8_t StatusBarApp::getNetworkMode() {
     return networkMode;
 }
@@ -317,6 +374,9 @@ void StatusBarApp::setClockMode(uint8_t mode) {
 void StatusBarApp::setMemMode(uint8_t mode) {
     setMode("mem", memMode, mode, 2);
 }
+void StatusBarApp::setCpuMode(uint8_t mode) {
+    setMode("cpu", cpuMode, mode, 2);
+}
 void StatusBarApp::setNetworkMode(uint8_t mode) {
     setMode("network", networkMode, mode, 1);
 }
@@ -1,9 +1,14 @@
 #pragma once
 
 #include "keira/app.h"
+#include "keira/eventbus.h"
 
 #define STATUSBAR_KEIRA_NAMESPACE "kstatusbar"
 
+// Redraw intervals in ms, when something changes on its own and when not
+#define STATUSBAR_REFRESH_INTERVAL      1000
+#define STATUSBAR_IDLE_REFRESH_INTERVAL 10000
+
 struct StatusBarWidget {
     std::function<int(lilka::Canvas*)> drawFn;
     uint8_t alignment;
@@ -19,9 +24,13 @@ private:
 
     uint8_t clockMode;
     uint8_t memMode;
+    uint8_t cpuMode;
     uint8_t networkMode;
     uint8_t batteryMode;
 
+    // Network, clock and app switch events wake status bar up to redraw
+    KeiraEventQueue events;
+
 public:
     StatusBarApp();
 
@@ -32,15 +41,18 @@ public:
 
     uint8_t getClockMode();
     uint8_t getMemMode();
+    uint8_t getCpuMode();
     uint8_t getNetworkMode();
     uint8_t getBatteryMode();
     void setClockMode(uint8_t mode);
     void setMemMode(uint8_t mode);
+    void setCpuMode(uint8_t mode);
     void setNetworkMode(uint8_t mode);
     void setBatteryMode(uint8_t mode);
 
 private:
     void run() override;
+    uint32_t getRefreshInterval();
 
     void setMode(const char* key, uint8_t& mode, uint8_t newMode, uint8_t maxMode);
     void loadSettings();
@@ -51,6 +63,7 @@ private:
 
     int drawClock(lilka::Canvas* canvas);
     int drawMem(lilka::Canvas* canvas);
+    int drawCpu(lilka::Canvas* canvas);
     int drawNetwork(lilka::Canvas* canvas);
     int drawBattery(lilka::Canvas* canvas);
 
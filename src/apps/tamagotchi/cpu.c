@@ -27,7 +27,7 @@
 #include "hal.h"
 #include "rom_12bit.h"
 
-#define CPU_SPEED_RATIO         0
+#define CPU_SPEED_RATIO         1
 #define TICK_FREQUENCY          32768 // Hz
 
 #define TIMER_1HZ_PERIOD        32768 // in ticks
@@ -1946,7 +1946,7 @@ static timestamp_t wait_for_cycles(timestamp_t since, u8_t cycles) {
         return g_hal->get_timestamp();
     }
 
-    deadline = since + (cycles * ts_freq) / ((TICK_FREQUENCY * CPU_SPEED_RATIO) || 1);
+    deadline = since + (cycles * ts_freq) / (TICK_FREQUENCY * CPU_SPEED_RATIO);
     g_hal->sleep_until(deadline);
 
     return deadline;
@@ -49,7 +49,7 @@ void TamagotchiApp::run() {
     hal_t hal = {
         .halt = []() -> void {},
         .log = hal_log,
-        .sleep_until = [](uint32_t timestamp) -> void {},
+        .sleep_until = [](uint32_t timestamp) -> void { instance->sleepUntil(timestamp); },
         .get_timestamp = []() -> timestamp_t { return micros(); },
         .update_screen = []() -> void {
             lilka::Canvas* canvas = instance->canvas;
@@ -98,7 +98,10 @@ void TamagotchiApp::run() {
     int64_t select_press_started = 0;
 
     while (lilka::controller.getState().any.pressed) {
+        waitNextFrame();
     }
+    // Don't make emulator catch up with time spent waiting above
+    cpu_sync_ref_timestamp();
 
     while (1) {
         lilka::State state = lilka::controller.getState();
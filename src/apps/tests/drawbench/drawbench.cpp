@@ -0,0 +1,95 @@
+#include "keira/keira.h"
+#include "drawbench.h"
+
+// Frames measured per drawing method
+#define DRAW_BENCH_FRAMES 20
+
+// Every method draws the same 2000 pixels, some of them off-screen
+static const char* benchScript = R"(
+local N = 2000
+local rec = {}
+for i = 0, N - 1 do
+    rec[#rec + 1] = (i * 37) % 300 - 10
+    rec[#rec + 1] = (i * 91) % 240
+    rec[#rec + 1] = (i * 13) % 65536
+end
+local list = drawlist.new()
+
+function percall()
+    for i = 1, #rec, 3 do
+        display.draw_pixel(rec[i], rec[i + 1], rec[i + 2])
+    end
+end
+
+function incremental()
+    list:clear()
+    for i = 1, #rec, 3 do
+        list:pixel(rec[i], rec[i + 1], rec[i + 2])
+    end
+    list:draw()
+end
+
+function batched()
+    list:clear()
+    list:add(rec, drawlist.PIXEL)
+    list:draw()
+end
+)";
+
+static const char* benchMethods[] = {"percall", "incremental", "batched"};
+
+DrawBenchApp::DrawBenchApp() : AbstractLuaRunnerApp("Draw Bench") {
+    setktStackSize(8192);
+}
+
+uint32_t DrawBenchApp::measure(const char* name) {
+    uint32_t start = micros();
+    for (int i = 0; i < DRAW_BENCH_FRAMES; i++) {
+        lua_getglobal(L, name);
+        if (lua_pcall(L, 0, 0, 0) != LUA_OK) {
+            lilka::serial.err("drawbench: %s", lua_tostring(L, -1));
+            lua_pop(L, 1);
+            return 0;
+        }
+    }
+    return (micros() - start) / DRAW_BENCH_FRAMES;
+}
+
+void DrawBenchApp::run() {
+#ifndef LILKA_NO_LUA
+    lilka::Canvas buffer(canvas->width(), canvas->height());
+    buffer.begin();
+    buffer.setFont(FONT_9x15);
+    buffer.fillScreen(lilka::colors::Black);
+    buffer.setTextBound(4, 0, canvas->width() - 8, canvas->height());
+    buffer.setCursor(4, 20);
+
+    buffer.println(K_S_DRAW_BENCH_ABOUT);
+    canvas->drawCanvas(&buffer);
+    queueDraw();
+
+    luaSetup(lilka::fileutils.getSDRoot().c_str());
+    if (luaL_dostring(L, benchScript) != LUA_OK) {
+        lilka::serial.err("drawbench: %s", lua_tostring(L, -1));
+        lua_pop(L, 1);
+    } else {
+        for (const char* method : benchMethods) {
+            uint32_t time = measure(method);
+            lua_gc(L, LUA_GCCOLLECT, 0);
+            // Restore results screen over pixels drawn by benchmark
+            buffer.printf(K_S_DRAW_BENCH_RESULT_FMT, method, static_cast<unsigned>(time));
+            canvas->drawCanvas(&buffer);
+            queueDraw();
+        }
+    }
+    luaTeardown();
+
+    buffer.println(K_S_DRAW_BENCH_DONE);
+    canvas->drawCanvas(&buffer);
+    queueDraw();
+
+    while (!lilka::controller.getState().a.justPressed) {
+        taskYIELD();
+    }
+#endif
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+#include "apps/lua/luarunner.h"
+
+// Compares per-call drawing from Lua with batched draw lists
+class DrawBenchApp : public AbstractLuaRunnerApp {
+public:
+    DrawBenchApp();
+
+private:
+    void run() override;
+    // Calls global Lua function @name DRAW_BENCH_FRAMES times, returns average time per call in microseconds
+    uint32_t measure(const char* name);
+};
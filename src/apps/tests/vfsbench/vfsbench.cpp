@@ -0,0 +1,102 @@
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "keira/keira.h"
+#include "keira/vfs/spiram/spiram.h"
+#include "vfsbench.h"
+
+#define VFS_BENCH_DIR LILKA_TMP_ROOT "/vfsbench"
+// Lookups done per directory size
+#define VFS_BENCH_OPS 1000
+
+// Directory sizes to measure lookups at
+const uint16_t benchSizes[] = {16, 128, 1024};
+
+static void benchFilePath(char* path, uint16_t index) {
+    snprintf(path, PATH_MAX, VFS_BENCH_DIR "/file%05u", index);
+}
+
+VFSBenchApp::VFSBenchApp() : App("VFS Bench") {
+}
+
+bool VFSBenchApp::fill(uint16_t from, uint16_t count) {
+    char path[PATH_MAX];
+    for (uint16_t i = from; i < count; i++) {
+        benchFilePath(path, i);
+        int fd = open(path, O_CREAT | O_WRONLY, 0644);
+        if (fd < 0) return false;
+        close(fd);
+    }
+    return true;
+}
+
+void VFSBenchApp::cleanup(uint16_t count) {
+    char path[PATH_MAX];
+    for (uint16_t i = 0; i < count; i++) {
+        benchFilePath(path, i);
+        unlink(path);
+    }
+    rmdir(VFS_BENCH_DIR);
+}
+
+void VFSBenchApp::run() {
+    lilka::Canvas buffer(canvas->width(), canvas->height());
+    buffer.begin();
+    buffer.setFont(FONT_9x15);
+    buffer.fillScreen(lilka::colors::Black);
+    buffer.setTextBound(4, 0, canvas->width() - 8, canvas->height());
+    buffer.setCursor(4, 20);
+
+    buffer.println(K_S_VFS_BENCH_ABOUT);
+    canvas->drawCanvas(&buffer);
+    queueDraw();
+
+    mkdir(VFS_BENCH_DIR, 0755);
+
+    char path[PATH_MAX];
+    struct stat st;
+    uint16_t filled = 0;
+
+    for (uint16_t size : benchSizes) {
+        if (!fill(filled, size)) {
+            buffer.printf(K_S_VFS_BENCH_NO_MEMORY_FMT, size);
+            break;
+        }
+        filled = size;
+
+        // Spread lookups over whole directory, so list position doesn't matter
+        uint32_t openStart = micros();
+        for (uint16_t i = 0; i < VFS_BENCH_OPS; i++) {
+            benchFilePath(path, (i * 7919) % size);
+            int fd = open(path, O_RDONLY);
+            if (fd >= 0) close(fd);
+        }
+        uint32_t openTime = micros() - openStart;
+
+        uint32_t statStart = micros();
+        for (uint16_t i = 0; i < VFS_BENCH_OPS; i++) {
+            benchFilePath(path, (i * 7919) % size);
+            ::stat(path, &st);
+        }
+        uint32_t statTime = micros() - statStart;
+
+        buffer.printf(
+            K_S_VFS_BENCH_RESULT_FMT,
+            size,
+            static_cast<unsigned>(VFS_BENCH_OPS * 1000000ULL / (openTime ? openTime : 1)),
+            static_cast<unsigned>(VFS_BENCH_OPS * 1000000ULL / (statTime ? statTime : 1))
+        );
+        canvas->drawCanvas(&buffer);
+        queueDraw();
+    }
+
+    cleanup(filled);
+
+    buffer.println(K_S_VFS_BENCH_DONE);
+    canvas->drawCanvas(&buffer);
+    queueDraw();
+
+    while (!lilka::controller.getState().a.justPressed) {
+        taskYIELD();
+    }
+}
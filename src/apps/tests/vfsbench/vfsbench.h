@@ -0,0 +1,14 @@
+#pragma once
+
+#include "keira/app.h"
+
+class VFSBenchApp : public App {
+public:
+    VFSBenchApp();
+
+private:
+    void run() override;
+    // Fills directory up to @count files, returns false if /tmp is out of memory
+    bool fill(uint16_t from, uint16_t count);
+    void cleanup(uint16_t count);
+};
@@ -134,9 +134,13 @@ bool USBDriveApp::initUSBMSC() {
     mscDevice->onStartStop(onMSCStartStop);
     mscDevice->mediaPresent(true);
 
+    // Services using SD card (e.g. FTP) let it go while host owns it
+    ksystem.events.publish(KEVENT_SD_STATE, 0);
+
     // Begin MSC with sector count and size
     if (!mscDevice->begin(sdCardSectors, sdCardSectorSize)) {
         lilka::serial.err("USB MSC: Failed to begin MSC");
+        ksystem.events.publish(KEVENT_SD_STATE, 1);
         delete mscDevice;
         mscDevice = nullptr;
         sdCardReady = false;
@@ -171,6 +175,7 @@ void USBDriveApp::deinitUSBMSC() {
         // The USB stack will be reset on reboot
 
         mscInitialized = false;
+        ksystem.events.publish(KEVENT_SD_STATE, 1);
         lilka::serial.log("USB MSC: Deinitialized");
     }
 }
@@ -5,8 +5,10 @@
 #include <lilka/display.h>
 #include <lilka/controller.h>
 #include "services/watchdog/watchdog.h"
+#include <esp_heap_caps.h>
 #include <string.h>
 #include <errno.h>
+#include <algorithm>
 #include "keira/utils/string.h"
 
 //=============================================================================
@@ -28,8 +30,9 @@ App::App(const char* name) {
 App::~App() {
     KMTX_LOCK(canvasMutex);
 
-    if (canvas) delete canvas;
-    if (backCanvas) delete backCanvas;
+    for (uint8_t i = 0; i < APP_BUFFERS_MAX; i++) {
+        if (buffers[i]) delete buffers[i];
+    }
 
     KMTX_UNLOCK(canvasMutex);
 }
@@ -65,6 +68,7 @@ void App::alert(const String& title, const String& description) {
         canvas->fillScreen(lilka::colors::Black);
         alertDialog.draw(canvas);
         queueDraw();
+        waitNextFrame();
     }
 }
 //-----------------------------------------------------------------------------
@@ -79,6 +83,7 @@ bool App::confirm(const String& title, const String& description) {
         canvas->fillScreen(lilka::colors::Black);
         confirmDialog.draw(canvas);
         queueDraw();
+        waitNextFrame();
     }
 
     return confirmDialog.getButton() == K_BTN_CONFIRM;
@@ -99,6 +104,7 @@ bool App::errnocheck() {
         canvas->fillScreen(lilka::colors::Black);
         errnoDialog.draw(canvas);
         queueDraw();
+        waitNextFrame();
     }
 
     // Reset errno
@@ -116,11 +122,67 @@ String App::input(const String& title, const String& value, bool masked) {
         inputDialog.update();
         inputDialog.draw(canvas);
         queueDraw();
+        waitNextFrame();
     }
 
     return inputDialog.getValue();
 }
 ///////////////////////////////////////////////////////////////////////////////
+
+//=============================================================================
+//  Frame pacing
+//=============================================================================
+void App::setTargetFps(uint8_t fps) {
+    targetFps = fps;
+    // Keep at least one tick per frame if fps is above tick rate
+    framePeriod = fps ? std::max<TickType_t>(pdMS_TO_TICKS(1000 / fps), 1) : 0;
+    lastWakeTick = 0;
+}
+//-----------------------------------------------------------------------------
+uint8_t App::getTargetFps() {
+    return targetFps;
+}
+//-----------------------------------------------------------------------------
+void App::waitNextFrame() {
+    if (!framePeriod) {
+        // Pacing disabled, only let other tasks of same priority run
+        taskYIELD();
+        return;
+    }
+
+    TickType_t now = xTaskGetTickCount();
+
+    // Behind schedule (or just resumed). vTaskDelayUntil() would return
+    // immediately for each missed frame, so start counting from now instead
+    if (lastWakeTick && now - lastWakeTick >= framePeriod) {
+        lastWakeTick = now;
+        return;
+    }
+    if (!lastWakeTick) lastWakeTick = now;
+
+    uint32_t start = micros();
+    vTaskDelayUntil(&lastWakeTick, framePeriod);
+    idleTime += micros() - start;
+}
+//-----------------------------------------------------------------------------
+void App::sleepUntil(uint32_t us) {
+    uint32_t start = micros();
+    int32_t remaining = us - start;
+    if (remaining <= 0) return;
+
+    // vTaskDelay() wakes up within last tick of requested amount, so
+    // rounding down keeps us from oversleeping the deadline
+    TickType_t ticks = remaining / (portTICK_PERIOD_MS * 1000);
+    if (!ticks) return;
+
+    vTaskDelay(ticks);
+    idleTime += micros() - start;
+}
+//-----------------------------------------------------------------------------
+void App::addIdleTime(uint32_t us) {
+    idleTime += us;
+}
+///////////////////////////////////////////////////////////////////////////////
 //=============================================================================
 //  App Canvas management
 //=============================================================================
@@ -130,14 +192,18 @@ bool App::getRedraw() {
 //-----------------------------------------------------------------------------
 void App::setRedraw(bool redraw) {
     this->redraw = redraw;
+    // Nothing known about display contents on forced redraw
+    fullRedraw = redraw;
+}
+//-----------------------------------------------------------------------------
+void App::addDamage(uint16_t x, uint16_t y, uint16_t w, uint16_t h) {
+    damage[drawIdx].add(x, y, w, h);
+    damageReported = true;
 }
 //-----------------------------------------------------------------------------
 void App::initCanvas() {
     KMTX_LOCK(canvasMutex);
 
-    auto oldCanvas = canvas;
-    auto oldBackCanvas = backCanvas;
-
     // Default canvas shifts
     uint16_t x = 0;
     uint16_t y = KEIRA_STATUSBAR_HEIGHT;
@@ -162,35 +228,53 @@ void App::initCanvas() {
     }
 
     // Ensure init/reinit needed
-    if (canvas && backCanvas) {
-        uint16_t cx = canvas->x();
-        uint16_t cy = canvas->y();
-        uint16_t bx = backCanvas->x();
-        uint16_t by = backCanvas->y();
-
-        uint16_t cw = canvas->width();
-        uint16_t ch = canvas->height();
-        uint16_t bw = backCanvas->width();
-        uint16_t bh = backCanvas->height();
-
-        // how to make it less ugly ? :D
-        if ((cx == bx) && (cy == by) && (cw == bw) && (ch == bh) && (cy == y) && (cx == x) && (cw == w) && (ch == h)) {
+    bool tripleRequested = flags & APP_FLAG_TRIPLE_BUFFER;
+    if (canvas && backCanvas && tripleBuffered == tripleRequested) {
+        bool same = true;
+        for (uint8_t i = 0; i < (tripleBuffered ? 3 : 2); i++) {
+            lilka::Canvas* buffer = buffers[i];
+            same = same && buffer->x() == x && buffer->y() == y && buffer->width() == w && buffer->height() == h;
+        }
+        if (same) {
             KMTX_UNLOCK(canvasMutex);
             return;
         }
     }
 
-    // Create canvases
-    canvas = new lilka::Canvas(x, y, w, h);
-    backCanvas = new lilka::Canvas(x, y, w, h);
+    // Cleanup old canvases if them exist
+    for (uint8_t i = 0; i < APP_BUFFERS_MAX; i++) {
+        if (buffers[i]) delete buffers[i];
+        buffers[i] = NULL;
+        damage[i].clear();
+    }
 
-    // Fill them with black
-    canvas->fillScreen(lilka::colors::Black);
-    backCanvas->fillScreen(lilka::colors::Black);
+    // Third buffer is optional, use it only if it won't starve the rest of
+    // the system. Otherwise fall back to double buffering
+    bool triple = false;
+    if (tripleRequested) {
+        size_t bufferSize = (size_t)w * h * sizeof(uint16_t);
+        size_t largestBlock = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+        triple = largestBlock >= 3 * bufferSize + APP_TRIPLE_BUFFER_RESERVE;
+    }
+    uint8_t bufferCount = triple ? 3 : 2;
 
-    // Cleanup old canvases if them exist
-    if (oldCanvas) delete oldCanvas;
-    if (oldBackCanvas) delete oldBackCanvas;
+    // Create canvases and fill them with black
+    for (uint8_t i = 0; i < bufferCount; i++) {
+        buffers[i] = new lilka::Canvas(x, y, w, h);
+        buffers[i]->fillScreen(lilka::colors::Black);
+    }
+
+    tripleBuffered = triple;
+    canvasEpoch++;
+    drawIdx = 0;
+    displayIdx = 1;
+    lastIdx = 1;
+    readyIdx.store(2);
+    canvas = buffers[drawIdx];
+    backCanvas = buffers[displayIdx];
+
+    // Display still shows previous content
+    fullRedraw = true;
 
     KMTX_UNLOCK(canvasMutex);
 }
@@ -198,40 +282,163 @@ void App::initCanvas() {
 void App::deinitCanvas() {
     KMTX_LOCK(canvasMutex);
 
-    if (canvas) {
-        delete canvas;
-        canvas = NULL;
-    }
-    if (backCanvas) {
-        delete backCanvas;
-        backCanvas = NULL;
+    for (uint8_t i = 0; i < APP_BUFFERS_MAX; i++) {
+        if (buffers[i]) delete buffers[i];
+        buffers[i] = NULL;
+        damage[i].clear();
     }
+    canvas = NULL;
+    backCanvas = NULL;
+    tripleBuffered = false;
+
+    // Don't count time spent suspended as frame time
+    lastFrameTime = 0;
 
     KMTX_UNLOCK(canvasMutex);
 }
 //-----------------------------------------------------------------------------
 void App::queueDraw() {
-    KMTX_LOCK(canvasMutex);
+    uint32_t queueTime = micros();
+
+    if (lastFrameTime) stats.push(FRAME_STAT_RUN, queueTime - lastFrameTime);
+
+    // Area changed against previously queued frame: reported by app, found
+    // by comparing frames if app asked for it, or whole canvas otherwise.
+    // If previous frame wasn't flushed yet, its damage is carried over below,
+    // so region covers all changes since last flush. Interlaced apps are
+    // flushed whole anyway
+    DamageRegion& frameDamage = damage[drawIdx];
+    if (flags & APP_FLAG_INTERLACED) {
+        frameDamage.invalidate(canvas->width(), canvas->height());
+    } else if (damageReported) {
+        // Collected by addDamage() already
+    } else if (flags & APP_FLAG_DAMAGE_DIFF) {
+        frameDamage.addDiff(
+            canvas->getFramebuffer(), buffers[lastIdx]->getFramebuffer(), canvas->width(), canvas->height()
+        );
+    } else {
+        frameDamage.invalidate(canvas->width(), canvas->height());
+    }
+    damageReported = false;
+
+    // Double buffered apps may block here while AppManager flushes display
+    uint32_t exchangeTime = micros();
+    bool replaced = tripleBuffered ? exchangeTriple() : exchangeDouble();
+    idleTime += micros() - exchangeTime;
 
     // Detect if frame was skipped. Need to readjust priorities in this case
-    KAPP_DBG if (frame && redraw) {
+    if (replaced) {
         skippedFrames++;
-        float percentSkipped = skippedFrames * 100 / frame;
-        lilka::serial.log("Skipping frame %d. Skipped %f", frame, percentSkipped);
+        KAPP_DBG {
+            float percentSkipped = skippedFrames * 100 / frame;
+            lilka::serial.log("Skipping frame %d. Skipped %f", frame, percentSkipped);
+        }
     }
 
-    // Flip canvas
-    auto buf = canvas;
-    canvas = backCanvas;
-    backCanvas = buf;
-
     // Increment frameCount
     frame++;
 
-    setRedraw(true);
+    stats.push(FRAME_STAT_WAIT, micros() - queueTime);
+
+    // Switch to a drawing task
+    if (!tripleBuffered) taskYIELD();
+
+    lastFrameTime = micros();
+}
+//-----------------------------------------------------------------------------
+bool App::exchangeDouble() {
+    KMTX_LOCK(canvasMutex);
+
+    bool replaced = frame && redraw;
+    if (replaced) damage[drawIdx].add(damage[displayIdx]);
+
+    // Flip canvas
+    lastIdx = drawIdx;
+    drawIdx = displayIdx;
+    displayIdx = lastIdx;
+    canvas = buffers[drawIdx];
+    backCanvas = buffers[displayIdx];
+    damage[drawIdx].clear();
+
+    redraw = true;
 
     KMTX_UNLOCK(canvasMutex);
 
-    // Switch to a drawing task
-    taskYIELD();
+    return replaced;
+}
+//-----------------------------------------------------------------------------
+bool App::exchangeTriple() {
+    // Publish our frame as the newest complete one and take whatever buffer
+    // was there. Never blocks: if AppManager didn't take previous frame yet,
+    // it is simply replaced and its damage moves to our frame. Slot is
+    // claimed first without ready bit, so AppManager can't take either
+    // buffer while damage is merged, and only then the frame is published
+    uint32_t prev = readyIdx.exchange(drawIdx);
+    if (prev & APP_FRAME_READY) damage[drawIdx].add(damage[prev & APP_FRAME_INDEX]);
+    readyIdx.store(drawIdx | APP_FRAME_READY);
+
+    lastIdx = drawIdx;
+    drawIdx = prev & APP_FRAME_INDEX;
+    canvas = buffers[drawIdx];
+    damage[drawIdx].clear();
+
+    return prev & APP_FRAME_READY;
+}
+//-----------------------------------------------------------------------------
+bool App::acquireFrame() {
+    // Double buffered apps swap canvases in queueDraw() already. Frame is
+    // taken only if it's still published, app may be merging damage into it
+    uint32_t ready = readyIdx.load();
+    if (tripleBuffered && (ready & APP_FRAME_READY) && readyIdx.compare_exchange_strong(ready, displayIdx)) {
+        displayIdx = ready & APP_FRAME_INDEX;
+        backCanvas = buffers[displayIdx];
+        redraw = true;
+    }
+
+    return redraw;
+}
+//-----------------------------------------------------------------------------
+uint32_t App::getCanvasEpoch() {
+    return canvasEpoch;
+}
+//-----------------------------------------------------------------------------
+AppPerfReport App::getPerfReport() {
+    AppPerfReport report;
+    bool suspended = getState() == KTS_SUSPENDED;
+
+    KMTX_LOCK(canvasMutex);
+
+    strlcpy(report.name, getName(), sizeof(report.name));
+    report.frames = frame;
+    report.droppedFrames = skippedFrames;
+    report.busyPercent = updateBusyPercent(suspended);
+    for (int type = 0; type < FRAME_STAT_COUNT; type++) {
+        report.stats[type] = stats.get(static_cast<FrameStatType>(type));
+    }
+
+    KMTX_UNLOCK(canvasMutex);
+
+    return report;
+}
+//-----------------------------------------------------------------------------
+uint8_t App::updateBusyPercent(bool suspended) {
+    uint32_t now = micros();
+    uint32_t idle = idleTime.load();
+    uint32_t elapsed = now - loadWindowStart;
+
+    if (suspended) {
+        // Suspended app burns nothing, start over once it's resumed
+        busyPercent = 0;
+    } else if (loadWindowStart && elapsed >= APP_CPU_LOAD_WINDOW) {
+        // Time app was preempted by others is counted as busy too
+        uint32_t idleElapsed = std::min(idle - loadWindowIdle, elapsed);
+        busyPercent = 100 - (uint64_t)idleElapsed * 100 / elapsed;
+    } else if (loadWindowStart) {
+        return busyPercent;
+    }
+
+    loadWindowStart = now;
+    loadWindowIdle = idle;
+
+    return busyPercent;
 }
@@ -7,6 +7,9 @@
 #define KEIRA_STATUSBAR_HEIGHT 24
 #include "keira/thread.h"
 #include "keira/bits/app.h"
+#include "keira/utils/damage.h"
+#include "keira/framestats.h"
+#include <atomic>
 
 // Uncomment this line to get debug information
 // #define KEIRA_APP_DEBUG
@@ -31,6 +34,13 @@ typedef enum : AppFlags_t {
 
     // Flags controlling app drawing
     APP_FLAG_INTERLACED = 1 << 3,
+    // Use third canvas so queueDraw() never waits for display flush.
+    // Falls back to double buffering if there's not enough memory
+    APP_FLAG_TRIPLE_BUFFER = 1 << 4,
+    // Compare each frame with previous one to flush only changed area.
+    // Costs a full canvas compare per frame, pays off for mostly static UIs.
+    // Without it whole canvas is flushed unless app calls addDamage()
+    APP_FLAG_DAMAGE_DIFF = 1 << 5,
 } AppFlags;
 //////////////////////////////////////////////////////////////////////////////
 
@@ -47,6 +57,12 @@ public:
     lilka::Canvas* canvas = NULL;
     // Swap canvas and backCanvas, automaticaly changes redraw status
     void queueDraw();
+    // Snapshot of frame timing telemetry
+    AppPerfReport getPerfReport();
+    // Changes each time canvases are recreated or painted over by system
+    // (e.g. toast). Apps caching what they've drawn on canvases can use it
+    // to detect their contents are lost
+    uint32_t getCanvasEpoch();
 
 protected:
     //========================================================================
@@ -68,6 +84,22 @@ protected:
     bool errnocheck();
     // Simple lilka::InputDialog
     String input(const String& title, const String& value = "", bool masked = false);
+    //========================================================================
+    //  Frame pacing
+    //========================================================================
+    // Frame rate waitNextFrame() keeps app at. 0 disables pacing
+    void setTargetFps(uint8_t fps);
+    uint8_t getTargetFps();
+    // Sleeps until next frame is due. App running behind schedule isn't
+    // delayed, and next frames are counted from now instead of rushing
+    // through missed ones
+    void waitNextFrame();
+    // Sleeps until micros() reaches deadline. Sleeps whole ticks only, so it
+    // may return up to a tick early, but never late
+    void sleepUntil(uint32_t us);
+    // Accounts blocking wait done by other means (e.g. on event queue) as
+    // idle time
+    void addIdleTime(uint32_t us);
 
     //////////////////////////////////////////////////////////////////////////
     //========================================================================
@@ -75,8 +107,12 @@ protected:
     //========================================================================
     //  Retrieves current redraw status. true indicates redraw needed
     bool getRedraw();
-    //  Set redraw status
+    //  Set redraw status. Setting it forces full canvas redraw, clearing it
+    //  drops collected damage
     void setRedraw(bool redraw);
+    // Reports area of canvas changed against previously queued frame. Frame
+    // with reported damage isn't compared, even with APP_FLAG_DAMAGE_DIFF
+    void addDamage(uint16_t x, uint16_t y, uint16_t w, uint16_t h);
     // Initializes canvas, recreates canvas on flag changes
     void initCanvas();
     // Clear existing canvases memory
@@ -84,10 +120,60 @@ protected:
     //////////////////////////////////////////////////////////////////////////
     lilka::Canvas* backCanvas = NULL;
     uint32_t frame = 0;
-    uint32_t skippedFrames = 0; // Counted only in debug mode
-    // TODO: lastFrame, FPS meter
+    // Frames replaced before AppManager managed to draw them
+    uint32_t skippedFrames = 0;
+
 private:
+    //========================================================================
+    //  Canvas handoff
+    //========================================================================
+    // Double buffering: swap canvases under canvasMutex
+    bool exchangeDouble();
+    // Triple buffering: publish frame via readyIdx, never blocks
+    bool exchangeTriple();
+    // Takes newest complete frame as backCanvas. To be called by
+    // AppManager with canvasMutex locked. Returns redraw status
+    bool acquireFrame();
+    // Closes CPU load window if it's long enough. To be called with
+    // canvasMutex locked. Returns busy percentage of last closed window
+    uint8_t updateBusyPercent(bool suspended);
+    //////////////////////////////////////////////////////////////////////////
+    // Frame timing telemetry
+    FrameStats stats;
+    // Time previous queueDraw() returned to app
+    uint32_t lastFrameTime = 0;
+    //////////////////////////////////////////////////////////////////////////
+    // Frame pacing (owned by app thread)
+    uint8_t targetFps = APP_TARGET_FPS;
+    TickType_t framePeriod = pdMS_TO_TICKS(1000 / APP_TARGET_FPS);
+    // Tick previous frame was due, 0 until first waitNextFrame()
+    TickType_t lastWakeTick = 0;
+    // Total time (us) app spent sleeping or blocked. Wraps, only
+    // differences are used
+    std::atomic<uint32_t> idleTime{0};
+    // CPU load window (owned by getPerfReport())
+    uint32_t loadWindowStart = 0;
+    uint32_t loadWindowIdle = 0;
+    uint8_t busyPercent = 0;
     SemaphoreHandle_t canvasMutex = xSemaphoreCreateMutex();
     bool redraw = false;
+    // Display contents unknown, push whole backCanvas on next redraw
+    bool fullRedraw = false;
+    // Canvas buffers. canvas and backCanvas point into this array
+    lilka::Canvas* buffers[APP_BUFFERS_MAX] = {};
+    // Area of each buffer changed since last display flush
+    DamageRegion damage[APP_BUFFERS_MAX];
+    bool tripleBuffered = false;
+    std::atomic<uint32_t> canvasEpoch{0};
+    // Buffer app draws to (owned by app thread)
+    uint8_t drawIdx = 0;
+    // addDamage() was called for current frame (owned by app thread)
+    bool damageReported = false;
+    // Buffer queued before current one (owned by app thread)
+    uint8_t lastIdx = 1;
+    // Buffer shown on display (owned by AppManager)
+    uint8_t displayIdx = 1;
+    // Newest complete frame waiting for AppManager + APP_FRAME_READY bit
+    std::atomic<uint32_t> readyIdx{2};
     AppFlags_t flags = AppFlags::APP_FLAG_NONE;
 };
@@ -3,6 +3,7 @@
 
 #include "keira/appmanager.h"
 #include "keira/thread.h"
+#include "keira/ksystem.h"
 
 // Apps:
 #include "apps/statusbar/statusbar.h"
@@ -44,6 +45,8 @@ void AppManager::run() {
 
         ThreadManager::threadsClean();
 
+        publishCombos();
+
         /// LOCK THREADS LIST
         KMTX_LOCK(ThreadManager::lock);
 
@@ -59,12 +62,19 @@ void AppManager::run() {
             continue;
         }
 
+        if (topApp != lastTopApp) {
+            lastTopApp = topApp;
+            ksystem.events.publish(KEVENT_APP_SWITCH, reinterpret_cast<uint32_t>(topApp));
+        }
+
         // Ensure topApp not sleeping
         if (topApp->getState() == KTS_SUSPENDED) {
             // Wake up Neo
             topApp->resume();
             KMTX_LOCK(panelMtx);
+            KMTX_LOCK(panel->canvasMutex);
             panel->setRedraw(true);
+            KMTX_UNLOCK(panel->canvasMutex);
             KMTX_UNLOCK(panelMtx);
         }
 
@@ -83,19 +93,40 @@ void AppManager::run() {
             /// LOCK APP CANVAS
             KMTX_LOCK(app->canvasMutex);
 
+            // Take newest frame queued by app
+            bool redraw = app->acquireFrame();
+
             // Draw toast message on app's canvas to prevent flickering
-            if (millis() < toast.endTime) {
-                renderToast(topApp->backCanvas);
+            if (app == topApp) {
+                bool toastVisible = millis() < toast.endTime;
+                if (toastVisible) {
+                    // Buffer gets back to app with toast on it. Let apps
+                    // keeping track of buffers contents know it's lost
+                    topApp->canvasEpoch++;
+                    renderToast(topApp->backCanvas);
+                }
+                // Toast moves, simply repaint whole app while it's shown
+                // and once after it's gone
+                if (toastVisible || toastShown) topApp->fullRedraw = true;
+                toastShown = toastVisible;
             }
 
             // Redraw app
-            if (app->getRedraw()) {
+            if (redraw) {
+                uint32_t flushStart = micros();
                 if (app->flags & AppFlags::APP_FLAG_INTERLACED) {
                     lilka::display.drawCanvasInterlaced(app->backCanvas, app->frame % 2);
-                } else {
+                } else if (app->fullRedraw) {
                     lilka::display.drawCanvas(app->backCanvas);
+                } else {
+                    flushDamage(app->backCanvas, app->damage[app->displayIdx]);
                 }
+                app->stats.push(FRAME_STAT_FLUSH, micros() - flushStart);
                 app->setRedraw(false);
+                if (app == topApp && !firstFrameShown) {
+                    firstFrameShown = true;
+                    xSemaphoreGive(firstFrame);
+                }
             }
             /// UNLOCK APP CANVAS
             KMTX_UNLOCK(app->canvasMutex);
@@ -107,6 +138,91 @@ void AppManager::run() {
         //K_AMG_DBG lilka::serial.log("Last frame tick = %d", lastFrameTick);
     }
 }
+/// App manager wakes up each frame anyway, so reading controller here adds
+/// no wakeups, and services waiting for combos don't have to poll it.
+void AppManager::publishCombos() {
+    lilka::State state = lilka::controller.peekState();
+    uint32_t combos = 0;
+    if (state.select.pressed && state.start.pressed) combos |= KEIRA_COMBO_SELECT_START;
+
+    if (combos != lastCombos) {
+        lastCombos = combos;
+        ksystem.events.publish(KEVENT_BUTTON_COMBO, combos);
+    }
+}
+
+/// Push damaged parts of canvas to display. Falls back to full canvas
+/// transfer if most of it changed anyway. Canvas mutex to be locked by caller
+void AppManager::flushDamage(lilka::Canvas* canvas, const DamageRegion& damage) {
+    if (damage.isEmpty()) return;
+
+    uint16_t cw = canvas->width();
+    uint16_t ch = canvas->height();
+
+    if (damage.area() >= (uint32_t)cw * ch * KEIRA_DAMAGE_FULL_FLUSH_PERCENT / 100) {
+        lilka::display.drawCanvas(canvas);
+        return;
+    }
+
+    uint16_t* fb = canvas->getFramebuffer();
+
+    for (uint8_t i = 0; i < damage.count(); i++) {
+        const DamageRect& rect = damage[i];
+
+        // Clip to canvas
+        if (rect.x >= cw || rect.y >= ch) continue;
+        uint16_t w = rect.x + rect.w > cw ? cw - rect.x : rect.w;
+        uint16_t h = rect.y + rect.h > ch ? ch - rect.y : rect.h;
+
+        // Full width rows are contiguous in framebuffer, send them at once
+        if (w == cw) {
+            lilka::display.draw16bitRGBBitmap(canvas->x(), canvas->y() + rect.y, fb + rect.y * cw, cw, h);
+            continue;
+        }
+
+        // Otherwise pack rows into flush buffer and send it in strips
+        uint16_t stripRows = KEIRA_FLUSH_BUFFER_PIXELS / w;
+        if (!stripRows) stripRows = 1;
+
+        for (uint16_t row = 0; row < h; row += stripRows) {
+            uint16_t rows = h - row < stripRows ? h - row : stripRows;
+            uint16_t* src = fb + (rect.y + row) * cw + rect.x;
+            // Single row (or row wider than buffer) is sent directly
+            if (rows == 1) {
+                lilka::display.draw16bitRGBBitmap(canvas->x() + rect.x, canvas->y() + rect.y + row, src, w, 1);
+                continue;
+            }
+            for (uint16_t r = 0; r < rows; r++) {
+                memcpy(flushBuffer + r * w, src + r * cw, w * sizeof(uint16_t));
+            }
+            lilka::display.draw16bitRGBBitmap(canvas->x() + rect.x, canvas->y() + rect.y + row, flushBuffer, w, rows);
+        }
+    }
+}
+
+/// Collect frame timing telemetry of panel and all running apps.
+std::vector<AppPerfReport> AppManager::getPerfReports() {
+    std::vector<AppPerfReport> reports;
+
+    KMTX_LOCK(ThreadManager::lock);
+
+    KMTX_LOCK(panelMtx);
+    if (panel) reports.push_back(panel->getPerfReport());
+    KMTX_UNLOCK(panelMtx);
+
+    for (auto thread : threads) {
+        reports.push_back(APP_PCAST(thread)->getPerfReport());
+    }
+
+    KMTX_UNLOCK(ThreadManager::lock);
+
+    return reports;
+}
+
+bool AppManager::waitFirstFrame(TickType_t timeout) {
+    return xSemaphoreTake(firstFrame, timeout) == pdTRUE;
+}
+
 /// Render panel and top app to the given canvas.
 /// Useful for taking screenshots.
 void AppManager::renderToCanvas(lilka::Canvas* canvas) {
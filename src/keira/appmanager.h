@@ -32,18 +32,37 @@ public:
     void renderToCanvas(lilka::Canvas* canvas);
     // Starts toast
     void startToast(String message, uint64_t duration = 2500);
+    // Retrieves frame timing telemetry of panel and running apps
+    std::vector<AppPerfReport> getPerfReports();
+    // Waits until first frame of top app reaches display. Returns false on timeout
+    bool waitFirstFrame(TickType_t timeout);
 
 private:
     // Performs app runing
     void threadsRun() override;
 
+    // Publishes KEVENT_BUTTON_COMBO when held combos change
+    void publishCombos();
+    uint32_t lastCombos = 0;
+    // Top app of previous frame, its change is published as KEVENT_APP_SWITCH
+    App* lastTopApp = NULL;
+
     // Performs toast rendering to given canvas
     void renderToast(lilka::Canvas* canvas);
+    // Sends damaged spans of canvas to display
+    void flushDamage(lilka::Canvas* canvas, const DamageRegion& damage);
+    // Scratch buffer to pack partial rows before sending them to display
+    uint16_t flushBuffer[KEIRA_FLUSH_BUFFER_PIXELS];
     // Storage for toast
     KeiraToast toast = KEIRA_TOAST_INITIALIZER;
+    // Toast was drawn on previous frame
+    bool toastShown = false;
     // TopPanel (StatusBarApp)
     App* panel = NULL;
     SemaphoreHandle_t panelMtx = xSemaphoreCreateMutex();
+    // Given once, when first frame of top app is shown
+    SemaphoreHandle_t firstFrame = xSemaphoreCreateBinary();
+    bool firstFrameShown = false;
     // Used for capping framerate to A
     TickType_t lastFrameTick = xTaskGetTickCount();
 };
@@ -18,6 +18,32 @@
 //============================================================================
 #define APP_DRAWING_FLAGS (APP_FLAG_DEFAULT | APP_FLAG_STATUSBAR | APP_FLAG_FULLSCREEN)
 //============================================================================
+//  CANVAS BUFFERS
+//============================================================================
+// == Max amount of canvases per app (triple buffering)
+#define APP_BUFFERS_MAX 3
+//----------------------------------------------------------------------------
+// == Triple buffering ready slot encoding: buffer index + "not taken" bit
+#define APP_FRAME_INDEX 0x7F
+#define APP_FRAME_READY 0x80
+//----------------------------------------------------------------------------
+// == Memory (in bytes) to be kept free after allocating triple buffers
+#ifndef APP_TRIPLE_BUFFER_RESERVE
+#    define APP_TRIPLE_BUFFER_RESERVE (64 * 1024)
+#endif
+//============================================================================
+//  FRAME PACING
+//============================================================================
+// == Frame rate waitNextFrame() keeps app at, unless changed by setTargetFps()
+#ifndef APP_TARGET_FPS
+#    define APP_TARGET_FPS 30
+#endif
+//----------------------------------------------------------------------------
+// == Shortest period (in us) CPU busy percentage is averaged over
+#ifndef APP_CPU_LOAD_WINDOW
+#    define APP_CPU_LOAD_WINDOW 1000000
+#endif
+//============================================================================
 //  THREAD SETTINGS
 //============================================================================
 // == STACK SIZE
@@ -10,6 +10,18 @@
 #define KEIRA_TOAST_INITIALIZER {.message = "", .startTime = 0, .endTime = 0, .mtx = xSemaphoreCreateMutex()}
 // clang-format on
 
+//============================================================================
+//  DISPLAY FLUSH SETTINGS
+//============================================================================
+// == Size of buffer used to pack partially damaged rows (in pixels)
+#ifndef KEIRA_FLUSH_BUFFER_PIXELS
+#    define KEIRA_FLUSH_BUFFER_PIXELS 4096
+#endif
+//----------------------------------------------------------------------------
+// == Damage area (in percents of canvas) to push whole canvas instead
+#ifndef KEIRA_DAMAGE_FULL_FLUSH_PERCENT
+#    define KEIRA_DAMAGE_FULL_FLUSH_PERCENT 75
+#endif
 //============================================================================
 //  THREAD SETTINGS
 //============================================================================
@@ -0,0 +1,42 @@
+#include "keira/boottimeline.h"
+#include <esp_timer.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <lilka/serial.h>
+#include "keira/mutex.h"
+
+void BootTimeline::mark(const char* format, ...) {
+    int64_t time = esp_timer_get_time();
+
+    KMTX_LOCK(lock);
+
+    if (count < KEIRA_BOOT_TIMELINE_SIZE) {
+        BootStage& stage = stages[count++];
+        stage.time = time;
+        va_list args;
+        va_start(args, format);
+        vsnprintf(stage.name, sizeof(stage.name), format, args);
+        va_end(args);
+    }
+
+    KMTX_UNLOCK(lock);
+}
+
+std::vector<BootStage> BootTimeline::getStages() {
+    KMTX_LOCK(lock);
+
+    std::vector<BootStage> result(stages, stages + count);
+
+    KMTX_UNLOCK(lock);
+
+    return result;
+}
+
+void BootTimeline::log() {
+    int64_t previous = 0;
+    lilka::serial.log("Boot timeline (us since start, us since previous stage):");
+    for (auto& stage : getStages()) {
+        lilka::serial.log("%10lld %10lld  %s", stage.time, stage.time - previous, stage.name);
+        previous = stage.time;
+    }
+}
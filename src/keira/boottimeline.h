@@ -0,0 +1,43 @@
+#pragma once
+//////////////////////////////////////////////////////////////////////////////
+//
+//  Keira OS Header file
+//
+//////////////////////////////////////////////////////////////////////////////
+// Boot timeline
+//////////////////////////////////////////////////////////////////////////////
+// Records when each boot stage ended, in microseconds since chip start, so
+// it's visible where time goes before launcher becomes interactive. Stages
+// are marked by KeiraSystem during setup and by services when they are
+// started and become ready. Fixed storage, marks past the limit are dropped.
+//////////////////////////////////////////////////////////////////////////////
+#include <Arduino.h>
+#include <vector>
+#include <stdint.h>
+
+// Amount of stages kept
+#ifndef KEIRA_BOOT_TIMELINE_SIZE
+#    define KEIRA_BOOT_TIMELINE_SIZE 40
+#endif
+
+#define KEIRA_BOOT_STAGE_NAME_MAX 32
+
+typedef struct {
+    char name[KEIRA_BOOT_STAGE_NAME_MAX];
+    int64_t time;
+} BootStage;
+
+class BootTimeline {
+public:
+    // Marks end of stage. Name is printf-like format
+    void mark(const char* format, ...);
+    // Retrieves copy of recorded stages in chronological order
+    std::vector<BootStage> getStages();
+    // Sends timeline to serial
+    void log();
+
+private:
+    BootStage stages[KEIRA_BOOT_TIMELINE_SIZE] = {};
+    uint8_t count = 0;
+    SemaphoreHandle_t lock = xSemaphoreCreateMutex();
+};
@@ -0,0 +1,63 @@
+#include "keira/eventbus.h"
+#include <lilka/serial.h>
+#include "keira/mutex.h"
+
+#ifdef KEIRA_EVENTBUS_DEBUG
+#    define K_EVB_DBG if (1)
+#else
+#    define K_EVB_DBG if (0)
+#endif
+
+KeiraEventQueue EventBus::subscribe(uint32_t mask, uint8_t depth) {
+    KeiraEventQueue queue = xQueueCreate(depth, sizeof(KeiraEvent));
+    if (queue == NULL) {
+        lilka::serial.err("EventBus: not enough memory for subscriber queue");
+        return NULL;
+    }
+
+    KMTX_LOCK(lock);
+
+    subscribers.push_back({queue, mask});
+
+    KMTX_UNLOCK(lock);
+
+    return queue;
+}
+
+void EventBus::unsubscribe(KeiraEventQueue queue) {
+    KMTX_LOCK(lock);
+
+    for (auto subscriber = subscribers.begin(); subscriber < subscribers.end(); subscriber++) {
+        if (subscriber->queue == queue) {
+            subscribers.erase(subscriber);
+            break;
+        }
+    }
+
+    KMTX_UNLOCK(lock);
+
+    vQueueDelete(queue);
+}
+
+void EventBus::publish(KeiraEventType type, uint32_t value) {
+    KeiraEvent event = {type, value};
+
+    K_EVB_DBG lilka::serial.log("EventBus: %s %u", KEIRA_EVENT_TYPE_ACSTR[type], value);
+
+    KMTX_LOCK(lock);
+
+    for (auto& subscriber : subscribers) {
+        if (!(subscriber.mask & KEVENT_MASK(type))) continue;
+        if (xQueueSend(subscriber.queue, &event, 0) != pdTRUE) {
+            K_EVB_DBG lilka::serial.err(
+                "EventBus: queue %p is full, %s dropped", subscriber.queue, KEIRA_EVENT_TYPE_ACSTR[type]
+            );
+        }
+    }
+
+    KMTX_UNLOCK(lock);
+}
+
+bool EventBus::wait(KeiraEventQueue queue, KeiraEvent* event, TickType_t timeout) {
+    return xQueueReceive(queue, event, timeout) == pdTRUE;
+}
@@ -0,0 +1,77 @@
+#pragma once
+//////////////////////////////////////////////////////////////////////////////
+//
+//  Keira OS Header file
+//
+//////////////////////////////////////////////////////////////////////////////
+// System event bus
+//////////////////////////////////////////////////////////////////////////////
+// Publish/subscribe for system events, so services can block until
+// something happens instead of polling. Each subscriber owns a FreeRTOS
+// queue receiving events of types it asked for; waiting on it costs no CPU.
+//
+// Events tell that something changed, not the whole new state. If
+// subscriber's queue is full, event is dropped for it, so subscribers should
+// re-read state they care about (e.g. NetworkService::getnetworkState())
+// after any wakeup rather than count events.
+//////////////////////////////////////////////////////////////////////////////
+#include <Arduino.h>
+#include <vector>
+
+// Uncomment to get debug information
+// #define KEIRA_EVENTBUS_DEBUG
+
+#ifndef KEIRA_EVENTBUS_QUEUE_DEPTH
+#    define KEIRA_EVENTBUS_QUEUE_DEPTH 8
+#endif
+
+typedef enum {
+    // Network state or signal strength changed. Value: NetworkState
+    KEVENT_NETWORK_STATE,
+    // Held button combos changed. Value: mask of KEIRA_COMBO_*
+    KEVENT_BUTTON_COMBO,
+    // SD card became available or unavailable to Keira (e.g. exported over
+    // USB). Value: 1 if available
+    KEVENT_SD_STATE,
+    // Other app is now on top. Value: App*
+    KEVENT_APP_SWITCH,
+    // Minute changed or time was synced. Value: time_t
+    KEVENT_CLOCK_TICK,
+    // Service was enabled or disabled. Value: Service*
+    KEVENT_SERVICE_STATE,
+    KEVENT_COUNT
+} KeiraEventType;
+
+const char KEIRA_EVENT_TYPE_ACSTR[][10] = {"network", "combo", "sd", "app", "clock", "service"};
+
+#define KEVENT_MASK(TYPE) (1UL << (TYPE))
+
+// Button combos reported by KEVENT_BUTTON_COMBO
+#define KEIRA_COMBO_SELECT_START (1UL << 0)
+
+typedef struct {
+    KeiraEventType type;
+    uint32_t value;
+} KeiraEvent;
+
+typedef QueueHandle_t KeiraEventQueue;
+
+class EventBus {
+public:
+    // Creates queue receiving events of types in mask (see KEVENT_MASK)
+    KeiraEventQueue subscribe(uint32_t mask, uint8_t depth = KEIRA_EVENTBUS_QUEUE_DEPTH);
+    void unsubscribe(KeiraEventQueue queue);
+    // Never blocks, can be called from any task but not from ISR
+    void publish(KeiraEventType type, uint32_t value = 0);
+    // Blocks until event arrives. Returns false on timeout
+    static bool wait(KeiraEventQueue queue, KeiraEvent* event, TickType_t timeout = portMAX_DELAY);
+
+private:
+    typedef struct {
+        KeiraEventQueue queue;
+        uint32_t mask;
+    } Subscriber;
+
+    std::vector<Subscriber> subscribers;
+    SemaphoreHandle_t lock = xSemaphoreCreateMutex();
+};
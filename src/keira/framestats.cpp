@@ -0,0 +1,30 @@
+#include "keira/framestats.h"
+#include <algorithm>
+#include <string.h>
+
+void FrameStats::push(FrameStatType type, uint32_t us) {
+    samples[type][head[type]] = us;
+    head[type] = (head[type] + 1) % KEIRA_FRAME_STATS_DEPTH;
+    if (filled[type] < KEIRA_FRAME_STATS_DEPTH) filled[type]++;
+}
+
+FrameStatPercentiles FrameStats::get(FrameStatType type) const {
+    FrameStatPercentiles result = {0, 0, 0};
+    uint16_t count = filled[type];
+    if (!count) return result;
+
+    // Sort a copy, ring keeps chronological order for next pushes
+    uint32_t sorted[KEIRA_FRAME_STATS_DEPTH];
+    memcpy(sorted, samples[type], count * sizeof(uint32_t));
+    std::sort(sorted, sorted + count);
+
+    result.p50 = sorted[(count - 1) * 50 / 100];
+    result.p95 = sorted[(count - 1) * 95 / 100];
+    result.p99 = sorted[(count - 1) * 99 / 100];
+    return result;
+}
+
+void FrameStats::reset() {
+    memset(head, 0, sizeof(head));
+    memset(filled, 0, sizeof(filled));
+}
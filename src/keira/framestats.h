@@ -0,0 +1,62 @@
+#pragma once
+//////////////////////////////////////////////////////////////////////////////
+//
+//  Keira OS Header file
+//
+//////////////////////////////////////////////////////////////////////////////
+// Per-app frame timing telemetry
+//////////////////////////////////////////////////////////////////////////////
+// Keeps last KEIRA_FRAME_STATS_DEPTH samples of each kind in a ring buffer.
+// Pushing a sample is O(1), percentiles are computed only on request, so
+// stats are always on without hurting apps.
+//////////////////////////////////////////////////////////////////////////////
+#include <stdint.h>
+#include "keira/thread.h"
+
+// Amount of samples kept per stat type
+#ifndef KEIRA_FRAME_STATS_DEPTH
+#    define KEIRA_FRAME_STATS_DEPTH 128
+#endif
+
+typedef enum {
+    // Time spent by app in run() between queueDraw() calls
+    FRAME_STAT_RUN,
+    // Time spent handing frame over in queueDraw(), including time blocked
+    // on canvasMutex for double buffered apps
+    FRAME_STAT_WAIT,
+    // Display flush duration inside AppManager::run()
+    FRAME_STAT_FLUSH,
+    FRAME_STAT_COUNT
+} FrameStatType;
+
+const char FRAME_STAT_TYPE_ACSTR[][6] = {"run", "wait", "flush"};
+
+// All values in microseconds
+typedef struct {
+    uint32_t p50;
+    uint32_t p95;
+    uint32_t p99;
+} FrameStatPercentiles;
+
+typedef struct {
+    // Copy of app name, report outlives the app it was taken from
+    char name[KT_NAME_MAX];
+    uint32_t frames;
+    uint32_t droppedFrames;
+    // Share of time app wasn't sleeping in pacing calls or blocked handing
+    // frames over, averaged over last APP_CPU_LOAD_WINDOW or longer
+    uint8_t busyPercent;
+    FrameStatPercentiles stats[FRAME_STAT_COUNT];
+} AppPerfReport;
+
+class FrameStats {
+public:
+    void push(FrameStatType type, uint32_t us);
+    FrameStatPercentiles get(FrameStatType type) const;
+    void reset();
+
+private:
+    uint32_t samples[FRAME_STAT_COUNT][KEIRA_FRAME_STATS_DEPTH] = {};
+    uint16_t head[FRAME_STAT_COUNT] = {};
+    uint16_t filled[FRAME_STAT_COUNT] = {};
+};
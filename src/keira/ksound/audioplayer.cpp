@@ -61,8 +61,17 @@ bool AudioPlayer::play(lilka::Sound* sound, AudioOutput* customOutput) {
         ownsOutput = true;
     }
 
-    // Create source from sound data
-    source = new AudioFileSourcePROGMEM(sound->data, sound->size);
+    // Create source from sound data, or stream it from file
+    if (sound->path) {
+        stream = new AudioFileSourceStream(AudioFileSourceStream::bufferSizeFor(sound->type));
+        source = stream;
+        if (!stream->open(sound->path)) {
+            stopInternal();
+            return false;
+        }
+    } else {
+        source = new AudioFileSourcePROGMEM(sound->data, sound->size);
+    }
 
     // Begin playback
     generator->begin(source, output);
@@ -184,6 +193,7 @@ void AudioPlayer::stopInternal() {
         delete source;
         source = nullptr;
     }
+    stream = nullptr;
     if (ownsOutput && output) {
         delete output;
     }
@@ -237,6 +247,10 @@ const lilka::Sound* AudioPlayer::getPlayingSound() {
     return playingSound;
 }
 
+const lilka::AudioFileSourceStream* AudioPlayer::getStream() {
+    return stream;
+}
+
 void AudioPlayer::cleanup() {
     stopInternal();
     if (commandQueue != nullptr) {
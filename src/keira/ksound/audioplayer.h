@@ -5,6 +5,7 @@
 #include <AudioFileSourcePROGMEM.h>
 
 #include "sound.h"
+#include "streamsource.h"
 
 namespace lilka {
 
@@ -34,6 +35,8 @@ public:
     bool isPlaying();
     bool isFinished();
     const lilka::Sound* getPlayingSound();
+    /// Джерело, якщо звук читається з файлу, інакше nullptr. Дійсне, поки звук не зупинено.
+    const lilka::AudioFileSourceStream* getStream();
     void cleanup();
 
 private:
@@ -41,7 +44,8 @@ private:
     static void audioTaskFunc(void* arg);
 
     AudioGenerator* generator = nullptr;
-    AudioFileSourcePROGMEM* source = nullptr;
+    AudioFileSource* source = nullptr;
+    AudioFileSourceStream* stream = nullptr;
     AudioOutput* output = nullptr;
     bool ownsOutput = false;
     lilka::Sound* playingSound = nullptr;
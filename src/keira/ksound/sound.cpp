@@ -1,5 +1,7 @@
 #include "sound.h"
 #include <cstring>
+#include <cstdlib>
+#include <sys/stat.h>
 
 namespace lilka {
 
@@ -8,8 +10,18 @@ Sound::Sound(uint8_t* data, size_t size, const char* type) : data(data), size(si
     this->type[sizeof(this->type) - 1] = '\0';
 }
 
+Sound::Sound(const char* path, const char* type) : data(nullptr), size(0) {
+    this->path = strdup(path);
+    strncpy(this->type, type, sizeof(this->type) - 1);
+    this->type[sizeof(this->type) - 1] = '\0';
+
+    struct stat st;
+    if (stat(path, &st) == 0) size = st.st_size;
+}
+
 Sound::~Sound() {
     delete[] data;
+    free(path);
 }
 
 } // namespace lilka
@@ -19,11 +19,22 @@ public:
     /// @param size Розмір даних у байтах.
     /// @param type Тип аудіо: "mod", "wav", "mp3", "aac", "flac".
     Sound(uint8_t* data, size_t size, const char* type);
+    /// Створити звук, який читатиметься з файлу під час відтворення.
+    ///
+    /// Файл не завантажується в пам'ять повністю, тож так можна відтворювати навіть дуже великі файли.
+    ///
+    /// @param path Шлях до аудіо-файлу.
+    /// @param type Тип аудіо: "wav", "mp3", "aac", "flac". MOD краще завантажувати повністю, бо його відтворення
+    /// постійно перемотує файл.
+    Sound(const char* path, const char* type);
     ~Sound();
 
-    /// Дані аудіо-файлу.
+    /// Дані аудіо-файлу, або nullptr для звуку, що читається з файлу.
     uint8_t* data;
 
+    /// Шлях до аудіо-файлу, якщо звук читається з файлу, інакше nullptr.
+    char* path = nullptr;
+
     /// Розмір даних у байтах.
     size_t size;
 
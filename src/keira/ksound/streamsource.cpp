@@ -0,0 +1,251 @@
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <string.h>
+#include <esp_heap_caps.h>
+
+#include "keira/mutex.h"
+
+#include "streamsource.h"
+
+namespace lilka {
+
+AudioFileSourceStream::AudioFileSourceStream(size_t bufferSize) {
+    // Reads are chunk aligned and never wrap around the ring
+    size_t chunks = (bufferSize + KSOUND_STREAM_CHUNK_SIZE - 1) / KSOUND_STREAM_CHUNK_SIZE;
+    if (chunks < 2) chunks = 2;
+    this->bufferSize = chunks * KSOUND_STREAM_CHUNK_SIZE;
+}
+
+AudioFileSourceStream::~AudioFileSourceStream() {
+    close();
+}
+
+size_t AudioFileSourceStream::bufferSizeFor(const char* type) {
+    // Worst case byte rates: 44.1kHz 16-bit stereo PCM, FLAC at ~70% of it, 320 kbps for lossy
+    uint32_t byteRate = 40000;
+    if (strcmp(type, "wav") == 0) {
+        byteRate = 176400;
+    } else if (strcmp(type, "flac") == 0) {
+        byteRate = 123480;
+    }
+    return byteRate * KSOUND_STREAM_SECONDS;
+}
+
+bool AudioFileSourceStream::open(const char* filename) {
+    close();
+
+    fd = ::open(filename, O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close();
+        return false;
+    }
+    fileSize = st.st_size;
+
+    buffer = static_cast<uint8_t*>(heap_caps_malloc(bufferSize, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT));
+    mutex = xSemaphoreCreateMutex();
+    dataReady = xSemaphoreCreateBinary();
+    spaceReady = xSemaphoreCreateBinary();
+    taskDone = xSemaphoreCreateBinary();
+    if (!buffer || !mutex || !dataReady || !spaceReady || !taskDone) {
+        close();
+        return false;
+    }
+
+    readPos = 0;
+    writePos = 0;
+    underruns = 0;
+    stopping = false;
+    // Nothing is read yet
+    refilling = true;
+
+    if (xTaskCreatePinnedToCore(readerTaskFunc, "AudioStream", 4096, this, 1, &taskHandle, 0) != pdPASS) {
+        taskHandle = nullptr;
+        close();
+        return false;
+    }
+
+    return true;
+}
+
+void AudioFileSourceStream::readerTaskFunc(void* arg) {
+    AudioFileSourceStream* self = static_cast<AudioFileSourceStream*>(arg);
+
+    while (!self->stopping) {
+        // Read ahead until the ring is full, then sleep till decoder frees a chunk
+        if (!self->fill()) {
+            xSemaphoreTake(self->spaceReady, pdMS_TO_TICKS(100));
+        }
+    }
+
+    xSemaphoreGive(self->taskDone);
+    vTaskSuspend(NULL);
+}
+
+bool AudioFileSourceStream::fill() {
+    KMTX_LOCK(mutex);
+
+    uint32_t w = writePos.load();
+    uint32_t freeSpace = bufferSize - (w - readPos.load());
+
+    // Read up to the next chunk boundary, so after a seek reads get aligned again
+    uint32_t n = KSOUND_STREAM_CHUNK_SIZE - (w % KSOUND_STREAM_CHUNK_SIZE);
+    if (n > fileSize - w) n = fileSize - w;
+
+    if (!n || freeSpace < n) {
+        KMTX_UNLOCK(mutex);
+        return false;
+    }
+
+    ssize_t got = ::read(fd, buffer + (w % bufferSize), n);
+    if (got <= 0) {
+        // File got shorter or card went away, treat what we have as the whole file
+        fileSize = w;
+    } else {
+        writePos = w + got;
+    }
+
+    KMTX_UNLOCK(mutex);
+    xSemaphoreGive(dataReady);
+    return got > 0;
+}
+
+void AudioFileSourceStream::restart(uint32_t pos) {
+    KMTX_LOCK(mutex);
+    lseek(fd, pos, SEEK_SET);
+    readPos = pos;
+    writePos = pos;
+    refilling = true;
+    KMTX_UNLOCK(mutex);
+    xSemaphoreGive(spaceReady);
+}
+
+uint32_t AudioFileSourceStream::copyOut(void* data, uint32_t len) {
+    uint32_t r = readPos.load();
+    uint32_t available = writePos.load() - r;
+    if (len > available) len = available;
+    if (!len) return 0;
+
+    // Copy in up to two parts, if data wraps around the ring
+    uint32_t offset = r % bufferSize;
+    uint32_t first = bufferSize - offset;
+    if (first > len) first = len;
+    memcpy(data, buffer + offset, first);
+    memcpy(static_cast<uint8_t*>(data) + first, buffer, len - first);
+
+    readPos = r + len;
+    xSemaphoreGive(spaceReady);
+    return len;
+}
+
+uint32_t AudioFileSourceStream::read(void* data, uint32_t len) {
+    if (fd < 0) return 0;
+
+    uint32_t total = 0;
+    bool waited = false;
+
+    while (total < len) {
+        uint32_t got = copyOut(static_cast<uint8_t*>(data) + total, len - total);
+        total += got;
+        if (got) {
+            refilling = false;
+            continue;
+        }
+
+        if (readPos.load() >= fileSize || stopping) break;
+
+        // Decoder is faster than the card, count it once per read
+        if (!waited && !refilling) {
+            underruns++;
+            waited = true;
+        }
+        xSemaphoreTake(dataReady, pdMS_TO_TICKS(100));
+    }
+
+    return total;
+}
+
+uint32_t AudioFileSourceStream::readNonBlock(void* data, uint32_t len) {
+    if (fd < 0) return 0;
+    return copyOut(data, len);
+}
+
+bool AudioFileSourceStream::seek(int32_t pos, int dir) {
+    if (fd < 0) return false;
+
+    int64_t target = pos;
+    if (dir == SEEK_CUR) {
+        target += readPos.load();
+    } else if (dir == SEEK_END) {
+        target += fileSize;
+    } else if (dir != SEEK_SET) {
+        return false;
+    }
+    if (target < 0 || target > fileSize) return false;
+
+    // Forward skip within buffered data is free, anything else refills buffer
+    if (target >= readPos.load() && target <= writePos.load()) {
+        readPos = target;
+        xSemaphoreGive(spaceReady);
+    } else {
+        restart(target);
+    }
+    return true;
+}
+
+bool AudioFileSourceStream::close() {
+    if (taskHandle) {
+        stopping = true;
+        xSemaphoreGive(spaceReady);
+        xSemaphoreTake(taskDone, portMAX_DELAY);
+        // Delete task from this context, so its stack is freed immediately
+        vTaskDelete(taskHandle);
+        taskHandle = nullptr;
+    }
+
+    if (fd >= 0) {
+        ::close(fd);
+        fd = -1;
+    }
+    if (buffer) {
+        heap_caps_free(buffer);
+        buffer = nullptr;
+    }
+    if (mutex) vSemaphoreDelete(mutex);
+    if (dataReady) vSemaphoreDelete(dataReady);
+    if (spaceReady) vSemaphoreDelete(spaceReady);
+    if (taskDone) vSemaphoreDelete(taskDone);
+    mutex = dataReady = spaceReady = taskDone = nullptr;
+
+    fileSize = 0;
+    return true;
+}
+
+bool AudioFileSourceStream::isOpen() {
+    return fd >= 0;
+}
+
+uint32_t AudioFileSourceStream::getSize() {
+    return fileSize;
+}
+
+uint32_t AudioFileSourceStream::getPos() {
+    return readPos.load();
+}
+
+size_t AudioFileSourceStream::getBufferLevel() const {
+    return writePos.load() - readPos.load();
+}
+
+size_t AudioFileSourceStream::getBufferSize() const {
+    return bufferSize;
+}
+
+uint32_t AudioFileSourceStream::getUnderruns() const {
+    return underruns.load();
+}
+
+} // namespace lilka
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <atomic>
+#include <AudioFileSource.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+
+namespace lilka {
+
+// Скільки секунд аудіо тримати в буфері
+#ifndef KSOUND_STREAM_SECONDS
+#    define KSOUND_STREAM_SECONDS 2
+#endif
+
+// Розмір одного читання з файлу. Читання вирівняні по ньому, що для SD-карти набагато швидше дрібних
+#ifndef KSOUND_STREAM_CHUNK_SIZE
+#    define KSOUND_STREAM_CHUNK_SIZE 16384
+#endif
+
+/// Джерело аудіо, яке читає файл під час відтворення.
+///
+/// Фонова задача заздалегідь читає файл великими шматками в кільцевий буфер у PSRAM,
+/// тож декодер не чекає на SD-карту, а файл не потрібно завантажувати в пам'ять повністю.
+///
+/// Буфер має одного читача (декодер) та одного писача (фонова задача), тож читання з нього не блокується
+/// мютексом. Перемотування в межах вже прочитаних даних миттєве, інакше буфер перезаповнюється з нової позиції.
+class AudioFileSourceStream : public AudioFileSource {
+public:
+    /// @param bufferSize Розмір кільцевого буфера, округлюється до KSOUND_STREAM_CHUNK_SIZE.
+    explicit AudioFileSourceStream(size_t bufferSize);
+    ~AudioFileSourceStream() override;
+
+    bool open(const char* filename) override;
+    uint32_t read(void* data, uint32_t len) override;
+    uint32_t readNonBlock(void* data, uint32_t len) override;
+    bool seek(int32_t pos, int dir) override;
+    bool close() override;
+    bool isOpen() override;
+    uint32_t getSize() override;
+    uint32_t getPos() override;
+
+    /// Кількість байтів, прочитаних наперед.
+    size_t getBufferLevel() const;
+    /// Розмір кільцевого буфера.
+    size_t getBufferSize() const;
+    /// Скільки разів декодеру довелося чекати на дані.
+    uint32_t getUnderruns() const;
+
+    /// Розмір буфера для KSOUND_STREAM_SECONDS секунд аудіо заданого типу ("wav", "mp3", ...).
+    static size_t bufferSizeFor(const char* type);
+
+private:
+    static void readerTaskFunc(void* arg);
+    // Читає наступний шматок файлу в буфер. Повертає false, якщо місця немає або файл скінчився
+    bool fill();
+    // Скидає буфер та починає читати з позиції pos
+    void restart(uint32_t pos);
+    uint32_t copyOut(void* data, uint32_t len);
+
+    int fd = -1;
+    uint8_t* buffer = nullptr;
+    size_t bufferSize;
+    uint32_t fileSize = 0;
+
+    // Абсолютні позиції у файлі. В буфері лежать байти [readPos, writePos)
+    std::atomic<uint32_t> readPos{0};
+    std::atomic<uint32_t> writePos{0};
+    std::atomic<uint32_t> underruns{0};
+    std::atomic<bool> stopping{false};
+    // Буфер скинуто перемотуванням, тож очікування даних не рахується як недозаповнення
+    bool refilling = false;
+
+    TaskHandle_t taskHandle = nullptr;
+    // Захищає fd та позиції під час читання файлу і перемотування
+    SemaphoreHandle_t mutex = nullptr;
+    SemaphoreHandle_t dataReady = nullptr;
+    SemaphoreHandle_t spaceReady = nullptr;
+    SemaphoreHandle_t taskDone = nullptr;
+};
+
+} // namespace lilka
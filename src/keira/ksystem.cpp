@@ -144,6 +144,8 @@ void KeiraSystem::showWelcomeMessage() {
 void KeiraSystem::launchServices() {
     // TODO: implement on/off service via complete destroyment of its resources/threads
     // Prepare Service Manager
+    // Order doesn't matter: service is started by manager once services it
+    // depends on are ready, and lazy ones after launcher shows up
 
 #ifdef KEIRA_WATCHDOG
     services.spawn(new WatchdogService());
@@ -156,7 +158,8 @@ void KeiraSystem::launchServices() {
     services.spawn(new WebService());
     services.spawn(new MDNSService());
 
-    // GUIDELINE: To add a new service register it here
+    // GUIDELINE: To add a new service register it here. Declare its
+    // dependencies and start mode in its constructor
 }
 
 // Verify OTA Update
@@ -207,27 +210,34 @@ void KeiraSystem::showStartupScreen() {
 
 // Prepare system to launch
 void KeiraSystem::setup() {
+    timeline.mark("setup");
+
     // Init Hardware
     lilka::begin();
+    timeline.mark("hardware");
 
     // Display splash [Should be done as fast as possible]
     // Maybe pass a black screen on display init in SDK to avoid noise display
     showStartupScreen();
+    timeline.mark("splash");
 
     // Handle CMD Params
     handleCMDParams();
 
     // Verify OTA Update
     verifyOTA();
+    timeline.mark("ota");
 
     // Register VFS
     registerFileSystems();
+    timeline.mark("filesystems");
 
     // Send greetings to serial
     showWelcomeMessage();
 
     // Time to launch services
     launchServices();
+    timeline.mark("services registered");
 
     // Launch Panel
     auto panel = new StatusBarApp();
@@ -244,6 +254,15 @@ void KeiraSystem::setup() {
 
     threads.start();
 
+    // Services not needed for launcher wait until it's interactive
+    if (apps.waitFirstFrame(pdMS_TO_TICKS(KEIRA_DEFERRED_SERVICES_TIMEOUT))) {
+        timeline.mark("first frame");
+    } else {
+        lilka::serial.err("No frame shown in %d ms, starting deferred services", KEIRA_DEFERRED_SERVICES_TIMEOUT);
+    }
+    services.startDeferred();
+    timeline.log();
+
     vTaskDelete(NULL);
 }
 
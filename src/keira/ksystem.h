@@ -11,6 +11,8 @@
 #include "keira/threadmanager.h"
 #include "keira/servicemanager.h"
 #include "keira/appmanager.h"
+#include "keira/boottimeline.h"
+#include "keira/eventbus.h"
 // Libraries
 #include <lilka.h>
 //#include <vector>
@@ -21,6 +23,12 @@
 
 #define KEIRA_VERSION_TYPE_ACSTR lilka::SDK_VERSION_TYPE_ACSTR
 
+// Lazy services are started once launcher shows first frame, or after this
+// amount of ms if it never does
+#ifndef KEIRA_DEFERRED_SERVICES_TIMEOUT
+#    define KEIRA_DEFERRED_SERVICES_TIMEOUT 5000
+#endif
+
 typedef enum KEIRA_VERSION_TYPE : uint8_t {
     KEIRA_VERSION_TYPE_DEV = 0,
     KEIRA_VERSION_TYPE_PRE_RELEASE = 1,
@@ -58,6 +66,18 @@ public:
     AppManager apps;
     ServiceManager services;
     //////////////////////////////////////////////////////////////////////////
+
+    //========================================================================
+    //  Boot stages timing, see `boot` telnet command
+    //========================================================================
+    BootTimeline timeline;
+    //////////////////////////////////////////////////////////////////////////
+
+    //========================================================================
+    //  System events (network, combos, SD, app switch, clock, services)
+    //========================================================================
+    EventBus events;
+    //////////////////////////////////////////////////////////////////////////
     // Yeah, we've to do that cause it doesn't support multithreading
     // TODO: move the fuck out from insane lib which have a begin/end
     // and have no access protection. I don't get it
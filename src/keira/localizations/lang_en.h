@@ -70,6 +70,8 @@
 #define K_S_LAUNCHER_GPIO_MANAGER      "GPIO-manager"
 #define K_S_LAUNCHER_COMBO             "Combo" // wtf?
 #define K_S_LAUNCHER_CALLBACK_TEST     "CallbackTest"
+#define K_S_LAUNCHER_VFS_BENCH         "/tmp bench"
+#define K_S_LAUNCHER_DRAW_BENCH        "Draw bench"
 #define K_S_LAUNCHER_LILCATALOG        "LilCatalogue"
 #define K_S_LAUNCHER_LILTRACKER        "LilTracker"
 #define K_S_LAUNCHER_LETRIS            "Letris"
@@ -105,6 +107,10 @@
 #define K_S_LAUNCHER_MEM_0             "None"
 #define K_S_LAUNCHER_MEM_1             "Icon"
 #define K_S_LAUNCHER_MEM_2             "Text"
+#define K_S_LAUNCHER_CPU               "CPU"
+#define K_S_LAUNCHER_CPU_0             "None"
+#define K_S_LAUNCHER_CPU_1             "Percent"
+#define K_S_LAUNCHER_CPU_2             "App + percent"
 #define K_S_LAUNCHER_NETWORK           K_S_LAUNCHER_WIFI
 #define K_S_LAUNCHER_NETWORK_0         "None"
 #define K_S_LAUNCHER_NETWORK_1         "Icon"
@@ -169,6 +175,19 @@
 #define K_S_I2C_SCANNER_DEVICES_FOUND "Found %d devices."
 ///////////////////////////////////////////////////////////////////////////////////////////////////////
 
+// apps/tests/vfsbench.cpp ////////////////////////////////////////////////////////////////////////////
+#define K_S_VFS_BENCH_ABOUT         "Measuring open/stat in /tmp..."
+#define K_S_VFS_BENCH_RESULT_FMT    "%u files: open %u/s, stat %u/s\n"
+#define K_S_VFS_BENCH_NO_MEMORY_FMT "%u files: out of memory\n"
+#define K_S_VFS_BENCH_DONE          "Done. A - exit"
+///////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// apps/tests/drawbench.cpp ///////////////////////////////////////////////////////////////////////////
+#define K_S_DRAW_BENCH_ABOUT      "Comparing Lua drawing methods..."
+#define K_S_DRAW_BENCH_RESULT_FMT "%s: %u us/frame\n"
+#define K_S_DRAW_BENCH_DONE       "Done. A - exit"
+///////////////////////////////////////////////////////////////////////////////////////////////////////
+
 // apps/demos/transform.cpp ///////////////////////////////////////////////////////////////////////////
 #define K_S_TRANSFORM_CANT_LOAD_FACE     "Can't load face.bmp from SD card." // FACEPALM.BMP
 #define K_S_TRANFORM_DRAWING_FACE_AT_FMT "Drawing face at %d, %d"
@@ -234,6 +253,10 @@
 #define K_S_LILTRACKER_OPEN                   "Open"
 #define K_S_LILTRACKER_SAVE                   "Save"
 #define K_S_LILTRACKER_RESET                  "Reset"
+#define K_S_LILTRACKER_RENDER_WAV             "Save WAV"
+#define K_S_LILTRACKER_EXPORT_STEMS           "Also save each channel\nto a separate file?\n[START]Yes\n[B]No"
+#define K_S_LILTRACKER_RENDER_DONE_FMT        "Done in %.1f s"
+#define K_S_LILTRACKER_RENDER_FAILED          "Failed to write WAV"
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////
 
@@ -300,8 +323,11 @@
 ///////////////////////////////////////////////////////////////////////////////////////////////////////
 
 // services/screenshot.cpp ////////////////////////////////////////////////////////////////////////////
-#define K_S_SCREENSHOT_SAVED      "Screenshot saved"
-#define K_S_SCREENSHOT_SAVE_ERROR "Screenshot save error"
+#define K_S_SCREENSHOT_SAVED         "Screenshot saved"
+#define K_S_SCREENSHOT_SAVE_ERROR    "Screenshot save error"
+#define K_S_SCREEN_RECORDING_STARTED "Screen recording started"
+#define K_S_SCREEN_RECORDING_SAVED   "Screen recording saved"
+#define K_S_SCREEN_RECORDING_ERROR   "Screen recording error"
 ///////////////////////////////////////////////////////////////////////////////////////////////////////
 
 // services/network.cpp ///////////////////////////////////////////////////////////////////////////////
@@ -69,6 +69,8 @@
 #define K_S_LAUNCHER_GPIO_MANAGER      "GPIO-менеджер"
 #define K_S_LAUNCHER_COMBO             "Combo" // wtf?
 #define K_S_LAUNCHER_CALLBACK_TEST     "CallbackTest"
+#define K_S_LAUNCHER_VFS_BENCH         "Тест /tmp"
+#define K_S_LAUNCHER_DRAW_BENCH        "Тест малювання"
 #define K_S_LAUNCHER_LILCATALOG        "ЛілКаталог"
 #define K_S_LAUNCHER_LILTRACKER        "ЛілТрекер"
 #define K_S_LAUNCHER_LETRIS            "Летріс"
@@ -104,6 +106,10 @@
 #define K_S_LAUNCHER_MEM_0             "Нема"
 #define K_S_LAUNCHER_MEM_1             "Іконка"
 #define K_S_LAUNCHER_MEM_2             "Текст"
+#define K_S_LAUNCHER_CPU               "Процесор"
+#define K_S_LAUNCHER_CPU_0             "Нема"
+#define K_S_LAUNCHER_CPU_1             "Відсоток"
+#define K_S_LAUNCHER_CPU_2             "Програма + відсоток"
 #define K_S_LAUNCHER_NETWORK           K_S_LAUNCHER_WIFI
 #define K_S_LAUNCHER_NETWORK_0         "Нема"
 #define K_S_LAUNCHER_NETWORK_1         "Іконка"
@@ -162,6 +168,19 @@
 #define K_S_I2C_SCANNER_DEVICES_FOUND "Found %d devices."
 ///////////////////////////////////////////////////////////////////////////////////////////////////////
 
+// apps/tests/vfsbench.cpp ////////////////////////////////////////////////////////////////////////////
+#define K_S_VFS_BENCH_ABOUT         "Вимірювання open/stat у /tmp..."
+#define K_S_VFS_BENCH_RESULT_FMT    "%u файлів: open %u/с, stat %u/с\n"
+#define K_S_VFS_BENCH_NO_MEMORY_FMT "%u файлів: не вистачає пам'яті\n"
+#define K_S_VFS_BENCH_DONE          "Готово. A - вихід"
+///////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// apps/tests/drawbench.cpp ///////////////////////////////////////////////////////////////////////////
+#define K_S_DRAW_BENCH_ABOUT      "Порівняння малювання з Lua..."
+#define K_S_DRAW_BENCH_RESULT_FMT "%s: %u мкс/кадр\n"
+#define K_S_DRAW_BENCH_DONE       "Готово. A - вихід"
+///////////////////////////////////////////////////////////////////////////////////////////////////////
+
 // apps/demos/transform.cpp ///////////////////////////////////////////////////////////////////////////
 #define K_S_TRANSFORM_CANT_LOAD_FACE     "Не вдалось завантажити face.bmp з SD-карти." // FACEPALM.BMP
 #define K_S_TRANFORM_DRAWING_FACE_AT_FMT "Drawing face at %d, %d"
@@ -226,6 +245,10 @@
 #define K_S_LILTRACKER_OPEN                   "Відкрити"
 #define K_S_LILTRACKER_SAVE                   "Зберегти"
 #define K_S_LILTRACKER_RESET                  "Скинути"
+#define K_S_LILTRACKER_RENDER_WAV             "Запис WAV"
+#define K_S_LILTRACKER_EXPORT_STEMS           "Також зберегти кожен\nканал в окремий файл?\n[START]Так\n[B]Ні"
+#define K_S_LILTRACKER_RENDER_DONE_FMT        "Готово за %.1f с"
+#define K_S_LILTRACKER_RENDER_FAILED          "Не вдалося записати WAV"
 ///////////////////////////////////////////////////////////////////////////////////////////////////////
 
 // apps/lilcatalog/lilcatalog.cpp /////////////////////////////////////////////////////////////////////
@@ -291,8 +314,11 @@
 ///////////////////////////////////////////////////////////////////////////////////////////////////////
 
 // services/screenshot.cpp ////////////////////////////////////////////////////////////////////////////
-#define K_S_SCREENSHOT_SAVED      "Скріншот збережено"
-#define K_S_SCREENSHOT_SAVE_ERROR "Помилка збереження скріншоту"
+#define K_S_SCREENSHOT_SAVED         "Скріншот збережено"
+#define K_S_SCREENSHOT_SAVE_ERROR    "Помилка збереження скріншоту"
+#define K_S_SCREEN_RECORDING_STARTED "Запис екрана розпочато"
+#define K_S_SCREEN_RECORDING_SAVED   "Запис екрана збережено"
+#define K_S_SCREEN_RECORDING_ERROR   "Помилка запису екрана"
 ///////////////////////////////////////////////////////////////////////////////////////////////////////
 
 // services/network.cpp ///////////////////////////////////////////////////////////////////////////////
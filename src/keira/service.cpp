@@ -1,6 +1,9 @@
 #include "keira/service.h"
 #include "services/watchdog/watchdog.h"
 #include "keira/ksystem.h"
+
+#define SERVICE_READY_BIT BIT0
+
 Service::Service(const char* name) {
     setName(name);
     setktStackSize(4096);
@@ -12,6 +15,7 @@ Service::Service(const char* name) {
     enabled = prefs.getBool("enabled", false);
     prefs.end();
     NVS_UNLOCK;
+    setupOnEntryCallback(KT_CLBK_CAST(&Service::onEntry), KT_CLBK_DATA_CAST(this));
 }
 
 // TODO: to be moved to service manager
@@ -27,4 +31,45 @@ void Service::setEnabled(bool enabled) {
     prefs.end();
     NVS_UNLOCK;
     this->enabled = enabled;
+    ksystem.events.publish(KEVENT_SERVICE_STATE, reinterpret_cast<uint32_t>(this));
+}
+
+const std::vector<const char*>& Service::getDependencies() {
+    return dependencies;
+}
+
+void Service::addDependency(const char* name) {
+    dependencies.push_back(name);
+}
+
+ServiceStartMode Service::getStartMode() {
+    return startMode;
+}
+
+void Service::setStartMode(ServiceStartMode mode) {
+    startMode = mode;
+}
+
+void Service::setManualReady() {
+    manualReady = true;
+}
+
+void Service::onEntry(Service* service) {
+    if (!service->manualReady) service->setReady();
+}
+
+bool Service::isReady() {
+    return xEventGroupGetBits(readyEvent) & SERVICE_READY_BIT;
+}
+
+bool Service::waitReady(TickType_t timeout) {
+    return xEventGroupWaitBits(readyEvent, SERVICE_READY_BIT, pdFALSE, pdTRUE, timeout) & SERVICE_READY_BIT;
+}
+
+void Service::setReady() {
+    if (isReady()) return;
+    xEventGroupSetBits(readyEvent, SERVICE_READY_BIT);
+    ksystem.timeline.mark("%s ready", getName());
+    // Dependents can be started right away
+    ksystem.services.notify();
 }
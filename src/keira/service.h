@@ -6,12 +6,44 @@
 #include "keira/thread.h"
 #include "Preferences.h"
 
+#include <freertos/event_groups.h>
+#include <vector>
+
+typedef enum {
+    // Started during boot, as soon as its dependencies are ready
+    SERVICE_START_EAGER,
+    // Not needed for first frame, started once launcher is shown
+    SERVICE_START_LAZY,
+} ServiceStartMode;
+
 class Service : public KeiraThread {
 public:
     Service(const char* name);
     bool getEnabled();
     void setEnabled(bool enabled);
 
+    // Names of services which should be ready before this one is started
+    const std::vector<const char*>& getDependencies();
+    ServiceStartMode getStartMode();
+    bool isReady();
+    // Blocks until service becomes ready. Returns false on timeout
+    bool waitReady(TickType_t timeout = portMAX_DELAY);
+
+protected:
+    // To be called from derived constructors
+    void addDependency(const char* name);
+    void setStartMode(ServiceStartMode mode);
+    // Service signals readiness itself with setReady() instead of being
+    // ready as soon as its thread starts
+    void setManualReady();
+    void setReady();
+
 private:
+    static void onEntry(Service* service);
+
     bool enabled = false;
+    std::vector<const char*> dependencies;
+    ServiceStartMode startMode = SERVICE_START_EAGER;
+    bool manualReady = false;
+    EventGroupHandle_t readyEvent = xEventGroupCreate();
 };
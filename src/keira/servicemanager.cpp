@@ -1 +1,96 @@
 #include "keira/servicemanager.h"
+#include "keira/service.h"
+#include "keira/ksystem.h"
+
+void ServiceManager::spawn(KeiraThread* thread, bool autoSuspend) {
+    if (thread->getktType() != KT_SERVICE) {
+        ThreadManager::spawn(thread, autoSuspend);
+        return;
+    }
+
+    KMTX_LOCK(lock);
+
+    threads.push_back(thread);
+    pending.push_back(static_cast<Service*>(thread));
+
+    KMTX_UNLOCK(lock);
+
+    K_TMG_DBG lilka::serial.log("Registered service %s", thread->getName());
+
+    notify();
+}
+
+void ServiceManager::startDeferred() {
+    KMTX_LOCK(lock);
+
+    deferredStarted = true;
+
+    KMTX_UNLOCK(lock);
+
+    notify();
+}
+
+void ServiceManager::notify() {
+    TaskHandle_t handle = getktTaskHandle();
+    if (handle) xTaskNotifyGive(handle);
+}
+
+bool ServiceManager::dependenciesReady(Service* service) {
+    for (auto name : service->getDependencies()) {
+        KeiraThread* dependency = NULL;
+        for (auto& thread : threads) {
+            if (strcmp(thread->getName(), name) == 0) {
+                dependency = thread;
+                break;
+            }
+        }
+        if (dependency == NULL) {
+            // Better to start service than to keep it waiting forever
+            lilka::serial.err("Service %s depends on unknown service %s", service->getName(), name);
+            continue;
+        }
+        if (dependency->getktType() == KT_SERVICE && !static_cast<Service*>(dependency)->isReady()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void ServiceManager::threadsRun() {
+    // Plain threads are launched as usual
+    ThreadManager::threadsRun();
+
+    std::vector<Service*> toStart;
+
+    KMTX_LOCK(lock);
+
+    for (auto service = pending.begin(); service < pending.end();) {
+        bool deferred = (*service)->getStartMode() == SERVICE_START_LAZY && !deferredStarted;
+        if (deferred || !dependenciesReady(*service)) {
+            service++;
+            continue;
+        }
+        toStart.push_back(*service);
+        service = pending.erase(service);
+    }
+
+    KMTX_UNLOCK(lock);
+
+    // Started without lock held, services may look each other up on start.
+    // Their threads aren't pinned, so independent ones run on both cores at once
+    for (auto service : toStart) {
+        ksystem.timeline.mark("%s starting", service->getName());
+        service->start();
+    }
+}
+
+void ServiceManager::run() {
+    while (true) {
+        // Terminate exiting
+        threadsClean();
+        // Launch new and those which dependencies became ready
+        threadsRun();
+        // Woken up early by notify(), so dependents don't wait for next update
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(KEIRA_THREADMANAGER_UPDATE_DELAY));
+    }
+}
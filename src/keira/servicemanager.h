@@ -5,6 +5,13 @@
 
 #define REG_SERVICE(NAME, CLASS, ENABLED)
 
+class Service;
+
+//////////////////////////////////////////////////////////////////////////////
+// Services are registered right away, so they can be looked up by name
+// before they run, but each one is started only once services it depends
+// on are ready. Lazy services wait for startDeferred() as well.
+//////////////////////////////////////////////////////////////////////////////
 class ServiceManager : public ThreadManager {
 public:
     bool getEnabled(const char* name);
@@ -12,5 +19,20 @@ public:
     void registerService(const char* name, KeiraCallback serviceFunc, bool enabled);
     //    void update()override;
 
+    // Registers service to be started once its dependencies are ready
+    void spawn(KeiraThread* thread, bool autoSuspend = false) override;
+    // Allows lazy services to start
+    void startDeferred();
+    // Wakes manager up to check pending services, e.g. when one becomes ready
+    void notify();
+
+    void run() override;
+
 private:
+    void threadsRun() override;
+    // Threads list to be locked by caller
+    bool dependenciesReady(Service* service);
+
+    std::vector<Service*> pending;
+    bool deferredStarted = false;
 };
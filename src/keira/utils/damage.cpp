@@ -0,0 +1,144 @@
+#include "damage.h"
+#include <string.h>
+
+static inline uint32_t rectArea(const DamageRect& r) {
+    return (uint32_t)r.w * r.h;
+}
+
+static inline DamageRect rectUnion(const DamageRect& a, const DamageRect& b) {
+    uint16_t x0 = a.x < b.x ? a.x : b.x;
+    uint16_t y0 = a.y < b.y ? a.y : b.y;
+    uint32_t x1 = (a.x + a.w) > (b.x + b.w) ? (a.x + a.w) : (b.x + b.w);
+    uint32_t y1 = (a.y + a.h) > (b.y + b.h) ? (a.y + a.h) : (b.y + b.h);
+    return {x0, y0, (uint16_t)(x1 - x0), (uint16_t)(y1 - y0)};
+}
+
+// Rects are worth merging if union doesn't cover more pixels than both of them
+// separately, i.e. they're contained, aligned neighbours or heavily overlapped
+static inline bool rectMergeable(const DamageRect& a, const DamageRect& b) {
+    return rectArea(rectUnion(a, b)) <= rectArea(a) + rectArea(b);
+}
+
+void DamageRegion::clear() {
+    rectCount = 0;
+}
+
+void DamageRegion::invalidate(uint16_t w, uint16_t h) {
+    rectCount = 0;
+    add(0, 0, w, h);
+}
+
+void DamageRegion::add(uint16_t x, uint16_t y, uint16_t w, uint16_t h) {
+    if (!w || !h) return;
+    addRect({x, y, w, h});
+}
+
+void DamageRegion::add(const DamageRegion& other) {
+    for (uint8_t i = 0; i < other.rectCount; i++)
+        addRect(other.rects[i]);
+}
+
+void DamageRegion::addRect(DamageRect rect) {
+    // Absorb every rect we can merge with. Merged rect grows, so restart scan
+    bool merged = true;
+    while (merged) {
+        merged = false;
+        for (uint8_t i = 0; i < rectCount; i++) {
+            if (rectMergeable(rects[i], rect)) {
+                rect = rectUnion(rects[i], rect);
+                remove(i);
+                merged = true;
+                break;
+            }
+        }
+    }
+
+    if (rectCount < KEIRA_DAMAGE_MAX_RECTS) {
+        rects[rectCount++] = rect;
+        return;
+    }
+
+    // No space left. Merge with rect giving the smallest area growth
+    uint8_t best = 0;
+    uint32_t bestGrowth = UINT32_MAX;
+    for (uint8_t i = 0; i < rectCount; i++) {
+        uint32_t growth = rectArea(rectUnion(rects[i], rect)) - rectArea(rects[i]);
+        if (growth < bestGrowth) {
+            bestGrowth = growth;
+            best = i;
+        }
+    }
+    rect = rectUnion(rects[best], rect);
+    remove(best);
+    addRect(rect);
+}
+
+void DamageRegion::remove(uint8_t index) {
+    rects[index] = rects[--rectCount];
+}
+
+void DamageRegion::addDiff(const uint16_t* a, const uint16_t* b, uint16_t w, uint16_t h) {
+    // Rows with changes are collected in vertical bands, each band is a
+    // bounding box of changed spans in consecutive rows
+    bool bandOpen = false;
+    DamageRect band = {0, 0, 0, 0};
+
+    for (uint16_t y = 0; y < h; y++) {
+        const uint16_t* rowA = a + (uint32_t)y * w;
+        const uint16_t* rowB = b + (uint32_t)y * w;
+
+        if (memcmp(rowA, rowB, w * sizeof(uint16_t)) == 0) {
+            if (bandOpen) {
+                addRect(band);
+                bandOpen = false;
+            }
+            continue;
+        }
+
+        // Row differs, find changed span from both ends
+        uint16_t left = 0;
+        while (rowA[left] == rowB[left])
+            left++;
+        uint16_t right = w - 1;
+        while (rowA[right] == rowB[right])
+            right--;
+
+        DamageRect span = {left, y, (uint16_t)(right - left + 1), 1};
+
+        // Keep band only while spans overlap horizontally, otherwise a
+        // diagonal change would turn into a huge bounding box
+        if (bandOpen && (span.x >= band.x + band.w || span.x + span.w <= band.x)) {
+            addRect(band);
+            bandOpen = false;
+        }
+
+        if (!bandOpen) {
+            band = span;
+            bandOpen = true;
+            continue;
+        }
+
+        band = rectUnion(band, span);
+    }
+
+    if (bandOpen) addRect(band);
+}
+
+bool DamageRegion::isEmpty() const {
+    return rectCount == 0;
+}
+
+uint32_t DamageRegion::area() const {
+    uint32_t total = 0;
+    for (uint8_t i = 0; i < rectCount; i++)
+        total += rectArea(rects[i]);
+    return total;
+}
+
+uint8_t DamageRegion::count() const {
+    return rectCount;
+}
+
+const DamageRect& DamageRegion::operator[](uint8_t index) const {
+    return rects[index];
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include <stdint.h>
+// Damage Region:  ////////////////////////////////////////////////////////////////////////////////////
+// Small list of merged rectangles describing canvas area changed since last
+// display flush. Used by App/AppManager to push only changed spans over SPI
+
+// Max amount of rects kept in region. On overflow closest rects get merged
+#ifndef KEIRA_DAMAGE_MAX_RECTS
+#    define KEIRA_DAMAGE_MAX_RECTS 8
+#endif
+
+typedef struct {
+    uint16_t x;
+    uint16_t y;
+    uint16_t w;
+    uint16_t h;
+} DamageRect;
+
+class DamageRegion {
+public:
+    // Forget all damage
+    void clear();
+    // Mark whole w x h area as damaged
+    void invalidate(uint16_t w, uint16_t h);
+    // Add rect to region, merging it with overlapping/touching ones
+    void add(uint16_t x, uint16_t y, uint16_t w, uint16_t h);
+    // Add all rects of other region
+    void add(const DamageRegion& other);
+    // Add spans of pixels which differ between two framebuffers of the same
+    // w x h size
+    void addDiff(const uint16_t* a, const uint16_t* b, uint16_t w, uint16_t h);
+
+    bool isEmpty() const;
+    // Summary area of all rects in pixels
+    uint32_t area() const;
+    uint8_t count() const;
+    const DamageRect& operator[](uint8_t index) const;
+
+private:
+    void addRect(DamageRect rect);
+    void remove(uint8_t index);
+    DamageRect rects[KEIRA_DAMAGE_MAX_RECTS];
+    uint8_t rectCount = 0;
+};
+// GUIDELINE: Region doesn't know canvas bounds, clip rects on use
+///////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,148 @@
+#include "drawlist.h"
+#include <algorithm>
+#include "keira/utils/mem.h"
+
+const uint8_t DrawList::recordSize[DRAW_CMD_COUNT] = {
+    5, // DRAW_CMD_FILL_RECT
+    4, // DRAW_CMD_FILL_CIRCLE
+    3, // DRAW_CMD_IMAGE
+    5, // DRAW_CMD_RECT
+    4, // DRAW_CMD_CIRCLE
+    5, // DRAW_CMD_LINE
+    3, // DRAW_CMD_PIXEL
+};
+
+// Bounding box of a command doesn't touch canvas
+static inline bool outside(int32_t x0, int32_t y0, int32_t x1, int32_t y1, int16_t w, int16_t h) {
+    return x1 < 0 || y1 < 0 || x0 >= w || y0 >= h;
+}
+
+DrawList::DrawList() : commands(NULL), count(0), capacity(0), typeCount(), images(), imageCount(0) {
+}
+
+DrawList::~DrawList() {
+    spiRamAllocator.deallocate(commands);
+}
+
+bool DrawList::reserve(uint32_t more) {
+    if (count + more <= capacity) return true;
+    uint32_t newCapacity = std::max(capacity * 2, count + more);
+    DrawCommand* newCommands =
+        static_cast<DrawCommand*>(spiRamAllocator.reallocate(commands, newCapacity * sizeof(DrawCommand)));
+    if (!newCommands) return false;
+    commands = newCommands;
+    capacity = newCapacity;
+    return true;
+}
+
+bool DrawList::push(DrawCommandType type, const int32_t* values) {
+    if (type >= DRAW_CMD_COUNT) return false;
+    if (type == DRAW_CMD_IMAGE && (values[0] < 0 || values[0] >= imageCount)) return false;
+    if (!reserve(1)) return false;
+
+    // Color (or image id) is the last value, except for images where it's the first one
+    DrawCommand& cmd = commands[count++];
+    cmd.type = type;
+    uint8_t n = recordSize[type];
+    if (type == DRAW_CMD_IMAGE) {
+        cmd.color = values[0];
+        values++;
+    } else {
+        cmd.color = values[n - 1];
+    }
+    for (uint8_t i = 0; i < n - 1; i++) {
+        cmd.args[i] = values[i];
+    }
+    typeCount[type]++;
+    return true;
+}
+
+int DrawList::addImage(lilka::Image* image) {
+    for (uint8_t i = 0; i < imageCount; i++) {
+        if (images[i] == image) return i;
+    }
+    if (imageCount == DRAW_LIST_MAX_IMAGES) return -1;
+    images[imageCount] = image;
+    return imageCount++;
+}
+
+void DrawList::clear() {
+    count = 0;
+    memset(typeCount, 0, sizeof(typeCount));
+}
+
+uint32_t DrawList::size() const {
+    return count;
+}
+
+void DrawList::draw(lilka::Canvas* canvas) const {
+    // Clip bounds are taken once per list. Framebuffer is written directly
+    // only when canvas isn't rotated, as its memory layout matches then
+    const int16_t w = canvas->width();
+    const int16_t h = canvas->height();
+    uint16_t* fb = canvas->getRotation() == 0 ? canvas->getFramebuffer() : NULL;
+
+    for (uint8_t type = 0; type < DRAW_CMD_COUNT; type++) {
+        if (!typeCount[type]) continue;
+        for (uint32_t i = 0; i < count; i++) {
+            const DrawCommand& cmd = commands[i];
+            if (cmd.type != type) continue;
+            const int16_t* a = cmd.args;
+            switch (type) {
+                case DRAW_CMD_PIXEL:
+                    if (static_cast<uint16_t>(a[0]) < w && static_cast<uint16_t>(a[1]) < h) {
+                        if (fb) {
+                            fb[a[1] * w + a[0]] = cmd.color;
+                        } else {
+                            canvas->drawPixel(a[0], a[1], cmd.color);
+                        }
+                    }
+                    break;
+                case DRAW_CMD_FILL_RECT: {
+                    int32_t x0 = a[0], y0 = a[1], x1 = a[0] + a[2], y1 = a[1] + a[3];
+                    if (x1 < x0) std::swap(x0, x1);
+                    if (y1 < y0) std::swap(y0, y1);
+                    x0 = std::max<int32_t>(x0, 0);
+                    y0 = std::max<int32_t>(y0, 0);
+                    x1 = std::min<int32_t>(x1, w);
+                    y1 = std::min<int32_t>(y1, h);
+                    if (x0 >= x1 || y0 >= y1) break;
+                    if (fb) {
+                        for (int32_t y = y0; y < y1; y++) {
+                            std::fill(fb + y * w + x0, fb + y * w + x1, cmd.color);
+                        }
+                    } else {
+                        canvas->fillRect(x0, y0, x1 - x0, y1 - y0, cmd.color);
+                    }
+                    break;
+                }
+                case DRAW_CMD_RECT: {
+                    int32_t x0 = a[0], y0 = a[1], x1 = a[0] + a[2], y1 = a[1] + a[3];
+                    if (outside(std::min(x0, x1), std::min(y0, y1), std::max(x0, x1), std::max(y0, y1), w, h)) break;
+                    canvas->drawRect(a[0], a[1], a[2], a[3], cmd.color);
+                    break;
+                }
+                case DRAW_CMD_FILL_CIRCLE:
+                case DRAW_CMD_CIRCLE:
+                    if (outside(a[0] - a[2], a[1] - a[2], a[0] + a[2], a[1] + a[2], w, h)) break;
+                    if (type == DRAW_CMD_FILL_CIRCLE) {
+                        canvas->fillCircle(a[0], a[1], a[2], cmd.color);
+                    } else {
+                        canvas->drawCircle(a[0], a[1], a[2], cmd.color);
+                    }
+                    break;
+                case DRAW_CMD_LINE:
+                    if (outside(
+                            std::min(a[0], a[2]), std::min(a[1], a[3]), std::max(a[0], a[2]), std::max(a[1], a[3]), w, h
+                        ))
+                        break;
+                    canvas->drawLine(a[0], a[1], a[2], a[3], cmd.color);
+                    break;
+                case DRAW_CMD_IMAGE:
+                    // Image pivot is applied by canvas, so clipping is left to it
+                    canvas->drawImage(images[cmd.color], a[0], a[1]);
+                    break;
+            }
+        }
+    }
+}
@@ -0,0 +1,75 @@
+#pragma once
+//////////////////////////////////////////////////////////////////////////////
+//
+//  Keira OS Header file
+//
+//////////////////////////////////////////////////////////////////////////////
+// Batched drawing for script bindings
+//////////////////////////////////////////////////////////////////////////////
+// Scripts append compact command records to a list and draw it with a
+// single call, instead of crossing interpreter/C boundary per primitive.
+// Commands are drawn grouped by type, in order of DrawCommandType, keeping
+// their relative order inside a group. Use separate lists if primitives of
+// different types must be layered in some other order.
+//////////////////////////////////////////////////////////////////////////////
+#include <lilka.h>
+
+typedef enum {
+    DRAW_CMD_FILL_RECT,
+    DRAW_CMD_FILL_CIRCLE,
+    DRAW_CMD_IMAGE,
+    DRAW_CMD_RECT,
+    DRAW_CMD_CIRCLE,
+    DRAW_CMD_LINE,
+    DRAW_CMD_PIXEL,
+    DRAW_CMD_COUNT
+} DrawCommandType;
+
+// Record values for each command type, in order (type itself not included):
+//   FILL_RECT, RECT   x, y, w, h, color
+//   FILL_CIRCLE, CIRCLE  x, y, r, color
+//   IMAGE             image id (see DrawList::addImage), x, y
+//   LINE              x0, y0, x1, y1, color
+//   PIXEL             x, y, color
+#define DRAW_LIST_MAX_RECORD_SIZE 5
+
+// Max amount of distinct images referenced by one list
+#ifndef DRAW_LIST_MAX_IMAGES
+#    define DRAW_LIST_MAX_IMAGES 32
+#endif
+
+typedef struct {
+    uint8_t type;
+    // Image id for DRAW_CMD_IMAGE
+    uint16_t color;
+    int16_t args[4];
+} DrawCommand;
+
+class DrawList {
+public:
+    static const uint8_t recordSize[DRAW_CMD_COUNT];
+
+    DrawList();
+    ~DrawList();
+
+    // Appends command from recordSize[type] values.
+    // Returns false on unknown image id or if out of memory
+    bool push(DrawCommandType type, const int32_t* values);
+    // Makes room for @count more commands
+    bool reserve(uint32_t count);
+    // Returns id of image for DRAW_CMD_IMAGE records, or -1 if list already
+    // references DRAW_LIST_MAX_IMAGES images. Images are kept on clear()
+    int addImage(lilka::Image* image);
+    void clear();
+    uint32_t size() const;
+
+    void draw(lilka::Canvas* canvas) const;
+
+private:
+    DrawCommand* commands;
+    uint32_t count;
+    uint32_t capacity;
+    uint32_t typeCount[DRAW_CMD_COUNT];
+    lilka::Image* images[DRAW_LIST_MAX_IMAGES];
+    uint8_t imageCount;
+};
@@ -0,0 +1,324 @@
+#include "tilemap.h"
+#include <algorithm>
+#include "keira/utils/mem.h"
+
+// Division and modulo rounding towards negative infinity, for scroll positions left/above of map
+static inline int32_t floorDiv(int32_t a, int32_t b) {
+    return a >= 0 ? a / b : -((-a + b - 1) / b);
+}
+
+static inline int32_t floorMod(int32_t a, int32_t b) {
+    int32_t m = a % b;
+    return m < 0 ? m + b : m;
+}
+
+TileMap::TileMap(lilka::Image* tileset, uint16_t tileWidth, uint16_t tileHeight, uint16_t cols, uint16_t rows) :
+    tileset(tileset),
+    tileWidth(tileWidth),
+    tileHeight(tileHeight),
+    tilesetCols(0),
+    tileCount(0),
+    opaque(NULL),
+    cols(cols),
+    rows(rows),
+    cells(NULL),
+    wideCells(false),
+    dirty(NULL),
+    background(lilka::colors::Black),
+    viewX(0),
+    viewY(0),
+    viewW(0),
+    viewH(0),
+    scrollX(0),
+    scrollY(0),
+    buffer(NULL),
+    bufferW(0),
+    bufferH(0),
+    bufferCols(0),
+    bufferRows(0),
+    renderedCol(0),
+    renderedRow(0),
+    rendered(false) {
+    if (tileWidth && tileHeight) {
+        tilesetCols = tileset->width / tileWidth;
+        // Last index is reserved, as cells store tile index + 1
+        tileCount = std::min<uint32_t>(tilesetCols * (tileset->height / tileHeight), UINT16_MAX - 1);
+    }
+    wideCells = tileCount > UINT8_MAX - 1;
+
+    uint32_t cellCount = cols * rows;
+    size_t cellsSize = cellCount * (wideCells ? sizeof(uint16_t) : sizeof(uint8_t));
+    size_t dirtySize = (cellCount + 7) / 8;
+    cells = spiRamAllocator.allocate(cellsSize);
+    dirty = static_cast<uint8_t*>(spiRamAllocator.allocate(dirtySize));
+    opaque = static_cast<uint8_t*>(spiRamAllocator.allocate(tileCount));
+    if (!isValid()) return;
+    memset(cells, 0, cellsSize);
+    memset(dirty, 0, dirtySize);
+
+    // Check tiles for transparent pixels once, instead of on every draw
+    for (uint16_t tile = 0; tile < tileCount; tile++) {
+        opaque[tile] = 1;
+        if (tileset->transparentColor < 0) continue;
+        const uint16_t* src = tileset->pixels + (tile / tilesetCols) * tileHeight * tileset->width +
+                              (tile % tilesetCols) * tileWidth;
+        for (uint16_t y = 0; y < tileHeight && opaque[tile]; y++, src += tileset->width) {
+            for (uint16_t x = 0; x < tileWidth; x++) {
+                if (src[x] == tileset->transparentColor) {
+                    opaque[tile] = 0;
+                    break;
+                }
+            }
+        }
+    }
+}
+
+TileMap::~TileMap() {
+    spiRamAllocator.deallocate(cells);
+    spiRamAllocator.deallocate(dirty);
+    spiRamAllocator.deallocate(opaque);
+    spiRamAllocator.deallocate(buffer);
+}
+
+bool TileMap::isValid() const {
+    return cells && dirty && (opaque || !tileCount);
+}
+
+uint16_t TileMap::getCols() const {
+    return cols;
+}
+
+uint16_t TileMap::getRows() const {
+    return rows;
+}
+
+uint16_t TileMap::getTileCount() const {
+    return tileCount;
+}
+
+bool TileMap::isDirty(uint32_t cell) const {
+    return dirty[cell >> 3] & (1 << (cell & 7));
+}
+
+void TileMap::setDirty(uint32_t cell, bool value) {
+    if (value) {
+        dirty[cell >> 3] |= 1 << (cell & 7);
+    } else {
+        dirty[cell >> 3] &= ~(1 << (cell & 7));
+    }
+}
+
+bool TileMap::setTile(uint16_t col, uint16_t row, int32_t tile) {
+    if (col >= cols || row >= rows || tile < TILE_MAP_EMPTY || tile >= tileCount) return false;
+    uint32_t cell = row * cols + col;
+    uint16_t value = tile + 1;
+    if (wideCells) {
+        if (static_cast<uint16_t*>(cells)[cell] == value) return true;
+        static_cast<uint16_t*>(cells)[cell] = value;
+    } else {
+        if (static_cast<uint8_t*>(cells)[cell] == value) return true;
+        static_cast<uint8_t*>(cells)[cell] = value;
+    }
+    setDirty(cell, true);
+    return true;
+}
+
+int32_t TileMap::getTile(uint16_t col, uint16_t row) const {
+    if (col >= cols || row >= rows) return TILE_MAP_EMPTY;
+    uint32_t cell = row * cols + col;
+    return (wideCells ? static_cast<uint16_t*>(cells)[cell] : static_cast<uint8_t*>(cells)[cell]) - 1;
+}
+
+void TileMap::invalidateTile(uint16_t col, uint16_t row) {
+    if (col < cols && row < rows) setDirty(row * cols + col, true);
+}
+
+void TileMap::invalidate() {
+    rendered = false;
+}
+
+void TileMap::setBackground(uint16_t color) {
+    if (color == background) return;
+    background = color;
+    rendered = false;
+}
+
+void TileMap::setViewport(int16_t x, int16_t y, uint16_t w, uint16_t h) {
+    viewX = x;
+    viewY = y;
+    viewW = w;
+    viewH = h;
+}
+
+void TileMap::setScroll(int32_t x, int32_t y) {
+    scrollX = x;
+    scrollY = y;
+}
+
+int TileMap::addSprite(lilka::Image* image, int32_t x, int32_t y) {
+    uint16_t id = 0;
+    while (id < sprites.size() && sprites[id].image) {
+        id++;
+    }
+    if (id == sprites.size()) {
+        sprites.push_back({});
+    }
+    sprites[id] = {image, x, y, true};
+    order.push_back(id);
+    return id;
+}
+
+bool TileMap::moveSprite(int id, int32_t x, int32_t y) {
+    if (id < 0 || id >= static_cast<int>(sprites.size()) || !sprites[id].image) return false;
+    sprites[id].x = x;
+    sprites[id].y = y;
+    return true;
+}
+
+bool TileMap::setSpriteImage(int id, lilka::Image* image) {
+    if (id < 0 || id >= static_cast<int>(sprites.size()) || !sprites[id].image || !image) return false;
+    sprites[id].image = image;
+    return true;
+}
+
+bool TileMap::setSpriteVisible(int id, bool visible) {
+    if (id < 0 || id >= static_cast<int>(sprites.size()) || !sprites[id].image) return false;
+    sprites[id].visible = visible;
+    return true;
+}
+
+bool TileMap::removeSprite(int id) {
+    if (id < 0 || id >= static_cast<int>(sprites.size()) || !sprites[id].image) return false;
+    sprites[id].image = NULL;
+    order.erase(std::find(order.begin(), order.end(), id));
+    return true;
+}
+
+bool TileMap::allocateBuffer(uint16_t w, uint16_t h) {
+    // One extra tile in each direction covers viewport at any sub-tile scroll offset
+    uint16_t newCols = (w + tileWidth - 1) / tileWidth + 1;
+    uint16_t newRows = (h + tileHeight - 1) / tileHeight + 1;
+    if (buffer && newCols == bufferCols && newRows == bufferRows) return true;
+
+    spiRamAllocator.deallocate(buffer);
+    bufferCols = newCols;
+    bufferRows = newRows;
+    bufferW = bufferCols * tileWidth;
+    bufferH = bufferRows * tileHeight;
+    buffer = static_cast<uint16_t*>(spiRamAllocator.allocate(bufferW * bufferH * sizeof(uint16_t)));
+    rendered = false;
+    return buffer != NULL;
+}
+
+void TileMap::renderTile(int32_t col, int32_t row) {
+    // Buffer size is a multiple of tile size, so tiles never wrap around its edge
+    uint16_t* dst = buffer + floorMod(row * tileHeight, bufferH) * bufferW + floorMod(col * tileWidth, bufferW);
+    int32_t tile = col >= 0 && row >= 0 && col < cols && row < rows ? getTile(col, row) : TILE_MAP_EMPTY;
+
+    if (tile == TILE_MAP_EMPTY) {
+        for (uint16_t y = 0; y < tileHeight; y++, dst += bufferW) {
+            std::fill(dst, dst + tileWidth, background);
+        }
+        return;
+    }
+
+    const uint16_t* src =
+        tileset->pixels + (tile / tilesetCols) * tileHeight * tileset->width + (tile % tilesetCols) * tileWidth;
+    if (opaque[tile]) {
+        for (uint16_t y = 0; y < tileHeight; y++, dst += bufferW, src += tileset->width) {
+            memcpy(dst, src, tileWidth * sizeof(uint16_t));
+        }
+    } else {
+        uint16_t transparent = tileset->transparentColor;
+        for (uint16_t y = 0; y < tileHeight; y++, dst += bufferW, src += tileset->width) {
+            for (uint16_t x = 0; x < tileWidth; x++) {
+                dst[x] = src[x] == transparent ? background : src[x];
+            }
+        }
+    }
+}
+
+void TileMap::blit(lilka::Canvas* canvas) {
+    // Viewport clipped to canvas
+    int32_t x0 = std::max<int32_t>(viewX, 0);
+    int32_t y0 = std::max<int32_t>(viewY, 0);
+    int32_t x1 = std::min<int32_t>(viewX + viewW, canvas->width());
+    int32_t y1 = std::min<int32_t>(viewY + viewH, canvas->height());
+    if (x0 >= x1 || y0 >= y1) return;
+
+    // Each row is copied in at most two parts, split where buffer wraps around
+    uint16_t* fb = canvas->getRotation() == 0 ? canvas->getFramebuffer() : NULL;
+    int32_t n = x1 - x0;
+    int32_t srcX = floorMod(scrollX + x0 - viewX, bufferW);
+    int32_t first = std::min<int32_t>(n, bufferW - srcX);
+    for (int32_t y = y0; y < y1; y++) {
+        const uint16_t* src = buffer + floorMod(scrollY + y - viewY, bufferH) * bufferW;
+        if (fb) {
+            uint16_t* dst = fb + y * canvas->width() + x0;
+            memcpy(dst, src + srcX, first * sizeof(uint16_t));
+            memcpy(dst + first, src, (n - first) * sizeof(uint16_t));
+        } else {
+            canvas->draw16bitRGBBitmap(x0, y, const_cast<uint16_t*>(src + srcX), first, 1);
+            if (n > first) {
+                canvas->draw16bitRGBBitmap(x0 + first, y, const_cast<uint16_t*>(src), n - first, 1);
+            }
+        }
+    }
+}
+
+void TileMap::drawSprites(lilka::Canvas* canvas) {
+    // Order is mostly sorted from previous frame, so insertion sort is close to linear.
+    // It's also stable, so sprites with the same y keep the order they were added in
+    for (size_t i = 1; i < order.size(); i++) {
+        uint16_t id = order[i];
+        size_t j = i;
+        while (j > 0 && sprites[order[j - 1]].y > sprites[id].y) {
+            order[j] = order[j - 1];
+            j--;
+        }
+        order[j] = id;
+    }
+
+    for (uint16_t id : order) {
+        const TileMapSprite& sprite = sprites[id];
+        if (!sprite.visible) continue;
+        // Skip sprites that are entirely outside viewport
+        int32_t x = viewX + sprite.x - scrollX;
+        int32_t y = viewY + sprite.y - scrollY;
+        int32_t left = x - sprite.image->pivotX;
+        int32_t top = y - sprite.image->pivotY;
+        if (left + sprite.image->width <= viewX || top + sprite.image->height <= viewY || left >= viewX + viewW ||
+            top >= viewY + viewH)
+            continue;
+        canvas->drawImage(sprite.image, x, y);
+    }
+}
+
+bool TileMap::draw(lilka::Canvas* canvas) {
+    if (!viewW || !viewH) {
+        setViewport(0, 0, canvas->width(), canvas->height());
+    }
+    if (!tileWidth || !tileHeight || !allocateBuffer(viewW, viewH)) return false;
+
+    // Render tiles that weren't in buffer on previous draw, and the ones that were changed
+    int32_t col0 = floorDiv(scrollX, tileWidth);
+    int32_t row0 = floorDiv(scrollY, tileHeight);
+    for (int32_t row = row0; row < row0 + bufferRows; row++) {
+        bool rowRendered = rendered && row >= renderedRow && row < renderedRow + bufferRows;
+        for (int32_t col = col0; col < col0 + bufferCols; col++) {
+            bool inMap = col >= 0 && row >= 0 && col < cols && row < rows;
+            uint32_t cell = inMap ? row * cols + col : 0;
+            if (rowRendered && col >= renderedCol && col < renderedCol + bufferCols && !(inMap && isDirty(cell)))
+                continue;
+            renderTile(col, row);
+            if (inMap) setDirty(cell, false);
+        }
+    }
+    renderedCol = col0;
+    renderedRow = row0;
+    rendered = true;
+
+    blit(canvas);
+    drawSprites(canvas);
+    return true;
+}
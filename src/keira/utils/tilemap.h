@@ -0,0 +1,113 @@
+#pragma once
+//////////////////////////////////////////////////////////////////////////////
+//
+//  Keira OS Header file
+//
+//////////////////////////////////////////////////////////////////////////////
+// Tile map with sprite layer for script bindings
+//////////////////////////////////////////////////////////////////////////////
+// Map is a grid of tile indices into a tileset atlas (an image with tiles
+// laid out left to right, top to bottom). Rendered tiles are kept in a
+// wrap-around buffer slightly larger than the viewport, so scrolling only
+// renders newly exposed rows and columns, and changing a tile only renders
+// that tile. Sprites are drawn over the map, sorted by y, so sprites lower
+// on screen overlap the ones above them. Sprites are clipped by canvas, not
+// by viewport.
+//////////////////////////////////////////////////////////////////////////////
+#include <lilka.h>
+#include <vector>
+
+// Tile index of a cell with no tile, background color is shown there
+#define TILE_MAP_EMPTY -1
+
+typedef struct {
+    // NULL for removed sprites, their slots are reused
+    lilka::Image* image;
+    int32_t x;
+    int32_t y;
+    bool visible;
+} TileMapSprite;
+
+class TileMap {
+public:
+    // Tileset must outlive the map. Tiles are tileWidth x tileHeight, all cells start empty
+    TileMap(lilka::Image* tileset, uint16_t tileWidth, uint16_t tileHeight, uint16_t cols, uint16_t rows);
+    ~TileMap();
+
+    // False if there was no memory for the map
+    bool isValid() const;
+
+    uint16_t getCols() const;
+    uint16_t getRows() const;
+    uint16_t getTileCount() const;
+
+    // Returns false if cell is outside map or tile is out of tileset
+    bool setTile(uint16_t col, uint16_t row, int32_t tile);
+    // Returns TILE_MAP_EMPTY for empty cells and cells outside map
+    int32_t getTile(uint16_t col, uint16_t row) const;
+    // Re-renders tile on next draw, e.g. after tileset pixels were changed
+    void invalidateTile(uint16_t col, uint16_t row);
+    void invalidate();
+
+    void setBackground(uint16_t color);
+    // Area of canvas covered by map. Defaults to whole canvas
+    void setViewport(int16_t x, int16_t y, uint16_t w, uint16_t h);
+    // Map pixel shown at top left corner of viewport
+    void setScroll(int32_t x, int32_t y);
+
+    // Returns sprite id. Sprite coordinates are in map pixels, image pivot is applied
+    int addSprite(lilka::Image* image, int32_t x, int32_t y);
+    bool moveSprite(int id, int32_t x, int32_t y);
+    bool setSpriteImage(int id, lilka::Image* image);
+    bool setSpriteVisible(int id, bool visible);
+    bool removeSprite(int id);
+
+    // Draws map and sprites. Returns false if there's no memory for tile buffer
+    bool draw(lilka::Canvas* canvas);
+
+private:
+    bool allocateBuffer(uint16_t w, uint16_t h);
+    void renderTile(int32_t col, int32_t row);
+    void blit(lilka::Canvas* canvas);
+    void drawSprites(lilka::Canvas* canvas);
+    bool isDirty(uint32_t cell) const;
+    void setDirty(uint32_t cell, bool dirty);
+
+    lilka::Image* tileset;
+    uint16_t tileWidth;
+    uint16_t tileHeight;
+    uint16_t tilesetCols;
+    uint16_t tileCount;
+    // Tiles without transparent pixels are copied by rows
+    uint8_t* opaque;
+
+    uint16_t cols;
+    uint16_t rows;
+    // Tile index + 1, 0 means empty. 8-bit cells are used for tilesets with up to 255 tiles
+    void* cells;
+    bool wideCells;
+    uint8_t* dirty;
+
+    uint16_t background;
+    int16_t viewX;
+    int16_t viewY;
+    uint16_t viewW;
+    uint16_t viewH;
+    int32_t scrollX;
+    int32_t scrollY;
+
+    // Wrap-around tile buffer, map pixel (x, y) is at (x mod bufferW, y mod bufferH)
+    uint16_t* buffer;
+    uint16_t bufferW;
+    uint16_t bufferH;
+    uint16_t bufferCols;
+    uint16_t bufferRows;
+    // Top left tile of area currently rendered into buffer
+    int32_t renderedCol;
+    int32_t renderedRow;
+    bool rendered;
+
+    std::vector<TileMapSprite> sprites;
+    // Sprite ids in drawing order, kept between frames so sorting is cheap
+    std::vector<uint16_t> order;
+};
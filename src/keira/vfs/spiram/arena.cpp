@@ -0,0 +1,196 @@
+#include "arena.h"
+#include <string.h>
+#include <esp_heap_caps.h>
+
+#define SLAB_SIZE (VFS_SPIRAM_SLAB_BLOCKS * VFS_SPIRAM_BLOCK_SIZE)
+
+//================================================================================================
+uint8_t* SPIRamArena::alloc(uint16_t wanted, uint16_t* pGot) {
+    if (!wanted) return NULL;
+    if (wanted > VFS_SPIRAM_SLAB_BLOCKS) wanted = VFS_SPIRAM_SLAB_BLOCKS;
+
+    // Longest run we've seen across slabs
+    SPIRamSlab* pBest = NULL;
+    uint16_t bestStart = 0;
+    uint16_t bestLength = 0;
+
+    for (SPIRamSlab* pSlab = pSlabs; pSlab; pSlab = pSlab->pNext) {
+        if (pSlab->usedCount == VFS_SPIRAM_SLAB_BLOCKS) continue;
+
+        uint16_t length;
+        uint16_t start = findRun(pSlab, wanted, &length);
+        if (length > bestLength) {
+            pBest = pSlab;
+            bestStart = start;
+            bestLength = length;
+            if (length == wanted) break;
+        }
+    }
+
+    // Rather start a new slab than split file into tiny extents. Leftovers
+    // get used once there's no memory for new slabs
+    if (bestLength < wanted) {
+        SPIRamSlab* pSlab = createSlab();
+        if (pSlab) {
+            pBest = pSlab;
+            bestStart = 0;
+            bestLength = wanted;
+        }
+    }
+
+    if (!pBest) return NULL;
+
+    markUsed(pBest, bestStart, bestLength, true);
+    *pGot = bestLength;
+    return pBest->data + bestStart * VFS_SPIRAM_BLOCK_SIZE;
+}
+//-------------------------------------------------------------------------------------- (^_^)==\~
+
+//================================================================================================
+uint16_t SPIRamArena::extend(const uint8_t* data, uint16_t nblocks, uint16_t wanted) {
+    SPIRamSlab* pSlab = findSlab(data);
+    if (!pSlab) return 0;
+
+    uint16_t block = (data - pSlab->data) / VFS_SPIRAM_BLOCK_SIZE + nblocks;
+    uint16_t added = 0;
+
+    while (added < wanted && block < VFS_SPIRAM_SLAB_BLOCKS && !isUsed(pSlab, block)) {
+        added++;
+        block++;
+    }
+
+    if (added) markUsed(pSlab, block - added, added, true);
+    return added;
+}
+//-------------------------------------------------------------------------------------- (^_^)==\~
+
+//================================================================================================
+void SPIRamArena::free(const uint8_t* data, uint16_t nblocks) {
+    if (!data || !nblocks) return;
+
+    SPIRamSlab* pSlab = findSlab(data);
+    if (!pSlab) return;
+
+    markUsed(pSlab, (data - pSlab->data) / VFS_SPIRAM_BLOCK_SIZE, nblocks, false);
+
+    if (!pSlab->usedCount) destroySlab(pSlab);
+}
+//-------------------------------------------------------------------------------------- (^_^)==\~
+
+//================================================================================================
+size_t SPIRamArena::getAllocatedSize() const {
+    return static_cast<size_t>(slabCount) * SLAB_SIZE;
+}
+//-------------------------------------------------------------------------------------- (^_^)==\~
+
+//================================================================================================
+SPIRamSlab* SPIRamArena::findSlab(const uint8_t* data) {
+    for (SPIRamSlab* pSlab = pSlabs; pSlab; pSlab = pSlab->pNext) {
+        if (data >= pSlab->data && data < pSlab->data + SLAB_SIZE) return pSlab;
+    }
+    return NULL;
+}
+//-------------------------------------------------------------------------------------- (^_^)==\~
+
+//================================================================================================
+SPIRamSlab* SPIRamArena::createSlab() {
+    uint32_t caps = MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT;
+    if (heap_caps_get_free_size(caps) < SLAB_SIZE + VFS_SPIRAM_RESERVED_SPACE) return NULL;
+
+    uint8_t* data = static_cast<uint8_t*>(heap_caps_malloc(SLAB_SIZE, caps));
+    if (!data) return NULL;
+
+    SPIRamSlab* pSlab = new SPIRamSlab();
+    pSlab->data = data;
+    pSlab->pNext = pSlabs;
+    pSlabs = pSlab;
+    slabCount++;
+
+    return pSlab;
+}
+//-------------------------------------------------------------------------------------- (^_^)==\~
+
+//================================================================================================
+void SPIRamArena::destroySlab(SPIRamSlab* pSlab) {
+    if (pSlabs == pSlab) {
+        pSlabs = pSlab->pNext;
+    } else {
+        SPIRamSlab* prev = pSlabs;
+        while (prev && prev->pNext != pSlab)
+            prev = prev->pNext;
+        if (prev) prev->pNext = pSlab->pNext;
+    }
+
+    heap_caps_free(pSlab->data);
+    delete pSlab;
+    slabCount--;
+}
+//-------------------------------------------------------------------------------------- (^_^)==\~
+
+//================================================================================================
+uint16_t SPIRamArena::findRun(const SPIRamSlab* pSlab, uint16_t wanted, uint16_t* pLength) {
+    uint16_t bestStart = 0;
+    uint16_t bestLength = 0;
+    uint16_t runStart = 0;
+    uint16_t runLength = 0;
+
+    for (uint16_t block = 0; block < VFS_SPIRAM_SLAB_BLOCKS; block++) {
+        // Skip fully used words at once
+        if ((block & 31) == 0 && pSlab->used[block / 32] == UINT32_MAX) {
+            runLength = 0;
+            block += 31;
+            continue;
+        }
+
+        if (isUsed(pSlab, block)) {
+            runLength = 0;
+            continue;
+        }
+
+        if (!runLength) runStart = block;
+        runLength++;
+
+        if (runLength > bestLength) {
+            bestStart = runStart;
+            bestLength = runLength;
+            if (bestLength == wanted) break;
+        }
+    }
+
+    *pLength = bestLength;
+    return bestStart;
+}
+//-------------------------------------------------------------------------------------- (^_^)==\~
+
+//================================================================================================
+void SPIRamArena::markUsed(SPIRamSlab* pSlab, uint16_t start, uint16_t count, bool used) {
+    for (uint16_t block = start; block < start + count; block++) {
+        uint32_t bit = 1UL << (block & 31);
+        bool wasUsed = pSlab->used[block / 32] & bit;
+        if (wasUsed == used) continue;
+
+        if (used) {
+            pSlab->used[block / 32] |= bit;
+            pSlab->usedCount++;
+        } else {
+            pSlab->used[block / 32] &= ~bit;
+            pSlab->usedCount--;
+        }
+    }
+}
+//-------------------------------------------------------------------------------------- (^_^)==\~
+
+//================================================================================================
+bool SPIRamArena::isUsed(const SPIRamSlab* pSlab, uint16_t block) {
+    return pSlab->used[block / 32] & (1UL << (block & 31));
+}
+//-------------------------------------------------------------------------------------- (^_^)==\~
+
+//================================================================================================
+SPIRamArena::~SPIRamArena() {
+    while (pSlabs)
+        destroySlab(pSlabs);
+}
+//-------------------------------------------------------------------------------------- (^_^)==\~
+
+#undef SLAB_SIZE
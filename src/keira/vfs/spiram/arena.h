@@ -0,0 +1,95 @@
+#pragma once
+
+//////////////////////////////////////////////////////////////////////////////
+//
+//  Keira OS Header file
+//
+//////////////////////////////////////////////////////////////////////////////
+// SPIRamArena - slab allocator handing out contiguous block extents
+//////////////////////////////////////////////////////////////////////////////
+
+#include <stdint.h>
+#include <stddef.h>
+
+//==========================================================
+// (o_O)==\~ CONFIGURATION
+//==========================================================
+// Block size used for file storage
+//==========================================================
+#ifndef VFS_SPIRAM_BLOCK_SIZE
+#    define VFS_SPIRAM_BLOCK_SIZE 512
+#endif
+//==========================================================
+// Blocks per slab [multiple of 32]. It's also the max
+// length of a single extent
+//==========================================================
+#ifndef VFS_SPIRAM_SLAB_BLOCKS
+#    define VFS_SPIRAM_SLAB_BLOCKS 128 // 64KB with 512 byte blocks
+#endif
+//==========================================================
+// Amount of space in spiram reserved for other purposes
+//==========================================================
+#ifndef VFS_SPIRAM_RESERVED_SPACE
+#    define VFS_SPIRAM_RESERVED_SPACE 1 * 1024 * 1024 // 1MB
+#endif
+//------------------------------------------------ (^_^)==\~
+
+//==========================================================
+// Slab of contiguous blocks, bitmap tracks used ones
+//==========================================================
+typedef struct SPIRamSlab SPIRamSlab;
+struct SPIRamSlab {
+    uint8_t* data = NULL;
+    uint32_t used[VFS_SPIRAM_SLAB_BLOCKS / 32] = {};
+    uint16_t usedCount = 0;
+    SPIRamSlab* pNext = NULL;
+};
+//------------------------------------------------ (^_^)==\~
+
+//==========================================================
+// SPIRamArena
+//==========================================================
+// Files grow by extents instead of separately allocated
+// blocks. Slabs are taken from spiram keeping
+// VFS_SPIRAM_RESERVED_SPACE free, and given back once empty
+//==========================================================
+class SPIRamArena {
+public:
+    //------------------------------------------------------
+    // Allocates contiguous run of 1..@wanted blocks.
+    // Returns NULL if out of memory, run length in @pGot
+    //------------------------------------------------------
+    uint8_t* alloc(uint16_t wanted, uint16_t* pGot);
+    //------------------------------------------------------
+    // Grows extent in place by up to @wanted blocks, if
+    // blocks right after it are free. Returns blocks added
+    //------------------------------------------------------
+    uint16_t extend(const uint8_t* data, uint16_t nblocks, uint16_t wanted);
+    //------------------------------------------------------
+    // Releases @nblocks blocks starting at @data. Might be
+    // a part of an extent, e.g. its tail
+    //------------------------------------------------------
+    void free(const uint8_t* data, uint16_t nblocks);
+    //------------------------------------------------------
+    // Bytes taken from heap
+    //------------------------------------------------------
+    size_t getAllocatedSize() const;
+
+    ~SPIRamArena();
+
+private:
+    SPIRamSlab* findSlab(const uint8_t* data);
+    SPIRamSlab* createSlab();
+    void destroySlab(SPIRamSlab* pSlab);
+    //------------------------------------------------------
+    // Seeks the first run of free blocks in slab, up to @wanted
+    // long. Returns run start, run length in @pLength
+    //------------------------------------------------------
+    static uint16_t findRun(const SPIRamSlab* pSlab, uint16_t wanted, uint16_t* pLength);
+    static void markUsed(SPIRamSlab* pSlab, uint16_t start, uint16_t count, bool used);
+    static bool isUsed(const SPIRamSlab* pSlab, uint16_t block);
+
+    SPIRamSlab* pSlabs = NULL;
+    uint16_t slabCount = 0;
+};
+//------------------------------------------------ (^_^)==\~
@@ -1,6 +1,7 @@
 #include "spiram.h"
 #include <errno.h>
 #include <string.h>
+#include <algorithm>
 #include <esp_heap_caps.h>
 
 //================================================================================================
@@ -26,6 +27,14 @@
 #define FD_ISWRITABLE(FD) ((FD_ACCMODE(FD) == O_WRONLY) || (FD_ACCMODE(FD) == O_RDWR))
 //-------------------------------------------------------------------------------------- (^_^)==\~
 
+//================================================================================================
+// Path index specific macro
+//================================================================================================
+// Marks slot of removed node, so probing goes on past it
+//------------------------------------------------------------------------------------------------
+#define INDEX_TOMBSTONE (reinterpret_cast<SPIRamNode*>(UINTPTR_MAX))
+//-------------------------------------------------------------------------------------- (^_^)==\~
+
 //================================================================================================
 ssize_t SPIRamVFS::write(int fd, void* src, size_t size) {
     // Do the harlem check
@@ -50,50 +59,12 @@ ssize_t SPIRamVFS::write(int fd, void* src, size_t size) {
     // Adjust offset
     if (desc.flags & O_APPEND) desc.offset = static_cast<long>(pNode->fsize);
 
-    size_t writeEnd = (size_t)desc.offset + size;
-    size_t blocksNeeded = (writeEnd + VFS_SPIRAM_BLOCK_SIZE - 1) / VFS_SPIRAM_BLOCK_SIZE;
-
-    // allocate new file blocks if needed
-    while (pNode->blocks.size() < blocksNeeded) {
-        SPIRamFileBlock* pBlock = static_cast<SPIRamFileBlock*>(spiram_vfs_mem_alloc(sizeof(SPIRamFileBlock)));
-        // Ensure we still have memory
-        if (!pBlock) {
-            errno = ENOMEM;
-            return ERR_BYTES_COUNT;
-        }
-
-        memset(pBlock, 0, sizeof(SPIRamFileBlock));
-
-        pNode->blocks.push_back(pBlock);
-    }
-
     // Thanks god we've no need to push data to the right, cause POSIX says we simply overwrite
     // in case offset is located in the middle of file
+    if (!writeData(pNode, src, size, (size_t)desc.offset)) return ERR_BYTES_COUNT;
 
-    size_t remaining = size;
-    size_t srcOff = 0;
-    size_t pos = (size_t)desc.offset;
-
-    while (remaining > 0) {
-        size_t blockIdx = pos / VFS_SPIRAM_BLOCK_SIZE;
-        size_t byteIdx = pos % VFS_SPIRAM_BLOCK_SIZE;
-
-        size_t chunk = VFS_SPIRAM_BLOCK_SIZE - byteIdx;
-        if (chunk > remaining) chunk = remaining;
-
-        memcpy(&pNode->blocks[blockIdx]->data[byteIdx], reinterpret_cast<const uint8_t*>(src) + srcOff, chunk);
-
-        pos += chunk;
-        srcOff += chunk;
-        remaining -= chunk;
-    }
-
-    // time to change time
-    pNode->atime = pNode->mtime = time(NULL);
-
-    // Advance offset and fileSize
-    if (writeEnd > pNode->fsize) pNode->fsize = writeEnd;
-    desc.offset = static_cast<long>(pos);
+    // Advance offset
+    desc.offset += static_cast<long>(size);
 
     KSVFS_DBG printf("[SPIRamVFS] write(%d, %zu) offset=%ld fsize=%zu\n", fd, size, desc.offset, pNode->fsize);
 
@@ -166,37 +137,79 @@ ssize_t SPIRamVFS::read(int fd, void* dst, size_t size) {
     size_t available = pNode->fsize - (size_t)desc.offset;
     size_t toRead = (size < available) ? size : available;
 
-    // do read
+    readData(pNode, dst, toRead, (size_t)desc.offset);
 
-    size_t remaining = toRead;
-    size_t dstOff = 0;
-    size_t pos = (size_t)desc.offset;
+    desc.offset += static_cast<long>(toRead);
 
-    while (remaining > 0) {
-        size_t blockIdx = pos / VFS_SPIRAM_BLOCK_SIZE;
-        size_t byteIdx = pos % VFS_SPIRAM_BLOCK_SIZE;
+    // update access time
+    pNode->atime = time(NULL);
 
-        size_t chunk = VFS_SPIRAM_BLOCK_SIZE - byteIdx;
-        if (chunk > remaining) chunk = remaining;
+    KSVFS_DBG printf("[SPIRamVFS] read(%d, %zu) got=%zu offset=%ld\n", fd, size, toRead, desc.offset);
 
-        memcpy(reinterpret_cast<uint8_t*>(dst) + dstOff, &pNode->blocks[blockIdx]->data[byteIdx], chunk);
+    return (ssize_t)toRead;
+}
+//-------------------------------------------------------------------------------------- (^_^)==\~
 
-        pos += chunk;
-        dstOff += chunk;
-        remaining -= chunk;
+//================================================================================================
+ssize_t SPIRamVFS::pread(int fd, void* dst, size_t size, off_t offset) {
+    if (!FD_ISVALID(fd) || FD_ACCMODE(fd) == O_WRONLY) {
+        errno = EBADF;
+        return ERR_BYTES_COUNT;
+    }
+    if (!dst || offset < 0) {
+        errno = EINVAL;
+        return ERR_BYTES_COUNT;
     }
 
-    desc.offset += static_cast<long>(toRead);
+    SPIRamNode* pNode = pfds[fd].pNode;
 
-    // update access time
+    if (S_ISDIR(pNode->mode)) {
+        errno = EISDIR;
+        return ERR_BYTES_COUNT;
+    }
+    if (!size || (size_t)offset >= pNode->fsize) return 0;
+
+    size_t available = pNode->fsize - (size_t)offset;
+    size_t toRead = (size < available) ? size : available;
+
+    // fd offset stays untouched
+    readData(pNode, dst, toRead, (size_t)offset);
     pNode->atime = time(NULL);
 
-    KSVFS_DBG printf("[SPIRamVFS] read(%d, %zu) got=%zu offset=%ld\n", fd, size, toRead, desc.offset);
+    KSVFS_DBG printf("[SPIRamVFS] pread(%d, %zu, %ld) got=%zu\n", fd, size, static_cast<long>(offset), toRead);
 
     return (ssize_t)toRead;
 }
 //-------------------------------------------------------------------------------------- (^_^)==\~
 
+//================================================================================================
+ssize_t SPIRamVFS::pwrite(int fd, const void* src, size_t size, off_t offset) {
+    if (!(FD_ISVALID(fd) && FD_ISWRITABLE(fd))) {
+        errno = EBADF;
+        return ERR_BYTES_COUNT;
+    }
+    if (!src || offset < 0) {
+        errno = EINVAL;
+        return ERR_BYTES_COUNT;
+    }
+    if (!size) return 0;
+
+    SPIRamNode* pNode = pfds[fd].pNode;
+
+    if (S_ISDIR(pNode->mode)) {
+        errno = EISDIR;
+        return ERR_BYTES_COUNT;
+    }
+
+    // Unlike write(), POSIX wants @offset to be used even with O_APPEND
+    if (!writeData(pNode, src, size, (size_t)offset)) return ERR_BYTES_COUNT;
+
+    KSVFS_DBG printf("[SPIRamVFS] pwrite(%d, %zu, %ld) fsize=%zu\n", fd, size, static_cast<long>(offset), pNode->fsize);
+
+    return (ssize_t)size;
+}
+//-------------------------------------------------------------------------------------- (^_^)==\~
+
 //================================================================================================
 int SPIRamVFS::open(const char* path, int flags, int mode) {
     if (!path) {
@@ -248,10 +261,7 @@ int SPIRamVFS::open(const char* path, int flags, int mode) {
 
     if (flags & O_TRUNC) {
         // free allocated blocks
-        for (auto& block : pNode->blocks)
-            heap_caps_free(block);
-
-        pNode->blocks.clear();
+        releaseBlocks(pNode, 0);
         pNode->fsize = 0;
 
         pNode->atime = pNode->ctime = time(NULL);
@@ -279,6 +289,9 @@ int SPIRamVFS::close(int fd) {
 
     SPIRamNode* pNode = pfds[fd].pNode;
 
+    // Writes reserve blocks ahead, give back what wasn't used
+    if (FD_ISWRITABLE(fd)) releaseBlocks(pNode, (pNode->fsize + VFS_SPIRAM_BLOCK_SIZE - 1) / VFS_SPIRAM_BLOCK_SIZE);
+
     pNode->refcount--;
 
     SPIRamFileDescriptor* pDesc = &(pfds[fd]);
@@ -590,12 +603,14 @@ int SPIRamVFS::rename(const char* src, const char* dst) {
     // reattach to dst parent
     strncpy(pNode->name, basename, VFS_SPIRAM_NAME_MAX - 1);
     pNode->name[VFS_SPIRAM_NAME_MAX - 1] = '\0';
-    pNode->nhash = spiram_vfs_hash(basename, pDstParent->nhash);
     pNode->pParent = pDstParent;
     pNode->pNext = pDstParent->pChild;
     pDstParent->pChild = pNode;
     pNode->mtime = pNode->ctime = time(NULL);
 
+    // hashes are path based, whole moved subtree gets new ones
+    reindexSubtree(pNode);
+
     KSVFS_DBG printf("[SPIRamVFS] rename '%s' -> '%s'\n", src, dst);
     return 0;
 }
@@ -610,6 +625,9 @@ SPIRamNode* SPIRamVFS::findNode(const char* path, SPIRamNode* pStart) {
         return pRoot;
     }
 
+    // Plain paths are resolved by index in one go
+    if (!pStart && !indexBroken && isPlainPath(path)) return indexFind(path, spiram_vfs_hash(path));
+
     const char* cur = path;
 
     // skip the leading slashes
@@ -716,6 +734,93 @@ int SPIRamVFS::access(const char* path, int amode) {
 }
 //-------------------------------------------------------------------------------------- (^_^)==\~
 
+//================================================================================================
+int SPIRamVFS::truncate(const char* path, off_t length) {
+    if (!path || length < 0) {
+        errno = EINVAL;
+        return ERR_BYTES_COUNT;
+    }
+
+    SPIRamNode* pNode = findNode(path);
+    if (!pNode) {
+        errno = ENOENT;
+        return ERR_BYTES_COUNT;
+    }
+    if (S_ISDIR(pNode->mode)) {
+        errno = EISDIR;
+        return ERR_BYTES_COUNT;
+    }
+
+    KSVFS_DBG printf("[SPIRamVFS] truncate('%s', %ld)\n", path, static_cast<long>(length));
+    return resizeNode(pNode, (size_t)length);
+}
+//-------------------------------------------------------------------------------------- (^_^)==\~
+
+//================================================================================================
+int SPIRamVFS::ftruncate(int fd, off_t length) {
+    if (!(FD_ISVALID(fd) && FD_ISWRITABLE(fd))) {
+        errno = EBADF;
+        return ERR_BYTES_COUNT;
+    }
+    if (length < 0) {
+        errno = EINVAL;
+        return ERR_BYTES_COUNT;
+    }
+
+    SPIRamNode* pNode = pfds[fd].pNode;
+    if (S_ISDIR(pNode->mode)) {
+        errno = EISDIR;
+        return ERR_BYTES_COUNT;
+    }
+
+    KSVFS_DBG printf("[SPIRamVFS] ftruncate(%d, %ld)\n", fd, static_cast<long>(length));
+    return resizeNode(pNode, (size_t)length);
+}
+//-------------------------------------------------------------------------------------- (^_^)==\~
+
+//================================================================================================
+int SPIRamVFS::ioctl(int fd, int cmd, va_list args) {
+    if (!FD_ISVALID(fd)) {
+        errno = EBADF;
+        return ERR_BYTES_COUNT;
+    }
+    if (cmd != VFS_SPIRAM_IOCTL_GET_SPAN) {
+        errno = ENOTTY;
+        return ERR_BYTES_COUNT;
+    }
+
+    SPIRamSpan* pSpan = va_arg(args, SPIRamSpan*);
+    if (!pSpan) {
+        errno = EINVAL;
+        return ERR_BYTES_COUNT;
+    }
+
+    const SPIRamFileDescriptor& desc = pfds[fd];
+    const SPIRamNode* pNode = desc.pNode;
+
+    if (S_ISDIR(pNode->mode)) {
+        errno = EISDIR;
+        return ERR_BYTES_COUNT;
+    }
+    if (FD_ACCMODE(fd) == O_WRONLY) {
+        errno = EBADF;
+        return ERR_BYTES_COUNT;
+    }
+
+    pSpan->data = NULL;
+    pSpan->size = 0;
+
+    if ((size_t)desc.offset < pNode->fsize) {
+        size_t avail;
+        size_t left = pNode->fsize - (size_t)desc.offset;
+        pSpan->data = dataAt(pNode, (size_t)desc.offset, &avail);
+        pSpan->size = (avail < left) ? avail : left;
+    }
+
+    return 0;
+}
+//-------------------------------------------------------------------------------------- (^_^)==\~
+
 //================================================================================================
 SPIRamNode* SPIRamVFS::createNode(const char* name, mode_t mode, SPIRamNode* pParent) {
     if (!pParent || !name || name[0] == '\0') {
@@ -736,13 +841,20 @@ SPIRamNode* SPIRamVFS::createNode(const char* name, mode_t mode, SPIRamNode* pPa
     uint32_t nHash = spiram_vfs_hash(name, pParent->nhash);
 
     // Check node existence
-    SPIRamNode* scan = pParent->pChild;
-    while (scan) {
-        if (scan->nhash == nHash && strcmp(scan->name, name) == 0) {
+    if (!indexBroken) {
+        if (indexFindChild(pParent, name, nHash)) {
             errno = EEXIST;
             return NULL;
         }
-        scan = scan->pNext;
+    } else {
+        SPIRamNode* scan = pParent->pChild;
+        while (scan) {
+            if (scan->nhash == nHash && strcmp(scan->name, name) == 0) {
+                errno = EEXIST;
+                return NULL;
+            }
+            scan = scan->pNext;
+        }
     }
 
     // Creating a new node
@@ -758,6 +870,8 @@ SPIRamNode* SPIRamVFS::createNode(const char* name, mode_t mode, SPIRamNode* pPa
     pNewNode->pNext = pParent->pChild;
     pParent->pChild = pNewNode;
 
+    indexInsert(pNewNode);
+
     KSVFS_DBG printf("[SPIRamVFS] createNode '%s'\n", name);
 
     return pNewNode;
@@ -774,7 +888,7 @@ void SPIRamVFS::fillNodeStat(const SPIRamNode* pNode, struct stat* st) {
     st->st_ctime = pNode->ctime;
     st->st_nlink = 1;
     st->st_blksize = VFS_SPIRAM_BLOCK_SIZE;
-    st->st_blocks = (blkcnt_t)pNode->blocks.size();
+    st->st_blocks = (blkcnt_t)pNode->nblocks;
 }
 //-------------------------------------------------------------------------------------- (^_^)==\~
 
@@ -782,6 +896,8 @@ void SPIRamVFS::fillNodeStat(const SPIRamNode* pNode, struct stat* st) {
 void SPIRamVFS::deleteNode(SPIRamNode* pNode) {
     if (!pNode) return;
 
+    indexRemove(pNode);
+
     SPIRamNode* parent = pNode->pParent;
     if (parent) {
         // Remove from sibling linked list
@@ -796,8 +912,7 @@ void SPIRamVFS::deleteNode(SPIRamNode* pNode) {
     }
 
     // Free file blocks
-    for (auto* block : pNode->blocks)
-        heap_caps_free(block);
+    releaseBlocks(pNode, 0);
 
     delete pNode;
     KSVFS_DBG printf("[SPIRamVFS] deleteNode done\n");
@@ -807,6 +922,184 @@ void SPIRamVFS::deleteNode(SPIRamNode* pNode) {
 }
 //-------------------------------------------------------------------------------------- (^_^)==\~
 
+//================================================================================================
+SPIRamNode* SPIRamVFS::indexFind(const char* path, uint32_t nHash) {
+    if (!indexSize) return NULL;
+
+    uint32_t mask = indexSize - 1;
+    // Load factor is kept below 3/4, so there's always a free slot to stop at
+    for (uint32_t i = nHash & mask; pIndex[i]; i = (i + 1) & mask) {
+        SPIRamNode* pNode = pIndex[i];
+        // Hashes may collide, verify actual location in a tree
+        if (pNode != INDEX_TOMBSTONE && pNode->nhash == nHash && nodeMatchesPath(pNode, path)) return pNode;
+    }
+
+    return NULL;
+}
+//-------------------------------------------------------------------------------------- (^_^)==\~
+
+//================================================================================================
+SPIRamNode* SPIRamVFS::indexFindChild(const SPIRamNode* pParent, const char* name, uint32_t nHash) {
+    if (!indexSize) return NULL;
+
+    uint32_t mask = indexSize - 1;
+    for (uint32_t i = nHash & mask; pIndex[i]; i = (i + 1) & mask) {
+        SPIRamNode* pNode = pIndex[i];
+        if (pNode != INDEX_TOMBSTONE && pNode->nhash == nHash && pNode->pParent == pParent &&
+            strcmp(pNode->name, name) == 0)
+            return pNode;
+    }
+
+    return NULL;
+}
+//-------------------------------------------------------------------------------------- (^_^)==\~
+
+//================================================================================================
+void SPIRamVFS::indexInsert(SPIRamNode* pNode) {
+    if (indexBroken) return;
+
+    if ((indexUsed + 1) * 4 > indexSize * 3) {
+        // Grow only if live nodes need it, otherwise it's just a tombstone cleanup
+        uint32_t size = indexSize ? indexSize : VFS_SPIRAM_INDEX_MIN_SIZE;
+        while ((indexCount + 1) * 2 > size)
+            size *= 2;
+
+        if (!indexResize(size)) {
+            // Out of memory. Tree is still consistent, so fall back to walking it
+            KSVFS_DBG printf("[SPIRamVFS] index resize to %lu failed\n", static_cast<unsigned long>(size));
+            heap_caps_free(pIndex);
+            pIndex = NULL;
+            indexSize = indexCount = indexUsed = 0;
+            indexBroken = true;
+            return;
+        }
+    }
+
+    uint32_t mask = indexSize - 1;
+    uint32_t i = pNode->nhash & mask;
+    while (pIndex[i] && pIndex[i] != INDEX_TOMBSTONE)
+        i = (i + 1) & mask;
+
+    if (!pIndex[i]) indexUsed++;
+    pIndex[i] = pNode;
+    indexCount++;
+}
+//-------------------------------------------------------------------------------------- (^_^)==\~
+
+//================================================================================================
+void SPIRamVFS::indexRemove(SPIRamNode* pNode) {
+    if (!indexSize) return;
+
+    uint32_t mask = indexSize - 1;
+    for (uint32_t i = pNode->nhash & mask; pIndex[i]; i = (i + 1) & mask) {
+        if (pIndex[i] == pNode) {
+            pIndex[i] = INDEX_TOMBSTONE;
+            indexCount--;
+            // Give memory back once /tmp got cleaned. Failing here is fine,
+            // old index is still valid
+            if (indexSize > VFS_SPIRAM_INDEX_MIN_SIZE && indexCount * 8 < indexSize) indexResize(indexSize / 2);
+            return;
+        }
+    }
+}
+//-------------------------------------------------------------------------------------- (^_^)==\~
+
+//================================================================================================
+bool SPIRamVFS::indexResize(uint32_t size) {
+    SPIRamNode** pNewIndex = static_cast<SPIRamNode**>(heap_caps_calloc_prefer(
+        size, sizeof(SPIRamNode*), 2, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT, MALLOC_CAP_DEFAULT
+    ));
+    if (!pNewIndex) return false;
+
+    uint32_t mask = size - 1;
+    for (uint32_t i = 0; i < indexSize; i++) {
+        SPIRamNode* pNode = pIndex[i];
+        if (!pNode || pNode == INDEX_TOMBSTONE) continue;
+
+        uint32_t j = pNode->nhash & mask;
+        while (pNewIndex[j])
+            j = (j + 1) & mask;
+        pNewIndex[j] = pNode;
+    }
+
+    heap_caps_free(pIndex);
+    pIndex = pNewIndex;
+    indexSize = size;
+    indexUsed = indexCount;
+
+    KSVFS_DBG printf("[SPIRamVFS] index resized to %lu\n", static_cast<unsigned long>(size));
+    return true;
+}
+//-------------------------------------------------------------------------------------- (^_^)==\~
+
+//================================================================================================
+void SPIRamVFS::reindexSubtree(SPIRamNode* pNode) {
+    SPIRamNode* cur = pNode;
+
+    // Parents go first, so child hash is always built from an updated one
+    while (cur) {
+        indexRemove(cur);
+        cur->nhash = spiram_vfs_hash(cur->name, cur->pParent->nhash);
+        indexInsert(cur);
+
+        if (cur->pChild) {
+            cur = cur->pChild;
+            continue;
+        }
+
+        // Climb up until there's a sibling to go, but never leave pNode subtree
+        while (cur != pNode && !cur->pNext)
+            cur = cur->pParent;
+
+        cur = (cur == pNode) ? NULL : cur->pNext;
+    }
+}
+//-------------------------------------------------------------------------------------- (^_^)==\~
+
+//================================================================================================
+bool SPIRamVFS::isPlainPath(const char* path) {
+    while (*path) {
+        while (*path == '/')
+            ++path;
+
+        const char* start = path;
+        while (*path && *path != '/')
+            ++path;
+
+        size_t len = (size_t)(path - start);
+
+        if (len >= VFS_SPIRAM_NAME_MAX) return false;
+        if (start[0] == '.' && (len == 1 || (len == 2 && start[1] == '.'))) return false;
+    }
+    return true;
+}
+//-------------------------------------------------------------------------------------- (^_^)==\~
+
+//================================================================================================
+bool SPIRamVFS::nodeMatchesPath(const SPIRamNode* pNode, const char* path) {
+    const char* end = path + strlen(path);
+
+    // Compare path components from the last one, walking node parents up to root
+    while (true) {
+        while (end > path && end[-1] == '/')
+            --end;
+
+        if (end == path) return pNode == pRoot;
+
+        const char* start = end;
+        while (start > path && start[-1] != '/')
+            --start;
+
+        size_t len = (size_t)(end - start);
+
+        if (pNode == pRoot || strlen(pNode->name) != len || memcmp(pNode->name, start, len) != 0) return false;
+
+        pNode = pNode->pParent;
+        end = start;
+    }
+}
+//-------------------------------------------------------------------------------------- (^_^)==\~
+
 //================================================================================================
 int SPIRamVFS::allocfd(SPIRamNode* pNode, int flags) {
     for (int i = 0; i < VFS_SPIRAM_MAX_FD; ++i) {
@@ -825,10 +1118,160 @@ int SPIRamVFS::allocfd(SPIRamNode* pNode, int flags) {
 //-------------------------------------------------------------------------------------- (^_^)==\~
 
 //================================================================================================
-void* SPIRamVFS::spiram_vfs_mem_alloc(size_t size) {
-    uint32_t caps = MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT;
-    if (heap_caps_get_free_size(caps) > VFS_SPIRAM_RESERVED_SPACE) return heap_caps_malloc(size, caps);
-    else return NULL;
+void SPIRamVFS::readData(const SPIRamNode* pNode, void* dst, size_t size, size_t pos) {
+    uint8_t* pDst = static_cast<uint8_t*>(dst);
+
+    while (size > 0) {
+        size_t chunk;
+        const uint8_t* pSrc = dataAt(pNode, pos, &chunk);
+        if (chunk > size) chunk = size;
+
+        memcpy(pDst, pSrc, chunk);
+
+        pos += chunk;
+        pDst += chunk;
+        size -= chunk;
+    }
+}
+//-------------------------------------------------------------------------------------- (^_^)==\~
+
+//================================================================================================
+bool SPIRamVFS::writeData(SPIRamNode* pNode, const void* src, size_t size, size_t pos) {
+    size_t writeEnd = pos + size;
+
+    // allocate new file blocks if needed. Blocks past EOF are always zero
+    // filled, so writing after a gap leaves a hole of zeros as POSIX wants
+    if (!reserveBlocks(pNode, (writeEnd + VFS_SPIRAM_BLOCK_SIZE - 1) / VFS_SPIRAM_BLOCK_SIZE)) {
+        errno = ENOMEM;
+        return false;
+    }
+
+    const uint8_t* pSrc = static_cast<const uint8_t*>(src);
+
+    while (size > 0) {
+        size_t chunk;
+        uint8_t* pDst = dataAt(pNode, pos, &chunk);
+        if (chunk > size) chunk = size;
+
+        memcpy(pDst, pSrc, chunk);
+
+        pos += chunk;
+        pSrc += chunk;
+        size -= chunk;
+    }
+
+    // time to change time
+    pNode->atime = pNode->mtime = time(NULL);
+
+    if (writeEnd > pNode->fsize) pNode->fsize = writeEnd;
+    return true;
+}
+//-------------------------------------------------------------------------------------- (^_^)==\~
+
+//================================================================================================
+uint8_t* SPIRamVFS::dataAt(const SPIRamNode* pNode, size_t pos, size_t* pAvail) {
+    size_t block = pos / VFS_SPIRAM_BLOCK_SIZE;
+    if (block >= pNode->nblocks) {
+        *pAvail = 0;
+        return NULL;
+    }
+
+    // Last extent starting at or before the block
+    auto next = std::upper_bound(
+        pNode->extents.begin(),
+        pNode->extents.end(),
+        block,
+        [](size_t block, const SPIRamExtent& extent) { return block < extent.firstBlock; }
+    );
+    const SPIRamExtent& extent = *(next - 1);
+
+    size_t offset = pos - extent.firstBlock * VFS_SPIRAM_BLOCK_SIZE;
+    *pAvail = (size_t)extent.nblocks * VFS_SPIRAM_BLOCK_SIZE - offset;
+    return extent.data + offset;
+}
+//-------------------------------------------------------------------------------------- (^_^)==\~
+
+//================================================================================================
+bool SPIRamVFS::reserveBlocks(SPIRamNode* pNode, size_t nblocks) {
+    while (pNode->nblocks < nblocks) {
+        // Grow geometrically, so sequentially written files end up in a few
+        // long extents. Excess gets released on close()
+        size_t wanted = nblocks - pNode->nblocks;
+        if (wanted < pNode->nblocks) wanted = pNode->nblocks;
+        if (wanted > VFS_SPIRAM_SLAB_BLOCKS) wanted = VFS_SPIRAM_SLAB_BLOCKS;
+
+        uint8_t* data = NULL;
+        uint16_t got = 0;
+
+        // Best case: blocks right after the last extent are free
+        if (!pNode->extents.empty()) {
+            SPIRamExtent& last = pNode->extents.back();
+            got = arena.extend(last.data, last.nblocks, wanted);
+            if (got) {
+                data = last.data + (size_t)last.nblocks * VFS_SPIRAM_BLOCK_SIZE;
+                last.nblocks += got;
+            }
+        }
+
+        if (!got) {
+            data = arena.alloc(wanted, &got);
+            // Ensure we still have memory
+            if (!data) return false;
+            pNode->extents.push_back({data, got, pNode->nblocks});
+        }
+
+        memset(data, 0, (size_t)got * VFS_SPIRAM_BLOCK_SIZE);
+        pNode->nblocks += got;
+    }
+
+    return true;
+}
+//-------------------------------------------------------------------------------------- (^_^)==\~
+
+//================================================================================================
+void SPIRamVFS::releaseBlocks(SPIRamNode* pNode, size_t nblocks) {
+    while (pNode->nblocks > nblocks) {
+        SPIRamExtent& last = pNode->extents.back();
+        size_t excess = pNode->nblocks - nblocks;
+
+        if (excess >= last.nblocks) {
+            arena.free(last.data, last.nblocks);
+            pNode->nblocks -= last.nblocks;
+            pNode->extents.pop_back();
+        } else {
+            // cut the tail only
+            arena.free(last.data + (last.nblocks - excess) * VFS_SPIRAM_BLOCK_SIZE, excess);
+            last.nblocks -= excess;
+            pNode->nblocks -= excess;
+        }
+    }
+}
+//-------------------------------------------------------------------------------------- (^_^)==\~
+
+//================================================================================================
+int SPIRamVFS::resizeNode(SPIRamNode* pNode, size_t size) {
+    size_t nblocks = (size + VFS_SPIRAM_BLOCK_SIZE - 1) / VFS_SPIRAM_BLOCK_SIZE;
+
+    if (size > pNode->fsize) {
+        // New blocks come zeroed, as well as old last block past EOF
+        if (!reserveBlocks(pNode, nblocks)) {
+            errno = ENOMEM;
+            return ERR_BYTES_COUNT;
+        }
+    } else {
+        releaseBlocks(pNode, nblocks);
+
+        // Keep bytes past EOF zeroed for a case file grows again
+        size_t tail = size % VFS_SPIRAM_BLOCK_SIZE;
+        if (tail) {
+            size_t avail;
+            memset(dataAt(pNode, size, &avail), 0, VFS_SPIRAM_BLOCK_SIZE - tail);
+        }
+    }
+
+    pNode->fsize = size;
+    pNode->mtime = pNode->ctime = time(NULL);
+    return 0;
 }
 //-------------------------------------------------------------------------------------- (^_^)==\~
 
@@ -890,9 +1333,7 @@ SPIRamVFS::~SPIRamVFS() {
             continue;
         }
 
-        // cur is a leaf: free its SPIRAM blocks
-        for (auto* block : cur->blocks)
-            heap_caps_free(block);
+        // cur is a leaf. Its blocks are freed along with arena slabs
 
         // Save where to go next before we delete cur
         SPIRamNode* next = cur->pNext; // sibling in same dir, or NULL
@@ -922,6 +1363,9 @@ SPIRamVFS::~SPIRamVFS() {
     }
 
     pRoot = NULL;
+
+    heap_caps_free(pIndex);
+    pIndex = NULL;
 }
 //-------------------------------------------------------------------------------------- (^_^)==\~
 
@@ -931,4 +1375,5 @@ SPIRamVFS::~SPIRamVFS() {
 #undef FD_ISVALID
 #undef FD_ACCMODE
 #undef FD_ISWRITABLE
+#undef INDEX_TOMBSTONE
 //-------------------------------------------------------------------------------------- (^_^)==\~
\ No newline at end of file
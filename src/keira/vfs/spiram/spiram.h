@@ -11,6 +11,7 @@
 #include "keira/vfs/vfs.h"
 #include <vector>
 #include "keira/crypto/fnv-1a-32.h"
+#include "arena.h"
 
 #include <limits.h> // PATH_MAX
 
@@ -47,16 +48,10 @@
 #    define VFS_SPIRAM_NAME_MAX 32
 #endif
 //==========================================================
-// Block size used for file storage
+// Initial capacity of path index [power of 2]
 //==========================================================
-#ifndef VFS_SPIRAM_BLOCK_SIZE
-#    define VFS_SPIRAM_BLOCK_SIZE 512
-#endif
-//==========================================================
-// Amount of space in spiram reserved for other purposes
-//==========================================================
-#ifndef VFS_SPIRAM_RESERVED_SPACE
-#    define VFS_SPIRAM_RESERVED_SPACE 1 * 1024 * 1024 // 1MB
+#ifndef VFS_SPIRAM_INDEX_MIN_SIZE
+#    define VFS_SPIRAM_INDEX_MIN_SIZE 64
 #endif
 //==========================================================
 // Crypto algorithm used for fast node search
@@ -70,14 +65,40 @@
 #define VFS_SPIRAM_FILE_MODE_DEFAULT (S_IFREG | 0644)
 //------------------------------------------------ (^_^)==\~
 
+//==========================================================
+// (o_O)==\~ IOCTL
+//==========================================================
+// Zero-copy read access:
+//   SPIRamSpan span;
+//   ioctl(fd, VFS_SPIRAM_IOCTL_GET_SPAN, &span);
+// Fills span with read-only pointer to file bytes starting
+// at current fd offset, and amount of bytes contiguous in
+// memory from there [0 at EOF]. Offset isn't moved, use
+// lseek(fd, span.size, SEEK_CUR) to get the next span.
+// Pointer is valid while fd is open and file isn't
+// written or truncated
+//==========================================================
+#define VFS_SPIRAM_IOCTL_GET_SPAN 0x5301
+
+typedef struct {
+    const uint8_t* data;
+    size_t size;
+} SPIRamSpan;
+//------------------------------------------------ (^_^)==\~
+
 // TODO: try to use SPIRamVFS instead of RootVFS
 
 //==========================================================
-// File block, all files consist from them
+// File extent, contiguous run of blocks given by arena.
+// All files consist from them
 //==========================================================
 typedef struct {
-    uint8_t data[VFS_SPIRAM_BLOCK_SIZE];
-} SPIRamFileBlock;
+    uint8_t* data;
+    uint16_t nblocks;
+    // Index of extent's first block within file. Ascending
+    // along extents, so they can be binary searched
+    size_t firstBlock;
+} SPIRamExtent;
 //------------------------------------------------ (^_^)==\~
 
 //==========================================================
@@ -140,9 +161,13 @@ struct SPIRamNode {
     //======================================================
     // File data
     //======================================================
-    // A vector of fileblocks with actual file bytes
+    // A vector of extents with actual file bytes
+    //======================================================
+    std::vector<SPIRamExtent> extents;
+    //======================================================
+    // Blocks in all extents
     //======================================================
-    std::vector<SPIRamFileBlock*> blocks;
+    size_t nblocks = 0;
     //======================================================
     // File size, we need it cause we're block aligned
     //======================================================
@@ -205,6 +230,10 @@ private:
     //------------------------------------------------------
     ssize_t read(int fd, void* dst, size_t size) override;
     //------------------------------------------------------
+    ssize_t pread(int fd, void* dst, size_t size, off_t offset) override;
+    //------------------------------------------------------
+    ssize_t pwrite(int fd, const void* src, size_t size, off_t offset) override;
+    //------------------------------------------------------
     int open(const char* path, int flags, int mode) override;
     //------------------------------------------------------
     int close(int fd) override;
@@ -231,8 +260,16 @@ private:
     int mkdir(const char* name, mode_t mode) override;
     //------------------------------------------------------
     int rmdir(const char* name) override;
+#endif
     //------------------------------------------------------
+    int ioctl(int fd, int cmd, va_list args) override;
+    //------------------------------------------------------
+#ifdef CONFIG_VFS_SUPPORT_DIR
     int access(const char* path, int amode) override;
+    //------------------------------------------------------
+    int truncate(const char* path, off_t length) override;
+    //------------------------------------------------------
+    int ftruncate(int fd, off_t length) override;
 #endif
     //------------------------------------------- (^_^)==\~~
 
@@ -256,6 +293,79 @@ private:
     void deleteNode(SPIRamNode* pNode); // + - ok
     //------------------------------------------- (^_^)==\~~
 
+    //======================================================
+    // File data operations
+    //======================================================
+    // Copies bytes from file at @pos, no bounds checks
+    //------------------------------------------------------
+    void readData(const SPIRamNode* pNode, void* dst, size_t size, size_t pos);
+    //------------------------------------------------------
+    // Copies bytes to file at @pos growing it if needed.
+    // Returns false with errno set on failure
+    //------------------------------------------------------
+    bool writeData(SPIRamNode* pNode, const void* src, size_t size, size_t pos);
+    //------------------------------------------------------
+    // Returns pointer to file byte at @pos and amount of
+    // bytes contiguous from there in @pAvail
+    //------------------------------------------------------
+    uint8_t* dataAt(const SPIRamNode* pNode, size_t pos, size_t* pAvail);
+    //------------------------------------------------------
+    // Ensures file has at least @nblocks blocks. Extents
+    // grow geometrically to keep their count low
+    //------------------------------------------------------
+    bool reserveBlocks(SPIRamNode* pNode, size_t nblocks);
+    //------------------------------------------------------
+    // Gives back blocks past @nblocks
+    //------------------------------------------------------
+    void releaseBlocks(SPIRamNode* pNode, size_t nblocks);
+    //------------------------------------------------------
+    // Sets file size, zero filling on growth
+    //------------------------------------------------------
+    int resizeNode(SPIRamNode* pNode, size_t size);
+    //------------------------------------------- (^_^)==\~~
+
+    //======================================================
+    // Path index [open addressing, linear probing]
+    //======================================================
+    // Nodes are keyed by nhash, which is a hash of the full
+    // path. Lookup costs one hash pass over path instead of
+    // walking sibling lists on every level
+    //------------------------------------------------------
+    // Seeks node by full path, verifying it on hash match
+    //------------------------------------------------------
+    SPIRamNode* indexFind(const char* path, uint32_t nHash);
+    //------------------------------------------------------
+    // Seeks direct child of @pParent by name
+    //------------------------------------------------------
+    SPIRamNode* indexFindChild(const SPIRamNode* pParent, const char* name, uint32_t nHash);
+    //------------------------------------------------------
+    // Adds node to index, grows index if needed
+    //------------------------------------------------------
+    void indexInsert(SPIRamNode* pNode);
+    //------------------------------------------------------
+    // Removes node from index leaving a tombstone
+    //------------------------------------------------------
+    void indexRemove(SPIRamNode* pNode);
+    //------------------------------------------------------
+    // Reallocates index with @size slots, drops tombstones
+    //------------------------------------------------------
+    bool indexResize(uint32_t size);
+    //------------------------------------------------------
+    // Recalculates hashes of node and all its descendants
+    // after move, keeping index in sync
+    //------------------------------------------------------
+    void reindexSubtree(SPIRamNode* pNode);
+    //------------------------------------------------------
+    // Checks path is absolute-like, without "."/".." and
+    // too long components, so its hash is a node hash
+    //------------------------------------------------------
+    static bool isPlainPath(const char* path);
+    //------------------------------------------------------
+    // Compares node's location in a tree with a plain path
+    //------------------------------------------------------
+    bool nodeMatchesPath(const SPIRamNode* pNode, const char* path);
+    //------------------------------------------- (^_^)==\~~
+
     //======================================================
     // File descriptor operations
     //======================================================
@@ -269,17 +379,16 @@ private:
     //------------------------------------------------------
     static uint32_t spiram_vfs_hash(const char* rpath, uint32_t parentHash = VFS_SPIRAM_HASH_INITAL);
     //======================================================
-    // Special memory allocator working with quota
-    //------------------------------------------------------
-    static void* spiram_vfs_mem_alloc(size_t size);
-    //------------------------------------------- (^_^)==\~~
-    //======================================================
     // Storage
     //======================================================
     // Root node
     //------------------------------------------------------
     SPIRamNode* pRoot = NULL;
     //------------------------------------------------------
+    // Allocator for file data, works with quota
+    //------------------------------------------------------
+    SPIRamArena arena;
+    //------------------------------------------------------
     // Statically allocated file descriptors used to track
     // file openings
     //
@@ -289,6 +398,19 @@ private:
     // esp-idf
     //------------------------------------------------------
     SPIRamFileDescriptor pfds[VFS_SPIRAM_MAX_FD];
+    //------------------------------------------------------
+    // Path index slots, NULL means free slot. Root isn't
+    // indexed, findNode() handles it separately
+    //------------------------------------------------------
+    SPIRamNode** pIndex = NULL;
+    // Slots count, always power of 2
+    uint32_t indexSize = 0;
+    // Live nodes in index
+    uint32_t indexCount = 0;
+    // Live nodes + tombstones
+    uint32_t indexUsed = 0;
+    // Set if index couldn't grow, findNode() walks tree then
+    bool indexBroken = false;
     //------------------------------------------- (^_^)==\~~
     //======================================================
     // static buffers for path manipulations
@@ -1,23 +1,44 @@
+#include <esp_sntp.h>
 #include "clock.h"
 #include "services/network/network.h"
 #include "keira/ksystem.h"
 ClockService::ClockService() : Service("clock") {
+    addDependency("network");
 }
 
 void ClockService::run() {
+    NetworkService* network = static_cast<NetworkService*>(ksystem.services["network"]);
+    // Time jumps once synced, let everyone showing it know
+    sntp_set_time_sync_notification_cb([](struct timeval* tv) {
+        ksystem.events.publish(KEVENT_CLOCK_TICK, tv->tv_sec);
+    });
+    KeiraEventQueue events = ksystem.events.subscribe(KEVENT_MASK(KEVENT_NETWORK_STATE));
+    KeiraEvent event;
+    bool synced = false;
+    uint32_t lastSync = 0;
+    time_t lastMinute = time(NULL) / 60;
+
     while (1) {
-        NetworkService* network = reinterpret_cast<NetworkService*>(ksystem.services["network"]);
-        if (network == NULL) {
-            vTaskDelay(1000 / portTICK_PERIOD_MS);
-            continue;
-        }
-        if (network->getnetworkState() == NetworkState::NETWORK_STATE_ONLINE) {
+        bool isOnline = network->getnetworkState() == NetworkState::NETWORK_STATE_ONLINE;
+        if (isOnline && (!synced || millis() - lastSync >= CLOCK_SYNC_INTERVAL)) {
             lilka::serial.log("ClockService: Setting time from NTP server");
             configTzTime(MYTZ, "ua.pool.ntp.org", "pool.ntp.org");
-            // Delay for 12 hours
-            vTaskDelay(1000 * 60 * 60 * 12 / portTICK_PERIOD_MS);
-        } else {
-            vTaskDelay(1000 / portTICK_PERIOD_MS);
+            synced = true;
+            lastSync = millis();
+        }
+
+        // Sleep until next minute unless network state changes. Extra tick
+        // makes sure we wake up after the boundary, not right before it
+        struct timeval tv;
+        gettimeofday(&tv, NULL);
+        uint32_t untilMinute = (60 - tv.tv_sec % 60) * 1000 - tv.tv_usec / 1000;
+        ksystem.events.wait(events, &event, pdMS_TO_TICKS(untilMinute) + 1);
+
+        // Checked after any wakeup: network events arriving close to the boundary must not eat the tick
+        time_t now = time(NULL);
+        if (now / 60 != lastMinute) {
+            lastMinute = now / 60;
+            ksystem.events.publish(KEVENT_CLOCK_TICK, now);
         }
     }
 }
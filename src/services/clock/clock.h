@@ -5,6 +5,9 @@
 // TODO: Hardcoded timezone
 #define MYTZ PSTR("EET-2EEST,M3.5.0/3,M10.5.0/4") // Europe/Kyiv
 
+// Time is resynced from NTP this often, in ms
+#define CLOCK_SYNC_INTERVAL (12UL * 60 * 60 * 1000)
+
 class ClockService : public Service {
 public:
     ClockService();
@@ -3,6 +3,9 @@
 #include "services/network/network.h"
 
 FTPService::FTPService() : Service("ftp") {
+    addDependency("network");
+    setStartMode(SERVICE_START_LAZY);
+
     NVS_LOCK;
     Preferences prefs;
     prefs.begin(getName(), true);
@@ -13,8 +16,6 @@ FTPService::FTPService() : Service("ftp") {
     if (password.isEmpty()) {
         createPassword();
     }
-
-    lilka::fileutils.initSD();
 }
 
 FTPService::~FTPService() {
@@ -24,35 +25,52 @@ FTPService::~FTPService() {
 }
 
 void FTPService::run() {
-    // Await network service
-    while (networkService == NULL) {
-        networkService = static_cast<NetworkService*>(ksystem.services["network"]);
-        vTaskDelay(10 / portTICK_PERIOD_MS);
-    }
+    lilka::fileutils.initSD();
 
+    networkService = static_cast<NetworkService*>(ksystem.services["network"]);
+
+    KeiraEventQueue events = ksystem.events.subscribe(
+        KEVENT_MASK(KEVENT_NETWORK_STATE) | KEVENT_MASK(KEVENT_SERVICE_STATE) | KEVENT_MASK(KEVENT_SD_STATE)
+    );
+    KeiraEvent event;
+    bool sdAvailable = true;
     bool wasOnline = false;
     while (true) {
         bool isOnline = networkService->getnetworkState() == NetworkState::NETWORK_STATE_ONLINE;
-        if ((getEnabled() && isOnline) && !wasOnline) {
+        bool serve = getEnabled() && isOnline && sdAvailable;
+        if (serve && !wasOnline) {
             ftpServer = new FtpServer();
             ftpServer->begin(user.c_str(), password.c_str());
             wasOnline = true;
-        } else if ((!getEnabled() || !isOnline) && wasOnline) {
+        } else if (!serve && wasOnline) {
             ftpServer->end();
             delete ftpServer;
             ftpServer = nullptr;
             wasOnline = false;
         }
 
-        if (getEnabled() && isOnline) {
-            ftpServer->handleFTP();
-            taskYIELD();
-        } else {
-            vTaskDelay(500 / portTICK_PERIOD_MS);
+        // Sleep until something changes, or poll server as often as its state needs
+        TickType_t timeout = portMAX_DELAY;
+        if (serve) {
+            uint8_t status = ftpServer->handleFTP();
+            timeout = getPollTimeout(status);
+        }
+        if (ksystem.events.wait(events, &event, timeout) && event.type == KEVENT_SD_STATE) {
+            sdAvailable = event.value;
         }
+        if (!timeout) taskYIELD();
     }
 }
 
+TickType_t FTPService::getPollTimeout(uint8_t status) {
+    // handleFTP() returns command stage in bits 0-2 and transfer stage in bits 3-5
+    uint8_t cmdStage = status & 0x07;
+    uint8_t transferStage = (status >> 3) & 0x07;
+    if (transferStage != FTP_Close) return 0;
+    if (cmdStage <= FTP_Client) return pdMS_TO_TICKS(FTP_IDLE_POLL_INTERVAL);
+    return pdMS_TO_TICKS(FTP_CLIENT_POLL_INTERVAL);
+}
+
 String FTPService::getUser() {
     return user;
 }
@@ -5,6 +5,11 @@
 #define FTP_USER            "lilka"
 #define FTP_PASSWORD_LENGTH 6
 
+// How often server is polled while waiting for a client and while client is
+// connected, in ms. During transfers it's polled continuously
+#define FTP_IDLE_POLL_INTERVAL   50
+#define FTP_CLIENT_POLL_INTERVAL 5
+
 class FTPService : public Service {
 private:
     String user = FTP_USER;
@@ -23,4 +28,5 @@ public:
 
 private:
     void run() override;
+    TickType_t getPollTimeout(uint8_t status);
 };
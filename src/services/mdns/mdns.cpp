@@ -3,6 +3,9 @@
 #include "services/network/network.h"
 
 MDNSService::MDNSService() : Service("mdns") {
+    addDependency("network");
+    setStartMode(SERVICE_START_LAZY);
+
     NVS_LOCK;
     Preferences prefs;
     prefs.begin(getName(), true);
@@ -12,12 +15,11 @@ MDNSService::MDNSService() : Service("mdns") {
 }
 
 void MDNSService::run() {
-    // Await network service
-    while (networkService == NULL) {
-        networkService = static_cast<NetworkService*>(ksystem.services["network"]);
-        vTaskDelay(10 / portTICK_PERIOD_MS);
-    }
+    networkService = static_cast<NetworkService*>(ksystem.services["network"]);
 
+    KeiraEventQueue events =
+        ksystem.events.subscribe(KEVENT_MASK(KEVENT_NETWORK_STATE) | KEVENT_MASK(KEVENT_SERVICE_STATE));
+    KeiraEvent event;
     bool wasOnline = false;
     while (true) {
         bool isOnline = networkService->getnetworkState() == NetworkState::NETWORK_STATE_ONLINE;
@@ -30,7 +32,8 @@ void MDNSService::run() {
             wasOnline = false;
         }
 
-        vTaskDelay(500 / portTICK_PERIOD_MS);
+        // mDNS runs in its own task, nothing to do until something changes
+        ksystem.events.wait(events, &event);
     }
 }
 
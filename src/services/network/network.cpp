@@ -16,6 +16,8 @@
 // - keira.[SSID_hash]_pw - password of known network with a given SSID
 
 NetworkService::NetworkService() : Service("network") {
+    // Ready once WiFi is set up and state is known, not when thread starts
+    setManualReady();
 }
 
 void NetworkService::run() {
@@ -119,6 +121,11 @@ void NetworkService::run() {
         WiFi.disconnect(true, true);
         WiFi.mode(WIFI_OFF);
     }
+    setReady();
+
+    // Woken up when WiFi is enabled or disabled from settings
+    KeiraEventQueue events = ksystem.events.subscribe(KEVENT_MASK(KEVENT_SERVICE_STATE));
+    KeiraEvent event;
 
     while (1) {
         // Check if WiFi is deallocated
@@ -164,10 +171,30 @@ void NetworkService::run() {
             }
         }
 
-        vTaskDelay(1000 / portTICK_PERIOD_MS);
+        // Signal strength is polled only while WiFi is enabled
+        ksystem.events.wait(events, &event, enabled ? pdMS_TO_TICKS(1000) : portMAX_DELAY);
     }
 }
 
+void NetworkService::setnetworkState(NetworkState networkState) {
+    KMTX_LOCK(mtxNetwork);
+    bool changed = this->networkState != networkState;
+    this->networkState = networkState;
+    KMTX_UNLOCK(mtxNetwork);
+
+    if (changed) ksystem.events.publish(KEVENT_NETWORK_STATE, networkState);
+}
+
+void NetworkService::setsignalStrength(int8_t signalStrength) {
+    KMTX_LOCK(mtxNetwork);
+    bool changed = this->signalStrength != signalStrength;
+    this->signalStrength = signalStrength;
+    auto state = networkState;
+    KMTX_UNLOCK(mtxNetwork);
+
+    if (changed) ksystem.events.publish(KEVENT_NETWORK_STATE, state);
+}
+
 void NetworkService::autoConnect() {
     WiFi.mode(WIFI_STA);
 
@@ -30,9 +30,10 @@ private:
     void run() override;
     void autoConnect();
 
-    KMTX_SETER(NetworkState, networkState, mtxNetwork);
+    // Publish KEVENT_NETWORK_STATE when value changes
+    void setnetworkState(NetworkState networkState);
+    void setsignalStrength(int8_t signalStrength);
     KMTX_SETER(int, disconnectReason, mtxNetwork);
-    KMTX_SETER(int8_t, signalStrength, mtxNetwork);
     KMTX_SETER(String, lastPassword, mtxNetwork);
     KMTX_SETER(String, ipAddr, mtxNetwork);
 
@@ -0,0 +1,298 @@
+#include "pngwriter.h"
+
+// Deflate length and distance codes (RFC 1951, 3.2.5)
+static const uint16_t png_length_base[29] = {3,  4,  5,  6,  7,  8,  9,  10, 11,  13,  15,  17,  19,  23, 27,
+                                             31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+static const uint8_t png_length_extra[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2,
+                                             2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+static const uint16_t png_distance_base[30] = {1,    2,    3,    4,    5,    7,     9,     13,    17,  25,
+                                               33,   49,   65,   97,   129,  193,   257,   385,   513, 769,
+                                               1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+static const uint8_t png_distance_extra[30] = {0, 0, 0, 0, 1, 1, 2, 2,  3,  3,  4,  4,  5,  5,  6,
+                                               6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+#define PNG_MIN_MATCH 3
+#define PNG_MAX_MATCH 258
+
+static uint32_t png_crc32(uint32_t crc, const uint8_t* data, uint32_t size) {
+    // Half-byte table, small enough to not bother with PROGMEM
+    static const uint32_t table[16] = {
+        0x00000000, 0x1db71064, 0x3b6e20c8, 0x26d930ac, 0x76dc4190, 0x6b6b51f4, 0x4db26158, 0x5005713c,
+        0xedb88320, 0xf00f9344, 0xd6d6a3e8, 0xcb61b38c, 0x9b64c2b0, 0x86d3d2d4, 0xa00ae278, 0xbdbdf21c,
+    };
+    crc = ~crc;
+    for (uint32_t i = 0; i < size; i++) {
+        crc ^= data[i];
+        crc = (crc >> 4) ^ table[crc & 0x0F];
+        crc = (crc >> 4) ^ table[crc & 0x0F];
+    }
+    return ~crc;
+}
+
+static void png_put32(uint8_t* dest, uint32_t value) {
+    dest[0] = value >> 24;
+    dest[1] = value >> 16;
+    dest[2] = value >> 8;
+    dest[3] = value;
+}
+
+PNGWriter::PNGWriter(File* file, uint16_t width, uint16_t height) :
+    file(file),
+    width(width),
+    height(height),
+    rowBytes(width * 3),
+    failed(false),
+    rowIndex(0),
+    streamLength(0),
+    adlerA(1),
+    adlerB(0),
+    bitBuffer(0),
+    bitCount(0),
+    chunkLength(0) {
+    raw[0] = new uint8_t[rowBytes]();
+    raw[1] = new uint8_t[rowBytes]();
+    filtered = new uint8_t[(rowBytes + 1) * 2];
+    candidate = new uint8_t[rowBytes];
+}
+
+PNGWriter::~PNGWriter() {
+    delete[] raw[0];
+    delete[] raw[1];
+    delete[] filtered;
+    delete[] candidate;
+}
+
+bool PNGWriter::writeChunk(const char* type, const uint8_t* data, uint32_t size) {
+    uint8_t head[8];
+    uint8_t crc[4];
+    png_put32(head, size);
+    memcpy(head + 4, type, 4);
+    png_put32(crc, png_crc32(png_crc32(0, head + 4, 4), data, size));
+    if (file->write(head, 8) != 8 || file->write(data, size) != size || file->write(crc, 4) != 4) {
+        failed = true;
+    }
+    return !failed;
+}
+
+bool PNGWriter::flushChunk() {
+    if (!chunkLength) {
+        return !failed;
+    }
+    png_put32(chunk, chunkLength);
+    memcpy(chunk + 4, "IDAT", 4);
+    png_put32(chunk + 8 + chunkLength, png_crc32(0, chunk + 4, chunkLength + 4));
+    uint32_t size = 8 + chunkLength + 4;
+    if (!failed && file->write(chunk, size) != size) {
+        failed = true;
+    }
+    chunkLength = 0;
+    return !failed;
+}
+
+void PNGWriter::writeBits(uint32_t bits, uint8_t count) {
+    bitBuffer |= bits << bitCount;
+    bitCount += count;
+    while (bitCount >= 8) {
+        chunk[8 + chunkLength++] = bitBuffer;
+        bitBuffer >>= 8;
+        bitCount -= 8;
+        if (chunkLength == PNG_WRITER_CHUNK_SIZE) {
+            flushChunk();
+        }
+    }
+}
+
+void PNGWriter::writeHuffman(uint32_t code, uint8_t length) {
+    // Huffman codes are packed starting from the most significant bit
+    uint32_t reversed = 0;
+    for (uint8_t i = 0; i < length; i++) {
+        reversed = (reversed << 1) | ((code >> i) & 1);
+    }
+    writeBits(reversed, length);
+}
+
+// Fixed literal/length code (RFC 1951, 3.2.6)
+static void png_fixed_code(uint16_t symbol, uint32_t* code, uint8_t* length) {
+    if (symbol < 144) {
+        *code = 0x30 + symbol;
+        *length = 8;
+    } else if (symbol < 256) {
+        *code = 0x190 + symbol - 144;
+        *length = 9;
+    } else if (symbol < 280) {
+        *code = symbol - 256;
+        *length = 7;
+    } else {
+        *code = 0xC0 + symbol - 280;
+        *length = 8;
+    }
+}
+
+void PNGWriter::writeLiteral(uint8_t value) {
+    uint32_t code;
+    uint8_t length;
+    png_fixed_code(value, &code, &length);
+    writeHuffman(code, length);
+}
+
+void PNGWriter::writeMatch(uint16_t length, uint16_t distance) {
+    uint8_t lengthCode = 28;
+    while (png_length_base[lengthCode] > length) {
+        lengthCode--;
+    }
+    uint32_t code;
+    uint8_t codeLength;
+    png_fixed_code(257 + lengthCode, &code, &codeLength);
+    writeHuffman(code, codeLength);
+    writeBits(length - png_length_base[lengthCode], png_length_extra[lengthCode]);
+
+    uint8_t distanceCode = 29;
+    while (png_distance_base[distanceCode] > distance) {
+        distanceCode--;
+    }
+    writeHuffman(distanceCode, 5);
+    writeBits(distance - png_distance_base[distanceCode], png_distance_extra[distanceCode]);
+}
+
+bool PNGWriter::begin() {
+    static const uint8_t signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    if (file->write(signature, sizeof(signature)) != sizeof(signature)) {
+        failed = true;
+        return false;
+    }
+
+    uint8_t header[13];
+    png_put32(header, width);
+    png_put32(header + 4, height);
+    header[8] = 8; // Bit depth
+    header[9] = 2; // Truecolor
+    header[10] = 0; // Deflate
+    header[11] = 0; // Adaptive filtering
+    header[12] = 0; // No interlace
+    if (!writeChunk("IHDR", header, sizeof(header))) {
+        return false;
+    }
+
+    // zlib header (32K window, no dictionary), then the only deflate block: final, fixed Huffman codes
+    writeBits(0x78, 8);
+    writeBits(0x01, 8);
+    writeBits(1, 1);
+    writeBits(1, 2);
+    return !failed;
+}
+
+void PNGWriter::filterRow(const uint8_t* row, const uint8_t* prevRow) {
+    uint8_t* dest = filtered + rowBytes + 1;
+    uint32_t bestScore = UINT32_MAX;
+    for (uint8_t filter = 0; filter <= 2; filter++) {
+        uint32_t score = 0;
+        for (uint32_t i = 0; i < rowBytes; i++) {
+            uint8_t value = row[i];
+            if (filter == 1) {
+                value -= i >= 3 ? row[i - 3] : 0;
+            } else if (filter == 2) {
+                value -= prevRow[i];
+            }
+            candidate[i] = value;
+            // Sum of absolute values as signed bytes, the usual heuristic
+            score += value < 128 ? value : 256 - value;
+        }
+        if (score < bestScore) {
+            bestScore = score;
+            dest[0] = filter;
+            memcpy(dest + 1, candidate, rowBytes);
+        }
+    }
+}
+
+void PNGWriter::compressRow() {
+    const uint32_t stride = rowBytes + 1;
+    const uint8_t* data = filtered;
+    // Stream offset of the current row, matches can't reach further back
+    const uint32_t history = streamLength < stride ? streamLength : stride;
+    const uint16_t distances[3] = {1, 3, static_cast<uint16_t>(stride)};
+
+    uint32_t pos = stride;
+    while (pos < stride * 2) {
+        uint32_t maxLength = stride * 2 - pos;
+        if (maxLength > PNG_MAX_MATCH) {
+            maxLength = PNG_MAX_MATCH;
+        }
+        uint32_t bestLength = 0;
+        uint16_t bestDistance = 0;
+        for (uint16_t distance : distances) {
+            if (distance > pos - stride + history) {
+                continue;
+            }
+            uint32_t length = 0;
+            while (length < maxLength && data[pos + length] == data[pos + length - distance]) {
+                length++;
+            }
+            if (length > bestLength) {
+                bestLength = length;
+                bestDistance = distance;
+            }
+        }
+        if (bestLength >= PNG_MIN_MATCH) {
+            writeMatch(bestLength, bestDistance);
+            pos += bestLength;
+        } else {
+            writeLiteral(data[pos]);
+            pos++;
+        }
+    }
+
+    // Adler-32 of uncompressed stream, reduced at least every 5552 bytes so sums don't overflow
+    const uint8_t* row = data + stride;
+    for (uint32_t done = 0; done < stride;) {
+        uint32_t step = stride - done < 5552 ? stride - done : 5552;
+        for (uint32_t i = 0; i < step; i++) {
+            adlerA += row[done + i];
+            adlerB += adlerA;
+        }
+        adlerA %= 65521;
+        adlerB %= 65521;
+        done += step;
+    }
+
+    streamLength += stride;
+    memcpy(filtered, filtered + stride, stride);
+}
+
+bool PNGWriter::writeRow(const uint16_t* row) {
+    if (failed || rowIndex >= height) {
+        return false;
+    }
+    uint8_t* current = raw[rowIndex & 1];
+    const uint8_t* previous = raw[(rowIndex & 1) ^ 1];
+    for (uint16_t x = 0; x < width; x++) {
+        uint16_t rgb565 = row[x];
+        current[x * 3 + 0] = (rgb565 >> 11 & 0x1F) * 255 / 31;
+        current[x * 3 + 1] = (rgb565 >> 5 & 0x3F) * 255 / 63;
+        current[x * 3 + 2] = (rgb565 & 0x1F) * 255 / 31;
+    }
+    filterRow(current, previous);
+    compressRow();
+    rowIndex++;
+    return !failed;
+}
+
+bool PNGWriter::end() {
+    if (failed || rowIndex != height) {
+        return false;
+    }
+    // End of block, then Adler-32 starts at byte boundary
+    writeHuffman(0, 7);
+    if (bitCount) {
+        writeBits(0, 8 - bitCount);
+    }
+    uint8_t adler[4];
+    png_put32(adler, (adlerB << 16) | adlerA);
+    for (uint8_t i = 0; i < 4; i++) {
+        writeBits(adler[i], 8);
+    }
+    if (!flushChunk()) {
+        return false;
+    }
+    return writeChunk("IEND", NULL, 0);
+}
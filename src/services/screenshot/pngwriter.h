@@ -0,0 +1,58 @@
+#pragma once
+
+#include <lilka.h>
+
+// IDAT chunk payload size. Chunk header, payload and CRC are written to the file with a single write
+#define PNG_WRITER_CHUNK_SIZE 4096
+
+// Writes RGB565 image as 24-bit PNG row by row, without keeping the whole image in memory.
+// Each row gets the cheapest of None/Sub/Up filters and is compressed with deflate using fixed
+// Huffman codes. Matches are only searched at a few distances (same byte, previous pixel,
+// pixel above), which catches flat areas and repeated rows that make up most of UI screens.
+// Working set is two rows and one output chunk.
+class PNGWriter {
+public:
+    PNGWriter(File* file, uint16_t width, uint16_t height);
+    ~PNGWriter();
+
+    // Writes signature and header
+    bool begin();
+    // Rows must be written top to bottom, height times
+    bool writeRow(const uint16_t* row);
+    // Finishes compressed stream and writes IEND
+    bool end();
+
+private:
+    void filterRow(const uint8_t* raw, const uint8_t* prevRaw);
+    void compressRow();
+    void writeBits(uint32_t bits, uint8_t count);
+    void writeHuffman(uint32_t code, uint8_t length);
+    void writeLiteral(uint8_t value);
+    void writeMatch(uint16_t length, uint16_t distance);
+    bool flushChunk();
+    bool writeChunk(const char* type, const uint8_t* data, uint32_t size);
+
+    File* file;
+    uint16_t width;
+    uint16_t height;
+    uint32_t rowBytes;
+    bool failed;
+
+    // Unfiltered RGB of current and previous rows
+    uint8_t* raw[2];
+    // Filtered rows as they go into deflate stream: previous and current, each with filter type byte
+    uint8_t* filtered;
+    // Scratch for choosing filter
+    uint8_t* candidate;
+    uint16_t rowIndex;
+    // Bytes of uncompressed stream so far, matches can't reach before its start
+    uint32_t streamLength;
+    uint32_t adlerA;
+    uint32_t adlerB;
+
+    uint32_t bitBuffer;
+    uint8_t bitCount;
+    // Chunk length and type, PNG_WRITER_CHUNK_SIZE bytes of data and room for CRC
+    uint8_t chunk[8 + PNG_WRITER_CHUNK_SIZE + 4];
+    uint32_t chunkLength;
+};
@@ -0,0 +1,167 @@
+#include "recorder.h"
+#include "keira/utils/mem.h"
+
+// Op count that fits into op byte
+#define SCREEN_RECORDER_SHORT_COUNT 63
+#define SCREEN_RECORDER_MAX_COUNT   65535
+// Fill is used for runs of at least this many pixels of the same color
+#define SCREEN_RECORDER_MIN_FILL 3
+
+ScreenRecorder::ScreenRecorder() :
+    width(0),
+    height(0),
+    recording(false),
+    failed(false),
+    frameCount(0),
+    bytesWritten(0),
+    previous(NULL),
+    block(NULL),
+    blockLength(0) {
+}
+
+ScreenRecorder::~ScreenRecorder() {
+    end();
+}
+
+bool ScreenRecorder::isRecording() {
+    return recording;
+}
+
+uint32_t ScreenRecorder::getFrameCount() {
+    return frameCount;
+}
+
+bool ScreenRecorder::begin(String filename, uint16_t width, uint16_t height, uint16_t frameInterval) {
+    if (recording) {
+        return false;
+    }
+    this->width = width;
+    this->height = height;
+    previous = static_cast<uint16_t*>(spiRamAllocator.allocate(width * height * sizeof(uint16_t)));
+    block = static_cast<uint8_t*>(malloc(SCREEN_RECORDER_BLOCK_SIZE));
+    file = SD.open(filename, FILE_WRITE, true);
+    if (!previous || !block || !file) {
+        lilka::serial.err("Failed to start screen recording to %s", filename.c_str());
+        if (file) {
+            file.close();
+        }
+        spiRamAllocator.deallocate(previous);
+        free(block);
+        previous = NULL;
+        block = NULL;
+        return false;
+    }
+    memset(previous, 0, width * height * sizeof(uint16_t));
+
+    recording = true;
+    failed = false;
+    frameCount = 0;
+    bytesWritten = 0;
+    blockLength = 0;
+
+    for (const char* c = SCREEN_RECORDER_MAGIC; *c; c++) {
+        writeByte(*c);
+    }
+    writeByte(SCREEN_RECORDER_VERSION);
+    writeByte(0);
+    writeWord(width);
+    writeWord(height);
+    writeWord(frameInterval);
+    lilka::serial.log("Screen recording started: %s", filename.c_str());
+    return true;
+}
+
+bool ScreenRecorder::flush() {
+    if (blockLength && !failed) {
+        if (file.write(block, blockLength) != blockLength) {
+            failed = true;
+        }
+        bytesWritten += blockLength;
+    }
+    blockLength = 0;
+    return !failed;
+}
+
+void ScreenRecorder::writeByte(uint8_t value) {
+    block[blockLength++] = value;
+    if (blockLength == SCREEN_RECORDER_BLOCK_SIZE) {
+        flush();
+    }
+}
+
+void ScreenRecorder::writeWord(uint16_t value) {
+    writeByte(value & 0xFF);
+    writeByte(value >> 8);
+}
+
+void ScreenRecorder::writeOp(screen_recorder_op_t op, uint32_t count) {
+    if (count <= SCREEN_RECORDER_SHORT_COUNT) {
+        writeByte(op << 6 | count);
+    } else {
+        writeByte(op << 6);
+        writeWord(count);
+    }
+}
+
+bool ScreenRecorder::writeFrame(const uint16_t* framebuffer, uint32_t timestamp) {
+    if (!recording || failed) {
+        return false;
+    }
+    writeWord(timestamp & 0xFFFF);
+    writeWord(timestamp >> 16);
+
+    const uint32_t pixelCount = width * height;
+    uint32_t i = 0;
+    while (i < pixelCount) {
+        uint32_t limit = pixelCount - i < SCREEN_RECORDER_MAX_COUNT ? pixelCount - i : SCREEN_RECORDER_MAX_COUNT;
+        const uint16_t* current = framebuffer + i;
+        uint16_t* last = previous + i;
+        uint32_t count = 1;
+
+        if (current[0] == last[0]) {
+            while (count < limit && current[count] == last[count]) {
+                count++;
+            }
+            writeOp(SCREEN_RECORDER_OP_SKIP, count);
+        } else {
+            while (count < limit && current[count] == current[0]) {
+                count++;
+            }
+            if (count >= SCREEN_RECORDER_MIN_FILL) {
+                writeOp(SCREEN_RECORDER_OP_FILL, count);
+                writeWord(current[0]);
+            } else {
+                // Copy changed pixels until an unchanged one or a run worth filling
+                count = 1;
+                while (count < limit && current[count] != last[count] &&
+                       !(count + 2 < limit && current[count] == current[count + 1] &&
+                         current[count] == current[count + 2])) {
+                    count++;
+                }
+                writeOp(SCREEN_RECORDER_OP_COPY, count);
+                for (uint32_t j = 0; j < count; j++) {
+                    writeWord(current[j]);
+                }
+            }
+            memcpy(last, current, count * sizeof(uint16_t));
+        }
+        i += count;
+    }
+    frameCount++;
+    return !failed;
+}
+
+bool ScreenRecorder::end() {
+    if (!recording) {
+        return false;
+    }
+    flush();
+    file.close();
+    spiRamAllocator.deallocate(previous);
+    free(block);
+    previous = NULL;
+    block = NULL;
+    recording = false;
+    lilka::serial.log("Screen recording stopped: %d frames, %d bytes", frameCount, bytesWritten);
+    return !failed;
+}
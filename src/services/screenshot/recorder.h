@@ -0,0 +1,56 @@
+#pragma once
+
+#include <lilka.h>
+
+#define SCREEN_RECORDER_MAGIC   "KREC"
+#define SCREEN_RECORDER_VERSION 1
+// Encoded frame data is collected into blocks of this size before writing to SD
+#define SCREEN_RECORDER_BLOCK_SIZE 8192
+
+// Stream layout (little-endian), converted to GIF by tools/krec2gif.py:
+//   header: "KREC", uint8 version, uint8 reserved, uint16 width, uint16 height, uint16 frame interval (ms)
+//   frame:  uint32 timestamp (ms since start), then ops until width * height pixels are covered.
+// Op byte: 2 high bits are type, 6 low bits are pixel count (0 means uint16 count follows):
+//   0 - skip: pixels are the same as in previous frame
+//   1 - fill: one uint16 RGB565 color follows, repeated count times
+//   2 - copy: count uint16 RGB565 pixels follow
+// Before the first frame, previous frame is black.
+typedef enum {
+    SCREEN_RECORDER_OP_SKIP = 0,
+    SCREEN_RECORDER_OP_FILL = 1,
+    SCREEN_RECORDER_OP_COPY = 2,
+} screen_recorder_op_t;
+
+// Writes frames as difference from the previous one, so static parts of the screen cost nothing
+// and frames can be captured while the app keeps running at its normal rate.
+class ScreenRecorder {
+public:
+    ScreenRecorder();
+    ~ScreenRecorder();
+
+    bool begin(String filename, uint16_t width, uint16_t height, uint16_t frameInterval);
+    bool writeFrame(const uint16_t* framebuffer, uint32_t timestamp);
+    // Closes file. Returns false if any write has failed
+    bool end();
+
+    bool isRecording();
+    uint32_t getFrameCount();
+
+private:
+    void writeOp(screen_recorder_op_t op, uint32_t count);
+    void writeByte(uint8_t value);
+    void writeWord(uint16_t value);
+    bool flush();
+
+    uint16_t width;
+    uint16_t height;
+    File file;
+    bool recording;
+    bool failed;
+    uint32_t frameCount;
+    uint32_t bytesWritten;
+    // Previous frame, in PSRAM
+    uint16_t* previous;
+    uint8_t* block;
+    uint32_t blockLength;
+};
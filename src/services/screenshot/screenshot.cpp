@@ -1,6 +1,5 @@
-#include <contrib/LodePNG/lodepng.h>
-
 #include "services/screenshot/screenshot.h"
+#include "services/screenshot/pngwriter.h"
 #include "keira/appmanager.h"
 #include "services/clock/clock.h"
 #include "keira/ksystem.h"
@@ -11,6 +10,12 @@
 #    define KEIRA_SCREENSHOT_PNG
 #endif
 
+#ifndef KEIRA_SCREEN_RECORDING_FPS
+#    define KEIRA_SCREEN_RECORDING_FPS 10
+#endif
+// Holding SELECT+START for this long starts recording instead of taking a screenshot
+#define KEIRA_SCREEN_RECORDING_HOLD_TIME 1000
+
 #ifdef KEIRA_SCREENSHOT_BMP
 class BMPEncoder {
 public:
@@ -94,9 +99,11 @@ private:
 };
 #endif
 
-ScreenshotService::ScreenshotService() : Service("screenshot") {
+ScreenshotService::ScreenshotService() : Service("screenshot"), recordingStart(0), nextFrameTime(0) {
     setktStackSize(8192);
     setktPriority(KT_PRIO_DEFAULT);
+    // Clock is used to name files
+    addDependency("clock");
 }
 
 bool ScreenshotService::saveScreenshot(lilka::Canvas* canvas) {
@@ -114,40 +121,36 @@ bool ScreenshotService::saveScreenshot(lilka::Canvas* canvas) {
     return false;
 
 #elif defined(KEIRA_SCREENSHOT_PNG)
-    int16_t width = canvas->width();
-    int16_t height = canvas->height();
-
-    uint8_t* image = new uint8_t[width * height * 4];
-    std::unique_ptr<uint8_t[]> imagePtr(image);
-    for (int y = 0; y < height; ++y) {
-        for (int x = 0; x < width; ++x) {
-            const uint16_t* framebufferLine = canvas->getFramebuffer() + y * canvas->width();
-            uint16_t rgb565 = framebufferLine[x];
-            image[4 * width * y + 4 * x + 0] = (rgb565 >> 11 & 0x1F) * 255 / 31;
-            image[4 * width * y + 4 * x + 1] = (rgb565 >> 5 & 0x3F) * 255 / 63;
-            image[4 * width * y + 4 * x + 2] = (rgb565 & 0x1F) * 255 / 31;
-            image[4 * width * y + 4 * x + 3] = 255;
-        }
+    // Rows are encoded straight from canvas, so only a few KB are needed besides it
+    String filename = getFilename("screenshot", "png");
+    File file = SD.open(filename, FILE_WRITE, true);
+    if (!file) {
+        return false;
     }
-    std::vector<uint8_t> compressedImage;
-    if (!lodepng::encode(compressedImage, image, width, height)) {
-        return writeScreenshot(compressedImage.data(), compressedImage.size(), "png");
+    std::unique_ptr<PNGWriter> writer(new PNGWriter(&file, canvas->width(), canvas->height()));
+    bool ok = writer->begin();
+    for (int16_t y = 0; y < canvas->height() && ok; y++) {
+        ok = writer->writeRow(canvas->getFramebuffer() + y * canvas->width());
     }
-
-    return false;
+    ok = ok && writer->end();
+    file.close();
+    if (!ok) {
+        SD.remove(filename);
+    }
+    return ok;
 #else
 #    error "Either KEIRA_SCREENSHOT_BMP or KEIRA_SCREENSHOT_PNG must be defined"
 #endif
 }
 
-bool ScreenshotService::writeScreenshot(uint8_t* buffer, uint32_t length, const char* ext) {
-    // Generate filename
+String ScreenshotService::getFilename(const char* prefix, const char* ext) {
     struct tm time = reinterpret_cast<ClockService*>(ksystem.services["clock"])->getTime();
     char filename[64];
     snprintf(
         filename,
         sizeof(filename),
-        "/screenshots/screenshot_%04d%02d%02d_%02d%02d%02d.%s",
+        "/screenshots/%s_%04d%02d%02d_%02d%02d%02d.%s",
+        prefix,
         time.tm_year + 1900,
         time.tm_mon + 1,
         time.tm_mday,
@@ -157,8 +160,11 @@ bool ScreenshotService::writeScreenshot(uint8_t* buffer, uint32_t length, const
         ext
     );
     lilka::serial.log("Screenshot filename: %s", filename);
+    return filename;
+}
 
-    File file = SD.open(filename, FILE_WRITE, true);
+bool ScreenshotService::writeScreenshot(uint8_t* buffer, uint32_t length, const char* ext) {
+    File file = SD.open(getFilename("screenshot", ext), FILE_WRITE, true);
     if (file) {
         size_t bytes = file.write(buffer, length);
         file.close();
@@ -167,25 +173,94 @@ bool ScreenshotService::writeScreenshot(uint8_t* buffer, uint32_t length, const
     return false;
 }
 
+void ScreenshotService::startRecording(lilka::Canvas* canvas) {
+    recordingStart = millis();
+    nextFrameTime = recordingStart;
+    if (recorder.begin(
+            getFilename("recording", "krec"), canvas->width(), canvas->height(), 1000 / KEIRA_SCREEN_RECORDING_FPS
+        )) {
+        ksystem.apps.startToast(K_S_SCREEN_RECORDING_STARTED);
+    } else {
+        ksystem.apps.startToast(K_S_SCREEN_RECORDING_ERROR);
+    }
+}
+
+void ScreenshotService::stopRecording() {
+    if (recorder.end()) {
+        ksystem.apps.startToast(K_S_SCREEN_RECORDING_SAVED);
+    } else {
+        ksystem.apps.startToast(K_S_SCREEN_RECORDING_ERROR);
+    }
+}
+
+void ScreenshotService::recordFrame(lilka::Canvas* canvas) {
+    uint32_t now = millis();
+    if (static_cast<int32_t>(now - nextFrameTime) < 0) {
+        return;
+    }
+    ksystem.apps.renderToCanvas(canvas);
+    if (!recorder.writeFrame(canvas->getFramebuffer(), now - recordingStart)) {
+        stopRecording();
+        return;
+    }
+    nextFrameTime += 1000 / KEIRA_SCREEN_RECORDING_FPS;
+    if (static_cast<int32_t>(now - nextFrameTime) >= 0) {
+        // SD card fell behind, skip missed frames instead of capturing them back to back
+        nextFrameTime = now + 1000 / KEIRA_SCREEN_RECORDING_FPS;
+    }
+}
+
 void ScreenshotService::run() {
     bool activated = false;
+    bool longPress = false;
+    uint32_t pressTime = 0;
     lilka::Canvas canvas(lilka::display.width(), lilka::display.height());
+    // Combo changes are published by app manager, nothing to do until then
+    KeiraEventQueue events = ksystem.events.subscribe(KEVENT_MASK(KEVENT_BUTTON_COMBO));
+    KeiraEvent event;
     while (1) {
-        lilka::State state = lilka::controller.peekState();
-        if (state.select.pressed && state.start.pressed && !activated) {
-            activated = true;
+        TickType_t timeout = portMAX_DELAY;
+        if (recorder.isRecording()) {
+            recordFrame(&canvas);
+            int32_t wait = nextFrameTime - millis();
+            timeout = pdMS_TO_TICKS(wait > 0 ? wait : 0);
+        }
+        if (activated && !longPress) {
+            // Wake up when combo is held long enough to start recording
+            int32_t hold = KEIRA_SCREEN_RECORDING_HOLD_TIME - (millis() - pressTime);
+            TickType_t holdTimeout = pdMS_TO_TICKS(hold > 0 ? hold : 0);
+            if (holdTimeout < timeout) timeout = holdTimeout;
+        }
 
-            // Take screenshot
-            ksystem.apps.renderToCanvas(&canvas);
+        bool combo = activated;
+        if (ksystem.events.wait(events, &event, timeout)) {
+            combo = event.value & KEIRA_COMBO_SELECT_START;
+        }
 
-            if (saveScreenshot(&canvas)) {
-                ksystem.apps.startToast(K_S_SCREENSHOT_SAVED);
-            } else {
-                ksystem.apps.startToast(K_S_SCREENSHOT_SAVE_ERROR);
+        if (combo && !activated) {
+            activated = true;
+            pressTime = millis();
+            longPress = false;
+            if (recorder.isRecording()) {
+                // Any press stops recording
+                longPress = true;
+                stopRecording();
             }
-        } else if (!state.select.pressed || !state.start.pressed) {
+        } else if (combo && !longPress && millis() - pressTime >= KEIRA_SCREEN_RECORDING_HOLD_TIME) {
+            longPress = true;
+            startRecording(&canvas);
+        } else if (!combo && activated) {
             activated = false;
+            if (!longPress) {
+                // Take screenshot
+                ksystem.apps.renderToCanvas(&canvas);
+
+                if (saveScreenshot(&canvas)) {
+                    ksystem.apps.startToast(K_S_SCREENSHOT_SAVED);
+                } else {
+                    ksystem.apps.startToast(K_S_SCREENSHOT_SAVE_ERROR);
+                }
+            }
         }
-        vTaskDelay(100 / portTICK_PERIOD_MS);
     }
 }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "keira/service.h"
+#include "services/screenshot/recorder.h"
 
 class ScreenshotService : public Service {
 public:
@@ -10,4 +11,14 @@ private:
     void run() override;
     bool saveScreenshot(lilka::Canvas* canvas);
     bool writeScreenshot(uint8_t* buffer, uint32_t length, const char* ext);
+    String getFilename(const char* prefix, const char* ext);
+
+    void startRecording(lilka::Canvas* canvas);
+    void stopRecording();
+    // Captures frame if it's time for the next one
+    void recordFrame(lilka::Canvas* canvas);
+
+    ScreenRecorder recorder;
+    uint32_t recordingStart;
+    uint32_t nextFrameTime;
 };
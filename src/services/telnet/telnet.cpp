@@ -9,6 +9,7 @@ ESPTelnet* telnet = NULL;
 EscapeCodes ansi;
 
 TelnetService::TelnetService() : Service("telnet") {
+    addDependency("network");
 }
 
 TelnetService::~TelnetService() {
@@ -32,6 +33,8 @@ Command commands[] = {
             telnet->println("  reboot             - перезавантажити пристрій");
             telnet->println("  uptime             - показати час роботи пристрою");
             telnet->println("  free               - показати стан пам'яті");
+            telnet->println("  perf               - показати завантаження CPU і час кадрів програм (p50/p95/p99, мкс)");
+            telnet->println("  boot               - показати хронологію завантаження (мкс)");
             telnet->println("  ls [DIR]           - показати список файлів на SD-картці");
             telnet->println("  find [TEXT]        - знайти файли на SD-картці, які містять TEXT в назві");
             telnet->println("  nvs get [NS] [KEY] - отримати значення ключа з NVS");
@@ -61,6 +64,38 @@ Command commands[] = {
             );
         },
     },
+    {
+        "perf",
+        [](std::vector<String> args) {
+            for (auto& report : ksystem.apps.getPerfReports()) {
+                telnet->printf(
+                    "%s: CPU %u%%, кадрів %u, пропущено %u",
+                    report.name,
+                    report.busyPercent,
+                    report.frames,
+                    report.droppedFrames
+                );
+                telnet->println();
+                for (int type = 0; type < FRAME_STAT_COUNT; type++) {
+                    const FrameStatPercentiles& stat = report.stats[type];
+                    telnet->printf("  %-6s %8u %8u %8u", FRAME_STAT_TYPE_ACSTR[type], stat.p50, stat.p95, stat.p99);
+                    telnet->println();
+                }
+            }
+        },
+    },
+    {
+        "boot",
+        [](std::vector<String> args) {
+            int64_t previous = 0;
+            telnet->println("   від старту  від попер.  етап");
+            for (auto& stage : ksystem.timeline.getStages()) {
+                telnet->printf("%12lld %11lld  %s", stage.time, stage.time - previous, stage.name);
+                telnet->println();
+                previous = stage.time;
+            }
+        },
+    },
     {
         "ls",
         [](std::vector<String> args) {
@@ -315,14 +350,11 @@ void TelnetService::setupEventHandlers() {
 }
 
 void TelnetService::run() {
-    NetworkService* network = NULL;
-
-    // Await network service
-    while (network == NULL) {
-        network = static_cast<NetworkService*>(ksystem.services["network"]);
-        vTaskDelay(10 / portTICK_PERIOD_MS);
-    }
+    NetworkService* network = static_cast<NetworkService*>(ksystem.services["network"]);
 
+    KeiraEventQueue events =
+        ksystem.events.subscribe(KEVENT_MASK(KEVENT_NETWORK_STATE) | KEVENT_MASK(KEVENT_SERVICE_STATE));
+    KeiraEvent event;
     bool wasOnline = false;
     while (1) {
         bool isOnline = network->getnetworkState() == NetworkState::NETWORK_STATE_ONLINE;
@@ -339,11 +371,12 @@ void TelnetService::run() {
             delete telnet;
             telnet = NULL;
         }
-        if (getEnabled() && isOnline) {
+        // Sleep until something changes, server is polled only while it runs
+        TickType_t timeout = portMAX_DELAY;
+        if (wasOnline) {
             telnet->loop();
-            taskYIELD();
-        } else {
-            vTaskDelay(500 / portTICK_PERIOD_MS);
+            timeout = pdMS_TO_TICKS(telnet->isConnected() ? TELNET_CLIENT_POLL_INTERVAL : TELNET_IDLE_POLL_INTERVAL);
         }
+        ksystem.events.wait(events, &event, timeout);
     }
 }
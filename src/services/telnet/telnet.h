@@ -4,6 +4,10 @@
 #include "services/network/network.h"
 #include "keira/service.h"
 
+// How often server is polled while waiting for a client and while client is connected, in ms
+#define TELNET_IDLE_POLL_INTERVAL   50
+#define TELNET_CLIENT_POLL_INTERVAL 10
+
 class TelnetService : public Service {
 public:
     TelnetService();
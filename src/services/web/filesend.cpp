@@ -0,0 +1,140 @@
+#include "filesend.h"
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+
+void webMakeETag(char* etag, size_t size, size_t fileSize, time_t mtime) {
+    snprintf(
+        etag, size, "\"%lx-%llx\"", static_cast<unsigned long>(fileSize), static_cast<unsigned long long>(mtime)
+    );
+}
+
+bool webParseRange(const char* header, size_t fileSize, size_t* start, size_t* end, bool* isRange) {
+    *isRange = false;
+    if (strncmp(header, "bytes=", 6) != 0 || strchr(header, ',')) {
+        return true;
+    }
+    const char* spec = header + 6;
+    char* endptr;
+    if (*spec == '-') {
+        unsigned long long suffix = strtoull(spec + 1, &endptr, 10);
+        if (endptr == spec + 1 || *endptr) return true;
+        if (!suffix || !fileSize) return false;
+        *start = suffix < fileSize ? fileSize - suffix : 0;
+        *end = fileSize - 1;
+    } else {
+        unsigned long long first = strtoull(spec, &endptr, 10);
+        if (endptr == spec || *endptr != '-') return true;
+        const char* lastSpec = endptr + 1;
+        unsigned long long last = fileSize - 1;
+        if (*lastSpec) {
+            last = strtoull(lastSpec, &endptr, 10);
+            if (endptr == lastSpec || *endptr) return true;
+        }
+        if (first >= fileSize || last < first) return false;
+        *start = first;
+        *end = std::min<unsigned long long>(last, fileSize - 1);
+    }
+    *isRange = true;
+    return true;
+}
+
+WebFileReply webResolveFileReply(
+    const char* ifNoneMatch, const char* ifRange, const char* range, const char* etag, size_t fileSize, size_t* start,
+    size_t* end
+) {
+    if (ifNoneMatch && (strstr(ifNoneMatch, etag) || strcmp(ifNoneMatch, "*") == 0)) {
+        return WEB_FILE_NOT_MODIFIED;
+    }
+    *start = 0;
+    *end = fileSize ? fileSize - 1 : 0;
+    // Range is ignored if file was changed since client got the first part of it
+    if (!range || (ifRange && strcmp(ifRange, etag) != 0)) {
+        return WEB_FILE_FULL;
+    }
+    bool isRange;
+    if (!webParseRange(range, fileSize, start, end, &isRange)) {
+        return WEB_FILE_UNSATISFIABLE;
+    }
+    return isRange ? WEB_FILE_PARTIAL : WEB_FILE_FULL;
+}
+
+// Second buffer is filled from file by reader task while the first one is sent
+typedef struct {
+    char* data;
+    size_t size;
+} WebFileChunk;
+
+typedef struct {
+    FILE* file;
+    size_t remaining;
+    WebFileChunk chunks[2];
+    // Free queue has room for an extra NULL, which stops the reader
+    QueueHandle_t freeChunks;
+    QueueHandle_t filledChunks;
+    SemaphoreHandle_t done;
+} WebFileReader;
+
+static void webFileReaderTask(void* arg) {
+    WebFileReader* reader = static_cast<WebFileReader*>(arg);
+    WebFileChunk* chunk;
+    while (reader->remaining && xQueueReceive(reader->freeChunks, &chunk, portMAX_DELAY) == pdTRUE && chunk) {
+        chunk->size = fread(chunk->data, 1, std::min<size_t>(reader->remaining, WEB_BUFFER_FILE_STREAM), reader->file);
+        // Empty chunk tells sender that file couldn't be read
+        reader->remaining = chunk->size ? reader->remaining - chunk->size : 0;
+        xQueueSend(reader->filledChunks, &chunk, portMAX_DELAY);
+    }
+    xSemaphoreGive(reader->done);
+    vTaskDelete(NULL);
+}
+
+bool webSendFileBody(FILE* file, size_t length, WebSendFunc send, void* context) {
+    if (length <= WEB_BUFFER_FILE_STREAM) {
+        char* buf = static_cast<char*>(malloc(std::max<size_t>(length, 1)));
+        bool ok = buf && fread(buf, 1, length, file) == length && send(context, buf, length);
+        free(buf);
+        return ok;
+    }
+
+    WebFileReader reader = {};
+    reader.file = file;
+    reader.remaining = length;
+    reader.freeChunks = xQueueCreate(3, sizeof(WebFileChunk*));
+    reader.filledChunks = xQueueCreate(2, sizeof(WebFileChunk*));
+    reader.done = xSemaphoreCreateBinary();
+    bool ok = reader.freeChunks && reader.filledChunks && reader.done;
+    for (int i = 0; i < 2 && ok; i++) {
+        reader.chunks[i].data = static_cast<char*>(malloc(WEB_BUFFER_FILE_STREAM));
+        ok = reader.chunks[i].data != NULL;
+        WebFileChunk* chunk = &reader.chunks[i];
+        xQueueSend(reader.freeChunks, &chunk, 0);
+    }
+    bool started = ok && xTaskCreate(webFileReaderTask, "webFileReader", 4096, &reader, 1, NULL) == pdPASS;
+    ok = started;
+
+    size_t sent = 0;
+    while (ok && sent < length) {
+        WebFileChunk* chunk;
+        xQueueReceive(reader.filledChunks, &chunk, portMAX_DELAY);
+        ok = chunk->size && send(context, chunk->data, chunk->size);
+        sent += chunk->size;
+        xQueueSend(reader.freeChunks, &chunk, portMAX_DELAY);
+    }
+
+    if (started) {
+        WebFileChunk* stop = NULL;
+        xQueueSend(reader.freeChunks, &stop, 0);
+        xSemaphoreTake(reader.done, portMAX_DELAY);
+    }
+    for (int i = 0; i < 2; i++) {
+        free(reader.chunks[i].data);
+    }
+    if (reader.freeChunks) vQueueDelete(reader.freeChunks);
+    if (reader.filledChunks) vQueueDelete(reader.filledChunks);
+    if (reader.done) vSemaphoreDelete(reader.done);
+    return ok;
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdio.h>
+#include <time.h>
+
+// Size of each of two buffers used to stream files, larger files are read by a separate task
+#define WEB_BUFFER_FILE_STREAM 16384
+// Quoted size and mtime in hex, with terminating zero
+#define WEB_ETAG_SIZE 40
+
+typedef enum {
+    WEB_FILE_FULL,
+    WEB_FILE_PARTIAL,
+    WEB_FILE_NOT_MODIFIED,
+    WEB_FILE_UNSATISFIABLE,
+} WebFileReply;
+
+// Writes strong ETag of a file. Size and modification time are enough to tell whether file was changed
+void webMakeETag(char* etag, size_t size, size_t fileSize, time_t mtime);
+
+// Parses single "bytes=start-end", "bytes=start-" or "bytes=-suffix" range. Multiple ranges are not supported,
+// in which case whole file is sent. Returns false if range can't be satisfied
+bool webParseRange(const char* header, size_t fileSize, size_t* start, size_t* end, bool* isRange);
+
+// Decides how to answer a download from its conditional and Range headers, NULL for missing ones.
+// Byte range to send is stored in start and end (inclusive) for full and partial replies
+WebFileReply webResolveFileReply(
+    const char* ifNoneMatch, const char* ifRange, const char* range, const char* etag, size_t fileSize, size_t* start,
+    size_t* end
+);
+
+// Sends data to client, returns false if connection is lost
+typedef bool (*WebSendFunc)(void* context, const char* data, size_t size);
+
+// Sends length bytes of file from current position. Files larger than one buffer are read by a separate task,
+// so SD card reads overlap socket sends
+bool webSendFileBody(FILE* file, size_t length, WebSendFunc send, void* context);
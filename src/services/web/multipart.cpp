@@ -0,0 +1,263 @@
+#include "multipart.h"
+#include <string.h>
+#include <strings.h>
+
+MultipartParser::MultipartParser(const char* boundary, MultipartListener* listener) :
+    listener(listener),
+    state(STATE_PREAMBLE),
+    delimiterLength(0),
+    lookbehindLength(0),
+    delimiterEndLength(0),
+    headerLineLength(0),
+    headerLineOverflow(false) {
+    size_t boundaryLength = strlen(boundary);
+    if (!boundaryLength || boundaryLength > MULTIPART_MAX_BOUNDARY) {
+        state = STATE_FAILED;
+        return;
+    }
+    memcpy(delimiter, "\r\n--", 4);
+    memcpy(delimiter + 4, boundary, boundaryLength);
+    delimiterLength = boundaryLength + 4;
+    delimiter[delimiterLength] = 0;
+
+    for (int i = 0; i < 256; i++) {
+        skip[i] = delimiterLength;
+    }
+    for (size_t i = 0; i < delimiterLength - 1; i++) {
+        skip[static_cast<uint8_t>(delimiter[i])] = delimiterLength - 1 - i;
+    }
+
+    // First delimiter may come right at the start of body, without CRLF before it
+    memcpy(lookbehind, "\r\n", 2);
+    lookbehindLength = 2;
+    name[0] = 0;
+    filename[0] = 0;
+}
+
+bool MultipartParser::isFinished() const {
+    return state == STATE_EPILOGUE;
+}
+
+bool MultipartParser::isFailed() const {
+    return state == STATE_FAILED;
+}
+
+size_t MultipartParser::find(const char* data, size_t size) const {
+    const size_t last = delimiterLength - 1;
+    size_t pos = 0;
+    while (pos + delimiterLength <= size) {
+        uint8_t c = data[pos + last];
+        if (c == static_cast<uint8_t>(delimiter[last]) && memcmp(data + pos, delimiter, last) == 0) {
+            return pos;
+        }
+        pos += skip[c];
+    }
+    return size;
+}
+
+bool MultipartParser::emit(const char* data, size_t size, bool emitData) {
+    if (!emitData || !size || listener->onPartData(data, size)) {
+        return true;
+    }
+    state = STATE_FAILED;
+    return false;
+}
+
+size_t MultipartParser::scan(const char* data, size_t size, bool emitData, bool* found) {
+    *found = false;
+
+    if (lookbehindLength) {
+        // Delimiter that starts in lookbehind ends within first (delimiterLength - 1) bytes of data
+        char join[MULTIPART_MAX_DELIMITER * 2];
+        size_t head = size < delimiterLength - 1 ? size : delimiterLength - 1;
+        memcpy(join, lookbehind, lookbehindLength);
+        memcpy(join + lookbehindLength, data, head);
+        size_t joinLength = lookbehindLength + head;
+        size_t pos = find(join, joinLength);
+        if (pos < joinLength) {
+            size_t consumed = pos + delimiterLength - lookbehindLength;
+            lookbehindLength = 0;
+            *found = true;
+            return emit(join, pos, emitData) ? consumed : 0;
+        }
+        if (head < delimiterLength - 1) {
+            // Whole chunk is in join, keep its tail for the next one
+            size_t keep = joinLength < delimiterLength - 1 ? joinLength : delimiterLength - 1;
+            if (!emit(join, joinLength - keep, emitData)) {
+                return 0;
+            }
+            memcpy(lookbehind, join + joinLength - keep, keep);
+            lookbehindLength = keep;
+            return size;
+        }
+        if (!emit(lookbehind, lookbehindLength, emitData)) {
+            return 0;
+        }
+        lookbehindLength = 0;
+    }
+
+    size_t pos = find(data, size);
+    if (pos < size) {
+        *found = true;
+        return emit(data, pos, emitData) ? pos + delimiterLength : 0;
+    }
+    size_t keep = size < delimiterLength - 1 ? size : delimiterLength - 1;
+    if (!emit(data, size - keep, emitData)) {
+        return 0;
+    }
+    memcpy(lookbehind, data + size - keep, keep);
+    lookbehindLength = keep;
+    return size;
+}
+
+// Copies value of parameter key (e.g. name="file") from header line into value
+static bool multipart_get_param(const char* line, const char* key, char* value, size_t size) {
+    size_t keyLength = strlen(key);
+    const char* p = strchr(line, ';');
+    while (p) {
+        p++;
+        while (*p == ' ' || *p == '\t') p++;
+        if (strncasecmp(p, key, keyLength) == 0 && p[keyLength] == '=') {
+            p += keyLength + 1;
+            const char* end;
+            if (*p == '"') {
+                p++;
+                end = strchr(p, '"');
+                if (!end) return false;
+            } else {
+                end = p + strcspn(p, "; \t");
+            }
+            size_t length = end - p;
+            if (length >= size) return false;
+            memcpy(value, p, length);
+            value[length] = 0;
+            return true;
+        }
+        p = strchr(p, ';');
+    }
+    return false;
+}
+
+void MultipartParser::parseHeaderLine() {
+    headerLine[headerLineLength] = 0;
+    if (strncasecmp(headerLine, "Content-Disposition:", 20) == 0) {
+        if (!multipart_get_param(headerLine, "name", name, sizeof(name))) {
+            name[0] = 0;
+        }
+        if (!multipart_get_param(headerLine, "filename", filename, sizeof(filename))) {
+            filename[0] = 0;
+        }
+    }
+}
+
+bool MultipartParser::feed(const char* data, size_t size) {
+    while (size && state != STATE_FAILED && state != STATE_EPILOGUE) {
+        switch (state) {
+            case STATE_PREAMBLE:
+            case STATE_BODY: {
+                bool found;
+                bool inBody = state == STATE_BODY;
+                size_t consumed = scan(data, size, inBody, &found);
+                if (state == STATE_FAILED) {
+                    return false;
+                }
+                data += consumed;
+                size -= consumed;
+                if (found) {
+                    if (inBody && !listener->onPartEnd()) {
+                        state = STATE_FAILED;
+                        return false;
+                    }
+                    state = STATE_DELIMITER_END;
+                    delimiterEndLength = 0;
+                }
+                break;
+            }
+            case STATE_DELIMITER_END:
+                // Transport padding after delimiter is allowed
+                if (!delimiterEndLength && (*data == ' ' || *data == '\t')) {
+                    data++;
+                    size--;
+                    break;
+                }
+                delimiterEnd[delimiterEndLength++] = *data++;
+                size--;
+                if (delimiterEndLength == 2) {
+                    if (memcmp(delimiterEnd, "--", 2) == 0) {
+                        state = STATE_EPILOGUE;
+                    } else if (memcmp(delimiterEnd, "\r\n", 2) == 0) {
+                        state = STATE_HEADERS;
+                        headerLineLength = 0;
+                        headerLineOverflow = false;
+                        name[0] = 0;
+                        filename[0] = 0;
+                    } else {
+                        state = STATE_FAILED;
+                    }
+                }
+                break;
+            case STATE_HEADERS: {
+                char c = *data++;
+                size--;
+                if (c != '\n') {
+                    if (headerLineLength < MULTIPART_MAX_HEADER_LINE - 1) {
+                        headerLine[headerLineLength++] = c;
+                    } else {
+                        headerLineOverflow = true;
+                    }
+                    break;
+                }
+                if (headerLineLength && headerLine[headerLineLength - 1] == '\r') {
+                    headerLineLength--;
+                }
+                if (!headerLineLength && !headerLineOverflow) {
+                    // Empty line ends headers
+                    if (!listener->onPartBegin(name, filename)) {
+                        state = STATE_FAILED;
+                        return false;
+                    }
+                    state = STATE_BODY;
+                    lookbehindLength = 0;
+                } else if (!headerLineOverflow) {
+                    parseHeaderLine();
+                }
+                headerLineLength = 0;
+                headerLineOverflow = false;
+                break;
+            }
+            default:
+                break;
+        }
+    }
+    return state != STATE_FAILED;
+}
+
+bool MultipartParser::getBoundary(const char* contentType, char* boundary, size_t size) {
+    const char* p = contentType;
+    while ((p = strchr(p, ';'))) {
+        p++;
+        while (*p == ' ' || *p == '\t') p++;
+        if (strncasecmp(p, "boundary=", 9) == 0) {
+            break;
+        }
+    }
+    if (!p) {
+        return false;
+    }
+    p += 9;
+    size_t length;
+    if (*p == '"') {
+        p++;
+        const char* end = strchr(p, '"');
+        if (!end) return false;
+        length = end - p;
+    } else {
+        length = strcspn(p, "; \t");
+    }
+    if (!length || length > MULTIPART_MAX_BOUNDARY || length >= size) {
+        return false;
+    }
+    memcpy(boundary, p, length);
+    boundary[length] = 0;
+    return true;
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// RFC 2046 limits boundary to 70 characters
+#define MULTIPART_MAX_BOUNDARY    70
+// Delimiter is CRLF, "--" and boundary
+#define MULTIPART_MAX_DELIMITER   (MULTIPART_MAX_BOUNDARY + 4)
+#define MULTIPART_MAX_HEADER_LINE 512
+#define MULTIPART_MAX_FIELD       256
+
+class MultipartListener {
+public:
+    virtual ~MultipartListener() {
+    }
+    // Called for every part. Filename is empty for regular form fields
+    virtual bool onPartBegin(const char* name, const char* filename) = 0;
+    virtual bool onPartData(const char* data, size_t size) = 0;
+    virtual bool onPartEnd() = 0;
+};
+
+// Incremental multipart/form-data parser. Body can be fed in chunks of any size, delimiters split
+// between chunks are handled. Part data is passed to listener straight from fed chunks, except for
+// the few bytes that might be the beginning of a delimiter, which are held until next chunk.
+// Delimiter is searched with Boyer-Moore-Horspool, so most of the data is skipped without comparing.
+class MultipartParser {
+public:
+    MultipartParser(const char* boundary, MultipartListener* listener);
+
+    // Returns false on malformed input or if listener returned false, parser stops then
+    bool feed(const char* data, size_t size);
+    // Closing delimiter was found
+    bool isFinished() const;
+    bool isFailed() const;
+
+    // Extracts boundary from Content-Type header value. Returns false if there's none or it's too long
+    static bool getBoundary(const char* contentType, char* boundary, size_t size);
+
+private:
+    typedef enum {
+        STATE_PREAMBLE,
+        STATE_DELIMITER_END,
+        STATE_HEADERS,
+        STATE_BODY,
+        STATE_EPILOGUE,
+        STATE_FAILED,
+    } state_t;
+
+    // Returns offset of first delimiter in data, or size if there's none
+    size_t find(const char* data, size_t size) const;
+    // Searches delimiter in data, passing preceding bytes to emit(). Returns number of consumed bytes,
+    // which include delimiter if it was found
+    size_t scan(const char* data, size_t size, bool emitData, bool* found);
+    bool emit(const char* data, size_t size, bool emitData);
+    void parseHeaderLine();
+
+    MultipartListener* listener;
+    state_t state;
+
+    char delimiter[MULTIPART_MAX_DELIMITER + 1];
+    size_t delimiterLength;
+    // Boyer-Moore-Horspool bad character table
+    uint8_t skip[256];
+
+    // Tail of previous chunk that might be a beginning of delimiter
+    char lookbehind[MULTIPART_MAX_DELIMITER];
+    size_t lookbehindLength;
+
+    // Bytes of "--" or CRLF after delimiter
+    char delimiterEnd[2];
+    size_t delimiterEndLength;
+
+    char headerLine[MULTIPART_MAX_HEADER_LINE];
+    size_t headerLineLength;
+    bool headerLineOverflow;
+    char name[MULTIPART_MAX_FIELD];
+    char filename[MULTIPART_MAX_FIELD];
+};
@@ -1,4 +1,7 @@
+#include <algorithm>
 #include "web.h"
+#include "multipart.h"
+#include "filesend.h"
 #include "esp_http_server.h"
 #include "keira/ksystem.h"
 
@@ -800,7 +803,8 @@ static const char* getFileIcon(const char* name, bool isDir) {
     return "&#128196;";
 }
 
-static const char* getMimeType(const String& filename) {
+// Fallback is returned for unknown extensions
+static const char* getMimeType(const String& filename, const char* fallback = "text/plain") {
     String lower = filename;
     lower.toLowerCase();
     if (lower.endsWith(".jpg") || lower.endsWith(".jpeg")) return "image/jpeg";
@@ -822,7 +826,17 @@ static const char* getMimeType(const String& filename) {
     if (lower.endsWith(".html") || lower.endsWith(".htm")) return "text/html";
     if (lower.endsWith(".css")) return "text/css";
     if (lower.endsWith(".js")) return "application/javascript";
-    return "text/plain";
+    if (lower.endsWith(".svg")) return "image/svg+xml";
+    if (lower.endsWith(".ico")) return "image/x-icon";
+    if (lower.endsWith(".m4a")) return "audio/mp4";
+    if (lower.endsWith(".aac")) return "audio/aac";
+    if (lower.endsWith(".mid") || lower.endsWith(".midi")) return "audio/midi";
+    if (lower.endsWith(".txt") || lower.endsWith(".lua") || lower.endsWith(".md") || lower.endsWith(".ini") ||
+        lower.endsWith(".log"))
+        return "text/plain; charset=UTF-8";
+    if (lower.endsWith(".csv")) return "text/csv";
+    if (lower.endsWith(".zip")) return "application/zip";
+    return fallback;
 }
 
 static esp_err_t replyWithDirectory(httpd_req_t* req, DIR* dir, const String& query, bool sdCardSelected) {
@@ -943,42 +957,119 @@ static esp_err_t replyWithDirectory(httpd_req_t* req, DIR* dir, const String& qu
     return ESP_OK;
 }
 
-static esp_err_t replyWithFile(httpd_req_t* req, const String& path) {
-    esp_err_t err = ESP_OK;
-    String fileNameHeader;
+// httpd_send() may send only a part of the buffer
+static bool webSendAll(httpd_req_t* req, const char* data, size_t size) {
+    while (size) {
+        int sent = httpd_send(req, data, size);
+        if (sent < 0) {
+            return false;
+        }
+        data += sent;
+        size -= sent;
+    }
+    return true;
+}
 
-    auto file = fopen(path.c_str(), "r");
+static bool webSendToClient(void* context, const char* data, size_t size) {
+    return webSendAll(static_cast<httpd_req_t*>(context), data, size);
+}
+
+// Returns true if header is present, value is truncated to fit into buf
+static bool getHeader(httpd_req_t* req, const char* name, char* buf, size_t size) {
+    esp_err_t err = httpd_req_get_hdr_value_str(req, name, buf, size);
+    return err == ESP_OK || err == ESP_ERR_HTTPD_RESULT_TRUNC;
+}
+
+static esp_err_t replyWithFile(httpd_req_t* req, const String& path) {
+    struct stat statbuf;
+    FILE* file = NULL;
+    if (stat(path.c_str(), &statbuf) == 0) {
+        file = fopen(path.c_str(), "r");
+    }
     if (file == NULL) {
         httpd_resp_send_404(req);
         return ESP_OK;
     }
-
-    for (auto scanForName = path.end(); scanForName > path.begin(); scanForName--) {
-        if (*scanForName == '/' || *scanForName == '\\') {
-            scanForName++;
-            fileNameHeader = "attachment; filename=\"";
-            fileNameHeader += scanForName;
-            fileNameHeader += "\"";
-            err = httpd_resp_set_hdr(req, "Content-Disposition", fileNameHeader.c_str());
-            break;
-        }
+    size_t fileSize = statbuf.st_size;
+
+    char etag[WEB_ETAG_SIZE];
+    webMakeETag(etag, sizeof(etag), fileSize, statbuf.st_mtime);
+
+    // Longer If-Range can't match anyway
+    char ifNoneMatch[128], ifRange[WEB_ETAG_SIZE], range[128];
+    size_t start, end;
+    WebFileReply reply = webResolveFileReply(
+        getHeader(req, "If-None-Match", ifNoneMatch, sizeof(ifNoneMatch)) ? ifNoneMatch : NULL,
+        getHeader(req, "If-Range", ifRange, sizeof(ifRange)) ? ifRange : NULL,
+        getHeader(req, "Range", range, sizeof(range)) ? range : NULL,
+        etag,
+        fileSize,
+        &start,
+        &end
+    );
+    char header[128];
+    if (reply == WEB_FILE_NOT_MODIFIED) {
+        fclose(file);
+        httpd_resp_set_status(req, "304 Not Modified");
+        httpd_resp_set_hdr(req, "ETag", etag);
+        return httpd_resp_send(req, NULL, 0);
+    }
+    if (reply == WEB_FILE_UNSATISFIABLE) {
+        fclose(file);
+        snprintf(header, sizeof(header), "bytes */%lu", static_cast<unsigned long>(fileSize));
+        httpd_resp_set_status(req, "416 Range Not Satisfiable");
+        httpd_resp_set_hdr(req, "Content-Range", header);
+        return httpd_resp_send(req, NULL, 0);
+    }
+    bool isRange = reply == WEB_FILE_PARTIAL;
+    size_t length = fileSize ? end - start + 1 : 0;
+    if (isRange && fseek(file, start, SEEK_SET) != 0) {
+        fclose(file);
+        return httpd_resp_send_500(req);
     }
 
-    if (err == ESP_OK) {
-        char* fileBuf = static_cast<char*>(malloc(WEB_BUFFER_FS_OP));
-        err = httpd_resp_set_type(req, "application/octet-stream");
-        if (err == ESP_OK) {
-            size_t readBytes;
-            do {
-                readBytes = fread(fileBuf, 1, WEB_BUFFER_FS_OP, file);
-                err = httpd_resp_send_chunk(req, fileBuf, readBytes);
-                if (err != ESP_OK) break;
-            } while (readBytes > 0);
-        }
-        free(fileBuf);
+    String fileName = path;
+    int lastSlash = std::max(fileName.lastIndexOf('/'), fileName.lastIndexOf('\\'));
+    if (lastSlash >= 0) fileName = fileName.substring(lastSlash + 1);
+
+    // httpd_resp_* always uses chunked encoding, while players need Content-Length to seek,
+    // so response head is written by hand
+    String head = isRange ? "HTTP/1.1 206 Partial Content\r\n" : "HTTP/1.1 200 OK\r\n";
+    head += "Content-Type: ";
+    head += getMimeType(fileName, "application/octet-stream");
+    head += "\r\nContent-Length: ";
+    head += String(static_cast<unsigned long>(length));
+    if (isRange) {
+        snprintf(
+            header,
+            sizeof(header),
+            "\r\nContent-Range: bytes %lu-%lu/%lu",
+            static_cast<unsigned long>(start),
+            static_cast<unsigned long>(end),
+            static_cast<unsigned long>(fileSize)
+        );
+        head += header;
     }
+    head += "\r\nAccept-Ranges: bytes\r\nETag: ";
+    head += etag;
+    head += "\r\nCache-Control: no-cache\r\nContent-Disposition: attachment; filename=\"";
+    head += fileName;
+    head += "\"\r\n\r\n";
+
+    uint32_t startTime = millis();
+    bool ok = webSendAll(req, head.c_str(), head.length()) && webSendFileBody(file, length, webSendToClient, req);
     fclose(file);
-    return err;
+
+    uint32_t elapsedMs = millis() - startTime;
+    lilka::serial.log(
+        "Sent %s (%u bytes) in %u ms, %u KB/s%s",
+        fileName.c_str(),
+        static_cast<unsigned>(length),
+        static_cast<unsigned>(elapsedMs),
+        static_cast<unsigned>(elapsedMs ? length / elapsedMs : 0),
+        ok ? "" : ", aborted"
+    );
+    return ok ? ESP_OK : ESP_FAIL;
 }
 
 static esp_err_t download_handler(httpd_req_t* req) {
@@ -1079,22 +1170,170 @@ static esp_err_t upload_handler(httpd_req_t* req) {
     return res;
 }
 
-static String extractFilename(const char* buf, int len) {
-    const char* filenameStart = strnstr(buf, "filename=\"", len);
-    if (filenameStart) {
-        filenameStart += 10;
-        const char* filenameEnd = strchr(filenameStart, '"');
-        if (filenameEnd) return String(filenameStart, filenameEnd - filenameStart);
+// Saves file parts of multipart form. Writes are coalesced into a large buffer, so the card gets
+// whole-cluster writes at cluster-aligned offsets instead of whatever each recv returned
+class WebUploadListener : public MultipartListener {
+public:
+    // Files are saved into folder, or the first one into fixedPath if it's set (others are ignored then)
+    WebUploadListener(const String& folder, const String& fixedPath) :
+        folder(folder), fixedPath(fixedPath), buffer(NULL), buffered(0), file(NULL), fileCount(0) {
+        buffer = static_cast<char*>(malloc(WEB_BUFFER_UPLOAD_WRITE));
     }
-    return "uploaded_file.bin";
-}
 
-static String extractBoundary(const char* buf, int len) {
-    const char* boundaryStart = buf;
-    if (!boundaryStart) return "";
-    const char* boundaryEnd = strnstr(boundaryStart, "\r\n", len);
-    if (!boundaryEnd) return "";
-    return String(boundaryStart, boundaryEnd - boundaryStart);
+    ~WebUploadListener() {
+        // Incomplete file is removed
+        if (file) {
+            fclose(file);
+            remove(path.c_str());
+        }
+        free(buffer);
+    }
+
+    bool onPartBegin(const char* name, const char* filename) override {
+        if (!filename[0] || (fixedPath.length() && fileCount)) {
+            // Regular form field or extra file
+            return true;
+        }
+        if (fixedPath.length()) {
+            path = fixedPath;
+        } else {
+            // Some browsers send full client path
+            String basename = filename;
+            int lastSlash = std::max(basename.lastIndexOf('/'), basename.lastIndexOf('\\'));
+            if (lastSlash >= 0) basename = basename.substring(lastSlash + 1);
+            if (!basename.length() || basename == "." || basename == "..") {
+                lastError = "Invalid file name";
+                return false;
+            }
+            path = lilka::fileutils.joinPath(folder, basename);
+        }
+        lilka::serial.log("Uploading file: %s", path.c_str());
+        file = fopen(path.c_str(), "wb");
+        if (!file) {
+            lastError = "Failed to create file on SD card";
+            return false;
+        }
+        // Buffering is done here, stdio would only split and copy large writes
+        setvbuf(file, NULL, _IONBF, 0);
+        fileCount++;
+        buffered = 0;
+        return true;
+    }
+
+    bool onPartData(const char* data, size_t size) override {
+        if (!file) {
+            return true;
+        }
+        while (size) {
+            size_t n = std::min(size, WEB_BUFFER_UPLOAD_WRITE - buffered);
+            memcpy(buffer + buffered, data, n);
+            buffered += n;
+            data += n;
+            size -= n;
+            if (buffered == WEB_BUFFER_UPLOAD_WRITE && !flush()) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool onPartEnd() override {
+        if (!file) {
+            return true;
+        }
+        bool ok = flush();
+        ok = fclose(file) == 0 && ok;
+        file = NULL;
+        if (!ok) {
+            lastError = "Failed to write file";
+            remove(path.c_str());
+        }
+        return ok;
+    }
+
+    bool isValid() const {
+        return buffer != NULL;
+    }
+
+    int getFileCount() const {
+        return fileCount;
+    }
+
+    String lastError;
+
+private:
+    bool flush() {
+        if (buffered && fwrite(buffer, 1, buffered, file) != buffered) {
+            lastError = "Failed to write file";
+            return false;
+        }
+        buffered = 0;
+        return true;
+    }
+
+    String folder;
+    String fixedPath;
+    String path;
+    char* buffer;
+    size_t buffered;
+    FILE* file;
+    int fileCount;
+};
+
+// Feeds request body to multipart parser. Returns false and sets lastError if upload failed
+static bool receiveMultipart(httpd_req_t* req, WebUploadListener* listener, String* lastError) {
+    char contentType[128];
+    char boundary[MULTIPART_MAX_BOUNDARY + 1];
+    if (httpd_req_get_hdr_value_str(req, "Content-Type", contentType, sizeof(contentType)) != ESP_OK ||
+        !MultipartParser::getBoundary(contentType, boundary, sizeof(boundary))) {
+        *lastError = "Expected multipart/form-data";
+        return false;
+    }
+    if (!listener->isValid()) {
+        *lastError = "Memory allocation failed";
+        return false;
+    }
+    char* buf = static_cast<char*>(malloc(WEB_BUFFER_FS_OP));
+    if (!buf) {
+        *lastError = "Memory allocation failed";
+        return false;
+    }
+
+    MultipartParser parser(boundary, listener);
+    uint32_t startTime = millis();
+    size_t received = 0;
+    bool ok = true;
+    while (ok) {
+        int len = httpd_req_recv(req, buf, WEB_BUFFER_FS_OP);
+        if (len == HTTPD_SOCK_ERR_TIMEOUT) {
+            continue;
+        }
+        if (len < 0) {
+            *lastError = "Failed to receive file";
+            ok = false;
+        } else if (len == 0) {
+            break;
+        } else if (!parser.feed(buf, len)) {
+            *lastError = listener->lastError.length() ? listener->lastError : "Malformed multipart data";
+            ok = false;
+        }
+        received += len > 0 ? len : 0;
+    }
+    free(buf);
+
+    if (ok && !parser.isFinished()) {
+        *lastError = "Upload is incomplete";
+        ok = false;
+    }
+    uint32_t elapsedMs = millis() - startTime;
+    lilka::serial.log(
+        "Received %d file(s), %u bytes in %u ms, %u KB/s",
+        listener->getFileCount(),
+        static_cast<unsigned>(received),
+        static_cast<unsigned>(elapsedMs),
+        static_cast<unsigned>(elapsedMs ? received / elapsedMs : 0)
+    );
+    return ok;
 }
 
 static esp_err_t sd_upload_handler(httpd_req_t* req) {
@@ -1125,79 +1364,14 @@ static esp_err_t sd_upload_handler(httpd_req_t* req) {
         return httpd_resp_sendstr(req, sdCardSelected ? "SD card not available" : "SPIFFS not available");
     }
 
-    char* buf = static_cast<char*>(malloc(WEB_BUFFER_FS_OP));
-    if (!buf) {
-        httpd_resp_set_status(req, HTTPD_500);
-        return httpd_resp_sendstr(req, "Memory allocation failed");
+    String folder = targetFolder.length() > 0 ? lilka::fileutils.joinPath(root, targetFolder) : root;
+    bool ok;
+    {
+        WebUploadListener listener(folder, "");
+        ok = receiveMultipart(req, &listener, &lastError);
     }
 
-    FILE* file = NULL;
-    bool seekBinary = true;
-    String filename;
-    String boundary;
-    esp_err_t err = ESP_OK;
-    int len = 0;
-
-    do {
-        len = httpd_req_recv(req, buf, WEB_BUFFER_FS_OP);
-        if (len < 0) {
-            lastError = "Failed to receive file";
-            err = ESP_FAIL;
-            break;
-        }
-
-        // Pointer to actual data we write
-        const char* data = buf;
-
-        // Parse form data and open file
-        if (seekBinary) {
-            filename = extractFilename(buf, len);
-
-            // idf already skipped headers correctly and now we care about form data
-            // still cause boundary exists at begining of form data we can extract it
-            boundary = extractBoundary(buf, len);
-            // lilka::serial.log("Found boundary: %s", boundary.c_str());
-            // needed step to correctly match ending of file
-            boundary = "\r\n" + boundary;
-
-            lilka::serial.log("Uploading file: %s to folder: %s", filename.c_str(), targetFolder.c_str());
-            String fullPath = targetFolder.length() > 0 ? lilka::fileutils.joinPath(targetFolder, filename) : filename;
-            String filePath = lilka::fileutils.joinPath(root, fullPath);
-            lilka::serial.log("Full file path: %s", filePath.c_str());
-            file = fopen(filePath.c_str(), "wb");
-            if (!file) {
-                lilka::serial.log("Failed to create file: %s", filePath.c_str());
-                lastError = "Failed to create file on SD card";
-                err = ESP_FAIL;
-                break;
-            }
-
-            auto beforeBinary = strnstr(buf, fileHeaderDivider, len);
-            if (beforeBinary) {
-                data = beforeBinary + 4;
-                len -= (data - buf);
-            }
-            seekBinary = false;
-        }
-
-        // Write file
-        if (len > 0 && file) {
-            const char* endMarker = static_cast<char*>(memmem(data, len, boundary.c_str(), boundary.length()));
-            if (endMarker) {
-                size_t toWrite = endMarker - data;
-                if (toWrite > 0) fwrite(data, 1, toWrite, file);
-                len = 0;
-            } else {
-                fwrite(data, 1, len, file);
-            }
-        }
-    } while (len > 0);
-
-    if (file) fclose(file);
-
-    free(buf);
-
-    if (err == ESP_OK) {
+    if (ok) {
         res = httpd_resp_sendstr(req, "OK");
     } else {
         httpd_resp_set_status(req, HTTPD_500);
@@ -1221,49 +1395,18 @@ static esp_err_t multiboot_upload_handler(httpd_req_t* req) {
         return httpd_resp_sendstr(req, "SD card not available");
     }
 
-    char* buf = static_cast<char*>(malloc(WEB_BUFFER_FS_OP));
-    if (!buf) {
-        httpd_resp_set_status(req, HTTPD_500);
-        return httpd_resp_sendstr(req, "Memory allocation failed");
-    }
-
     String filePath = lilka::fileutils.joinPath(sdRoot, "_web_multiboot.bin");
-    FILE* file = NULL;
-    bool seekBinary = true;
-    esp_err_t err = ESP_OK;
-
-    int len = 0;
-    do {
-        len = httpd_req_recv(req, buf, WEB_BUFFER_FS_OP);
-        if (len < 0) {
-            lastError = "Failed to receive file";
-            err = ESP_FAIL;
-            break;
+    bool ok;
+    {
+        WebUploadListener listener(sdRoot, filePath);
+        ok = receiveMultipart(req, &listener, &lastError);
+        if (ok && !listener.getFileCount()) {
+            lastError = "No file in request";
+            ok = false;
         }
+    }
 
-        if (seekBinary) {
-            file = fopen(filePath.c_str(), "wb");
-            if (!file) {
-                lastError = "Failed to create file on SD card";
-                err = ESP_FAIL;
-                break;
-            }
-
-            auto beforeBinary = strnstr(buf, fileHeaderDivider, len);
-            if (beforeBinary) {
-                const char* towrite = beforeBinary + 4;
-                len -= (towrite - buf);
-                if (len > 0) fwrite(towrite, 1, len, file);
-            }
-            seekBinary = false;
-        } else if (len > 0 && file) {
-            fwrite(buf, 1, len, file);
-        }
-    } while (len > 0);
-
-    free(buf);
-
-    if (err == ESP_OK) {
+    if (ok) {
         lilka::serial.log("Multiboot file saved, scheduling boot: %s", filePath.c_str());
         pendingMultibootPath = filePath;
         pendingMultiboot = true;
@@ -1559,6 +1702,68 @@ static esp_err_t progress_handler(httpd_req_t* req) {
     return httpd_resp_sendstr(req, progressJson);
 }
 
+// Escapes string to be put inside JSON string literal. Truncates on
+// character boundary if dst is too small
+static void jsonEscape(const char* src, char* dst, size_t size) {
+    size_t len = 0;
+    for (; *src; src++) {
+        char esc[7];
+        unsigned char c = *src;
+        if (c == '"' || c == '\\') snprintf(esc, sizeof(esc), "\\%c", c);
+        else if (c < 0x20) snprintf(esc, sizeof(esc), "\\u%04x", c);
+        else snprintf(esc, sizeof(esc), "%c", c);
+        size_t escLen = strlen(esc);
+        if (len + escLen >= size) break;
+        memcpy(dst + len, esc, escLen);
+        len += escLen;
+    }
+    dst[len] = '\0';
+}
+
+static esp_err_t perf_handler(httpd_req_t* req) {
+    char buf[256];
+    // App names are arbitrary, each char may take up to 6 when escaped
+    char name[KT_NAME_MAX * 6 + 1];
+
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_sendstr_chunk(req, "[");
+
+    bool first = true;
+    for (auto& report : ksystem.apps.getPerfReports()) {
+        jsonEscape(report.name, name, sizeof(name));
+        snprintf(
+            buf,
+            sizeof(buf),
+            "%s{\"name\":\"%s\",\"busy\":%u,\"frames\":%u,\"dropped\":%u",
+            first ? "" : ",",
+            name,
+            report.busyPercent,
+            report.frames,
+            report.droppedFrames
+        );
+        httpd_resp_sendstr_chunk(req, buf);
+        for (int type = 0; type < FRAME_STAT_COUNT; type++) {
+            const FrameStatPercentiles& stat = report.stats[type];
+            snprintf(
+                buf,
+                sizeof(buf),
+                ",\"%s\":{\"p50\":%u,\"p95\":%u,\"p99\":%u}",
+                FRAME_STAT_TYPE_ACSTR[type],
+                stat.p50,
+                stat.p95,
+                stat.p99
+            );
+            httpd_resp_sendstr_chunk(req, buf);
+        }
+        httpd_resp_sendstr_chunk(req, "}");
+        first = false;
+    }
+
+    httpd_resp_sendstr_chunk(req, "]");
+    httpd_resp_send_chunk(req, NULL, 0);
+    return ESP_OK;
+}
+
 static esp_err_t boot_handler(httpd_req_t* req) {
     bool sdCardSelected;
     String query = getQueryPath(req, &sdCardSelected);
@@ -1620,6 +1825,7 @@ static void startWebServer() {
     httpd_uri_t copy_uri = {.uri = "/copy", .method = HTTP_POST, .handler = copy_handler, .user_ctx = NULL};
     httpd_uri_t listdirs_uri = {.uri = "/listdirs", .method = HTTP_GET, .handler = listdirs_handler, .user_ctx = NULL};
     httpd_uri_t progress_uri = {.uri = "/progress", .method = HTTP_GET, .handler = progress_handler, .user_ctx = NULL};
+    httpd_uri_t perf_uri = {.uri = "/perf", .method = HTTP_GET, .handler = perf_handler, .user_ctx = NULL};
 
     lilka::serial.log("Start web service on %d", config.server_port);
     if (httpd_start(&stream_httpd, &config) == ESP_OK) {
@@ -1635,24 +1841,26 @@ static void startWebServer() {
         httpd_register_uri_handler(stream_httpd, &copy_uri);
         httpd_register_uri_handler(stream_httpd, &listdirs_uri);
         httpd_register_uri_handler(stream_httpd, &progress_uri);
+        httpd_register_uri_handler(stream_httpd, &perf_uri);
         httpd_register_uri_handler(stream_httpd, &preview_uri);
     }
 }
 
 WebService::WebService() : Service("web") {
     setktStackSize(8192);
+    addDependency("network");
+    setStartMode(SERVICE_START_LAZY);
 }
 
 WebService::~WebService() {
 }
 
 void WebService::run() {
-    // Await network service
-    while (networkService == NULL) {
-        networkService = static_cast<NetworkService*>(ksystem.services["network"]);
-        vTaskDelay(10 / portTICK_PERIOD_MS);
-    }
+    networkService = static_cast<NetworkService*>(ksystem.services["network"]);
 
+    KeiraEventQueue events =
+        ksystem.events.subscribe(KEVENT_MASK(KEVENT_NETWORK_STATE) | KEVENT_MASK(KEVENT_SERVICE_STATE));
+    KeiraEvent event;
     bool wasOnline = false;
 
     while (true) {
@@ -1728,11 +1936,6 @@ void WebService::run() {
             );
         }
 
-        if (!networkService) {
-            vTaskDelay(1000 / portTICK_PERIOD_MS);
-            continue;
-        }
-
         bool isOnline = networkService->getnetworkState() == NetworkState::NETWORK_STATE_ONLINE;
 
         if (getEnabled() && isOnline && !wasOnline) {
@@ -1743,6 +1946,8 @@ void WebService::run() {
             stopWebServer();
         }
 
-        vTaskDelay(500 / portTICK_PERIOD_MS);
+        // Server runs in its own task. While it's up, restart and multiboot
+        // requested by its handlers are picked up here
+        ksystem.events.wait(events, &event, wasOnline ? pdMS_TO_TICKS(WEB_PENDING_POLL_INTERVAL) : portMAX_DELAY);
     }
 }
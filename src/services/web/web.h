@@ -5,6 +5,10 @@
 
 #define WEB_BUFFER_FS_OP    4096
 #define WEB_BUFFER_FLASH_OP 4096
+// Uploads are written in blocks of this size, which is a multiple of FAT cluster size
+#define WEB_BUFFER_UPLOAD_WRITE 32768
+// How often requested restart/multiboot is checked while server runs, in ms
+#define WEB_PENDING_POLL_INTERVAL 500
 
 class WebService : public Service {
 public:
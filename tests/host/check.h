@@ -0,0 +1,27 @@
+#pragma once
+//////////////////////////////////////////////////////////////////////////////
+// Minimal checks for host unit tests. Failed check is reported, test keeps
+// going, and checkResult() turns failures into process exit code.
+//////////////////////////////////////////////////////////////////////////////
+#include <stdio.h>
+
+static int checkFailures = 0;
+
+static inline bool checkImpl(bool ok, const char* file, int line, const char* expr) {
+    if (!ok) {
+        fprintf(stderr, "%s:%d: check failed: %s\n", file, line, expr);
+        checkFailures++;
+    }
+    return ok;
+}
+
+#define CHECK(COND) checkImpl((COND), __FILE__, __LINE__, #COND)
+
+static inline int checkResult(const char* name) {
+    if (checkFailures) {
+        fprintf(stderr, "%s: %d check(s) failed\n", name, checkFailures);
+        return 1;
+    }
+    printf("%s: ok\n", name);
+    return 0;
+}
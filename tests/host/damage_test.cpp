@@ -0,0 +1,127 @@
+// Brute-force check of DamageRegion: every changed pixel must be covered by
+// region, and region must stay within canvas and rect limit
+#include "check.h"
+#include "keira/utils/damage.h"
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+static const uint16_t W = 96;
+static const uint16_t H = 64;
+
+static bool covered(const DamageRegion& region, uint16_t x, uint16_t y) {
+    for (uint8_t i = 0; i < region.count(); i++) {
+        const DamageRect& r = region[i];
+        if (x >= r.x && x < r.x + r.w && y >= r.y && y < r.y + r.h) return true;
+    }
+    return false;
+}
+
+static void checkBounds(const DamageRegion& region) {
+    CHECK(region.count() <= KEIRA_DAMAGE_MAX_RECTS);
+    for (uint8_t i = 0; i < region.count(); i++) {
+        const DamageRect& r = region[i];
+        CHECK(r.w > 0 && r.h > 0);
+        CHECK(r.x + r.w <= W && r.y + r.h <= H);
+    }
+}
+
+static void mutate(std::vector<uint16_t>& fb, int kind) {
+    switch (kind) {
+        case 0: // Scattered pixels
+            for (int i = rand() % 20; i > 0; i--)
+                fb[(rand() % H) * W + rand() % W] ^= 1 + rand() % 0xFFFF;
+            break;
+        case 1: { // Filled rect
+            uint16_t x = rand() % W, y = rand() % H;
+            uint16_t w = 1 + rand() % (W - x), h = 1 + rand() % (H - y);
+            for (uint16_t row = y; row < y + h; row++)
+                for (uint16_t col = x; col < x + w; col++)
+                    fb[row * W + col] = ~fb[row * W + col];
+            break;
+        }
+        case 2: // Diagonal line
+            for (uint16_t i = 0; i < H; i++)
+                fb[i * W + (i * 3 + rand() % 2) % W] += 1;
+            break;
+        default: // Edge columns only
+            for (uint16_t row = 0; row < H; row += 1 + rand() % 4) {
+                fb[row * W] += 1;
+                fb[row * W + W - 1] += 1;
+            }
+            break;
+    }
+}
+
+static void testDiff() {
+    std::vector<uint16_t> a(W * H), b(W * H);
+    for (int iter = 0; iter < 2000; iter++) {
+        for (auto& px : a)
+            px = rand();
+        b = a;
+        for (int n = 1 + rand() % 3; n > 0; n--)
+            mutate(b, rand() % 4);
+
+        DamageRegion region;
+        region.addDiff(a.data(), b.data(), W, H);
+        checkBounds(region);
+
+        bool changed = false;
+        for (uint16_t y = 0; y < H; y++) {
+            for (uint16_t x = 0; x < W; x++) {
+                if (a[y * W + x] == b[y * W + x]) continue;
+                changed = true;
+                if (!CHECK(covered(region, x, y))) return;
+            }
+        }
+        CHECK(changed == !region.isEmpty());
+    }
+}
+
+static void testIdentical() {
+    std::vector<uint16_t> a(W * H, 0x1234);
+    DamageRegion region;
+    region.addDiff(a.data(), a.data(), W, H);
+    CHECK(region.isEmpty());
+    CHECK(region.area() == 0);
+}
+
+static void testAddKeepsCoverage() {
+    for (int iter = 0; iter < 2000; iter++) {
+        DamageRegion region;
+        std::vector<DamageRect> added;
+        for (int n = rand() % 30; n > 0; n--) {
+            uint16_t x = rand() % W, y = rand() % H;
+            DamageRect r = {x, y, (uint16_t)(1 + rand() % (W - x)), (uint16_t)(1 + rand() % (H - y))};
+            region.add(r.x, r.y, r.w, r.h);
+            added.push_back(r);
+        }
+        checkBounds(region);
+        for (auto& r : added) {
+            for (uint16_t y = r.y; y < r.y + r.h; y++)
+                for (uint16_t x = r.x; x < r.x + r.w; x++)
+                    if (!CHECK(covered(region, x, y))) return;
+        }
+    }
+}
+
+static void testInvalidate() {
+    DamageRegion region;
+    region.add(3, 4, 5, 6);
+    region.invalidate(W, H);
+    CHECK(region.count() == 1);
+    CHECK(region.area() == (uint32_t)W * H);
+    region.clear();
+    CHECK(region.isEmpty());
+    region.add(1, 1, 0, 5);
+    CHECK(region.isEmpty());
+}
+
+int main() {
+    srand(1);
+    testIdentical();
+    testDiff();
+    testAddKeepsCoverage();
+    testInvalidate();
+    return checkResult("damage");
+}
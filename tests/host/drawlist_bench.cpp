@@ -0,0 +1,138 @@
+//////////////////////////////////////////////////////////////////////////////
+// DrawList benchmark: host time per frame of an mJS script drawing pixels
+// one call at a time, through an incrementally built draw list, and through
+// a flat array passed to list.add(). Flat array is also read element by
+// element with mjs_array_get(), the way it was read before mjs_array_get_all().
+// Real mJS and mjsdrawlist bindings are used, canvas is the host stub.
+//
+//   drawlist-bench [frames] [pixels]
+//////////////////////////////////////////////////////////////////////////////
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include "mjs.h"
+#include "apps/mjs/mjsdrawlist.h"
+#include "keira/app.h"
+#include "keira/utils/drawlist.h"
+
+#define BENCH_DEFAULT_FRAMES 50
+#define BENCH_DEFAULT_PIXELS 2000
+
+// Same as display.draw_pixel() in mjsdisplay.cpp
+static void bench_draw_pixel(struct mjs* mjs) {
+    mjs_val_t app_val = mjs_get(mjs, mjs_get_global(mjs), "__app__", ~0);
+    int x = mjs_get_int(mjs, mjs_arg(mjs, 0));
+    int y = mjs_get_int(mjs, mjs_arg(mjs, 1));
+    uint16_t color = mjs_get_int(mjs, mjs_arg(mjs, 2));
+    static_cast<App*>(mjs_get_ptr(mjs, app_val))->canvas->drawPixel(x, y, color);
+    mjs_return(mjs, mjs_mk_undefined());
+}
+
+// add_by_index(list, records): list.add(records, drawlist.PIXEL) with a lookup per element
+static void bench_add_by_index(struct mjs* mjs) {
+    mjs_val_t ptr_val = mjs_get(mjs, mjs_arg(mjs, 0), "pointer", ~0);
+    DrawList* list = static_cast<DrawList*>(mjs_get_ptr(mjs, ptr_val));
+    mjs_val_t records = mjs_arg(mjs, 1);
+    unsigned long len = mjs_array_length(mjs, records);
+    for (unsigned long i = 0; i + 3 <= len; i += 3) {
+        int32_t values[3];
+        for (int j = 0; j < 3; j++) {
+            values[j] = mjs_get_double(mjs, mjs_array_get(mjs, records, i + j));
+        }
+        list->push(DRAW_CMD_PIXEL, values);
+    }
+    mjs_return(mjs, mjs_mk_undefined());
+}
+
+static const char* setupScript =
+    "let list = drawlist.create();"
+    "let records = [];"
+    "function percall(n) {"
+    "  for (let i = 0; i < n; i++) { display.draw_pixel(i % 280, i % 240, i); }"
+    "}"
+    "function incremental(n) {"
+    "  list.clear();"
+    "  for (let i = 0; i < n; i++) { list.pixel(i % 280, i % 240, i); }"
+    "  list.draw();"
+    "}"
+    "function flat(n) {"
+    "  list.clear();"
+    "  list.add(records, drawlist.PIXEL);"
+    "  list.draw();"
+    "}"
+    "function byindex(n) {"
+    "  list.clear();"
+    "  add_by_index(list, records);"
+    "  list.draw();"
+    "}";
+
+static const struct {
+    const char* name;
+    bool flatArray;
+} scenarios[] = {
+    {"percall", false},
+    {"incremental", false},
+    {"flat", true},
+    {"byindex", true},
+};
+
+// Each scenario runs in its own interpreter. mJS collects garbage whenever its property arena gets short, and
+// with the flat array alive that happens on every call, so per-call scenarios would mostly measure GC
+static struct mjs* createInstance(App* app, bool flatArray, int pixels) {
+    struct mjs* mjs = mjs_create();
+    mjs_val_t global = mjs_get_global(mjs);
+    mjs_set(mjs, global, "__app__", ~0, mjs_mk_foreign(mjs, app));
+    mjs_val_t display = mjs_mk_object(mjs);
+    mjs_set(mjs, display, "draw_pixel", ~0, mjs_mk_foreign_func(mjs, (mjs_func_ptr_t)bench_draw_pixel));
+    mjs_set(mjs, global, "display", ~0, display);
+    mjs_set(mjs, global, "add_by_index", ~0, mjs_mk_foreign_func(mjs, (mjs_func_ptr_t)bench_add_by_index));
+    mjs_drawlist_register(mjs);
+
+    mjs_val_t res;
+    mjs_err_t err = mjs_exec(mjs, setupScript, &res);
+    if (err != MJS_OK) {
+        printf("setup failed: %s\n", mjs_strerror(mjs, err));
+        exit(1);
+    }
+    // Flat array is built once, as a script would keep it between frames
+    mjs_val_t records = mjs_get(mjs, global, "records", ~0);
+    for (int i = 0; flatArray && i < pixels; i++) {
+        mjs_array_push(mjs, records, mjs_mk_number(mjs, i % 280));
+        mjs_array_push(mjs, records, mjs_mk_number(mjs, i % 240));
+        mjs_array_push(mjs, records, mjs_mk_number(mjs, i));
+    }
+    return mjs;
+}
+
+int main(int argc, char** argv) {
+    int frames = argc > 1 ? atoi(argv[1]) : BENCH_DEFAULT_FRAMES;
+    int pixels = argc > 2 ? atoi(argv[2]) : BENCH_DEFAULT_PIXELS;
+
+    lilka::Canvas canvas(280, 240);
+    App app;
+    app.canvas = &canvas;
+
+    printf("%d pixels, %d frames, us/frame\n", pixels, frames);
+    for (auto& scenario : scenarios) {
+        struct mjs* mjs = createInstance(&app, scenario.flatArray, pixels);
+        mjs_val_t func = mjs_get(mjs, mjs_get_global(mjs), scenario.name, ~0);
+        std::chrono::steady_clock::duration spent{};
+        for (int frame = 0; frame < frames; frame++) {
+            // Canvas stub logs every call, log is dropped outside of measured time
+            canvas.calls.clear();
+            mjs_val_t res;
+            auto start = std::chrono::steady_clock::now();
+            mjs_err_t err = mjs_call(mjs, &res, func, mjs_mk_undefined(), 1, mjs_mk_number(mjs, pixels));
+            spent += std::chrono::steady_clock::now() - start;
+            if (err != MJS_OK) {
+                printf("%s failed: %s\n", scenario.name, mjs_strerror(mjs, err));
+                return 1;
+            }
+        }
+        long long us = std::chrono::duration_cast<std::chrono::microseconds>(spent).count();
+        printf("%-12s %8lld\n", scenario.name, us / frames);
+        mjs_destroy(mjs);
+    }
+
+    return 0;
+}
@@ -0,0 +1,134 @@
+// DrawList: commands are drawn grouped by type in DrawCommandType order,
+// keeping their relative order, off-screen commands are rejected and direct
+// framebuffer writes match what canvas calls would draw
+#include "check.h"
+#include "keira/utils/drawlist.h"
+
+static void push(DrawList& list, DrawCommandType type, std::initializer_list<int32_t> values) {
+    CHECK(list.push(type, values.begin()));
+}
+
+static void testOrder() {
+    lilka::Image image = {16, 8};
+    DrawList list;
+    int32_t imageId = list.addImage(&image);
+    CHECK(imageId == 0);
+
+    push(list, DRAW_CMD_PIXEL, {1, 2, 100});
+    push(list, DRAW_CMD_LINE, {0, 0, 10, 10, 101});
+    push(list, DRAW_CMD_FILL_RECT, {5, 5, 3, 3, 102});
+    push(list, DRAW_CMD_CIRCLE, {20, 20, 4, 103});
+    push(list, DRAW_CMD_PIXEL, {3, 4, 104});
+    push(list, DRAW_CMD_IMAGE, {imageId, 30, 31});
+    push(list, DRAW_CMD_RECT, {6, 7, 8, 9, 105});
+    push(list, DRAW_CMD_FILL_CIRCLE, {40, 41, 5, 106});
+    push(list, DRAW_CMD_LINE, {9, 9, 1, 1, 107});
+    CHECK(list.size() == 9);
+
+    // Rotated canvas makes pixels and filled rects go through canvas calls
+    lilka::Canvas canvas(100, 80);
+    canvas.rotation = 1;
+    list.draw(&canvas);
+
+    const char expectedOps[] = "FOiRollpp";
+    const uint16_t expectedColors[] = {102, 106, 0, 105, 103, 101, 107, 100, 104};
+    CHECK(canvas.calls.size() == 9);
+    for (size_t i = 0; i < canvas.calls.size() && i < 9; i++) {
+        CHECK(canvas.calls[i].op == expectedOps[i]);
+        CHECK(canvas.calls[i].color == expectedColors[i]);
+    }
+    if (canvas.calls.size() == 9) {
+        const lilka::CanvasCall& img = canvas.calls[2];
+        CHECK(img.args[0] == 30 && img.args[1] == 31 && img.args[2] == 16);
+        const lilka::CanvasCall& line = canvas.calls[6];
+        CHECK(line.args[0] == 9 && line.args[1] == 9 && line.args[2] == 1 && line.args[3] == 1);
+    }
+
+    // Lists are reusable after clear(), images are kept
+    list.clear();
+    CHECK(list.size() == 0);
+    canvas.calls.clear();
+    list.draw(&canvas);
+    CHECK(canvas.calls.empty());
+    CHECK(list.addImage(&image) == imageId);
+}
+
+static void testClipping() {
+    DrawList list;
+    push(list, DRAW_CMD_LINE, {-50, -50, -1, -1, 1});
+    push(list, DRAW_CMD_LINE, {-50, -50, 0, 0, 2});
+    push(list, DRAW_CMD_CIRCLE, {-10, 10, 9, 3});
+    push(list, DRAW_CMD_FILL_CIRCLE, {-10, 10, 10, 4});
+    push(list, DRAW_CMD_RECT, {100, 0, 5, 5, 5});
+    push(list, DRAW_CMD_RECT, {105, 0, -6, 5, 6});
+    push(list, DRAW_CMD_PIXEL, {-1, 0, 7});
+    push(list, DRAW_CMD_PIXEL, {0, 80, 8});
+    push(list, DRAW_CMD_FILL_RECT, {100, 0, 5, 5, 9});
+
+    lilka::Canvas canvas(100, 80);
+    canvas.rotation = 1;
+    list.draw(&canvas);
+
+    // Only commands touching canvas reach it
+    const char expectedOps[] = "ORl";
+    const uint16_t expectedColors[] = {4, 6, 2};
+    CHECK(canvas.calls.size() == 3);
+    for (size_t i = 0; i < canvas.calls.size() && i < 3; i++) {
+        CHECK(canvas.calls[i].op == expectedOps[i]);
+        CHECK(canvas.calls[i].color == expectedColors[i]);
+    }
+}
+
+static void testFramebuffer() {
+    const int16_t w = 40, h = 30;
+    DrawList list;
+    push(list, DRAW_CMD_FILL_RECT, {-5, -5, 10, 8, 0x1111});
+    push(list, DRAW_CMD_FILL_RECT, {38, 28, -4, -3, 0x2222});
+    push(list, DRAW_CMD_FILL_RECT, {10, 10, 0, 5, 0x3333});
+    push(list, DRAW_CMD_PIXEL, {39, 29, 0x4444});
+    push(list, DRAW_CMD_PIXEL, {40, 0, 0x5555});
+    push(list, DRAW_CMD_PIXEL, {0, -1, 0x6666});
+    push(list, DRAW_CMD_PIXEL, {2, 2, 0x7777});
+
+    lilka::Canvas canvas(w, h);
+    list.draw(&canvas);
+    CHECK(canvas.calls.empty());
+
+    // Reference image: rects normalized and clipped, pixels drawn last
+    std::vector<uint16_t> expected(w * h, 0);
+    for (int y = 0; y < 3; y++)
+        for (int x = 0; x < 5; x++)
+            expected[y * w + x] = 0x1111;
+    for (int y = 25; y < 28; y++)
+        for (int x = 34; x < 38; x++)
+            expected[y * w + x] = 0x2222;
+    expected[29 * w + 39] = 0x4444;
+    expected[2 * w + 2] = 0x7777;
+
+    CHECK(memcmp(canvas.getFramebuffer(), expected.data(), w * h * sizeof(uint16_t)) == 0);
+}
+
+static void testValidation() {
+    lilka::Image image = {1, 1};
+    DrawList list;
+    int32_t badImage[] = {0, 1, 1};
+    CHECK(!list.push(DRAW_CMD_IMAGE, badImage));
+    CHECK(list.addImage(&image) == 0);
+    CHECK(list.push(DRAW_CMD_IMAGE, badImage));
+    int32_t values[DRAW_LIST_MAX_RECORD_SIZE] = {};
+    CHECK(!list.push(DRAW_CMD_COUNT, values));
+    CHECK(list.size() == 1);
+
+    lilka::Image images[DRAW_LIST_MAX_IMAGES];
+    for (int i = 1; i < DRAW_LIST_MAX_IMAGES; i++)
+        CHECK(list.addImage(&images[i]) == i);
+    CHECK(list.addImage(&images[0]) == -1);
+}
+
+int main() {
+    testOrder();
+    testClipping();
+    testFramebuffer();
+    testValidation();
+    return checkResult("drawlist");
+}
@@ -0,0 +1,121 @@
+//////////////////////////////////////////////////////////////////////////////
+// Download throughput benchmark: webSendFileBody() against reading and
+// sending WEB_BUFFER_FS_OP bytes at a time, as downloads were sent before
+// Range support. Card and Wi-Fi are simulated by sleeping in fread() and in
+// send callback for the time a transfer of that size would take, so numbers
+// show how well reads overlap sends, not what the device reaches.
+//
+//   filesend-bench [file size in KB]
+//////////////////////////////////////////////////////////////////////////////
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <thread>
+#include "services/web/filesend.h"
+
+#define BENCH_DEFAULT_SIZE_KB 2048
+// Buffer downloads were read into before Range support (WEB_BUFFER_FS_OP)
+#define BENCH_SEQUENTIAL_BUFFER 4096
+
+typedef struct {
+    const char* name;
+    // Card: fixed cost of a read call and its speed in bytes per us (MB/s), 0 for no delay at all
+    uint32_t cardReadUs;
+    double cardSpeed;
+    double linkSpeed;
+} Scenario;
+
+static const Scenario scenarios[] = {
+    {"no delays", 0, 0, 0},
+    {"card 2 MB/s, wifi 1 MB/s", 300, 2, 1},
+    {"card 1 MB/s, wifi 1 MB/s", 300, 1, 1},
+    {"card 1 MB/s, wifi 2 MB/s", 300, 1, 2},
+};
+
+static const Scenario* current = NULL;
+
+static void waitFor(double us) {
+    std::this_thread::sleep_for(std::chrono::duration<double, std::micro>(us));
+}
+
+extern "C" size_t __real_fread(void* data, size_t size, size_t count, FILE* file);
+
+extern "C" size_t __wrap_fread(void* data, size_t size, size_t count, FILE* file) {
+    size_t got = __real_fread(data, size, count, file);
+    if (current && current->cardSpeed) waitFor(current->cardReadUs + got * size / current->cardSpeed);
+    return got;
+}
+
+static bool sendToLink(void* context, const char* data, size_t size) {
+    if (current->linkSpeed) waitFor(size / current->linkSpeed);
+    return true;
+}
+
+static bool sendSequential(FILE* file, size_t length, WebSendFunc send, void* context) {
+    char buf[BENCH_SEQUENTIAL_BUFFER];
+    while (length) {
+        size_t got = fread(buf, 1, std::min<size_t>(length, sizeof(buf)), file);
+        if (!got || !send(context, buf, got)) return false;
+        length -= got;
+    }
+    return true;
+}
+
+static const struct {
+    const char* name;
+    bool (*send)(FILE* file, size_t length, WebSendFunc send, void* context);
+} methods[] = {
+    {"sequential 4 KB", sendSequential},
+    {"webSendFileBody", webSendFileBody},
+};
+
+int main(int argc, char** argv) {
+    size_t size = (argc > 1 ? atoi(argv[1]) : BENCH_DEFAULT_SIZE_KB) * 1024;
+
+    char path[] = "/tmp/keira-filesend-XXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0) {
+        perror("mkstemp");
+        return 1;
+    }
+    std::string data(size, 'k');
+    bool written = write(fd, data.data(), size) == static_cast<ssize_t>(size);
+    close(fd);
+    if (!written) {
+        perror(path);
+        unlink(path);
+        return 1;
+    }
+
+    printf("%lu KB file, MB/s\n", static_cast<unsigned long>(size / 1024));
+    printf("%-26s", "scenario");
+    for (auto& method : methods) {
+        printf(" %16s", method.name);
+    }
+    printf("\n");
+
+    for (const Scenario& scenario : scenarios) {
+        printf("%-26s", scenario.name);
+        for (auto& method : methods) {
+            FILE* file = fopen(path, "rb");
+            current = &scenario;
+            auto start = std::chrono::steady_clock::now();
+            bool ok = method.send(file, size, sendToLink, NULL);
+            double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+            current = NULL;
+            fclose(file);
+            if (!ok) {
+                printf(" %16s", "failed");
+            } else {
+                printf(" %16.2f", size / us);
+            }
+        }
+        printf("\n");
+    }
+
+    unlink(path);
+    return 0;
+}
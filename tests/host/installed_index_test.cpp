@@ -0,0 +1,168 @@
+// InstalledIndex: index is rebuilt from manifests, survives round trips through put() and remove(),
+// is rebuilt when manifests folder changes behind its back or the file is damaged, and an index
+// left as backup by an interrupted save is still used
+#include <ftw.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <string>
+#include "check.h"
+#include "apps/lilcatalog/installed_index.h"
+
+static std::string root;
+
+static void writeFile(const std::string& path, const std::string& contents) {
+    FILE* file = fopen((root + path).c_str(), "w");
+    if (!CHECK(file != NULL)) return;
+    fputs(contents.c_str(), file);
+    fclose(file);
+}
+
+static bool fileExists(const std::string& path) {
+    struct stat st;
+    return stat((root + path).c_str(), &st) == 0;
+}
+
+// Saves manifest as catalog does, with executable in app folder unless it's missing on purpose
+static void addManifest(
+    const std::string& id, const std::string& name, const std::string& type, const std::string& location,
+    bool executable = true
+) {
+    writeFile(
+        std::string(CATALOG_MANIFEST_CACHE_FOLDER) + "/" + id + ".json",
+        "{\"name\": \"" + name + "\", \"description\": \"Long text\", \"entryfile\": {\"type\": \"" + type +
+            "\", \"location\": \"" + location + "\"}, \"files\": []}"
+    );
+    if (executable) {
+        mkdir((root + "/lilcatalog/" + id).c_str(), 0755);
+        writeFile("/lilcatalog/" + id + "/" + location, "");
+    }
+}
+
+static void removeManifest(const std::string& id) {
+    unlink((root + CATALOG_MANIFEST_CACHE_FOLDER + "/" + id + ".json").c_str());
+}
+
+// Returns position of app in index, or -1
+static int find(const InstalledIndex& index, const char* id) {
+    for (uint16_t i = 0; i < index.size(); i++) {
+        if (strcmp(index.getId(i), id) == 0) return i;
+    }
+    return -1;
+}
+
+static bool hasApp(const char* id, const char* name, ExecutionType type) {
+    InstalledIndex index;
+    index.load();
+    int i = find(index, id);
+    return i >= 0 && strcmp(index.getName(i), name) == 0 && index.getType(i) == type;
+}
+
+static uint16_t countApps() {
+    InstalledIndex index;
+    index.load();
+    return index.size();
+}
+
+static void testRebuild() {
+    addManifest("lua", "Lua app", "lua", "main.lua");
+    addManifest("bin", "Binary app", "binary", "app.bin");
+    // Type is taken from extension when manifest doesn't have a runnable one
+    addManifest("so", "Dynamic app", "archive", "app.so");
+    addManifest("missing", "Not downloaded", "lua", "main.lua", false);
+    addManifest("unknown", "Unknown", "image", "picture.png");
+    writeFile(std::string(CATALOG_MANIFEST_CACHE_FOLDER) + "/broken.json", "{\"name\": ");
+
+    InstalledIndex index;
+    CHECK(index.load());
+    CHECK(index.size() == 3);
+    int i = find(index, "lua");
+    CHECK(i >= 0 && strcmp(index.getName(i), "Lua app") == 0 && index.getType(i) == EXEC_TYPE_LUA);
+    CHECK(i >= 0 && strcmp(index.getLocation(i), "main.lua") == 0);
+    CHECK(i >= 0 && index.getExecutablePath(i) == String((root + "/lilcatalog/lua/main.lua").c_str()));
+    CHECK(hasApp("bin", "Binary app", EXEC_TYPE_BINARY));
+    CHECK(hasApp("so", "Dynamic app", EXEC_TYPE_DYNAPP));
+    CHECK(find(index, "missing") < 0 && find(index, "unknown") < 0 && find(index, "broken") < 0);
+    CHECK(fileExists(CATALOG_INSTALLED_INDEX_FILE));
+}
+
+static void testUpdates() {
+    // Index is used as long as manifest names match, so names given to put() show up instead of
+    // the ones in manifests, which only a rebuild would read
+    addManifest("new", "Manifest name", "lua", "main.lua");
+    CHECK(InstalledIndex::put({"new", "Put name", "main.lua", EXEC_TYPE_LUA}));
+    CHECK(hasApp("new", "Put name", EXEC_TYPE_LUA));
+    CHECK(countApps() == 4);
+
+    // Reinstall replaces the entry
+    CHECK(InstalledIndex::put({"new", "Reinstalled", "app.bin", EXEC_TYPE_BINARY}));
+    CHECK(hasApp("new", "Reinstalled", EXEC_TYPE_BINARY));
+    CHECK(countApps() == 4);
+
+    removeManifest("new");
+    CHECK(InstalledIndex::remove("new"));
+    InstalledIndex index;
+    CHECK(index.load());
+    CHECK(index.size() == 3 && find(index, "new") < 0);
+}
+
+static void testStale() {
+    // Manifest added without put() makes index stale
+    addManifest("external", "External", "lua", "main.lua");
+    CHECK(hasApp("external", "External", EXEC_TYPE_LUA));
+    CHECK(countApps() == 4);
+
+    // Damaged index is rebuilt
+    CHECK(InstalledIndex::put({"external", "Put name", "main.lua", EXEC_TYPE_LUA}));
+    FILE* file = fopen((root + CATALOG_INSTALLED_INDEX_FILE).c_str(), "r+b");
+    if (CHECK(file != NULL)) {
+        fseek(file, sizeof(catalog_index_header_t) + 2, SEEK_SET);
+        fputc('X', file);
+        fclose(file);
+    }
+    CHECK(hasApp("external", "External", EXEC_TYPE_LUA));
+}
+
+static void testInterruptedSave() {
+    CHECK(InstalledIndex::put({"external", "Put name", "main.lua", EXEC_TYPE_LUA}));
+
+    // Power lost after old index was moved aside, but before the new one took its place
+    std::string path = root + CATALOG_INSTALLED_INDEX_FILE;
+    CHECK(rename(path.c_str(), (path + ".bak").c_str()) == 0);
+    writeFile(std::string(CATALOG_INSTALLED_INDEX_FILE) + ".tmp", "partial");
+    CHECK(hasApp("external", "Put name", EXEC_TYPE_LUA));
+
+    // Next save keeps backup until the new index is in place, and cleans up after
+    CHECK(InstalledIndex::put({"external", "Saved again", "main.lua", EXEC_TYPE_LUA}));
+    CHECK(fileExists(CATALOG_INSTALLED_INDEX_FILE));
+    CHECK(!fileExists(std::string(CATALOG_INSTALLED_INDEX_FILE) + ".bak"));
+    CHECK(!fileExists(std::string(CATALOG_INSTALLED_INDEX_FILE) + ".tmp"));
+    CHECK(hasApp("external", "Saved again", EXEC_TYPE_LUA));
+
+    InstalledIndex::clear();
+    CHECK(!fileExists(CATALOG_INSTALLED_INDEX_FILE));
+    CHECK(countApps() == 4);
+}
+
+static int removeEntry(const char* path, const struct stat*, int, struct FTW*) {
+    return remove(path);
+}
+
+int main() {
+    char dir[] = "/tmp/keira-index-XXXXXX";
+    if (!mkdtemp(dir)) {
+        perror("mkdtemp");
+        return 1;
+    }
+    root = dir;
+    SD.root = root;
+    mkdir((root + "/lilcatalog").c_str(), 0755);
+    mkdir((root + CATALOG_MANIFEST_CACHE_FOLDER).c_str(), 0755);
+
+    testRebuild();
+    testUpdates();
+    testStale();
+    testInterruptedSave();
+
+    nftw(dir, removeEntry, 16, FTW_DEPTH | FTW_PHYS);
+    return checkResult("installed_index");
+}
@@ -0,0 +1,8 @@
+#pragma once
+// Script bindings only reach app's canvas, App itself needs Keira system services
+#include <lilka.h>
+
+class App {
+public:
+    lilka::Canvas* canvas;
+};
@@ -0,0 +1,223 @@
+// MultipartParser: body fed in chunks of any size, split at any byte, gives the same parts,
+// data that looks like a beginning of a delimiter is passed through, and garbage is handled
+#include <string.h>
+#include <random>
+#include <string>
+#include <vector>
+#include "check.h"
+#include "services/web/multipart.h"
+
+typedef struct {
+    std::string name;
+    std::string filename;
+    std::string data;
+} Part;
+
+class RecordingListener : public MultipartListener {
+public:
+    std::vector<Part> parts;
+    bool partOpen = false;
+    // Listener stops parser after this many data bytes, -1 to never stop
+    long stopAfter = -1;
+    size_t dataSize = 0;
+
+    bool onPartBegin(const char* name, const char* filename) override {
+        CHECK(!partOpen);
+        partOpen = true;
+        parts.push_back({name, filename, ""});
+        return true;
+    }
+
+    bool onPartData(const char* data, size_t size) override {
+        CHECK(partOpen);
+        if (partOpen) parts.back().data.append(data, size);
+        dataSize += size;
+        return stopAfter < 0 || dataSize < static_cast<size_t>(stopAfter);
+    }
+
+    bool onPartEnd() override {
+        CHECK(partOpen);
+        partOpen = false;
+        return true;
+    }
+};
+
+static std::string buildBody(const std::string& boundary, const std::vector<Part>& parts) {
+    std::string body = "preamble\r\n";
+    for (const Part& part : parts) {
+        body += "--" + boundary + "\r\nContent-Disposition: form-data; name=\"" + part.name + "\"";
+        if (!part.filename.empty()) {
+            body += "; filename=\"" + part.filename + "\"\r\nContent-Type: application/octet-stream";
+        }
+        body += "\r\n\r\n" + part.data + "\r\n";
+    }
+    return body + "--" + boundary + "--\r\nepilogue\r\n--" + boundary + "\r\n";
+}
+
+// Feeds body in chunks of given sizes, last size is repeated
+static bool parse(
+    const std::string& boundary, const std::string& body, const std::vector<size_t>& chunkSizes,
+    RecordingListener* listener, bool* finished
+) {
+    MultipartParser parser(boundary.c_str(), listener);
+    size_t offset = 0;
+    for (size_t i = 0; offset < body.size(); i++) {
+        size_t size = std::min(chunkSizes[std::min(i, chunkSizes.size() - 1)], body.size() - offset);
+        if (!parser.feed(body.data() + offset, size)) return false;
+        offset += size;
+    }
+    *finished = parser.isFinished();
+    return !parser.isFailed();
+}
+
+static bool sameParts(const std::vector<Part>& a, const std::vector<Part>& b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); i++) {
+        if (a[i].name != b[i].name || a[i].filename != b[i].filename || a[i].data != b[i].data) return false;
+    }
+    return true;
+}
+
+static void testSplits() {
+    const std::string boundary = "----WebKitFormBoundary7MA4YWxkTrZu0gW";
+    const std::string delimiter = "\r\n--" + boundary;
+    // Data holds every proper prefix of the delimiter, so each of them is held back and then released
+    std::string tricky = "\r\n--\r\n";
+    for (size_t i = 1; i < delimiter.size(); i++) {
+        tricky += delimiter.substr(0, i) + "x";
+    }
+    std::vector<Part> parts = {{"field", "", "value"}, {"file", "a.bin", tricky}, {"empty", "b.bin", ""}};
+    std::string body = buildBody(boundary, parts);
+
+    // Split in two at every byte
+    for (size_t split = 1; split < body.size(); split++) {
+        RecordingListener listener;
+        bool finished = false;
+        CHECK(parse(boundary, body, {split, body.size()}, &listener, &finished));
+        CHECK(finished);
+        CHECK(sameParts(listener.parts, parts));
+        CHECK(!listener.partOpen);
+    }
+
+    // Byte by byte
+    RecordingListener listener;
+    bool finished = false;
+    CHECK(parse(boundary, body, {1}, &listener, &finished));
+    CHECK(finished);
+    CHECK(sameParts(listener.parts, parts));
+}
+
+static void testRandom() {
+    std::mt19937 rng(1);
+    const char alphabet[] = "abcdefghijklmnopqrstuvwxyz0123456789'()+_,-./:=?";
+    for (int iteration = 0; iteration < 2000; iteration++) {
+        std::string boundary;
+        size_t boundaryLength = 1 + rng() % MULTIPART_MAX_BOUNDARY;
+        for (size_t i = 0; i < boundaryLength; i++) {
+            boundary += alphabet[rng() % (sizeof(alphabet) - 1)];
+        }
+        const std::string delimiter = "\r\n--" + boundary;
+
+        std::vector<Part> parts;
+        size_t partCount = rng() % 5;
+        while (parts.size() < partCount) {
+            Part part = {"f" + std::to_string(parts.size()), rng() % 3 ? "file.bin" : "", ""};
+            size_t size = rng() % 4 ? rng() % 8192 : rng() % 4;
+            while (part.data.size() < size) {
+                switch (rng() % 8) {
+                    case 0:
+                        part.data += delimiter.substr(0, rng() % delimiter.size());
+                        break;
+                    case 1:
+                        part.data += "\r\n";
+                        break;
+                    default:
+                        part.data += static_cast<char>(rng());
+                        break;
+                }
+            }
+            // Whole delimiter can't appear in data
+            if (part.data.find(delimiter) == std::string::npos) parts.push_back(part);
+        }
+        std::string body = buildBody(boundary, parts);
+
+        size_t maxChunk = rng() % 3 == 0 ? 8 : rng() % 2 ? 256 : 8192;
+        std::vector<size_t> chunkSizes;
+        for (size_t total = 0; total < body.size(); total += chunkSizes.back()) {
+            chunkSizes.push_back(1 + rng() % maxChunk);
+        }
+        RecordingListener listener;
+        bool finished = false;
+        CHECK(parse(boundary, body, chunkSizes, &listener, &finished));
+        CHECK(finished);
+        CHECK(sameParts(listener.parts, parts));
+    }
+}
+
+static void testGarbage() {
+    std::mt19937 rng(2);
+    const char* tokens[] = {
+        "--xyz", "\r\n", "--", "Content-Disposition: form-data; name=\"a\"; filename=\"b\"", "\r\n\r\n", "x", "\n"
+    };
+    for (int iteration = 0; iteration < 5000; iteration++) {
+        std::string body;
+        size_t size = rng() % 3000;
+        while (body.size() < size) {
+            body += rng() % 3 ? std::string(tokens[rng() % 7]) : std::string(1, static_cast<char>(rng()));
+        }
+        // Listener checks that parts never nest and data only comes inside parts
+        RecordingListener listener;
+        listener.stopAfter = rng() % 2 ? static_cast<long>(rng() % 100) : -1;
+        MultipartParser parser("xyz", &listener);
+        for (size_t offset = 0; offset < body.size();) {
+            size_t chunk = std::min<size_t>(1 + rng() % 64, body.size() - offset);
+            if (!parser.feed(body.data() + offset, chunk)) {
+                CHECK(parser.isFailed());
+                break;
+            }
+            offset += chunk;
+        }
+    }
+}
+
+static void testErrors() {
+    std::string body = buildBody("xyz", {{"a", "a.bin", std::string(100, 'a')}});
+    bool finished = false;
+
+    // Listener stops parser
+    RecordingListener stopping;
+    stopping.stopAfter = 10;
+    CHECK(!parse("xyz", body, {7}, &stopping, &finished));
+
+    // Truncated body is not finished
+    RecordingListener truncated;
+    CHECK(parse("xyz", body.substr(0, body.size() / 2), {4}, &truncated, &finished));
+    CHECK(!finished);
+
+    RecordingListener unused;
+    CHECK(!parse(std::string(MULTIPART_MAX_BOUNDARY + 1, 'b'), "", {1}, &unused, &finished));
+}
+
+static void testBoundary() {
+    char boundary[MULTIPART_MAX_BOUNDARY + 1];
+    CHECK(MultipartParser::getBoundary("multipart/form-data; boundary=abc", boundary, sizeof(boundary)));
+    CHECK(strcmp(boundary, "abc") == 0);
+    const char* quoted = "multipart/form-data; charset=utf-8; BOUNDARY=\"a b\"";
+    CHECK(MultipartParser::getBoundary(quoted, boundary, sizeof(boundary)));
+    CHECK(strcmp(boundary, "a b") == 0);
+    CHECK(MultipartParser::getBoundary("multipart/form-data;boundary=x;y=z", boundary, sizeof(boundary)));
+    CHECK(strcmp(boundary, "x") == 0);
+    CHECK(!MultipartParser::getBoundary("multipart/form-data", boundary, sizeof(boundary)));
+    CHECK(!MultipartParser::getBoundary("multipart/form-data; boundary=", boundary, sizeof(boundary)));
+    std::string tooLong = "multipart/form-data; boundary=" + std::string(MULTIPART_MAX_BOUNDARY + 1, 'b');
+    CHECK(!MultipartParser::getBoundary(tooLong.c_str(), boundary, sizeof(boundary)));
+}
+
+int main() {
+    testSplits();
+    testRandom();
+    testGarbage();
+    testErrors();
+    testBoundary();
+    return checkResult("multipart");
+}
@@ -0,0 +1,165 @@
+// OfflineRenderer: mix and stems are bit-identical to a single Synth rendering the same rows buffer by buffer,
+// including when rows are so dense that rounds are cut short by a full event queue, and a failed render
+// removes the files it created and nothing else
+#include <ftw.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <string>
+#include <vector>
+#include "check.h"
+#include "apps/liltracker/offline_render.h"
+#include "apps/liltracker/sequencer.h"
+
+#define TEST_PAGE_COUNT 3
+// Fast enough for a few rows per round
+#define TEST_BPM 600
+// Over a hundred rows per round, worker synth runs out of event queue
+#define TEST_DENSE_BPM 20000
+
+static std::string root;
+static uint32_t seed = 1;
+
+static uint32_t nextRandom(uint32_t range) {
+    seed = seed * 1103515245 + 12345;
+    return (seed >> 16) % range;
+}
+
+// Every row of every channel changes something, with random notes, waveforms, volumes and effects
+static void fillTrack(Track* track) {
+    track->setPatternCount(TEST_PAGE_COUNT);
+    track->setPageCount(TEST_PAGE_COUNT);
+    for (int16_t pageIndex = 0; pageIndex < TEST_PAGE_COUNT; pageIndex++) {
+        Pattern* pattern = track->getPattern(pageIndex);
+        for (uint8_t channelIndex = 0; channelIndex < CHANNEL_COUNT; channelIndex++) {
+            track->getPage(pageIndex)->patternIndices[channelIndex] = pageIndex;
+            for (int16_t row = 0; row < CHANNEL_SIZE; row++) {
+                event_t event = {};
+                event.note = {static_cast<uint8_t>(nextRandom(12)), static_cast<uint8_t>(2 + nextRandom(5))};
+                event.waveform = waveforms[nextRandom(WAVEFORM_COUNT)];
+                event.volume = nextRandom(MAX_VOLUME + 1);
+                event.type = static_cast<event_type_t>(nextRandom(EVENT_TYPE_COUNT));
+                event.effect = {effects[nextRandom(EFFECT_TYPE_COUNT)], static_cast<uint8_t>(nextRandom(256))};
+                pattern->setChannelEvent(channelIndex, row, event);
+            }
+        }
+    }
+}
+
+// Renders track with one synth, queueing rows right before the buffer they start in, like real-time playback.
+// Returns mix followed by each channel
+static std::vector<std::vector<int16_t>> renderReference(Track* track, float masterVolume) {
+    const uint32_t rowLength = SYNTH_SAMPLE_RATE * 60 / track->getBPM();
+    const uint32_t rowCount = track->getPageCount() * CHANNEL_SIZE;
+    const int64_t totalSamples = static_cast<int64_t>(rowLength) * rowCount;
+
+    Synth synth;
+    Synth* synths[CHANNEL_COUNT] = {&synth, &synth, &synth};
+    int16_t combinedBuffer[SYNTH_BUFFER_SIZE];
+    int16_t channelBuffers[CHANNEL_COUNT][SYNTH_BUFFER_SIZE];
+    std::vector<std::vector<int16_t>> outputs(CHANNEL_COUNT + 1);
+    uint32_t row = 0;
+    int64_t rowSample = 0;
+    while (synth.getCurrentSample() < totalSamples) {
+        while (row < rowCount && rowSample < synth.getCurrentSample() + SYNTH_BUFFER_SIZE) {
+            CHECK(Sequencer::queueRow(synths, track, row / CHANNEL_SIZE, row % CHANNEL_SIZE, rowSample));
+            row++;
+            rowSample += rowLength;
+        }
+        uint32_t sampleCount = SYNTH_BUFFER_SIZE;
+        if (totalSamples - synth.getCurrentSample() < sampleCount) {
+            sampleCount = totalSamples - synth.getCurrentSample();
+        }
+        synth.render(combinedBuffer, channelBuffers, sampleCount, masterVolume);
+        for (uint32_t i = 0; i < sampleCount; i++) {
+            int32_t sum = 0;
+            for (uint8_t channelIndex = 0; channelIndex < CHANNEL_COUNT; channelIndex++) {
+                outputs[channelIndex + 1].push_back(channelBuffers[channelIndex][i]);
+                sum += channelBuffers[channelIndex][i];
+            }
+            outputs[0].push_back(sum / CHANNEL_COUNT);
+        }
+    }
+    return outputs;
+}
+
+static bool fileExists(const std::string& path) {
+    struct stat st;
+    return stat((root + path).c_str(), &st) == 0;
+}
+
+// Returns samples of a WAV written by OfflineRenderer, after checking its header
+static std::vector<int16_t> readWav(const std::string& path) {
+    std::vector<int16_t> samples;
+    FILE* file = fopen((root + path).c_str(), "rb");
+    if (!CHECK(file != NULL)) return samples;
+    uint8_t header[OFFLINE_RENDER_DATA_OFFSET];
+    if (CHECK(fread(header, 1, sizeof(header), file) == sizeof(header))) {
+        const data_subchunk_t* data =
+            reinterpret_cast<const data_subchunk_t*>(header + OFFLINE_RENDER_DATA_OFFSET - sizeof(data_subchunk_t));
+        CHECK(memcmp(header, "RIFF", 4) == 0 && memcmp(header + 8, "WAVE", 4) == 0);
+        CHECK(memcmp(data->subchunk2ID, "data", 4) == 0);
+        samples.resize(data->subchunk2Size / sizeof(int16_t));
+        CHECK(fread(samples.data(), sizeof(int16_t), samples.size(), file) == samples.size());
+        CHECK(fgetc(file) == EOF);
+    }
+    fclose(file);
+    return samples;
+}
+
+static void testIdentical(int16_t bpm) {
+    Track track(bpm);
+    fillTrack(&track);
+    std::vector<std::vector<int16_t>> expected = renderReference(&track, 0.5f);
+
+    OfflineRenderer renderer(&track, 0.5f);
+    float lastProgress = 0;
+    CHECK(renderer.render("/song.wav", 0, true, [&lastProgress](float progress) {
+        CHECK(progress >= lastProgress);
+        lastProgress = progress;
+    }));
+    CHECK(lastProgress == 1.0f);
+
+    for (uint8_t i = 0; i <= CHANNEL_COUNT; i++) {
+        std::string path = i == 0 ? "/song.wav" : OfflineRenderer::stemFilename("/song.wav", i - 1).c_str();
+        CHECK(readWav(path) == expected[i]);
+        remove((root + path).c_str());
+    }
+}
+
+static void testFailedRender() {
+    Track track(TEST_BPM);
+    fillTrack(&track);
+    // Folder in place of the last stem can't be opened for writing
+    std::string blocked = OfflineRenderer::stemFilename("/song.wav", CHANNEL_COUNT - 1).c_str();
+    mkdir((root + blocked).c_str(), 0755);
+
+    OfflineRenderer renderer(&track, 0.5f);
+    CHECK(!renderer.render("/song.wav", 0, true, nullptr));
+    CHECK(!fileExists("/song.wav"));
+    for (uint8_t channelIndex = 0; channelIndex < CHANNEL_COUNT - 1; channelIndex++) {
+        CHECK(!fileExists(OfflineRenderer::stemFilename("/song.wav", channelIndex).c_str()));
+    }
+    CHECK(fileExists(blocked));
+    rmdir((root + blocked).c_str());
+}
+
+static int removeEntry(const char* path, const struct stat*, int, struct FTW*) {
+    return remove(path);
+}
+
+int main() {
+    char dir[] = "/tmp/keira-render-XXXXXX";
+    if (!mkdtemp(dir)) {
+        perror("mkdtemp");
+        return 1;
+    }
+    root = dir;
+    SD.root = root;
+
+    testIdentical(TEST_BPM);
+    testIdentical(TEST_DENSE_BPM);
+    testFailedRender();
+
+    nftw(dir, removeEntry, 16, FTW_DEPTH | FTW_PHYS);
+    return checkResult("offline_render");
+}
@@ -0,0 +1,179 @@
+// File downloads: Range parsing (bytes=a-b, a-, -n, unsatisfiable and multiple ranges), conditional
+// requests with If-None-Match and If-Range, and the streamed body holding exactly the requested bytes,
+// whether it's sent in one go or through reader task
+#include <string.h>
+#include <unistd.h>
+#include <string>
+#include "check.h"
+#include "services/web/filesend.h"
+
+#define TEST_FILE_SIZE 100000
+
+static char path[] = "/tmp/keira-range-XXXXXX";
+
+static char byteAt(size_t pos) {
+    return static_cast<char>(pos * 7 + pos / 251);
+}
+
+static WebFileReply resolve(
+    const char* range, size_t fileSize, size_t* start, size_t* end, const char* ifRange = NULL,
+    const char* ifNoneMatch = NULL
+) {
+    return webResolveFileReply(ifNoneMatch, ifRange, range, "\"186a0-5f5e100\"", fileSize, start, end);
+}
+
+static bool isPartial(const char* range, size_t fileSize, size_t start, size_t end) {
+    size_t gotStart, gotEnd;
+    return resolve(range, fileSize, &gotStart, &gotEnd) == WEB_FILE_PARTIAL && gotStart == start && gotEnd == end;
+}
+
+static bool isFull(const char* range, size_t fileSize) {
+    size_t start, end;
+    return resolve(range, fileSize, &start, &end) == WEB_FILE_FULL && start == 0 && end == fileSize - 1;
+}
+
+static bool isUnsatisfiable(const char* range, size_t fileSize) {
+    size_t start, end;
+    return resolve(range, fileSize, &start, &end) == WEB_FILE_UNSATISFIABLE;
+}
+
+static void testRanges() {
+    CHECK(isFull(NULL, 1000));
+
+    // bytes=a-b, end past the file is cut to its size
+    CHECK(isPartial("bytes=0-99", 1000, 0, 99));
+    CHECK(isPartial("bytes=500-500", 1000, 500, 500));
+    CHECK(isPartial("bytes=990-5000", 1000, 990, 999));
+    // bytes=a-
+    CHECK(isPartial("bytes=500-", 1000, 500, 999));
+    CHECK(isPartial("bytes=0-", 1000, 0, 999));
+    // bytes=-n, suffix longer than file is the whole file
+    CHECK(isPartial("bytes=-100", 1000, 900, 999));
+    CHECK(isPartial("bytes=-2000", 1000, 0, 999));
+
+    // Out of range
+    CHECK(isUnsatisfiable("bytes=1000-", 1000));
+    CHECK(isUnsatisfiable("bytes=1000-1100", 1000));
+    CHECK(isUnsatisfiable("bytes=5-2", 1000));
+    CHECK(isUnsatisfiable("bytes=-0", 1000));
+    CHECK(isUnsatisfiable("bytes=0-", 0));
+    CHECK(isUnsatisfiable("bytes=-10", 0));
+
+    // Multiple ranges, other units and garbage fall back to the full body
+    CHECK(isFull("bytes=0-1,5-6", 1000));
+    CHECK(isFull("bytes=0-1, 2000-3000", 1000));
+    CHECK(isFull("items=0-1", 1000));
+    CHECK(isFull("bytes=abc", 1000));
+    CHECK(isFull("bytes=1-x", 1000));
+    CHECK(isFull("bytes=-", 1000));
+    CHECK(isFull("bytes=", 1000));
+}
+
+static void testConditional() {
+    char etag[WEB_ETAG_SIZE];
+    webMakeETag(etag, sizeof(etag), 100000, 100000000);
+    CHECK(strcmp(etag, "\"186a0-5f5e100\"") == 0);
+    char other[WEB_ETAG_SIZE];
+    webMakeETag(other, sizeof(other), 100000, 100000001);
+    CHECK(strcmp(etag, other) != 0);
+    webMakeETag(other, sizeof(other), 100001, 100000000);
+    CHECK(strcmp(etag, other) != 0);
+
+    size_t start, end;
+    // If-Range with current ETag keeps the range, stale one gets the whole changed file
+    CHECK(resolve("bytes=100-199", 1000, &start, &end, etag) == WEB_FILE_PARTIAL && start == 100 && end == 199);
+    CHECK(resolve("bytes=100-199", 1000, &start, &end, other) == WEB_FILE_FULL && start == 0 && end == 999);
+    // Stale If-Range doesn't make an unsatisfiable range an error
+    CHECK(resolve("bytes=5000-", 1000, &start, &end, other) == WEB_FILE_FULL && start == 0 && end == 999);
+    CHECK(resolve(NULL, 1000, &start, &end, etag) == WEB_FILE_FULL);
+
+    CHECK(resolve(NULL, 1000, &start, &end, NULL, etag) == WEB_FILE_NOT_MODIFIED);
+    CHECK(resolve("bytes=0-1", 1000, &start, &end, NULL, "*") == WEB_FILE_NOT_MODIFIED);
+    CHECK(resolve(NULL, 1000, &start, &end, NULL, "\"1-2\", \"186a0-5f5e100\"") == WEB_FILE_NOT_MODIFIED);
+    CHECK(resolve("bytes=0-1", 1000, &start, &end, NULL, other) == WEB_FILE_PARTIAL);
+}
+
+typedef struct {
+    std::string data;
+    // Send fails once this many bytes were sent, -1 to never fail
+    long failAfter;
+} Client;
+
+static bool sendToClient(void* context, const char* data, size_t size) {
+    Client* client = static_cast<Client*>(context);
+    if (client->failAfter >= 0 && client->data.size() + size > static_cast<size_t>(client->failAfter)) {
+        return false;
+    }
+    client->data.append(data, size);
+    return true;
+}
+
+// Sends body of a range the way download handler does and checks it holds the requested bytes
+static void checkBody(const char* range) {
+    size_t start, end;
+    WebFileReply reply = resolve(range, TEST_FILE_SIZE, &start, &end);
+    if (!CHECK(reply == WEB_FILE_PARTIAL || reply == WEB_FILE_FULL)) return;
+
+    FILE* file = fopen(path, "rb");
+    if (!CHECK(file != NULL)) return;
+    Client client = {"", -1};
+    CHECK(fseek(file, start, SEEK_SET) == 0);
+    CHECK(webSendFileBody(file, end - start + 1, sendToClient, &client));
+    fclose(file);
+
+    bool same = client.data.size() == end - start + 1;
+    for (size_t i = 0; same && i < client.data.size(); i++) {
+        same = client.data[i] == byteAt(start + i);
+    }
+    if (!CHECK(same)) fprintf(stderr, "  range %s\n", range);
+}
+
+static void testBody() {
+    checkBody(NULL);
+    checkBody("bytes=0-0");
+    checkBody("bytes=1000-1999");
+    // Exactly one buffer is still sent in one go, one more byte goes through reader task
+    checkBody("bytes=0-16383");
+    checkBody("bytes=0-16384");
+    checkBody("bytes=12345-");
+    checkBody("bytes=-50000");
+    checkBody("bytes=99990-200000");
+
+    // Client going away and file shorter than expected stop the transfer
+    FILE* file = fopen(path, "rb");
+    if (!CHECK(file != NULL)) return;
+    Client client = {"", WEB_BUFFER_FILE_STREAM + 100};
+    CHECK(!webSendFileBody(file, TEST_FILE_SIZE, sendToClient, &client));
+    CHECK(client.data.size() == WEB_BUFFER_FILE_STREAM);
+    fseek(file, 0, SEEK_SET);
+    client = {"", -1};
+    CHECK(!webSendFileBody(file, TEST_FILE_SIZE + 1, sendToClient, &client));
+    CHECK(client.data.size() == TEST_FILE_SIZE);
+    fclose(file);
+}
+
+int main() {
+    int fd = mkstemp(path);
+    if (fd < 0) {
+        perror("mkstemp");
+        return 1;
+    }
+    std::string data(TEST_FILE_SIZE, 0);
+    for (size_t i = 0; i < TEST_FILE_SIZE; i++) {
+        data[i] = byteAt(i);
+    }
+    bool written = write(fd, data.data(), data.size()) == TEST_FILE_SIZE;
+    close(fd);
+    if (!written) {
+        perror(path);
+        unlink(path);
+        return 1;
+    }
+
+    testRanges();
+    testConditional();
+    testBody();
+
+    unlink(path);
+    return checkResult("range");
+}
@@ -0,0 +1,288 @@
+// PNGWriter output is decoded with zlib and compared with source pixels, ScreenRecorder
+// stream is decoded back into frames following the format described in recorder.h
+#include <stdlib.h>
+#include <unistd.h>
+#include <random>
+#include <vector>
+#include <zlib.h>
+#include "check.h"
+#include "services/screenshot/pngwriter.h"
+#include "services/screenshot/recorder.h"
+
+typedef enum {
+    IMAGE_UI,
+    IMAGE_NOISE,
+    IMAGE_GRADIENT,
+} image_kind_t;
+
+static std::vector<uint16_t> makeImage(uint16_t width, uint16_t height, image_kind_t kind) {
+    std::mt19937 rng(width * height + kind);
+    std::vector<uint16_t> image(width * height);
+    for (uint32_t y = 0; y < height; y++) {
+        for (uint32_t x = 0; x < width; x++) {
+            uint16_t& pixel = image[y * width + x];
+            if (kind == IMAGE_UI) {
+                // Flat panels, a few lines of "text" and repeated rows
+                pixel = y < 24 ? 0x2104 : ((x / 40 + y / 30) % 2 ? 0xFFFF : 0x001F);
+                if (y % 30 > 10 && y % 30 < 18 && x % 7 < 4) pixel = rng() % 4 ? 0x0000 : pixel;
+            } else if (kind == IMAGE_NOISE) {
+                pixel = rng();
+            } else {
+                pixel = (x * 31 / width) << 11 | (y * 63 / height) << 5 | (x + y) % 32;
+            }
+        }
+    }
+    return image;
+}
+
+static uint32_t readBE32(const uint8_t* data) {
+    return static_cast<uint32_t>(data[0]) << 24 | data[1] << 16 | data[2] << 8 | data[3];
+}
+
+static std::vector<uint8_t> readFile(const std::string& path) {
+    std::vector<uint8_t> data;
+    FILE* file = fopen(path.c_str(), "rb");
+    if (!file) return data;
+    uint8_t buffer[4096];
+    size_t size;
+    while ((size = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        data.insert(data.end(), buffer, buffer + size);
+    }
+    fclose(file);
+    return data;
+}
+
+static uint8_t paeth(uint8_t a, uint8_t b, uint8_t c) {
+    int p = a + b - c;
+    int pa = abs(p - a), pb = abs(p - b), pc = abs(p - c);
+    return pa <= pb && pa <= pc ? a : (pb <= pc ? b : c);
+}
+
+// Decodes 8-bit RGB PNG, checking chunk CRCs. Returns false if anything doesn't match the spec
+static bool decodePNG(const std::vector<uint8_t>& png, uint32_t* width, uint32_t* height, std::vector<uint8_t>* rgb) {
+    static const uint8_t signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    if (png.size() < 8 || memcmp(png.data(), signature, 8) != 0) return false;
+
+    std::vector<uint8_t> compressed;
+    bool header = false, end = false;
+    for (size_t offset = 8; offset < png.size() && !end;) {
+        if (png.size() - offset < 12) return false;
+        uint32_t length = readBE32(&png[offset]);
+        if (png.size() - offset - 12 < length) return false;
+        const uint8_t* type = &png[offset + 4];
+        const uint8_t* data = type + 4;
+        if (crc32(0, type, length + 4) != readBE32(data + length)) return false;
+        if (memcmp(type, "IHDR", 4) == 0) {
+            if (header || length != 13) return false;
+            *width = readBE32(data);
+            *height = readBE32(data + 4);
+            // 8 bits, truecolor, deflate, adaptive filtering, no interlace
+            if (data[8] != 8 || data[9] != 2 || data[10] || data[11] || data[12]) return false;
+            header = true;
+        } else if (memcmp(type, "IDAT", 4) == 0) {
+            compressed.insert(compressed.end(), data, data + length);
+        } else if (memcmp(type, "IEND", 4) == 0) {
+            end = true;
+        }
+        offset += length + 12;
+    }
+    if (!header || !end) return false;
+
+    const uint32_t stride = *width * 3;
+    std::vector<uint8_t> filtered((stride + 1) * *height);
+    uLongf size = filtered.size();
+    if (uncompress(filtered.data(), &size, compressed.data(), compressed.size()) != Z_OK) return false;
+    if (size != filtered.size()) return false;
+
+    rgb->assign(stride * *height, 0);
+    for (uint32_t y = 0; y < *height; y++) {
+        const uint8_t* in = &filtered[y * (stride + 1)];
+        uint8_t* out = &(*rgb)[y * stride];
+        const uint8_t* up = y ? out - stride : NULL;
+        for (uint32_t i = 0; i < stride; i++) {
+            uint8_t a = i >= 3 ? out[i - 3] : 0;
+            uint8_t b = up ? up[i] : 0;
+            uint8_t c = up && i >= 3 ? up[i - 3] : 0;
+            uint8_t predictor;
+            switch (in[0]) {
+                case 0:
+                    predictor = 0;
+                    break;
+                case 1:
+                    predictor = a;
+                    break;
+                case 2:
+                    predictor = b;
+                    break;
+                case 3:
+                    predictor = (a + b) / 2;
+                    break;
+                case 4:
+                    predictor = paeth(a, b, c);
+                    break;
+                default:
+                    return false;
+            }
+            out[i] = in[i + 1] + predictor;
+        }
+    }
+    return true;
+}
+
+static void testPNG(const std::string& root, uint16_t width, uint16_t height, image_kind_t kind) {
+    std::vector<uint16_t> image = makeImage(width, height, kind);
+    File file = SD.open("/test.png", FILE_WRITE, true);
+    CHECK(static_cast<bool>(file));
+    {
+        PNGWriter writer(&file, width, height);
+        bool ok = writer.begin();
+        for (uint16_t y = 0; y < height; y++) {
+            ok = writer.writeRow(&image[y * width]) && ok;
+        }
+        CHECK(writer.end() && ok);
+    }
+    file.close();
+
+    std::vector<uint8_t> png = readFile(root + "/test.png");
+    uint32_t decodedWidth = 0, decodedHeight = 0;
+    std::vector<uint8_t> rgb;
+    if (!CHECK(decodePNG(png, &decodedWidth, &decodedHeight, &rgb))) return;
+    CHECK(decodedWidth == width && decodedHeight == height);
+
+    bool same = rgb.size() == image.size() * 3;
+    for (size_t i = 0; same && i < image.size(); i++) {
+        uint16_t pixel = image[i];
+        same = rgb[i * 3] == (pixel >> 11 & 0x1F) * 255 / 31 && rgb[i * 3 + 1] == (pixel >> 5 & 0x3F) * 255 / 63 &&
+               rgb[i * 3 + 2] == (pixel & 0x1F) * 255 / 31;
+    }
+    CHECK(same);
+    // Flat screens are what the match search is for
+    if (kind == IMAGE_UI) CHECK(png.size() < image.size() * 3 / 10);
+}
+
+static void testPNGs(const std::string& root) {
+    testPNG(root, 280, 240, IMAGE_UI);
+    // Spans many IDAT chunks, and leaves almost nothing to match
+    testPNG(root, 280, 240, IMAGE_NOISE);
+    testPNG(root, 280, 240, IMAGE_GRADIENT);
+    testPNG(root, 1, 1, IMAGE_NOISE);
+    testPNG(root, 7, 3, IMAGE_GRADIENT);
+    // Row runs longer than the longest deflate match
+    testPNG(root, 1000, 2, IMAGE_UI);
+}
+
+// Applies one frame of KREC stream to screen. Returns false if ops don't cover it exactly
+static bool decodeFrame(const std::vector<uint8_t>& stream, size_t* offset, std::vector<uint16_t>* screen) {
+    auto byte = [&](uint8_t* value) {
+        if (*offset >= stream.size()) return false;
+        *value = stream[(*offset)++];
+        return true;
+    };
+    auto word = [&](uint16_t* value) {
+        uint8_t low, high;
+        if (!byte(&low) || !byte(&high)) return false;
+        *value = low | high << 8;
+        return true;
+    };
+    size_t pixel = 0;
+    while (pixel < screen->size()) {
+        uint8_t op;
+        if (!byte(&op)) return false;
+        uint16_t count = op & 0x3F;
+        if (!count && !word(&count)) return false;
+        if (!count || pixel + count > screen->size()) return false;
+        uint16_t color;
+        switch (op >> 6) {
+            case SCREEN_RECORDER_OP_SKIP:
+                break;
+            case SCREEN_RECORDER_OP_FILL:
+                if (!word(&color)) return false;
+                std::fill(screen->begin() + pixel, screen->begin() + pixel + count, color);
+                break;
+            case SCREEN_RECORDER_OP_COPY:
+                for (uint16_t i = 0; i < count; i++) {
+                    if (!word(&(*screen)[pixel + i])) return false;
+                }
+                break;
+            default:
+                return false;
+        }
+        pixel += count;
+    }
+    return true;
+}
+
+static void testRecorder(const std::string& root) {
+    const uint16_t width = 280, height = 240;
+    std::mt19937 rng(3);
+    std::vector<std::vector<uint16_t>> frames;
+    std::vector<uint16_t> frame = makeImage(width, height, IMAGE_UI);
+    frames.push_back(std::vector<uint16_t>(width * height, 0));
+    frames.push_back(frame);
+    frames.push_back(frame);
+    // Small changes, single pixels and noise
+    for (int i = 0; i < 20; i++) {
+        frame[rng() % frame.size()] ^= 0xFFFF;
+        uint32_t start = rng() % (frame.size() - 100);
+        for (uint32_t j = start; j < start + 100; j++) {
+            frame[j] = rng() % 3 ? frame[j] : rng();
+        }
+        frames.push_back(frame);
+    }
+    // Whole screen changed, with runs longer than a single op can hold
+    frames.push_back(std::vector<uint16_t>(width * height, 0x1234));
+    frames.push_back(makeImage(width, height, IMAGE_NOISE));
+    frames.push_back(makeImage(width, height, IMAGE_GRADIENT));
+
+    ScreenRecorder recorder;
+    CHECK(recorder.begin("/test.krec", width, height, 40));
+    CHECK(recorder.isRecording());
+    for (size_t i = 0; i < frames.size(); i++) {
+        CHECK(recorder.writeFrame(frames[i].data(), 1000 * i + 70000));
+    }
+    CHECK(recorder.getFrameCount() == frames.size());
+    CHECK(recorder.end());
+    CHECK(!recorder.isRecording());
+
+    std::vector<uint8_t> stream = readFile(root + "/test.krec");
+    if (!CHECK(stream.size() > 12)) return;
+    CHECK(memcmp(stream.data(), SCREEN_RECORDER_MAGIC, 4) == 0);
+    CHECK(stream[4] == SCREEN_RECORDER_VERSION);
+    CHECK((stream[6] | stream[7] << 8) == width);
+    CHECK((stream[8] | stream[9] << 8) == height);
+    CHECK((stream[10] | stream[11] << 8) == 40);
+
+    std::vector<uint16_t> screen(width * height, 0);
+    size_t offset = 12;
+    for (size_t i = 0; i < frames.size(); i++) {
+        if (!CHECK(stream.size() - offset >= 4)) return;
+        uint32_t timestamp = stream[offset] | stream[offset + 1] << 8 | stream[offset + 2] << 16 |
+                             static_cast<uint32_t>(stream[offset + 3]) << 24;
+        offset += 4;
+        CHECK(timestamp == 1000 * i + 70000);
+        size_t frameStart = offset;
+        if (!CHECK(decodeFrame(stream, &offset, &screen))) return;
+        CHECK(screen == frames[i]);
+        // Unchanged frame is only a couple of skip ops
+        if (i && frames[i] == frames[i - 1]) CHECK(offset - frameStart <= 6);
+    }
+    CHECK(offset == stream.size());
+
+    CHECK(!recorder.begin("/missing/test.krec", width, height, 40));
+    CHECK(!recorder.isRecording());
+}
+
+int main() {
+    char root[] = "/tmp/keira-screenshot-XXXXXX";
+    if (!mkdtemp(root)) {
+        perror("mkdtemp");
+        return 1;
+    }
+    SD.root = root;
+    testPNGs(root);
+    testRecorder(root);
+    SD.remove("/test.png");
+    SD.remove("/test.krec");
+    rmdir(root);
+    return checkResult("screenshot");
+}
@@ -0,0 +1,109 @@
+// Sequencer::queueRow: notes start and stop at the exact sample of their row,
+// no matter where buffer boundaries fall, and full synth event queue is reported
+#include <vector>
+#include "check.h"
+#include "apps/liltracker/sequencer.h"
+
+// Not a multiple of buffer size, so rows start in the middle of buffers
+#define TEST_BPM      170
+#define TEST_ROW_SIZE (SYNTH_SAMPLE_RATE * 60 / TEST_BPM)
+
+static event_t makeEvent(event_type_t type) {
+    event_t event = {};
+    event.note = {9, 4};
+    event.waveform = type == EVENT_TYPE_NORMAL ? WAVEFORM_SQUARE : WAVEFORM_CONT;
+    event.type = type;
+    event.effect = {EFFECT_TYPE_NONE, 0};
+    return event;
+}
+
+// Queues rows right before the buffer they start in, the same way Sequencer::multiEventTask does,
+// and returns rendered samples of one channel
+static std::vector<int16_t> render(
+    Synth* const synths[CHANNEL_COUNT], Track* track, uint8_t channelIndex, uint16_t rowCount
+) {
+    int16_t combinedBuffer[SYNTH_BUFFER_SIZE];
+    int16_t channelBuffers[CHANNEL_COUNT][SYNTH_BUFFER_SIZE];
+    std::vector<int16_t> samples;
+    Synth* synth = synths[channelIndex];
+    uint16_t eventIndex = 0;
+    int64_t rowSample = 0;
+    while (samples.size() < static_cast<size_t>(rowCount) * TEST_ROW_SIZE) {
+        while (eventIndex < rowCount && rowSample < synth->getCurrentSample() + SYNTH_BUFFER_SIZE) {
+            CHECK(Sequencer::queueRow(synths, track, 0, eventIndex++, rowSample));
+            rowSample += TEST_ROW_SIZE;
+        }
+        // Other synths are rendered too, so their queues don't fill up
+        for (uint8_t i = 0; i < CHANNEL_COUNT; i++) {
+            if (synths[i] != synth) {
+                synths[i]->render(combinedBuffer, channelBuffers, SYNTH_BUFFER_SIZE, 0.5f);
+            }
+        }
+        synth->render(combinedBuffer, channelBuffers, SYNTH_BUFFER_SIZE, 0.5f);
+        samples.insert(samples.end(), channelBuffers[channelIndex], channelBuffers[channelIndex] + SYNTH_BUFFER_SIZE);
+    }
+    return samples;
+}
+
+// Returns true if samples in [start; end) are all silent, or all sounding
+static bool isSilent(const std::vector<int16_t>& samples, size_t start, size_t end, bool silent) {
+    for (size_t i = start; i < end; i++) {
+        if ((samples[i] == 0) != silent) return false;
+    }
+    return true;
+}
+
+static void testOnsets() {
+    Track track(TEST_BPM);
+    Pattern* pattern = track.getPattern(0);
+    pattern->setChannelEvent(0, 1, makeEvent(EVENT_TYPE_NORMAL));
+    pattern->setChannelEvent(0, 3, makeEvent(EVENT_TYPE_OFF));
+    pattern->setChannelEvent(0, 4, makeEvent(EVENT_TYPE_NORMAL));
+
+    Synth synth;
+    Synth* synths[CHANNEL_COUNT] = {&synth, &synth, &synth};
+    std::vector<int16_t> samples = render(synths, &track, 0, 6);
+
+    CHECK(isSilent(samples, 0, TEST_ROW_SIZE, true));
+    CHECK(isSilent(samples, TEST_ROW_SIZE, TEST_ROW_SIZE * 3, false));
+    CHECK(isSilent(samples, TEST_ROW_SIZE * 3, TEST_ROW_SIZE * 4, true));
+    CHECK(isSilent(samples, TEST_ROW_SIZE * 4, TEST_ROW_SIZE * 6, false));
+}
+
+static void testChannelSynths() {
+    Track track(TEST_BPM);
+    track.getPattern(0)->setChannelEvent(1, 2, makeEvent(EVENT_TYPE_NORMAL));
+
+    // Offline render gives each channel its own synth
+    Synth channelSynths[CHANNEL_COUNT];
+    Synth* synths[CHANNEL_COUNT] = {&channelSynths[0], &channelSynths[1], &channelSynths[2]};
+    std::vector<int16_t> samples = render(synths, &track, 1, 4);
+
+    CHECK(isSilent(samples, 0, TEST_ROW_SIZE * 2, true));
+    CHECK(isSilent(samples, TEST_ROW_SIZE * 2, TEST_ROW_SIZE * 4, false));
+}
+
+static void testQueueOverflow() {
+    Track track(TEST_BPM);
+    track.getPattern(0)->setChannelEvent(0, 0, makeEvent(EVENT_TYPE_NORMAL));
+
+    Synth synth;
+    Synth* synths[CHANNEL_COUNT] = {&synth, &synth, &synth};
+    for (int i = 0; i < SYNTH_EVENT_QUEUE_SIZE; i++) {
+        CHECK(synth.setVolume(0, 1.0f, 0));
+    }
+    CHECK(!Sequencer::queueRow(synths, &track, 0, 0, 0));
+
+    // Rendering drains the queue
+    int16_t combinedBuffer[SYNTH_BUFFER_SIZE];
+    int16_t channelBuffers[CHANNEL_COUNT][SYNTH_BUFFER_SIZE];
+    synth.render(combinedBuffer, channelBuffers, SYNTH_BUFFER_SIZE, 0.5f);
+    CHECK(Sequencer::queueRow(synths, &track, 0, 0, SYNTH_BUFFER_SIZE));
+}
+
+int main() {
+    testOnsets();
+    testChannelSynths();
+    testQueueOverflow();
+    return checkResult("sequencer");
+}
@@ -0,0 +1,155 @@
+// AudioFileSourceStream: data comes out intact whatever the card speed, decoder waiting on a slow card is
+// counted as underrun while waiting for refill after seek isn't, and seeks land where they should.
+// Reader task runs on pthreads (keira-sim FreeRTOS), card speed is faked by delaying its reads
+#include <stdlib.h>
+#include <unistd.h>
+#include <atomic>
+#include <vector>
+#include "check.h"
+#include "keira/ksound/streamsource.h"
+
+// Four chunks of buffer, file spanning several buffers and ending mid-chunk
+#define TEST_BUFFER_SIZE (4 * KSOUND_STREAM_CHUNK_SIZE)
+#define TEST_FILE_SIZE   (300000)
+// Decoder reads this much at a time
+#define TEST_READ_SIZE   4096
+// Time to read one chunk on slow card, ms
+#define TEST_SLOW_READ   10
+
+static char path[] = "/tmp/keira-stream-XXXXXX";
+static std::atomic<int> readDelay{0};
+
+// Linked with --wrap=read, so reader task's reads go through here
+extern "C" ssize_t __real_read(int fd, void* buf, size_t count);
+extern "C" ssize_t __wrap_read(int fd, void* buf, size_t count) {
+    if (readDelay) vTaskDelay(pdMS_TO_TICKS(readDelay));
+    return __real_read(fd, buf, count);
+}
+
+// Every byte depends on its position, so data from wrong offset is noticed
+static uint8_t byteAt(uint32_t pos) {
+    return (pos ^ (pos >> 8) ^ (pos >> 16)) & 0xFF;
+}
+
+// Reads len bytes expecting them to start at pos, returns amount read if data is right
+static uint32_t readAt(lilka::AudioFileSourceStream& stream, uint32_t pos, uint32_t len) {
+    std::vector<uint8_t> data(len);
+    uint32_t got = stream.read(data.data(), len);
+    for (uint32_t i = 0; i < got; i++) {
+        if (data[i] != byteAt(pos + i)) {
+            fprintf(stderr, "byte %u: got %u, expected %u\n", pos + i, data[i], byteAt(pos + i));
+            return 0;
+        }
+    }
+    return got;
+}
+
+// Waits till reader task can't fit another chunk into buffer
+static bool waitFull(lilka::AudioFileSourceStream& stream) {
+    size_t full = stream.getBufferSize() - KSOUND_STREAM_CHUNK_SIZE;
+    for (int i = 0; i < 1000 && stream.getBufferLevel() <= full; i++) {
+        vTaskDelay(pdMS_TO_TICKS(1));
+    }
+    return stream.getBufferLevel() > full;
+}
+
+static void testBuffered() {
+    readDelay = 0;
+    lilka::AudioFileSourceStream stream(TEST_BUFFER_SIZE);
+    if (!CHECK(stream.open(path))) return;
+    CHECK(stream.getSize() == TEST_FILE_SIZE);
+    CHECK(waitFull(stream));
+
+    // Everything decoder asks for is already there
+    for (uint32_t pos = 0; pos < TEST_BUFFER_SIZE; pos += TEST_READ_SIZE) {
+        CHECK(readAt(stream, pos, TEST_READ_SIZE) == TEST_READ_SIZE);
+    }
+    CHECK(stream.getUnderruns() == 0);
+}
+
+static void testSlowCard() {
+    readDelay = TEST_SLOW_READ;
+    lilka::AudioFileSourceStream stream(TEST_BUFFER_SIZE);
+    if (!CHECK(stream.open(path))) return;
+
+    // Decoder is faster than card: it has to wait, but gets everything in order
+    uint32_t pos = 0;
+    while (pos < TEST_FILE_SIZE) {
+        uint32_t got = readAt(stream, pos, TEST_READ_SIZE);
+        if (!CHECK(got > 0)) break;
+        pos += got;
+    }
+    CHECK(pos == TEST_FILE_SIZE);
+    CHECK(stream.getPos() == TEST_FILE_SIZE);
+    CHECK(stream.getUnderruns() > 0);
+    // Waits are counted once per read, not per wakeup
+    CHECK(stream.getUnderruns() <= TEST_FILE_SIZE / TEST_READ_SIZE + 1);
+
+    uint8_t byte;
+    CHECK(stream.read(&byte, 1) == 0);
+}
+
+static void testSeek() {
+    readDelay = 0;
+    lilka::AudioFileSourceStream stream(TEST_BUFFER_SIZE);
+    if (!CHECK(stream.open(path))) return;
+    CHECK(waitFull(stream));
+
+    // Forward within buffered data
+    uint32_t pos = 2 * KSOUND_STREAM_CHUNK_SIZE + 100;
+    CHECK(stream.seek(pos, SEEK_SET));
+    CHECK(stream.getPos() == pos);
+    CHECK(readAt(stream, pos, TEST_READ_SIZE) == TEST_READ_SIZE);
+    pos += TEST_READ_SIZE + 1000;
+    CHECK(stream.seek(1000, SEEK_CUR));
+    CHECK(readAt(stream, pos, TEST_READ_SIZE) == TEST_READ_SIZE);
+
+    // Backwards and far forward refill buffer. Decoder waits for it on slow card, but that's no underrun.
+    // Buffer is topped up first, so start of file is overwritten in it
+    CHECK(waitFull(stream));
+    readDelay = TEST_SLOW_READ;
+    CHECK(stream.seek(10, SEEK_SET));
+    CHECK(stream.getPos() == 10);
+    CHECK(readAt(stream, 10, TEST_READ_SIZE) == TEST_READ_SIZE);
+    pos = TEST_FILE_SIZE - 3 * TEST_READ_SIZE;
+    CHECK(stream.seek(pos, SEEK_SET));
+    CHECK(readAt(stream, pos, TEST_READ_SIZE) == TEST_READ_SIZE);
+    CHECK(stream.getUnderruns() == 0);
+
+    // Read past the end is cut short
+    CHECK(stream.seek(-100, SEEK_END));
+    CHECK(readAt(stream, TEST_FILE_SIZE - 100, 200) == 100);
+
+    // Outside of file position doesn't change
+    CHECK(!stream.seek(TEST_FILE_SIZE + 1, SEEK_SET));
+    CHECK(!stream.seek(-1, SEEK_SET));
+    CHECK(stream.getPos() == TEST_FILE_SIZE);
+    CHECK(stream.seek(0, SEEK_SET));
+    CHECK(readAt(stream, 0, TEST_READ_SIZE) == TEST_READ_SIZE);
+}
+
+int main() {
+    int fd = mkstemp(path);
+    if (fd < 0) {
+        perror("mkstemp");
+        return 1;
+    }
+    std::vector<uint8_t> data(TEST_FILE_SIZE);
+    for (uint32_t i = 0; i < TEST_FILE_SIZE; i++) {
+        data[i] = byteAt(i);
+    }
+    bool written = write(fd, data.data(), data.size()) == TEST_FILE_SIZE;
+    close(fd);
+    if (!written) {
+        perror(path);
+        unlink(path);
+        return 1;
+    }
+
+    testBuffered();
+    testSlowCard();
+    testSeek();
+
+    unlink(path);
+    return checkResult("streamsource");
+}
@@ -0,0 +1,76 @@
+#pragma once
+//////////////////////////////////////////////////////////////////////////////
+// Host stand-in for Arduino String, only the methods used by code under test
+//////////////////////////////////////////////////////////////////////////////
+#include <ctype.h>
+#include <stdint.h>
+#include <string.h>
+#include <string>
+
+class String {
+public:
+    String() {
+    }
+    String(const char* str) : value(str ? str : "") {
+    }
+    String(const std::string& str) : value(str) {
+    }
+    explicit String(int number) : value(std::to_string(number)) {
+    }
+
+    const char* c_str() const {
+        return value.c_str();
+    }
+    unsigned int length() const {
+        return value.size();
+    }
+    bool isEmpty() const {
+        return value.empty();
+    }
+    bool startsWith(const String& prefix) const {
+        return value.compare(0, prefix.value.size(), prefix.value) == 0;
+    }
+    bool endsWith(const String& suffix) const {
+        return value.size() >= suffix.value.size() &&
+               value.compare(value.size() - suffix.value.size(), suffix.value.size(), suffix.value) == 0;
+    }
+    int indexOf(char c) const {
+        size_t pos = value.find(c);
+        return pos == std::string::npos ? -1 : pos;
+    }
+    int lastIndexOf(char c) const {
+        size_t pos = value.rfind(c);
+        return pos == std::string::npos ? -1 : pos;
+    }
+    String substring(unsigned int from) const {
+        return from < value.size() ? value.substr(from) : "";
+    }
+    String substring(unsigned int from, unsigned int to) const {
+        return from < to && from < value.size() ? value.substr(from, to - from) : "";
+    }
+    void toLowerCase() {
+        for (char& c : value) {
+            c = tolower(static_cast<unsigned char>(c));
+        }
+    }
+
+    String& operator+=(const String& other) {
+        value += other.value;
+        return *this;
+    }
+    friend String operator+(const String& a, const String& b) {
+        return a.value + b.value;
+    }
+    friend bool operator==(const String& a, const String& b) {
+        return a.value == b.value;
+    }
+    friend bool operator!=(const String& a, const String& b) {
+        return a.value != b.value;
+    }
+    friend bool operator<(const String& a, const String& b) {
+        return a.value < b.value;
+    }
+
+private:
+    std::string value;
+};
@@ -0,0 +1,259 @@
+#pragma once
+//////////////////////////////////////////////////////////////////////////////
+// Host stand-in for the parts of ArduinoJson 7 used by code under test.
+// Documents are parsed into a plain tree. Filters are accepted but not
+// applied, on device they only save memory.
+//////////////////////////////////////////////////////////////////////////////
+#include <ctype.h>
+#include <stdlib.h>
+#include <map>
+#include <string>
+#include <vector>
+#include "Arduino.h"
+
+namespace ArduinoJson {
+
+class Allocator {
+public:
+    virtual ~Allocator() {
+    }
+    virtual void* allocate(size_t size) = 0;
+    virtual void* reallocate(void* ptr, size_t size) = 0;
+    virtual void deallocate(void* ptr) = 0;
+};
+
+} // namespace ArduinoJson
+
+struct JsonValue {
+    enum { JSON_NULL, JSON_LITERAL, JSON_STRING, JSON_ARRAY, JSON_OBJECT } type = JSON_NULL;
+    // String contents, or number and boolean as written
+    std::string text;
+    std::map<std::string, JsonValue> members;
+    std::vector<JsonValue> items;
+};
+
+// Path from document root, resolved on every access, so reading missing keys doesn't create them
+class JsonVariant {
+public:
+    JsonVariant(JsonValue* root, std::vector<std::string> path) : root(root), path(path) {
+    }
+
+    JsonVariant operator[](const char* key) const {
+        std::vector<std::string> child = path;
+        child.push_back(key);
+        return JsonVariant(root, child);
+    }
+
+    JsonVariant& operator=(bool value) {
+        JsonValue* node = root;
+        for (const std::string& key : path) {
+            node->type = JsonValue::JSON_OBJECT;
+            node = &node->members[key];
+        }
+        node->type = JsonValue::JSON_LITERAL;
+        node->text = value ? "true" : "false";
+        return *this;
+    }
+
+    template <typename T>
+    T as() const;
+
+private:
+    const JsonValue* resolve() const {
+        const JsonValue* node = root;
+        for (const std::string& key : path) {
+            if (node->type != JsonValue::JSON_OBJECT) return NULL;
+            auto it = node->members.find(key);
+            if (it == node->members.end()) return NULL;
+            node = &it->second;
+        }
+        return node;
+    }
+
+    JsonValue* root;
+    std::vector<std::string> path;
+};
+
+template <>
+inline String JsonVariant::as<String>() const {
+    const JsonValue* node = resolve();
+    if (!node || node->type == JsonValue::JSON_NULL) return "null";
+    return node->type == JsonValue::JSON_STRING || node->type == JsonValue::JSON_LITERAL ? node->text : "";
+}
+
+class JsonDocument {
+public:
+    JsonDocument() {
+    }
+    explicit JsonDocument(ArduinoJson::Allocator*) {
+    }
+
+    JsonVariant operator[](const char* key) {
+        return JsonVariant(&root, {key});
+    }
+
+    JsonValue root;
+};
+
+class DeserializationError {
+public:
+    explicit DeserializationError(bool failed) : failed(failed) {
+    }
+    explicit operator bool() const {
+        return failed;
+    }
+    const char* c_str() const {
+        return failed ? "InvalidInput" : "Ok";
+    }
+
+private:
+    bool failed;
+};
+
+namespace DeserializationOption {
+
+class Filter {
+public:
+    explicit Filter(JsonDocument&) {
+    }
+};
+
+} // namespace DeserializationOption
+
+class HostJsonParser {
+public:
+    HostJsonParser(const char* data, size_t size) : pos(data), end(data + size) {
+    }
+
+    bool parse(JsonValue* value) {
+        return parseValue(value) && (skipSpace(), pos == end);
+    }
+
+private:
+    void skipSpace() {
+        while (pos < end && (*pos == ' ' || *pos == '\t' || *pos == '\r' || *pos == '\n')) {
+            pos++;
+        }
+    }
+
+    bool parseString(std::string* text) {
+        if (pos == end || *pos++ != '"') return false;
+        while (pos < end && *pos != '"') {
+            char c = *pos++;
+            if (c != '\\') {
+                *text += c;
+                continue;
+            }
+            if (pos == end) return false;
+            c = *pos++;
+            switch (c) {
+                case 'b':
+                    *text += '\b';
+                    break;
+                case 'f':
+                    *text += '\f';
+                    break;
+                case 'n':
+                    *text += '\n';
+                    break;
+                case 'r':
+                    *text += '\r';
+                    break;
+                case 't':
+                    *text += '\t';
+                    break;
+                case 'u': {
+                    if (end - pos < 4) return false;
+                    unsigned code = strtoul(std::string(pos, 4).c_str(), NULL, 16);
+                    pos += 4;
+                    if (code < 0x80) {
+                        *text += static_cast<char>(code);
+                    } else if (code < 0x800) {
+                        *text += static_cast<char>(0xC0 | code >> 6);
+                        *text += static_cast<char>(0x80 | (code & 0x3F));
+                    } else {
+                        *text += static_cast<char>(0xE0 | code >> 12);
+                        *text += static_cast<char>(0x80 | (code >> 6 & 0x3F));
+                        *text += static_cast<char>(0x80 | (code & 0x3F));
+                    }
+                    break;
+                }
+                default:
+                    *text += c;
+                    break;
+            }
+        }
+        return pos < end && *pos++ == '"';
+    }
+
+    bool parseValue(JsonValue* value) {
+        skipSpace();
+        if (pos == end) return false;
+        if (*pos == '"') {
+            value->type = JsonValue::JSON_STRING;
+            return parseString(&value->text);
+        }
+        if (*pos == '{') {
+            value->type = JsonValue::JSON_OBJECT;
+            pos++;
+            skipSpace();
+            if (pos < end && *pos == '}') return ++pos, true;
+            while (true) {
+                std::string key;
+                skipSpace();
+                if (!parseString(&key)) return false;
+                skipSpace();
+                if (pos == end || *pos++ != ':') return false;
+                if (!parseValue(&value->members[key])) return false;
+                skipSpace();
+                if (pos == end) return false;
+                if (*pos == '}') return ++pos, true;
+                if (*pos++ != ',') return false;
+            }
+        }
+        if (*pos == '[') {
+            value->type = JsonValue::JSON_ARRAY;
+            pos++;
+            skipSpace();
+            if (pos < end && *pos == ']') return ++pos, true;
+            while (true) {
+                value->items.emplace_back();
+                if (!parseValue(&value->items.back())) return false;
+                skipSpace();
+                if (pos == end) return false;
+                if (*pos == ']') return ++pos, true;
+                if (*pos++ != ',') return false;
+            }
+        }
+        // Numbers, booleans and null are kept as written
+        const char* start = pos;
+        while (pos < end && (isalnum(static_cast<unsigned char>(*pos)) || *pos == '-' || *pos == '+' || *pos == '.')) {
+            pos++;
+        }
+        std::string literal(start, pos);
+        if (literal.empty()) return false;
+        if (literal == "null") {
+            value->type = JsonValue::JSON_NULL;
+            return true;
+        }
+        value->type = JsonValue::JSON_LITERAL;
+        value->text = literal;
+        char* numberEnd;
+        strtod(literal.c_str(), &numberEnd);
+        return literal == "true" || literal == "false" || *numberEnd == '\0';
+    }
+
+    const char* pos;
+    const char* end;
+};
+
+inline DeserializationError deserializeJson(JsonDocument& doc, const char* data, size_t size) {
+    doc.root = JsonValue();
+    return DeserializationError(!HostJsonParser(data, size).parse(&doc.root));
+}
+
+inline DeserializationError deserializeJson(
+    JsonDocument& doc, const char* data, size_t size, DeserializationOption::Filter
+) {
+    return deserializeJson(doc, data, size);
+}
@@ -0,0 +1,73 @@
+#pragma once
+//////////////////////////////////////////////////////////////////////////////
+// Host stand-in for FreeRTOS. Tests are single threaded, so semaphores are
+// plain counters and tasks are never started.
+//////////////////////////////////////////////////////////////////////////////
+#include <stdint.h>
+
+typedef int BaseType_t;
+typedef uint32_t TickType_t;
+
+#define pdFALSE       0
+#define pdTRUE        1
+#define pdFAIL        pdFALSE
+#define pdPASS        pdTRUE
+#define portMAX_DELAY 0xFFFFFFFFu
+
+struct HostSemaphore {
+    int count;
+    int max;
+};
+
+typedef HostSemaphore* SemaphoreHandle_t;
+typedef SemaphoreHandle_t xSemaphoreHandle;
+typedef void* TaskHandle_t;
+
+inline SemaphoreHandle_t xSemaphoreCreateBinary() {
+    return new HostSemaphore{0, 1};
+}
+
+inline SemaphoreHandle_t xSemaphoreCreateMutex() {
+    return new HostSemaphore{1, 1};
+}
+
+inline SemaphoreHandle_t xSemaphoreCreateRecursiveMutex() {
+    return new HostSemaphore{1, 1};
+}
+
+inline BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t) {
+    if (semaphore->count == 0) return pdFALSE;
+    semaphore->count--;
+    return pdTRUE;
+}
+
+inline BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore) {
+    if (semaphore->count == semaphore->max) return pdFALSE;
+    semaphore->count++;
+    return pdTRUE;
+}
+
+// Nested takes can't be told from unbalanced ones without an owner, so recursive mutex always succeeds
+inline BaseType_t xSemaphoreTakeRecursive(SemaphoreHandle_t, TickType_t) {
+    return pdTRUE;
+}
+
+inline BaseType_t xSemaphoreGiveRecursive(SemaphoreHandle_t) {
+    return pdTRUE;
+}
+
+inline void vSemaphoreDelete(SemaphoreHandle_t semaphore) {
+    delete semaphore;
+}
+
+inline BaseType_t xTaskCreatePinnedToCore(
+    void (*)(void*), const char*, uint32_t, void*, uint32_t, TaskHandle_t*, BaseType_t
+) {
+    return pdFAIL;
+}
+
+inline void vTaskDelete(TaskHandle_t) {
+}
+
+inline void taskYIELD() {
+}
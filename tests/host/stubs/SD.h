@@ -0,0 +1,68 @@
+#pragma once
+//////////////////////////////////////////////////////////////////////////////
+// Host stand-in for Arduino SD card. Paths are resolved in SD.root folder,
+// which tests point to a temporary directory.
+//////////////////////////////////////////////////////////////////////////////
+#include <stdio.h>
+#include <sys/stat.h>
+#include <memory>
+#include "Arduino.h"
+
+#define FILE_READ  "r"
+#define FILE_WRITE "w"
+
+class File {
+public:
+    File() {
+    }
+    explicit File(FILE* file) {
+        if (file) this->file.reset(file, fclose);
+    }
+
+    explicit operator bool() const {
+        return file != nullptr;
+    }
+    size_t write(const uint8_t* data, size_t size) {
+        return file && size ? fwrite(data, 1, size, file.get()) : 0;
+    }
+    size_t write(uint8_t value) {
+        return write(&value, 1);
+    }
+    size_t read(uint8_t* data, size_t size) {
+        return file ? fread(data, 1, size, file.get()) : 0;
+    }
+    bool seek(uint32_t position) {
+        return file && fseek(file.get(), position, SEEK_SET) == 0;
+    }
+    void close() {
+        file.reset();
+    }
+
+private:
+    std::shared_ptr<FILE> file;
+};
+
+class HostSD {
+public:
+    std::string root;
+
+    File open(const String& path, const char* mode = FILE_READ, bool create = false) {
+        (void)create;
+        return File(fopen((root + path.c_str()).c_str(), mode));
+    }
+    bool exists(const String& path) {
+        struct stat st;
+        return stat((root + path.c_str()).c_str(), &st) == 0;
+    }
+    bool remove(const String& path) {
+        return ::remove((root + path.c_str()).c_str()) == 0;
+    }
+    bool rename(const String& from, const String& to) {
+        return ::rename((root + from.c_str()).c_str(), (root + to.c_str()).c_str()) == 0;
+    }
+    bool mkdir(const String& path) {
+        return ::mkdir((root + path.c_str()).c_str(), 0755) == 0;
+    }
+};
+
+inline HostSD SD;
@@ -0,0 +1,3 @@
+#pragma once
+// Host tests run without Keira system services, only mutex helpers are provided
+#include "keira/mutex.h"
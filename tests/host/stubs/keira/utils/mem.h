@@ -0,0 +1,18 @@
+#pragma once
+// Host stand-in for keira/utils/mem.h: PSRAM allocations come from heap
+#include <stdlib.h>
+#include <ArduinoJson.h>
+
+struct SpiRamAllocator : ArduinoJson::Allocator {
+    void* allocate(size_t size) override {
+        return malloc(size);
+    }
+    void* reallocate(void* ptr, size_t size) override {
+        return realloc(ptr, size);
+    }
+    void deallocate(void* ptr) override {
+        free(ptr);
+    }
+};
+
+static SpiRamAllocator spiRamAllocator;
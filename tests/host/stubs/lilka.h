@@ -0,0 +1,88 @@
+#pragma once
+//////////////////////////////////////////////////////////////////////////////
+// Host stand-in for the parts of Lilka SDK used by code under test. Canvas
+// keeps a real framebuffer and logs every drawing call, so tests can check
+// what was drawn and in which order. SD root is SD.root folder.
+//////////////////////////////////////////////////////////////////////////////
+#include <stdint.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include "Arduino.h"
+#include "SD.h"
+#include "lilka/serial.h"
+
+namespace lilka {
+
+struct Image {
+    int16_t width;
+    int16_t height;
+};
+
+typedef struct {
+    char op;
+    int32_t args[4];
+    uint16_t color;
+} CanvasCall;
+
+class Canvas {
+public:
+    Canvas(int16_t w, int16_t h) : w(w), h(h), framebuffer(w * h) {
+    }
+    int16_t width() {
+        return w;
+    }
+    int16_t height() {
+        return h;
+    }
+    uint8_t getRotation() {
+        return rotation;
+    }
+    uint16_t* getFramebuffer() {
+        return framebuffer.data();
+    }
+    void drawPixel(int16_t x, int16_t y, uint16_t color) {
+        log('p', x, y, 0, 0, color);
+    }
+    void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+        log('F', x, y, w, h, color);
+    }
+    void drawRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+        log('R', x, y, w, h, color);
+    }
+    void fillCircle(int16_t x, int16_t y, int16_t r, uint16_t color) {
+        log('O', x, y, r, 0, color);
+    }
+    void drawCircle(int16_t x, int16_t y, int16_t r, uint16_t color) {
+        log('o', x, y, r, 0, color);
+    }
+    void drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color) {
+        log('l', x0, y0, x1, y1, color);
+    }
+    void drawImage(Image* image, int16_t x, int16_t y) {
+        log('i', x, y, image->width, image->height, 0);
+    }
+
+    uint8_t rotation = 0;
+    std::vector<CanvasCall> calls;
+
+private:
+    void log(char op, int32_t a, int32_t b, int32_t c, int32_t d, uint16_t color) {
+        calls.push_back({op, {a, b, c, d}, color});
+    }
+
+    int16_t w;
+    int16_t h;
+    std::vector<uint16_t> framebuffer;
+};
+
+class HostFileUtils {
+public:
+    String getSDRoot() {
+        return SD.root.c_str();
+    }
+};
+
+inline HostFileUtils fileutils;
+
+} // namespace lilka
@@ -0,0 +1,14 @@
+#pragma once
+#include <math.h>
+
+namespace lilka {
+
+inline float fSin360(float degrees) {
+    return sinf(degrees * static_cast<float>(M_PI) / 180.0f);
+}
+
+inline float fCos360(float degrees) {
+    return cosf(degrees * static_cast<float>(M_PI) / 180.0f);
+}
+
+} // namespace lilka
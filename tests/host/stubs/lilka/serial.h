@@ -0,0 +1,36 @@
+#pragma once
+// Host stand-in for Lilka serial logger, set `verbose` to see the log on stderr
+#include <stdarg.h>
+#include <stdio.h>
+
+namespace lilka {
+
+class HostSerial {
+public:
+    bool verbose = false;
+
+    void log(const char* format, ...) {
+        va_list args;
+        va_start(args, format);
+        print(format, args);
+        va_end(args);
+    }
+
+    void err(const char* format, ...) {
+        va_list args;
+        va_start(args, format);
+        print(format, args);
+        va_end(args);
+    }
+
+private:
+    void print(const char* format, va_list args) {
+        if (!verbose) return;
+        vfprintf(stderr, format, args);
+        fputc('\n', stderr);
+    }
+};
+
+inline HostSerial serial;
+
+} // namespace lilka
@@ -0,0 +1,2 @@
+#pragma once
+// Host tests run without watchdog
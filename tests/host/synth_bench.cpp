@@ -0,0 +1,73 @@
+//////////////////////////////////////////////////////////////////////////////
+// LilTracker synth benchmark: host time to render one SYNTH_BUFFER_SIZE
+// buffer with every channel playing, per waveform and effect. Only setters
+// without sample time are used, so the same file also builds against older
+// synth sources for comparison (see LILTRACKER in Makefile).
+//
+//   synth-bench [buffers]
+//////////////////////////////////////////////////////////////////////////////
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include "synth.h"
+
+#define BENCH_DEFAULT_BUFFERS 20000
+
+static const struct {
+    const char* name;
+    waveform_t waveform;
+} benchWaveforms[] = {
+    {"square", WAVEFORM_SQUARE},
+    {"saw", WAVEFORM_SAWTOOTH},
+    {"triangle", WAVEFORM_TRIANGLE},
+    {"sine", WAVEFORM_SINE},
+    {"noise", WAVEFORM_NOISE},
+};
+
+static const struct {
+    const char* name;
+    effect_t effect;
+} benchEffects[] = {
+    {"none", {EFFECT_TYPE_NONE, 0}},
+    {"arpeggio", {EFFECT_TYPE_ARPEGGIO, 0x37}},
+    {"vibrato", {EFFECT_TYPE_VIBRATO, 0x46}},
+    {"tremolo", {EFFECT_TYPE_TREMOLO, 0x46}},
+};
+
+int main(int argc, char** argv) {
+    int buffers = argc > 1 ? atoi(argv[1]) : BENCH_DEFAULT_BUFFERS;
+    static int16_t combinedBuffer[SYNTH_BUFFER_SIZE];
+    static int16_t channelBuffers[CHANNEL_COUNT][SYNTH_BUFFER_SIZE];
+    // Channels play a chord, so they don't share oscillator phase
+    const float frequencies[] = {220.0f, 277.18f, 329.63f, 440.0f};
+
+    printf("%d channels, %d samples per buffer, %d buffers, ns/buffer\n", CHANNEL_COUNT, SYNTH_BUFFER_SIZE, buffers);
+    printf("%-10s", "waveform");
+    for (auto& effect : benchEffects) {
+        printf(" %10s", effect.name);
+    }
+    printf("\n");
+
+    for (auto& waveform : benchWaveforms) {
+        printf("%-10s", waveform.name);
+        for (auto& effect : benchEffects) {
+            Synth synth;
+            for (uint8_t i = 0; i < CHANNEL_COUNT; i++) {
+                synth.setWaveform(i, waveform.waveform);
+                synth.setFrequency(i, frequencies[i % 4]);
+                synth.setVolume(i, 0.8f);
+                synth.setEffect(i, effect.effect);
+            }
+            auto start = std::chrono::steady_clock::now();
+            for (int buffer = 0; buffer < buffers; buffer++) {
+                synth.render(combinedBuffer, channelBuffers, SYNTH_BUFFER_SIZE, 0.5f);
+            }
+            long long ns =
+                std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+            printf(" %10lld", ns / buffers);
+        }
+        printf("\n");
+    }
+
+    return 0;
+}
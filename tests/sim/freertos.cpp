@@ -0,0 +1,356 @@
+// FreeRTOS API on top of pthreads, see shim/FreeRTOS.h
+#include <FreeRTOS.h>
+#include <pthread.h>
+#include <sched.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <vector>
+
+typedef std::chrono::steady_clock SimClock;
+
+// Blocked tasks wake up this often to notice they were suspended or deleted
+static const std::chrono::milliseconds SIM_POLL_INTERVAL(5);
+
+// Keira globals read tick count during static initialization, so start time
+// is taken on first use rather than being a global itself
+static SimClock::time_point simStart() {
+    static const SimClock::time_point start = SimClock::now();
+    return start;
+}
+
+struct SimTask {
+    TaskFunction_t function;
+    void* arg;
+    std::string name;
+    std::mutex lock;
+    std::condition_variable wake;
+    bool suspended = false;
+    bool deleted = false;
+};
+
+// Semaphore is handed to waiting tasks in order they came, otherwise a task
+// giving and taking it again in a loop (like AppManager) starves the rest
+struct SimWaiter {
+    bool granted = false;
+};
+
+struct SimSemaphore {
+    std::mutex lock;
+    std::condition_variable changed;
+    std::deque<SimWaiter*> waiters;
+    UBaseType_t count;
+    UBaseType_t max;
+    // Recursive mutex only
+    TaskHandle_t owner = NULL;
+    UBaseType_t depth = 0;
+};
+
+struct SimQueue {
+    std::mutex lock;
+    std::condition_variable changed;
+    std::deque<std::vector<uint8_t>> items;
+    UBaseType_t length;
+    UBaseType_t itemSize;
+};
+
+static thread_local SimTask* currentTask = NULL;
+
+static SimTask* current() {
+    // Main thread and threads not created through FreeRTOS get a task on first use
+    if (!currentTask) {
+        currentTask = new SimTask();
+        currentTask->name = "main";
+    }
+    return currentTask;
+}
+
+static SimClock::time_point deadlineOf(TickType_t timeout) {
+    if (timeout == portMAX_DELAY) return SimClock::time_point::max();
+    return SimClock::now() + std::chrono::milliseconds(timeout);
+}
+
+static void exitTask() {
+    SimTask* task = current();
+    currentTask = NULL;
+    delete task;
+    pthread_exit(NULL);
+}
+
+// Parks current task while it's suspended and ends it once it's deleted
+static void checkpoint() {
+    SimTask* task = current();
+    std::unique_lock<std::mutex> lock(task->lock);
+    task->wake.wait(lock, [task]() { return !task->suspended || task->deleted; });
+    bool deleted = task->deleted;
+    lock.unlock();
+    if (deleted) exitTask();
+}
+
+static void* taskEntry(void* arg) {
+    currentTask = static_cast<SimTask*>(arg);
+    checkpoint();
+    currentTask->function(currentTask->arg);
+    // Returning from task function isn't allowed in FreeRTOS, be forgiving here
+    exitTask();
+    return NULL;
+}
+
+BaseType_t xTaskCreatePinnedToCore(
+    TaskFunction_t function, const char* name, uint32_t, void* arg, UBaseType_t, TaskHandle_t* handle, BaseType_t
+) {
+    SimTask* task = new SimTask();
+    task->function = function;
+    task->arg = arg;
+    task->name = name ? name : "";
+    if (handle) *handle = task;
+
+    pthread_t thread;
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    int result = pthread_create(&thread, &attr, taskEntry, task);
+    pthread_attr_destroy(&attr);
+    if (result != 0) {
+        if (handle) *handle = NULL;
+        delete task;
+        return pdFAIL;
+    }
+    pthread_setname_np(thread, task->name.substr(0, 15).c_str());
+    return pdPASS;
+}
+
+BaseType_t xTaskCreate(
+    TaskFunction_t function, const char* name, uint32_t stackSize, void* arg, UBaseType_t priority,
+    TaskHandle_t* handle
+) {
+    return xTaskCreatePinnedToCore(function, name, stackSize, arg, priority, handle, tskNO_AFFINITY);
+}
+
+void vTaskDelete(TaskHandle_t task) {
+    if (!task || task == current()) exitTask();
+    // Task frees itself on its next checkpoint, it's not touched after unlock
+    std::lock_guard<std::mutex> lock(task->lock);
+    task->deleted = true;
+    task->wake.notify_all();
+}
+
+void vTaskSuspend(TaskHandle_t task) {
+    if (!task) task = current();
+    {
+        std::lock_guard<std::mutex> lock(task->lock);
+        task->suspended = true;
+    }
+    if (task == current()) checkpoint();
+}
+
+void vTaskResume(TaskHandle_t task) {
+    std::lock_guard<std::mutex> lock(task->lock);
+    task->suspended = false;
+    task->wake.notify_all();
+}
+
+eTaskState eTaskGetState(TaskHandle_t task) {
+    if (task == current()) return eRunning;
+    std::lock_guard<std::mutex> lock(task->lock);
+    if (task->deleted) return eDeleted;
+    return task->suspended ? eSuspended : eReady;
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle() {
+    return current();
+}
+
+TickType_t xTaskGetTickCount() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(SimClock::now() - simStart()).count();
+}
+
+void vTaskDelay(TickType_t ticks) {
+    checkpoint();
+    SimTask* task = current();
+    SimClock::time_point deadline = deadlineOf(ticks);
+    {
+        std::unique_lock<std::mutex> lock(task->lock);
+        while (!task->deleted && SimClock::now() < deadline) {
+            if (deadline == SimClock::time_point::max()) task->wake.wait(lock);
+            else task->wake.wait_until(lock, deadline);
+        }
+    }
+    checkpoint();
+}
+
+void vTaskDelayUntil(TickType_t* previousWake, TickType_t period) {
+    TickType_t wake = *previousWake + period;
+    TickType_t now = xTaskGetTickCount();
+    *previousWake = wake;
+    // Deadline already passed (tick counter wraps like on device)
+    if (static_cast<int32_t>(wake - now) <= 0) {
+        checkpoint();
+        return;
+    }
+    vTaskDelay(wake - now);
+}
+
+void taskYIELD() {
+    checkpoint();
+    sched_yield();
+}
+
+//=============================================================================
+static SemaphoreHandle_t createSemaphore(UBaseType_t max, UBaseType_t initial) {
+    SimSemaphore* semaphore = new SimSemaphore();
+    semaphore->max = max;
+    semaphore->count = initial;
+    return semaphore;
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex() {
+    return createSemaphore(1, 1);
+}
+
+SemaphoreHandle_t xSemaphoreCreateRecursiveMutex() {
+    return createSemaphore(1, 1);
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary() {
+    return createSemaphore(1, 0);
+}
+
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t max, UBaseType_t initial) {
+    return createSemaphore(max, initial);
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t timeout) {
+    SimClock::time_point deadline = deadlineOf(timeout);
+    while (true) {
+        checkpoint();
+        std::unique_lock<std::mutex> lock(semaphore->lock);
+        if (semaphore->count > 0) {
+            semaphore->count--;
+            return pdTRUE;
+        }
+        if (SimClock::now() >= deadline) return pdFALSE;
+        SimWaiter waiter;
+        semaphore->waiters.push_back(&waiter);
+        semaphore->changed.wait_until(lock, std::min(deadline, SimClock::now() + SIM_POLL_INTERVAL), [&waiter]() {
+            return waiter.granted;
+        });
+        if (waiter.granted) return pdTRUE;
+        // Leave the line to check for suspend or delete, then join it again
+        semaphore->waiters.erase(std::find(semaphore->waiters.begin(), semaphore->waiters.end(), &waiter));
+    }
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore) {
+    std::lock_guard<std::mutex> lock(semaphore->lock);
+    if (!semaphore->waiters.empty()) {
+        semaphore->waiters.front()->granted = true;
+        semaphore->waiters.pop_front();
+        semaphore->changed.notify_all();
+        return pdTRUE;
+    }
+    if (semaphore->count == semaphore->max) return pdFALSE;
+    semaphore->count++;
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreTakeRecursive(SemaphoreHandle_t semaphore, TickType_t timeout) {
+    {
+        std::lock_guard<std::mutex> lock(semaphore->lock);
+        if (semaphore->owner == current()) {
+            semaphore->depth++;
+            return pdTRUE;
+        }
+    }
+    if (xSemaphoreTake(semaphore, timeout) != pdTRUE) return pdFALSE;
+    std::lock_guard<std::mutex> lock(semaphore->lock);
+    semaphore->owner = current();
+    semaphore->depth = 1;
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGiveRecursive(SemaphoreHandle_t semaphore) {
+    {
+        std::lock_guard<std::mutex> lock(semaphore->lock);
+        if (semaphore->owner != current()) return pdFALSE;
+        if (--semaphore->depth) return pdTRUE;
+        semaphore->owner = NULL;
+    }
+    return xSemaphoreGive(semaphore);
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t semaphore) {
+    delete semaphore;
+}
+
+//=============================================================================
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize) {
+    SimQueue* queue = new SimQueue();
+    queue->length = length;
+    queue->itemSize = itemSize;
+    return queue;
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void* item, TickType_t timeout) {
+    SimClock::time_point deadline = deadlineOf(timeout);
+    while (true) {
+        if (timeout) checkpoint();
+        std::unique_lock<std::mutex> lock(queue->lock);
+        if (queue->items.size() < queue->length) {
+            const uint8_t* bytes = static_cast<const uint8_t*>(item);
+            queue->items.emplace_back(bytes, bytes + queue->itemSize);
+            queue->changed.notify_all();
+            return pdTRUE;
+        }
+        if (SimClock::now() >= deadline) return pdFALSE;
+        queue->changed.wait_until(lock, std::min(deadline, SimClock::now() + SIM_POLL_INTERVAL));
+    }
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void* item, TickType_t timeout) {
+    SimClock::time_point deadline = deadlineOf(timeout);
+    while (true) {
+        checkpoint();
+        std::unique_lock<std::mutex> lock(queue->lock);
+        if (!queue->items.empty()) {
+            memcpy(item, queue->items.front().data(), queue->itemSize);
+            queue->items.pop_front();
+            queue->changed.notify_all();
+            return pdTRUE;
+        }
+        if (SimClock::now() >= deadline) return pdFALSE;
+        queue->changed.wait_until(lock, std::min(deadline, SimClock::now() + SIM_POLL_INTERVAL));
+    }
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue) {
+    std::lock_guard<std::mutex> lock(queue->lock);
+    return queue->items.size();
+}
+
+BaseType_t xQueueReset(QueueHandle_t queue) {
+    std::lock_guard<std::mutex> lock(queue->lock);
+    queue->items.clear();
+    queue->changed.notify_all();
+    return pdPASS;
+}
+
+void vQueueDelete(QueueHandle_t queue) {
+    delete queue;
+}
+
+#if defined(__GLIBC__) && !__GLIBC_PREREQ(2, 38)
+size_t strlcpy(char* dst, const char* src, size_t size) {
+    size_t length = strlen(src);
+    if (size) {
+        size_t count = length < size - 1 ? length : size - 1;
+        memcpy(dst, src, count);
+        dst[count] = '\0';
+    }
+    return length;
+}
+#endif
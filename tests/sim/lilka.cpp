@@ -0,0 +1,337 @@
+// Lilka SDK and Arduino parts of keira-sim, see shim/lilka.h
+#include <lilka.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+typedef std::chrono::steady_clock SimClock;
+
+// Taken on first use, Keira globals may ask for time during static initialization
+static SimClock::duration sinceStart() {
+    static const SimClock::time_point start = SimClock::now();
+    return SimClock::now() - start;
+}
+
+unsigned long millis() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(sinceStart()).count();
+}
+
+unsigned long micros() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(sinceStart()).count();
+}
+
+void delay(uint32_t ms) {
+    vTaskDelay(pdMS_TO_TICKS(ms));
+}
+
+namespace lilka {
+
+const SimFont sim_font_6x13 = {6, 13};
+const SimFont sim_font_8x13 = {8, 13};
+const SimFont sim_font_10x20 = {10, 20};
+
+Display display;
+Controller controller;
+
+//=============================================================================
+Canvas::Canvas(int16_t x, int16_t y, int16_t w, int16_t h) :
+    posX(x), posY(y), w(w), h(h), framebuffer(w * h), font(FONT_6x13) {
+}
+
+void Canvas::fillScreen(uint16_t color) {
+    std::fill(framebuffer.begin(), framebuffer.end(), color);
+}
+
+void Canvas::fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+    int16_t x0 = std::max<int16_t>(x, 0);
+    int16_t y0 = std::max<int16_t>(y, 0);
+    int16_t x1 = std::min<int16_t>(x + w, this->w);
+    int16_t y1 = std::min<int16_t>(y + h, this->h);
+    for (int16_t row = y0; row < y1; row++) {
+        for (int16_t col = x0; col < x1; col++) {
+            framebuffer[row * this->w + col] = color;
+        }
+    }
+}
+
+void Canvas::drawRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+    fillRect(x, y, w, 1, color);
+    fillRect(x, y + h - 1, w, 1, color);
+    fillRect(x, y, 1, h, color);
+    fillRect(x + w - 1, y, 1, h, color);
+}
+
+void Canvas::drawPixel(int16_t x, int16_t y, uint16_t color) {
+    fillRect(x, y, 1, 1, color);
+}
+
+void Canvas::drawCanvas(Canvas* canvas) {
+    for (int16_t row = 0; row < canvas->h; row++) {
+        int16_t y = canvas->posY + row;
+        if (y < 0 || y >= h) continue;
+        for (int16_t col = 0; col < canvas->w; col++) {
+            int16_t x = canvas->posX + col;
+            if (x >= 0 && x < w) framebuffer[y * w + x] = canvas->framebuffer[row * canvas->w + col];
+        }
+    }
+}
+
+void Canvas::setFont(const SimFont* font) {
+    this->font = font;
+}
+
+void Canvas::setTextColor(uint16_t color) {
+    textColor = color;
+    textBackground = -1;
+}
+
+void Canvas::setTextColor(uint16_t color, uint16_t background) {
+    textColor = color;
+    textBackground = background;
+}
+
+void Canvas::setCursor(int16_t x, int16_t y) {
+    cursorX = x;
+    cursorY = y;
+}
+
+void Canvas::print(const char* text) {
+    for (const char* c = text; *c; c++) {
+        if (*c == '\n') {
+            cursorX = 0;
+            cursorY += font->height;
+            continue;
+        }
+        // Continuation bytes of UTF-8 sequence don't take a cell
+        if ((*c & 0xC0) == 0x80) continue;
+        int16_t top = cursorY - font->height + 3;
+        if (textBackground >= 0) fillRect(cursorX, top, font->width, font->height, textBackground);
+        if (*c != ' ') fillRect(cursorX + 1, top + 2, font->width - 2, font->height - 5, textColor);
+        cursorX += font->width;
+    }
+}
+
+void Canvas::printf(const char* format, ...) {
+    char buffer[256];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+    print(buffer);
+}
+
+void Canvas::getTextBounds(
+    const char* text, int16_t x, int16_t y, int16_t* x1, int16_t* y1, uint16_t* w, uint16_t* h
+) {
+    uint16_t cells = 0;
+    for (const char* c = text; *c; c++) {
+        if ((*c & 0xC0) != 0x80) cells++;
+    }
+    *x1 = x;
+    *y1 = y - font->height + 3;
+    *w = cells * font->width;
+    *h = font->height;
+}
+
+//=============================================================================
+Display::Display() : Canvas(0, 0, 280, 240) {
+}
+
+void Display::transfer(uint32_t pixels) {
+    transfers++;
+    pixelsSent += pixels;
+    if (!busMhz) return;
+    uint32_t us = pixels * 16 / busMhz;
+    busyUs += us;
+    std::this_thread::sleep_for(std::chrono::microseconds(us));
+}
+
+void Display::drawCanvas(Canvas* canvas) {
+    std::lock_guard<std::mutex> guard(lock);
+    Canvas::drawCanvas(canvas);
+    transfer(canvas->width() * canvas->height());
+}
+
+void Display::drawCanvasInterlaced(Canvas* canvas, bool odd) {
+    std::lock_guard<std::mutex> guard(lock);
+    uint16_t* src = canvas->getFramebuffer();
+    for (int16_t row = odd; row < canvas->height(); row += 2) {
+        int16_t y = canvas->y() + row;
+        if (y < 0 || y >= h) continue;
+        memcpy(&framebuffer[y * w + canvas->x()], src + row * canvas->width(), canvas->width() * sizeof(uint16_t));
+    }
+    transfer(canvas->width() * (canvas->height() + !odd) / 2);
+}
+
+void Display::draw16bitRGBBitmap(int16_t x, int16_t y, const uint16_t* bitmap, int16_t w, int16_t h) {
+    std::lock_guard<std::mutex> guard(lock);
+    for (int16_t row = 0; row < h; row++) {
+        if (y + row < 0 || y + row >= this->h) continue;
+        for (int16_t col = 0; col < w; col++) {
+            if (x + col >= 0 && x + col < this->w) framebuffer[(y + row) * this->w + x + col] = bitmap[row * w + col];
+        }
+    }
+    transfer(w * h);
+}
+
+bool Display::dump(const char* path) {
+    FILE* file = fopen(path, "wb");
+    if (!file) return false;
+    fprintf(file, "P6\n%d %d\n255\n", w, h);
+    std::lock_guard<std::mutex> guard(lock);
+    for (uint16_t pixel : framebuffer) {
+        uint8_t rgb[3] = {
+            static_cast<uint8_t>((pixel >> 11) * 255 / 31),
+            static_cast<uint8_t>(((pixel >> 5) & 0x3F) * 255 / 63),
+            static_cast<uint8_t>((pixel & 0x1F) * 255 / 31),
+        };
+        fwrite(rgb, 1, 3, file);
+    }
+    return fclose(file) == 0;
+}
+
+//=============================================================================
+static const char* const buttonNames[] = {"up", "down", "left", "right", "a", "b", "c", "d", "select", "start"};
+
+bool Controller::setScript(const char* script) {
+    std::vector<Event> parsed;
+    const char* c = script;
+    while (*c) {
+        char name[16];
+        unsigned time, hold = 100;
+        int length = 0;
+        if (sscanf(c, "%u:%15[a-z]%n", &time, name, &length) != 2) return false;
+        c += length;
+        if (*c == ':') {
+            if (sscanf(c, ":%u%n", &hold, &length) != 1) return false;
+            c += length;
+        }
+        int button = 0;
+        while (button < COUNT && strcmp(buttonNames[button], name) != 0) {
+            button++;
+        }
+        if (button == COUNT) return false;
+        parsed.push_back({time, static_cast<Button>(button), true});
+        parsed.push_back({time + hold, static_cast<Button>(button), false});
+        if (*c == ',') c++;
+        else if (*c) return false;
+    }
+    std::stable_sort(parsed.begin(), parsed.end(), [](const Event& a, const Event& b) { return a.time < b.time; });
+
+    std::lock_guard<std::mutex> guard(lock);
+    events = parsed;
+    nextEvent = 0;
+    return true;
+}
+
+void Controller::update() {
+    uint32_t now = millis();
+    while (nextEvent < events.size() && events[nextEvent].time <= now) {
+        const Event& event = events[nextEvent++];
+        ButtonState& button = state[event.button];
+        if (event.pressed && !button.pressed) button.justPressed = true;
+        if (!event.pressed && button.pressed) button.justReleased = true;
+        button.pressed = event.pressed;
+    }
+}
+
+State Controller::peekState() {
+    std::lock_guard<std::mutex> guard(lock);
+    update();
+    return state;
+}
+
+State Controller::getState() {
+    std::lock_guard<std::mutex> guard(lock);
+    update();
+    State result = state;
+    for (int button = 0; button < COUNT; button++) {
+        state[static_cast<Button>(button)].justPressed = false;
+        state[static_cast<Button>(button)].justReleased = false;
+    }
+    return result;
+}
+
+void Controller::resetState() {
+    std::lock_guard<std::mutex> guard(lock);
+    update();
+    for (int button = 0; button < COUNT; button++) {
+        state[static_cast<Button>(button)].justPressed = false;
+        state[static_cast<Button>(button)].justReleased = false;
+    }
+}
+
+//=============================================================================
+static void drawDialog(Canvas* canvas, const String& title, const String& message) {
+    int16_t w = canvas->width() - 40;
+    int16_t h = canvas->height() - 40;
+    canvas->fillRect(20, 20, w, h, colors::Gray);
+    canvas->drawRect(20, 20, w, h, colors::White);
+    canvas->setFont(FONT_8x13);
+    canvas->setTextColor(colors::White);
+    canvas->setCursor(28, 40);
+    canvas->print(title.c_str());
+    canvas->setFont(FONT_6x13);
+    canvas->setCursor(28, 64);
+    canvas->print(message.c_str());
+}
+
+Alert::Alert(const String& title, const String& message) : title(title), message(message) {
+}
+
+void Alert::addActivationButton(Button button) {
+    activationButtons.push_back(button);
+}
+
+void Alert::update() {
+    State state = controller.getState();
+    for (Button activation : activationButtons) {
+        if (state[activation].justPressed) {
+            finished = true;
+            button = activation;
+        }
+    }
+}
+
+void Alert::draw(Canvas* canvas) {
+    drawDialog(canvas, title, message);
+}
+
+bool Alert::isFinished() {
+    return finished;
+}
+
+Button Alert::getButton() {
+    return button;
+}
+
+InputDialog::InputDialog(const String& title) : title(title) {
+}
+
+void InputDialog::setMasked(bool) {
+}
+
+void InputDialog::setValue(const String& value) {
+    this->value = value;
+}
+
+void InputDialog::update() {
+    State state = controller.getState();
+    if (state.a.justPressed || state.start.justPressed) finished = true;
+}
+
+void InputDialog::draw(Canvas* canvas) {
+    drawDialog(canvas, title, value);
+}
+
+bool InputDialog::isFinished() {
+    return finished;
+}
+
+String InputDialog::getValue() {
+    return value;
+}
+
+} // namespace lilka
@@ -0,0 +1,108 @@
+//////////////////////////////////////////////////////////////////////////////
+// NES blitter benchmark: host time per frame of Driver::customBlit() for
+// each scale mode, with source frames changing in different amounts.
+// Real driver and App buffering are used, canvases are plain memory.
+//
+//   nesblit-bench [frames]
+//////////////////////////////////////////////////////////////////////////////
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include "apps/nes/driver.h"
+
+#define BENCH_DEFAULT_FRAMES 2000
+// Frames drawn before measurement, so each canvas got its line hashes
+#define BENCH_WARMUP_FRAMES 8
+// Lines changing each frame in "sprites" scenario, like a few sprites moving
+#define BENCH_SPRITE_LINES 32
+
+int nofrendo_main(int argc, char* argv[]) {
+    return 0;
+}
+
+int nofrendo_log_printf(const char* format, ...) {
+    return 0;
+}
+
+static uint8 pixels[NES_SCREEN_HEIGHT][NES_SCREEN_WIDTH];
+
+typedef struct {
+    const char* name;
+    // First and count of source lines changed every frame
+    int firstLine;
+    int lineCount;
+} Scenario;
+
+static const Scenario scenarios[] = {
+    {"static", 0, 0},
+    {"sprites", (NES_SCREEN_HEIGHT - BENCH_SPRITE_LINES) / 2, BENCH_SPRITE_LINES},
+    {"scroll", 0, NES_SCREEN_HEIGHT},
+};
+
+static const struct {
+    const char* name;
+    NesScaleMode mode;
+} modes[] = {
+    {"center", NES_SCALE_CENTER},
+    {"integer", NES_SCALE_INTEGER},
+    {"fit", NES_SCALE_FIT},
+};
+
+static void renderSource(const Scenario& scenario, int frame) {
+    for (int y = scenario.firstLine; y < scenario.firstLine + scenario.lineCount; y++) {
+        for (int x = 0; x < NES_SCREEN_WIDTH; x++) {
+            pixels[y][x] = (x + y + frame) & 0x3F;
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    int frames = argc > 1 ? atoi(argv[1]) : BENCH_DEFAULT_FRAMES;
+
+    bitmap_t bmp = {};
+    bmp.width = NES_SCREEN_WIDTH;
+    bmp.height = NES_SCREEN_HEIGHT;
+    bmp.pitch = NES_SCREEN_WIDTH;
+    bmp.data = &pixels[0][0];
+    for (int y = 0; y < NES_SCREEN_HEIGHT; y++) {
+        bmp.line[y] = pixels[y];
+    }
+
+    rgb_t palette[256];
+    for (int i = 0; i < 256; i++) {
+        palette[i] = {i * 37 & 0xFF, i * 59 & 0xFF, i * 91 & 0xFF};
+    }
+
+    NesApp app("bench.nes");
+    Driver::setNesApp(&app);
+
+    printf("%dx%d canvas, %d frames, ns/frame\n", app.canvas->width(), app.canvas->height(), frames);
+    printf("%-10s", "mode");
+    for (const Scenario& scenario : scenarios) {
+        printf(" %10s", scenario.name);
+    }
+    printf("\n");
+
+    for (auto& mode : modes) {
+        printf("%-10s", mode.name);
+        for (const Scenario& scenario : scenarios) {
+            Driver::setScaleMode(mode.mode);
+            Driver::init(NES_SCREEN_WIDTH, NES_SCREEN_HEIGHT);
+            Driver::setPalette(palette);
+            renderSource({"", 0, NES_SCREEN_HEIGHT}, 0);
+
+            std::chrono::steady_clock::duration spent{};
+            for (int frame = 0; frame < BENCH_WARMUP_FRAMES + frames; frame++) {
+                renderSource(scenario, frame);
+                auto start = std::chrono::steady_clock::now();
+                Driver::customBlit(&bmp, 0, NULL);
+                if (frame >= BENCH_WARMUP_FRAMES) spent += std::chrono::steady_clock::now() - start;
+            }
+            long long ns = std::chrono::duration_cast<std::chrono::nanoseconds>(spent).count();
+            printf(" %10lld", ns / frames);
+        }
+        printf("\n");
+    }
+
+    return 0;
+}
@@ -0,0 +1,43 @@
+#pragma once
+// keira-sim stand-in for nofrendo headers: only types NES driver uses
+#include <stdbool.h>
+#include <stdint.h>
+
+#define NES_SCREEN_WIDTH  256
+#define NES_SCREEN_HEIGHT 240
+
+typedef uint8_t uint8;
+typedef uint16_t uint16;
+typedef int16_t int16;
+
+typedef struct {
+    int r, g, b;
+} rgb_t;
+
+typedef struct {
+    int16 x, y;
+    uint16 w, h;
+} rect_t;
+
+typedef struct {
+    int width, height, pitch;
+    bool hardware;
+    uint8* data;
+    uint8* line[NES_SCREEN_HEIGHT];
+} bitmap_t;
+
+typedef struct {
+    const char* name;
+    int (*init)(int width, int height);
+    void (*shutdown)(void);
+    int (*set_mode)(int width, int height);
+    void (*set_palette)(rgb_t* palette);
+    void (*clear)(uint8 color);
+    bitmap_t* (*lock_write)(void);
+    void (*free_write)(int num_dirties, rect_t* dirty_rects);
+    void (*custom_blit)(bitmap_t* primary, int num_dirties, rect_t* dirty_rects);
+    bool invalidate;
+} viddriver_t;
+
+int nofrendo_main(int argc, char* argv[]);
+int nofrendo_log_printf(const char* format, ...);
@@ -0,0 +1,3 @@
+#pragma once
+// keira-sim stand-in for nofrendo headers, see nes/nes.h
+#include "nes.h"
@@ -0,0 +1,10 @@
+#pragma once
+// keira-sim additions to host Arduino stand-in: FreeRTOS and time since start
+#include_next <Arduino.h>
+#include <FreeRTOS.h>
+#include <semphr.h>
+#include <freertos/queue.h>
+
+unsigned long millis();
+unsigned long micros();
+void delay(uint32_t ms);
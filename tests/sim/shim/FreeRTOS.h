@@ -0,0 +1,78 @@
+#pragma once
+//////////////////////////////////////////////////////////////////////////////
+// keira-sim stand-in for FreeRTOS. Tasks are pthreads running all at once,
+// like on a CPU with many cores: priorities and core affinity are ignored.
+// Tick is 1 ms. Suspending or deleting another task takes effect once that
+// task calls into FreeRTOS, which Keira threads do every frame anyway.
+//////////////////////////////////////////////////////////////////////////////
+#include <stdint.h>
+#include <stddef.h>
+// ESP-IDF headers bring C library in with FreeRTOS, Keira relies on that
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+#if defined(__GLIBC__) && !__GLIBC_PREREQ(2, 38)
+size_t strlcpy(char* dst, const char* src, size_t size);
+#endif
+
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t TickType_t;
+typedef void (*TaskFunction_t)(void*);
+
+#define pdFALSE            0
+#define pdTRUE             1
+#define pdFAIL             pdFALSE
+#define pdPASS             pdTRUE
+#define portMAX_DELAY      0xFFFFFFFFu
+#define portTICK_PERIOD_MS 1
+#define configTICK_RATE_HZ 1000
+#define tskNO_AFFINITY     0x7FFFFFFF
+#define pdMS_TO_TICKS(MS)  ((TickType_t)(MS))
+#define PSTR(S)            (S)
+
+typedef enum { eRunning, eReady, eBlocked, eSuspended, eDeleted, eInvalid } eTaskState;
+
+struct SimTask;
+struct SimSemaphore;
+struct SimQueue;
+typedef SimTask* TaskHandle_t;
+typedef SimSemaphore* SemaphoreHandle_t;
+typedef SemaphoreHandle_t xSemaphoreHandle;
+typedef SimQueue* QueueHandle_t;
+
+BaseType_t xTaskCreatePinnedToCore(
+    TaskFunction_t function, const char* name, uint32_t stackSize, void* arg, UBaseType_t priority,
+    TaskHandle_t* handle, BaseType_t core
+);
+BaseType_t xTaskCreate(
+    TaskFunction_t function, const char* name, uint32_t stackSize, void* arg, UBaseType_t priority,
+    TaskHandle_t* handle
+);
+void vTaskDelete(TaskHandle_t task);
+void vTaskSuspend(TaskHandle_t task);
+void vTaskResume(TaskHandle_t task);
+eTaskState eTaskGetState(TaskHandle_t task);
+TaskHandle_t xTaskGetCurrentTaskHandle();
+TickType_t xTaskGetTickCount();
+void vTaskDelay(TickType_t ticks);
+void vTaskDelayUntil(TickType_t* previousWake, TickType_t period);
+void taskYIELD();
+
+SemaphoreHandle_t xSemaphoreCreateMutex();
+SemaphoreHandle_t xSemaphoreCreateRecursiveMutex();
+SemaphoreHandle_t xSemaphoreCreateBinary();
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t max, UBaseType_t initial);
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t timeout);
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore);
+BaseType_t xSemaphoreTakeRecursive(SemaphoreHandle_t semaphore, TickType_t timeout);
+BaseType_t xSemaphoreGiveRecursive(SemaphoreHandle_t semaphore);
+void vSemaphoreDelete(SemaphoreHandle_t semaphore);
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize);
+BaseType_t xQueueSend(QueueHandle_t queue, const void* item, TickType_t timeout);
+BaseType_t xQueueReceive(QueueHandle_t queue, void* item, TickType_t timeout);
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue);
+BaseType_t xQueueReset(QueueHandle_t queue);
+void vQueueDelete(QueueHandle_t queue);
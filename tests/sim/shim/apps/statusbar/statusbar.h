@@ -0,0 +1,2 @@
+#pragma once
+// Not simulated, included by appmanager.cpp only
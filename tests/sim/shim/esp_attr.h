@@ -0,0 +1,3 @@
+#pragma once
+// keira-sim: everything runs from RAM anyway
+#define IRAM_ATTR
@@ -0,0 +1,20 @@
+#pragma once
+// keira-sim has plenty of memory, as if PSRAM was always free
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#define MALLOC_CAP_8BIT   (1 << 2)
+#define MALLOC_CAP_SPIRAM (1 << 10)
+
+inline size_t heap_caps_get_largest_free_block(uint32_t) {
+    return 4 * 1024 * 1024;
+}
+
+inline void* heap_caps_malloc(size_t size, uint32_t) {
+    return malloc(size);
+}
+
+inline void heap_caps_free(void* ptr) {
+    free(ptr);
+}
@@ -0,0 +1,15 @@
+#pragma once
+// keira-sim system: only app manager and event bus are running
+#include "keira/appmanager.h"
+#include "keira/eventbus.h"
+
+class KeiraSystem {
+public:
+    // Starts panel and first app the way Keira does on boot
+    void setup(App* panel, App* firstApp);
+
+    AppManager apps;
+    EventBus events;
+};
+
+extern KeiraSystem ksystem;
@@ -0,0 +1,203 @@
+#pragma once
+//////////////////////////////////////////////////////////////////////////////
+// keira-sim stand-in for Lilka SDK. Canvases and display are plain RGB565
+// framebuffers. Display counts pixels sent to it and takes as long as the
+// bus would, so flush cost shows up in frame timing. There are no fonts,
+// each character is drawn as a block of its cell size. Controller replays
+// scripted button presses. SD card is the host stand-in, see host/stubs/SD.h.
+//////////////////////////////////////////////////////////////////////////////
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <Arduino.h>
+#include <SD.h>
+#include <lilka/serial.h>
+
+namespace lilka {
+
+namespace colors {
+const uint16_t Black = 0x0000;
+const uint16_t White = 0xFFFF;
+const uint16_t Red = 0xF800;
+const uint16_t Green = 0x07E0;
+const uint16_t Blue = 0x001F;
+const uint16_t Yellow = 0xFFE0;
+const uint16_t Cyan = 0x07FF;
+const uint16_t Gray = 0x8410;
+const uint16_t Dark_sienna = 0x3882;
+} // namespace colors
+
+typedef struct {
+    uint8_t width;
+    uint8_t height;
+} SimFont;
+
+extern const SimFont sim_font_6x13;
+extern const SimFont sim_font_8x13;
+extern const SimFont sim_font_10x20;
+
+#define FONT_6x13  (&lilka::sim_font_6x13)
+#define FONT_8x13  (&lilka::sim_font_8x13)
+#define FONT_10x20 (&lilka::sim_font_10x20)
+
+class Canvas {
+public:
+    Canvas(int16_t x, int16_t y, int16_t w, int16_t h);
+    virtual ~Canvas() {
+    }
+    int16_t x() {
+        return posX;
+    }
+    int16_t y() {
+        return posY;
+    }
+    int16_t width() {
+        return w;
+    }
+    int16_t height() {
+        return h;
+    }
+    uint16_t* getFramebuffer() {
+        return framebuffer.data();
+    }
+    // Canvases aren't rotated in simulator
+    uint8_t getRotation() {
+        return 0;
+    }
+    void fillScreen(uint16_t color);
+    void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+    void drawRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+    void drawPixel(int16_t x, int16_t y, uint16_t color);
+    // Copies other canvas at its own position
+    void drawCanvas(Canvas* canvas);
+
+    void setFont(const SimFont* font);
+    void setTextColor(uint16_t color);
+    void setTextColor(uint16_t color, uint16_t background);
+    // Text is drawn with cursor on its baseline, as with GFX fonts
+    void setCursor(int16_t x, int16_t y);
+    int16_t getCursorX() {
+        return cursorX;
+    }
+    void print(const char* text);
+    void printf(const char* format, ...);
+    void getTextBounds(const char* text, int16_t x, int16_t y, int16_t* x1, int16_t* y1, uint16_t* w, uint16_t* h);
+
+protected:
+    int16_t posX;
+    int16_t posY;
+    int16_t w;
+    int16_t h;
+    std::vector<uint16_t> framebuffer;
+    const SimFont* font;
+    uint16_t textColor = colors::White;
+    int32_t textBackground = -1;
+    int16_t cursorX = 0;
+    int16_t cursorY = 0;
+};
+
+#define LILKA_DISPLAY_ROTATION 0
+
+class Display : public Canvas {
+public:
+    Display();
+    void drawCanvas(Canvas* canvas);
+    void drawCanvasInterlaced(Canvas* canvas, bool odd);
+    void draw16bitRGBBitmap(int16_t x, int16_t y, const uint16_t* bitmap, int16_t w, int16_t h);
+    // Writes screen as binary PPM. Returns false on failure
+    bool dump(const char* path);
+
+    // Simulated bus speed, 0 makes transfers instant
+    uint32_t busMhz = 40;
+    std::atomic<uint32_t> transfers{0};
+    std::atomic<uint64_t> pixelsSent{0};
+    std::atomic<uint64_t> busyUs{0};
+
+private:
+    void transfer(uint32_t pixels);
+    std::mutex lock;
+};
+
+extern Display display;
+
+typedef enum { UP, DOWN, LEFT, RIGHT, A, B, C, D, SELECT, START, COUNT } Button;
+
+typedef struct {
+    bool pressed;
+    bool justPressed;
+    bool justReleased;
+} ButtonState;
+
+typedef struct {
+    ButtonState up, down, left, right, a, b, c, d, select, start;
+
+    ButtonState& operator[](Button button) {
+        return (&up)[button];
+    }
+} State;
+
+class Controller {
+public:
+    // Script is a comma separated list of "<ms>:<button>[:<hold ms>]",
+    // e.g. "500:down,900:a,3000:b:400". Buttons: up, down, left, right, a,
+    // b, c, d, select, start. Returns false on syntax error
+    bool setScript(const char* script);
+    // Current state, keeps just pressed/released flags
+    State peekState();
+    // Current state, clears just pressed/released flags
+    State getState();
+    void resetState();
+
+private:
+    typedef struct {
+        uint32_t time;
+        Button button;
+        bool pressed;
+    } Event;
+
+    void update();
+    std::mutex lock;
+    std::vector<Event> events;
+    size_t nextEvent = 0;
+    State state = {};
+};
+
+extern Controller controller;
+
+// Dialogs finish on activation button press, enough for App helpers
+class Alert {
+public:
+    Alert(const String& title, const String& message);
+    void addActivationButton(Button button);
+    void update();
+    void draw(Canvas* canvas);
+    bool isFinished();
+    Button getButton();
+
+private:
+    String title;
+    String message;
+    std::vector<Button> activationButtons;
+    bool finished = false;
+    Button button = A;
+};
+
+class InputDialog {
+public:
+    explicit InputDialog(const String& title);
+    void setMasked(bool masked);
+    void setValue(const String& value);
+    void update();
+    void draw(Canvas* canvas);
+    bool isFinished();
+    String getValue();
+
+private:
+    String title;
+    String value;
+    bool finished = false;
+};
+
+} // namespace lilka
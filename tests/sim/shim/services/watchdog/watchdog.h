@@ -0,0 +1,9 @@
+#pragma once
+// Watchdog isn't simulated. On device this header brings keira.h in through
+// service.h, and app.cpp relies on it for strings and button definitions
+#include <lilka.h>
+#include "keira/keira_lang.h"
+
+#define K_BTN_BACK    lilka::Button::B
+#define K_BTN_OK      lilka::Button::A
+#define K_BTN_CONFIRM lilka::Button::START
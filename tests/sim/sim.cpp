@@ -0,0 +1,196 @@
+//////////////////////////////////////////////////////////////////////////////
+// keira-sim: runs Keira app manager, apps and frame handoff on Linux, with
+// FreeRTOS tasks as pthreads and display in memory. Meant for profiling
+// frame pacing, flush cost and locking with perf and sanitizers.
+//
+//   keira-sim [-t ms] [-i script] [-b mhz] [-o screen.ppm] [-v]
+//
+// Launcher stand-in is a menu flushing only changed areas. Its first item
+// starts a fullscreen triple buffered game, B quits the game. At exit frame
+// telemetry of every app and display bus totals are printed.
+//////////////////////////////////////////////////////////////////////////////
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <algorithm>
+#include "keira/ksystem.h"
+
+// Simulation length if not given, ms
+#define SIM_DEFAULT_TIME 5000
+// How often frame telemetry is collected while running, ms
+#define SIM_REPORT_INTERVAL 1000
+// Default input: move around menu, play a bit and return
+#define SIM_DEFAULT_SCRIPT "400:down,700:down,1000:up,1300:up,1600:a,3600:b"
+
+KeiraSystem ksystem;
+
+void KeiraSystem::setup(App* panel, App* firstApp) {
+    apps.setpanel(panel);
+    panel->start();
+    apps.spawn(firstApp, false);
+    apps.start();
+}
+
+// Status bar stand-in: clock changing once a second
+class SimPanelApp : public App {
+public:
+    SimPanelApp() : App("StatusBar") {
+        setFlags(AppFlags::APP_FLAG_STATUSBAR | AppFlags::APP_FLAG_DAMAGE_DIFF);
+        setTargetFps(10);
+    }
+
+private:
+    void run() override {
+        while (1) {
+            uint32_t seconds = millis() / 1000;
+            canvas->fillScreen(lilka::colors::Black);
+            canvas->setFont(FONT_8x13);
+            canvas->setTextColor(lilka::colors::White);
+            canvas->setCursor(canvas->width() / 2 - 20, 18);
+            canvas->printf("%02u:%02u", seconds / 60, seconds % 60);
+            queueDraw();
+            waitNextFrame();
+        }
+    }
+};
+
+// Fullscreen game repainting everything each frame
+class SimGameApp : public App {
+public:
+    SimGameApp() : App("Game") {
+        setFlags(AppFlags::APP_FLAG_FULLSCREEN | AppFlags::APP_FLAG_TRIPLE_BUFFER);
+        setTargetFps(60);
+    }
+
+private:
+    void run() override {
+        int16_t x = 0;
+        int16_t dx = 3;
+        while (1) {
+            if (lilka::controller.getState().b.justPressed) return;
+            x += dx;
+            if (x < 0 || x > canvas->width() - 40) dx = -dx;
+            canvas->fillScreen(lilka::colors::Blue);
+            for (int16_t row = 0; row < canvas->height(); row += 20) {
+                canvas->fillRect((x + row * 3) % canvas->width(), row, 40, 16, lilka::colors::Yellow);
+            }
+            queueDraw();
+            waitNextFrame();
+        }
+    }
+};
+
+// Launcher stand-in: menu where only cursor moves
+class SimMenuApp : public App {
+public:
+    SimMenuApp() : App("Launcher") {
+        setFlags(AppFlags::APP_FLAG_DEFAULT | AppFlags::APP_FLAG_DAMAGE_DIFF);
+    }
+
+private:
+    void run() override {
+        const char* items[] = {"Game", "Files", "Settings", "Catalog", "Tracker", "About"};
+        const int count = sizeof(items) / sizeof(items[0]);
+        int cursor = 0;
+        while (1) {
+            lilka::State state = lilka::controller.getState();
+            if (state.up.justPressed) cursor = (cursor + count - 1) % count;
+            if (state.down.justPressed) cursor = (cursor + 1) % count;
+            if (state.a.justPressed && cursor == 0) ksystem.apps.spawn(new SimGameApp());
+
+            canvas->fillScreen(lilka::colors::Black);
+            canvas->setFont(FONT_8x13);
+            for (int i = 0; i < count; i++) {
+                if (i == cursor) canvas->fillRect(0, 8 + i * 24, canvas->width(), 24, lilka::colors::Cyan);
+                canvas->setTextColor(i == cursor ? lilka::colors::Black : lilka::colors::White);
+                canvas->setCursor(16, 26 + i * 24);
+                canvas->print(items[i]);
+            }
+            queueDraw();
+            waitNextFrame();
+        }
+    }
+};
+
+static void printReports(uint32_t elapsedMs) {
+    printf("%-12s %6s %7s %5s  %-24s %-24s %-24s\n", "app", "frames", "dropped", "busy", "run p50/p95/p99 us",
+           "wait p50/p95/p99 us", "flush p50/p95/p99 us");
+    for (auto& report : ksystem.apps.getPerfReports()) {
+        char stats[FRAME_STAT_COUNT][32];
+        for (int type = 0; type < FRAME_STAT_COUNT; type++) {
+            const FrameStatPercentiles& stat = report.stats[type];
+            snprintf(stats[type], sizeof(stats[type]), "%u/%u/%u", stat.p50, stat.p95, stat.p99);
+        }
+        printf("%-12s %6u %7u %4u%%  %-24s %-24s %-24s\n", report.name, report.frames, report.droppedFrames,
+               report.busyPercent, stats[FRAME_STAT_RUN], stats[FRAME_STAT_WAIT], stats[FRAME_STAT_FLUSH]);
+    }
+    uint32_t transfers = lilka::display.transfers;
+    uint64_t pixels = lilka::display.pixelsSent;
+    uint64_t busyUs = lilka::display.busyUs;
+    printf(
+        "display: %u transfers, %llu pixels (%.1f full frames/s), bus busy %.1f%%\n",
+        transfers,
+        (unsigned long long)pixels,
+        pixels * 1000.0 / (lilka::display.width() * lilka::display.height()) / elapsedMs,
+        busyUs / 10.0 / elapsedMs
+    );
+}
+
+static void usage(const char* name) {
+    fprintf(stderr, "Usage: %s [-t ms] [-i script] [-b mhz] [-o screen.ppm] [-v]\n", name);
+    fprintf(stderr, "  -t  run for this long, default %d ms\n", SIM_DEFAULT_TIME);
+    fprintf(stderr, "  -i  button presses, \"<ms>:<button>[:<hold ms>],...\", default \"%s\"\n", SIM_DEFAULT_SCRIPT);
+    fprintf(stderr, "  -b  display bus speed in MHz, 0 makes transfers free, default %u\n", lilka::display.busMhz);
+    fprintf(stderr, "  -o  save screen at exit as PPM\n");
+    fprintf(stderr, "  -v  print Keira log\n");
+}
+
+int main(int argc, char** argv) {
+    uint32_t time = SIM_DEFAULT_TIME;
+    const char* script = SIM_DEFAULT_SCRIPT;
+    const char* output = NULL;
+    int option;
+    while ((option = getopt(argc, argv, "t:i:b:o:vh")) != -1) {
+        switch (option) {
+            case 't':
+                time = atoi(optarg);
+                break;
+            case 'i':
+                script = optarg;
+                break;
+            case 'b':
+                lilka::display.busMhz = atoi(optarg);
+                break;
+            case 'o':
+                output = optarg;
+                break;
+            case 'v':
+                lilka::serial.verbose = true;
+                break;
+            default:
+                usage(argv[0]);
+                return 1;
+        }
+    }
+    if (!lilka::controller.setScript(script)) {
+        fprintf(stderr, "Bad input script: %s\n", script);
+        return 1;
+    }
+
+    ksystem.setup(new SimPanelApp(), new SimMenuApp());
+    // Busy percentage is counted between reports, poll them like status bar does on device
+    TickType_t start = xTaskGetTickCount();
+    while (xTaskGetTickCount() - start < time) {
+        vTaskDelay(pdMS_TO_TICKS(std::min<uint32_t>(SIM_REPORT_INTERVAL, time - (xTaskGetTickCount() - start))));
+        ksystem.apps.getPerfReports();
+    }
+
+    printReports(time);
+    if (output && !lilka::display.dump(output)) {
+        perror(output);
+        return 1;
+    }
+    // Keira threads never end, leave them running
+    fflush(stdout);
+    _exit(0);
+}
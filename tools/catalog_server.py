@@ -0,0 +1,133 @@
+#!/usr/bin/python
+##################################################################################
+#                                                                                #
+## Local stand-in for catalog.lilka.dev to test LilCatalog without the internet ##
+## Serves a folder with the same layout (apps/index_N.json, apps/<id>/...)      ##
+## over HTTP/1.1 keep-alive, with ETag/Last-Modified and 304 responses.         ##
+## Usage: catalog_server.py [--port 8000] [--root catalog] [--fake N]           ##
+## Build firmware with -D CATALOG_BASE_URL='"http://<host>:8000"'               ##
+#                                                                                #
+##################################################################################
+import argparse, hashlib, json, mimetypes, os, sys
+from email.utils import formatdate, parsedate_to_datetime
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+from pathlib import Path
+
+PAGE_SIZE = 10
+ICON_SIZE = 64 * 64 * 2
+
+
+def make_fake_catalog(root, count):
+    """Generates count Lua apps with short manifests and icons"""
+    apps = root / "apps"
+    ids = ["fake_app_%03d" % i for i in range(count)]
+    pages = [ids[i : i + PAGE_SIZE] for i in range(0, len(ids), PAGE_SIZE)] or [[]]
+    for page, manifests in enumerate(pages):
+        index = {"page": page, "total_pages": len(pages), "manifests": manifests}
+        (apps / ("index_%d.json" % page)).parent.mkdir(parents=True, exist_ok=True)
+        (apps / ("index_%d.json" % page)).write_text(json.dumps(index))
+    for i, app_id in enumerate(ids):
+        static = apps / app_id / "static"
+        static.mkdir(parents=True, exist_ok=True)
+        manifest = {
+            "name": "Fake app %d" % i,
+            "short_description": "Generated by catalog_server.py",
+            "description": "Generated by catalog_server.py",
+            "author": "catalog_server.py",
+            "icon_min": "icon_min.bin",
+            "entryfile": {"type": "lua", "location": "main.lua"},
+            "files": [],
+        }
+        (apps / app_id / "index.json").write_text(json.dumps(manifest))
+        short = {k: manifest[k] for k in ("name", "short_description", "icon_min", "entryfile")}
+        (apps / app_id / "index_short.json").write_text(json.dumps(short))
+        color = (i * 0x1234) & 0xFFFF
+        (static / "icon_min.bin").write_bytes(color.to_bytes(2, "little") * (ICON_SIZE // 2))
+        (static / "main.lua").write_text('display.fill_screen(display.color565(0, 0, 0))\nprint("%s")\n' % app_id)
+
+
+class CatalogHandler(BaseHTTPRequestHandler):
+    protocol_version = "HTTP/1.1"
+    root = None
+
+    def resolve(self):
+        path = (self.root / self.path.split("?", 1)[0].lstrip("/")).resolve()
+        if self.root not in path.parents or not path.is_file():
+            return None
+        return path
+
+    def send_empty(self, code, headers=None):
+        self.send_response(code)
+        for name, value in (headers or {}).items():
+            self.send_header(name, value)
+        self.send_header("Content-Length", "0")
+        self.end_headers()
+
+    def not_modified(self, etag, mtime):
+        if_none_match = self.headers.get("If-None-Match")
+        if if_none_match is not None:
+            return etag in [tag.strip() for tag in if_none_match.split(",")] or if_none_match.strip() == "*"
+        if_modified_since = self.headers.get("If-Modified-Since")
+        if if_modified_since:
+            try:
+                return int(mtime) <= parsedate_to_datetime(if_modified_since).timestamp()
+            except (TypeError, ValueError):
+                return False
+        return False
+
+    def serve(self, with_body):
+        path = self.resolve()
+        if path is None:
+            self.send_empty(404)
+            return
+        stat = path.stat()
+        etag = '"%s"' % hashlib.sha1(("%s:%d:%d" % (path, stat.st_mtime_ns, stat.st_size)).encode()).hexdigest()[:16]
+        headers = {"ETag": etag, "Last-Modified": formatdate(stat.st_mtime, usegmt=True)}
+        if self.not_modified(etag, stat.st_mtime):
+            self.send_empty(304, headers)
+            return
+        self.send_response(200)
+        for name, value in headers.items():
+            self.send_header(name, value)
+        self.send_header("Content-Type", mimetypes.guess_type(path.name)[0] or "application/octet-stream")
+        self.send_header("Content-Length", str(stat.st_size))
+        self.end_headers()
+        if with_body:
+            self.wfile.write(path.read_bytes())
+
+    def do_GET(self):
+        self.serve(True)
+
+    def do_HEAD(self):
+        self.serve(False)
+
+    def log_request(self, code="-", size="-"):
+        # Port tells apart connections, so keep-alive reuse is visible in the log
+        sys.stderr.write("%s:%d %s %s\n" % (self.client_address[0], self.client_address[1], self.requestline, code))
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Local stand-in for LilCatalog server")
+    parser.add_argument("--port", type=int, default=8000)
+    parser.add_argument("--root", default="catalog", help="folder with apps/ inside")
+    parser.add_argument("--fake", type=int, metavar="N", help="generate N fake apps into root first")
+    args = parser.parse_args()
+
+    root = Path(args.root).resolve()
+    if args.fake is not None:
+        make_fake_catalog(root, args.fake)
+    if not (root / "apps").is_dir():
+        print("%s has no apps folder, use --fake N to generate one" % root)
+        sys.exit(1)
+
+    CatalogHandler.root = root
+    server = ThreadingHTTPServer(("", args.port), CatalogHandler)
+    print("Serving %s on port %d" % (root, args.port))
+    try:
+        server.serve_forever()
+    except KeyboardInterrupt:
+        pass
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,87 @@
+#!/usr/bin/python
+##################################################################################
+#                                                                                #
+## Converts screen recording (.krec) made by KeiraOS screenshot service to GIF  ##
+## Usage: krec2gif.py recording.krec [output.gif]                               ##
+## Requires Pillow                                                              ##
+#                                                                                #
+##################################################################################
+import struct, sys
+from pathlib import Path
+
+from PIL import Image
+
+OP_SKIP = 0
+OP_FILL = 1
+OP_COPY = 2
+
+
+def rgb565_to_rgb(pixels):
+    rgb = bytearray(len(pixels) * 3)
+    for i, pixel in enumerate(pixels):
+        rgb[i * 3] = (pixel >> 11 & 0x1F) * 255 // 31
+        rgb[i * 3 + 1] = (pixel >> 5 & 0x3F) * 255 // 63
+        rgb[i * 3 + 2] = (pixel & 0x1F) * 255 // 31
+    return bytes(rgb)
+
+
+def read_frames(data):
+    magic, version, _, width, height, interval = struct.unpack_from("<4sBBHHH", data)
+    if magic != b"KREC" or version != 1:
+        raise ValueError("Not a KREC v1 file")
+    pos = 12
+    pixel_count = width * height
+    screen = [0] * pixel_count
+    # Stream may be cut off if recording wasn't stopped properly, incomplete frame is dropped then
+    while pos + 4 <= len(data):
+        (timestamp,) = struct.unpack_from("<I", data, pos)
+        pos += 4
+        i = 0
+        try:
+            while i < pixel_count:
+                op = data[pos] >> 6
+                count = data[pos] & 0x3F
+                pos += 1
+                if not count:
+                    (count,) = struct.unpack_from("<H", data, pos)
+                    pos += 2
+                if op == OP_FILL:
+                    (color,) = struct.unpack_from("<H", data, pos)
+                    pos += 2
+                    screen[i : i + count] = [color] * count
+                elif op == OP_COPY:
+                    screen[i : i + count] = struct.unpack_from(f"<{count}H", data, pos)
+                    pos += count * 2
+                elif op != OP_SKIP:
+                    raise ValueError(f"Unknown op {op} at {pos - 1}")
+                i += count
+        except (IndexError, struct.error):
+            break
+        yield timestamp, Image.frombytes("RGB", (width, height), rgb565_to_rgb(screen))
+
+
+def main():
+    if len(sys.argv) < 2:
+        print(f"Usage: {sys.argv[0]} recording.krec [output.gif]")
+        exit(-1)
+    source = Path(sys.argv[1])
+    target = Path(sys.argv[2]) if len(sys.argv) > 2 else source.with_suffix(".gif")
+
+    frames = []
+    timestamps = []
+    for timestamp, image in read_frames(source.read_bytes()):
+        frames.append(image)
+        timestamps.append(timestamp)
+    if not frames:
+        print("Error: no frames in recording")
+        exit(-2)
+
+    # Frame is shown until the next one was captured
+    durations = [b - a for a, b in zip(timestamps, timestamps[1:])]
+    durations.append(durations[-1] if durations else 100)
+    frames[0].save(target, save_all=True, append_images=frames[1:], duration=durations, loop=0)
+    print(f"Saved {len(frames)} frames to {target}")
+
+
+if __name__ == "__main__":
+    main()